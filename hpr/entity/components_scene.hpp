@@ -43,7 +43,6 @@ struct CameraComponent
 	float   aspect;
 	float   znear;
 	float   zfar;
-	uint8_t active;
 };
 
 
@@ -51,7 +50,6 @@ struct LightComponent
 {
 	scn::LightType type;
 
-	uint8_t enabled;
 	float   intensity;
 	float   range;
 	float   inner_deg;
@@ -59,5 +57,10 @@ struct LightComponent
 	vec3    color_rgb;
 };
 
+
+struct CameraActiveTag {};
+
+struct LightEnabledTag {};
+
 } // hpr::ecs
 
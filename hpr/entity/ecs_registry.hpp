@@ -1,9 +1,12 @@
 #pragma once
 
+#include <array>
 #include <tuple>
 #include <utility>
+#include <algorithm>
 #include <type_traits>
 
+#include "panic.hpp"
 #include "mtp_memory.hpp"
 
 #include "handle.hpp"
@@ -16,6 +19,59 @@ namespace hpr::ecs {
 inline constexpr uint32_t k_invalid_slot {0xFFFFFFFFU};
 
 
+// NOTE: empty component types are tags - membership only, no dense values
+
+template <typename T>
+inline constexpr bool is_tag_v = std::is_empty_v<T>;
+
+
+template <typename... Types>
+struct Exclude {};
+
+template <typename... Types>
+inline constexpr Exclude<Types...> exclude {};
+
+
+enum class HookEvent : uint8_t
+{
+	add = 0,
+	remove,
+	update,
+	count
+};
+
+
+struct ComponentHook
+{
+	using HookFn = void (*)(void* hook_context, Entity entity);
+
+	HookFn function;
+	void*  context;
+};
+
+
+// NOTE: add fires after insertion, remove fires before erase, update fires on replace / patch / notify
+//       hooks must not add or remove the component type they are connected to
+
+struct RackHooks
+{
+	std::array<mtp::vault<ComponentHook, mtp::default_set>, static_cast<size_t>(HookEvent::count)> lists;
+
+	void fire(HookEvent event, Entity entity) const
+	{
+		const auto& list = lists[static_cast<size_t>(event)];
+
+		for (const ComponentHook& hook : list)
+			hook.function(hook.context, entity);
+	}
+
+	[[nodiscard]] bool empty(HookEvent event) const
+	{
+		return lists[static_cast<size_t>(event)].empty();
+	}
+};
+
+
 template <typename... Components>
 class Registry
 {
@@ -120,15 +176,17 @@ public:
 
 		uint32_t slot = rack.sparse_index[entity];
 		if (slot == k_invalid_slot) {
-			slot = static_cast<uint32_t>(rack.dense_values.size());
+			slot = static_cast<uint32_t>(rack.dense_entities.size());
 			rack.sparse_index[entity] = slot;
 			rack.dense_entities.emplace_back(entity);
-			rack.dense_values.emplace_back(std::forward<Types>(args)...);
-			return rack.dense_values[slot];
+			rack.emplace_value(std::forward<Types>(args)...);
+			rack.hooks.fire(HookEvent::add, entity);
+			return rack.value(slot);
 		}
 
-		rack.dense_values[slot] = T(std::forward<Types>(args)...);
-		return rack.dense_values[slot];
+		rack.assign_value(slot, std::forward<Types>(args)...);
+		rack.hooks.fire(HookEvent::update, entity);
+		return rack.value(slot);
 	}
 
 
@@ -144,36 +202,99 @@ public:
 	template <typename T>
 	void remove(Entity entity)
 	{
-		auto& rack = get_rack<T>();
+		get_rack<T>().erase_entity(entity);
+	}
 
-		if (entity >= rack.sparse_index.size())
-			return;
 
-		std::uint32_t slot = rack.sparse_index[entity];
-		if (slot == k_invalid_slot)
+	template <typename T>
+	void remove(Handle<Entity> handle)
+	{
+		if (!is_valid(handle))
 			return;
 
-		std::uint32_t last = static_cast<std::uint32_t>(rack.dense_values.size() - 1U);
+		remove<T>(handle.index);
+	}
 
-		if (slot != last) {
-			rack.dense_values[slot] = std::move(rack.dense_values[last]);
-			rack.dense_entities[slot] = rack.dense_entities[last];
-			rack.sparse_index[rack.dense_entities[slot]] = slot;
-		}
 
-		rack.dense_values.resize(last);
-		rack.dense_entities.resize(last);
-		rack.sparse_index[entity] = k_invalid_slot;
+	template <typename T, typename Func>
+	T* patch(Entity entity, Func&& func)
+	{
+		T* component = get<T>(entity);
+		if (!component)
+			return nullptr;
+
+		func(*component);
+		get_rack<T>().hooks.fire(HookEvent::update, entity);
+
+		return component;
 	}
 
 
 	template <typename T>
-	void remove(Handle<Entity> handle)
+	void notify_update(Entity entity)
 	{
-		if (!is_valid(handle))
+		if (!has<T>(entity))
 			return;
 
-		remove<T>(handle.index);
+		get_rack<T>().hooks.fire(HookEvent::update, entity);
+	}
+
+
+	template <typename T>
+	void connect(HookEvent event, ComponentHook::HookFn function, void* context)
+	{
+		HPR_ASSERT_MSG(event != HookEvent::count, "[connect] invalid hook event");
+		HPR_ASSERT_MSG(function, "[connect] hook function is null");
+
+		get_rack<T>().hooks.lists[static_cast<size_t>(event)].emplace_back(ComponentHook {function, context});
+	}
+
+
+	template <typename T, auto Method, typename Owner>
+	void connect(HookEvent event, Owner& owner)
+	{
+		connect<T>(
+			event,
+			[](void* hook_context, Entity entity) {
+				(static_cast<Owner*>(hook_context)->*Method)(entity);
+			},
+			&owner
+		);
+	}
+
+
+	template <typename T>
+	void disconnect(HookEvent event, void* context)
+	{
+		HPR_ASSERT_MSG(event != HookEvent::count, "[disconnect] invalid hook event");
+
+		auto& list = get_rack<T>().hooks.lists[static_cast<size_t>(event)];
+
+		for (size_t i = 0; i < list.size();) {
+			if (list[i].context == context) {
+				list[i] = list.back();
+				list.pop_back();
+			}
+			else {
+				++i;
+			}
+		}
+	}
+
+
+	template <typename T>
+	void disconnect(void* context)
+	{
+		disconnect<T>(HookEvent::add,    context);
+		disconnect<T>(HookEvent::remove, context);
+		disconnect<T>(HookEvent::update, context);
+	}
+
+
+	template <typename T>
+	[[nodiscard]] bool has_hooks(HookEvent event) const
+	{
+		return !get_rack_const<T>().hooks.empty(event);
 	}
 
 
@@ -189,7 +310,7 @@ public:
 		if (slot == k_invalid_slot)
 			return nullptr;
 
-		return &rack.dense_values[slot];
+		return &rack.value(slot);
 	}
 
 
@@ -214,7 +335,7 @@ public:
 		if (slot == k_invalid_slot)
 			return nullptr;
 
-		return &rack.dense_values[slot];
+		return &rack.value(slot);
 	}
 
 
@@ -232,25 +353,108 @@ public:
 	void each(Func&& func)
 	{
 		auto& rack = get_rack<T>();
-		const std::size_t count = rack.dense_values.size();
+		const std::size_t count = rack.dense_entities.size();
 
 		for (std::size_t i = 0; i < count; ++i) {
-		    func(rack.dense_entities[i], rack.dense_values[i]);
+			if constexpr (is_tag_v<T>)
+				func(rack.dense_entities[i]);
+			else
+				func(rack.dense_entities[i], rack.dense_values[i]);
 		}
 	}
 
 
-	template <typename Primary, typename... Secondary, typename Func>
-	void scan(Func&& func)
+	// NOTE: tags filter the scan but are not passed to func - put the sparsest type first
+
+	template <typename Primary, typename... Secondary, typename... Excluded, typename Func>
+	void scan(Exclude<Excluded...>, Func&& func)
 	{
 		auto& primary_rack = get_rack<Primary>();
-		const std::size_t count = primary_rack.dense_values.size();
+		const std::size_t count = primary_rack.dense_entities.size();
 		for (std::size_t i = 0; i < count; ++i) {
 			Entity entity = primary_rack.dense_entities[i];
 			if (!(has<Secondary>(entity) && ...))
 				continue;
+			if ((has<Excluded>(entity) || ...))
+				continue;
 
-			func(entity, primary_rack.dense_values[i], *get<Secondary>(entity)...);
+			std::apply(
+				[&func, entity](auto&... components) {
+					func(entity, components...);
+				},
+				std::tuple_cat(
+					component_ref<Primary>(primary_rack, static_cast<uint32_t>(i)),
+					component_ref<Secondary>(get_rack<Secondary>(), get_rack<Secondary>().sparse_index[entity])...
+				)
+			);
+		}
+	}
+
+
+	template <typename Primary, typename... Secondary, typename Func>
+	void scan(Func&& func)
+	{
+		scan<Primary, Secondary...>(exclude<>, std::forward<Func>(func));
+	}
+
+
+	// NOTE: compare takes (const T&, const T&) or (Entity, Entity), followers adopt the sorted order
+
+	template <typename T, typename... Followers, typename Compare>
+	void sort(Compare&& compare)
+	{
+		auto& rack = get_rack<T>();
+		const uint32_t count = static_cast<uint32_t>(rack.dense_entities.size());
+
+		if (count > 1) {
+
+			mtp::vault<uint32_t, mtp::default_set> order;
+			order.reserve(count);
+
+			for (uint32_t slot = 0; slot < count; ++slot)
+				order.emplace_back(slot);
+
+			std::sort(order.begin(), order.end(), [&rack, &compare](uint32_t lhs, uint32_t rhs)
+			{
+				if constexpr (!is_tag_v<T> && std::is_invocable_r_v<bool, Compare&, const T&, const T&>)
+					return compare(
+						static_cast<const T&>(rack.dense_values[lhs]),
+						static_cast<const T&>(rack.dense_values[rhs])
+					);
+				else
+					return compare(rack.dense_entities[lhs], rack.dense_entities[rhs]);
+			});
+
+			rack.permute(order);
+		}
+
+		(sort_as<Followers, T>(), ...);
+	}
+
+
+	template <typename T, typename Leader>
+	void sort_as()
+	{
+		static_assert(!std::is_same_v<T, Leader>, "[sort_as] rack cannot follow itself");
+
+		auto& rack = get_rack<T>();
+		const auto& leader = get_rack_const<Leader>();
+
+		uint32_t next_slot = 0;
+		const std::size_t leader_count = leader.dense_entities.size();
+
+		for (std::size_t i = 0; i < leader_count; ++i) {
+
+			const Entity entity = leader.dense_entities[i];
+			if (entity >= rack.sparse_index.size())
+				continue;
+
+			const uint32_t slot = rack.sparse_index[entity];
+			if (slot == k_invalid_slot)
+				continue;
+
+			rack.swap_slots(slot, next_slot);
+			++next_slot;
 		}
 	}
 
@@ -265,7 +469,7 @@ public:
 	template <typename T>
 	std::size_t size() const
 	{
-		return get_rack_const<T>().dense_values.size();
+		return get_rack_const<T>().dense_entities.size();
 	}
 
 	template <typename T>
@@ -277,7 +481,10 @@ public:
 	template <typename T>
 	std::size_t size_values() const
 	{
-		return get_rack_const<T>().dense_values.size();
+		if constexpr (is_tag_v<T>)
+			return 0;
+		else
+			return get_rack_const<T>().dense_values.size();
 	}
 
 	template <typename T>
@@ -352,6 +559,30 @@ private:
 		mtp::vault<T, mtp::default_set>             dense_values;
 		mtp::vault<std::uint32_t, mtp::default_set> sparse_index;
 
+		RackHooks hooks;
+
+		T& value(uint32_t slot)
+		{
+			return dense_values[slot];
+		}
+
+		const T& value(uint32_t slot) const
+		{
+			return dense_values[slot];
+		}
+
+		template <typename... Types>
+		void emplace_value(Types&&... args)
+		{
+			dense_values.emplace_back(std::forward<Types>(args)...);
+		}
+
+		template <typename... Types>
+		void assign_value(uint32_t slot, Types&&... args)
+		{
+			dense_values[slot] = T(std::forward<Types>(args)...);
+		}
+
 		void ensure_sparse_capacity(std::size_t cap)
 		{
 			if (cap > sparse_index.size())
@@ -367,6 +598,8 @@ private:
 			if (slot == k_invalid_slot)
 				return;
 
+			hooks.fire(HookEvent::remove, entity);
+
 			std::uint32_t last = static_cast<std::uint32_t>(dense_values.size() - 1U);
 			if (slot != last) {
 				dense_values[slot] = std::move(dense_values[last]);
@@ -379,8 +612,61 @@ private:
 			sparse_index[entity] = k_invalid_slot;
 		}
 
+		void swap_slots(uint32_t slot_a, uint32_t slot_b)
+		{
+			if (slot_a == slot_b)
+				return;
+
+			std::swap(dense_values[slot_a], dense_values[slot_b]);
+			std::swap(dense_entities[slot_a], dense_entities[slot_b]);
+
+			sparse_index[dense_entities[slot_a]] = slot_a;
+			sparse_index[dense_entities[slot_b]] = slot_b;
+		}
+
+		// NOTE: order[slot] is the source slot moved into slot, consumed in place
+
+		void permute(mtp::vault<uint32_t, mtp::default_set>& order)
+		{
+			const uint32_t count = static_cast<uint32_t>(order.size());
+
+			for (uint32_t cycle_beg = 0; cycle_beg < count; ++cycle_beg) {
+
+				if (order[cycle_beg] == cycle_beg)
+					continue;
+
+				T      cycle_value  = std::move(dense_values[cycle_beg]);
+				Entity cycle_entity = dense_entities[cycle_beg];
+
+				uint32_t dst = cycle_beg;
+
+				for (;;) {
+					const uint32_t src = order[dst];
+					order[dst] = dst;
+
+					if (src == cycle_beg) {
+						dense_values[dst]   = std::move(cycle_value);
+						dense_entities[dst] = cycle_entity;
+						break;
+					}
+
+					dense_values[dst]   = std::move(dense_values[src]);
+					dense_entities[dst] = dense_entities[src];
+					dst = src;
+				}
+			}
+
+			for (uint32_t slot = 0; slot < count; ++slot)
+				sparse_index[dense_entities[slot]] = slot;
+		}
+
 		void clear()
 		{
+			if (!hooks.empty(HookEvent::remove)) {
+				for (Entity entity : dense_entities)
+					hooks.fire(HookEvent::remove, entity);
+			}
+
 			dense_entities.resize(0);
 			dense_values.resize(0);
 			sparse_index.resize(0, k_invalid_slot);
@@ -388,6 +674,112 @@ private:
 	};
 
 
+	template <typename T>
+	requires is_tag_v<T>
+	struct Rack<T>
+	{
+		mtp::vault<Entity,        mtp::default_set> dense_entities;
+		mtp::vault<std::uint32_t, mtp::default_set> sparse_index;
+
+		RackHooks hooks;
+
+		static inline T tag_value {};
+
+		T& value(uint32_t)
+		{
+			return tag_value;
+		}
+
+		const T& value(uint32_t) const
+		{
+			return tag_value;
+		}
+
+		template <typename... Types>
+		void emplace_value(Types&&...)
+		{}
+
+		template <typename... Types>
+		void assign_value(uint32_t, Types&&...)
+		{}
+
+		void ensure_sparse_capacity(std::size_t cap)
+		{
+			if (cap > sparse_index.size())
+				sparse_index.resize(cap, k_invalid_slot);
+		}
+
+		void erase_entity(Entity entity)
+		{
+			if (entity >= sparse_index.size())
+				return;
+
+			std::uint32_t slot = sparse_index[entity];
+			if (slot == k_invalid_slot)
+				return;
+
+			hooks.fire(HookEvent::remove, entity);
+
+			std::uint32_t last = static_cast<std::uint32_t>(dense_entities.size() - 1U);
+			if (slot != last) {
+				dense_entities[slot] = dense_entities[last];
+				sparse_index[dense_entities[slot]] = slot;
+			}
+
+			dense_entities.resize(last);
+			sparse_index[entity] = k_invalid_slot;
+		}
+
+		void swap_slots(uint32_t slot_a, uint32_t slot_b)
+		{
+			if (slot_a == slot_b)
+				return;
+
+			std::swap(dense_entities[slot_a], dense_entities[slot_b]);
+
+			sparse_index[dense_entities[slot_a]] = slot_a;
+			sparse_index[dense_entities[slot_b]] = slot_b;
+		}
+
+		void permute(mtp::vault<uint32_t, mtp::default_set>& order)
+		{
+			const uint32_t count = static_cast<uint32_t>(order.size());
+
+			mtp::vault<Entity, mtp::default_set> sorted_entities;
+			sorted_entities.reserve(count);
+
+			for (uint32_t slot = 0; slot < count; ++slot)
+				sorted_entities.emplace_back(dense_entities[order[slot]]);
+
+			for (uint32_t slot = 0; slot < count; ++slot) {
+				dense_entities[slot] = sorted_entities[slot];
+				sparse_index[dense_entities[slot]] = slot;
+			}
+		}
+
+		void clear()
+		{
+			if (!hooks.empty(HookEvent::remove)) {
+				for (Entity entity : dense_entities)
+					hooks.fire(HookEvent::remove, entity);
+			}
+
+			dense_entities.resize(0);
+			sparse_index.resize(0, k_invalid_slot);
+		}
+	};
+
+
+	template <typename T, typename RackType>
+	static auto component_ref(RackType& rack, uint32_t slot)
+	{
+		if constexpr (is_tag_v<T>)
+			return std::tuple<> {};
+		else
+			return std::tuple<T&> {rack.value(slot)};
+	}
+
+
 	template <typename T>
 	static constexpr bool is_registered_v = (std::is_same_v<T, Components> || ...);
 
@@ -14,8 +14,11 @@ struct BoundSystem
 	template <typename... Components>
 	static void update(Registry<Components...>& registry)
 	{
+		// NOTE: bound update hooks fire only for bounds that actually moved, static
+		//       entities cost their listeners nothing
+
 		registry.template scan<TransformComponent, BoundComponent>(
-			[](Entity, const TransformComponent& transform, BoundComponent& bound)
+			[&registry](Entity entity, const TransformComponent& transform, BoundComponent& bound)
 			{
 				const mat3 linear_world = mat3(transform.world);
 
@@ -28,8 +31,16 @@ struct BoundSystem
 				const vec4 center_local_hom(bound.local_center, 1.0f);
 				const vec4 center_world_hom = transform.world * center_local_hom;
 
-				bound.world_center = vec3(center_world_hom);
-				bound.world_half   = abs_linear * bound.local_half;
+				const vec3 world_center = vec3(center_world_hom);
+				const vec3 world_half   = abs_linear * bound.local_half;
+
+				if (world_center == bound.world_center && world_half == bound.world_half)
+					return;
+
+				bound.world_center = world_center;
+				bound.world_half   = world_half;
+
+				registry.template notify_update<BoundComponent>(entity);
 			}
 		);
 	}
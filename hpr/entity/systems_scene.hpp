@@ -148,13 +148,10 @@ struct CameraSystem
 	{
 		ecs::Entity active_cam = ecs::invalid_entity;
 
-		registry.template each<CameraComponent>(
-			[&active_cam](ecs::Entity entity, CameraComponent& camera_component)
+		registry.template scan<CameraActiveTag, CameraComponent>(
+			[&active_cam](ecs::Entity entity, CameraComponent&)
 			{
-				if (active_cam != ecs::invalid_entity)
-					return;
-
-				if (camera_component.active)
+				if (active_cam == ecs::invalid_entity)
 					active_cam = entity;
 			}
 		);
@@ -416,11 +413,9 @@ struct LightSystem
 		draw_view_light_set_buffer.clear();
 		const mat4& mtx_V = draw_view.mtx_V;
 
-		registry.template scan<LightComponent, TransformComponent>(
+		registry.template scan<LightEnabledTag, LightComponent, TransformComponent>(
 			[&mtx_V](Entity, LightComponent& light_component, const TransformComponent& transform_component)
 			{
-				if (!light_component.enabled)
-					return;
 				if (draw_view_light_set_buffer.size() >= scn::k_max_light_count)
 					return;
 
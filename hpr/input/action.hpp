@@ -34,7 +34,9 @@ enum class ActionKind : uint8_t
 	SnapOn,
 	SnapOff,
 	Move,
-	ToggleCameraMode
+	ToggleCameraMode,
+	TileUndo,
+	TileRedo
 };
 
 struct MoveAction
@@ -143,6 +145,12 @@ struct SnapOffAction
 struct ToggleCameraModeAction
 {};
 
+struct TileUndoAction
+{};
+
+struct TileRedoAction
+{};
+
 using ActionPayload = std::variant <
 	OrbitAction,
 	PanAction,
@@ -167,7 +175,9 @@ using ActionPayload = std::variant <
 	SnapOnAction,
 	SnapOffAction,
 	MoveAction,
-	ToggleCameraModeAction
+	ToggleCameraModeAction,
+	TileUndoAction,
+	TileRedoAction
 >;
 
 struct Action
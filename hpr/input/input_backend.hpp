@@ -125,6 +125,9 @@ inline void handle_event(const sapp_event* event, InputState& state)
 
 		if (event->key_code == SAPP_KEYCODE_F9) { state.key_f9_press = true; }
 
+		if (event->key_code == SAPP_KEYCODE_Z)  { state.key_z_press = true; }
+		if (event->key_code == SAPP_KEYCODE_Y)  { state.key_y_press = true; }
+
 		if (event->key_code == SAPP_KEYCODE_W)  { state.key_w = true; }
 		if (event->key_code == SAPP_KEYCODE_A)  { state.key_a = true; }
 		if (event->key_code == SAPP_KEYCODE_S)  { state.key_s = true; }
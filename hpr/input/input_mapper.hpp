@@ -112,6 +112,15 @@ public:
 			current_actions.push_back({ActionKind::ToggleCameraMode, payload});
 		}
 
+		if (input_state.key_ctrl && input_state.key_z_press) {
+			TileUndoAction payload {};
+			current_actions.push_back({ActionKind::TileUndo, payload});
+		}
+		if (input_state.key_ctrl && input_state.key_y_press) {
+			TileRedoAction payload {};
+			current_actions.push_back({ActionKind::TileRedo, payload});
+		}
+
 
 		float move_forward = (input_state.key_w ? 1.0f : 0.0f) - (input_state.key_s ? 1.0f : 0.0f);
 		float move_right   = (input_state.key_d ? 1.0f : 0.0f) - (input_state.key_a ? 1.0f : 0.0f);
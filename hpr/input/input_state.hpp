@@ -83,6 +83,9 @@ struct InputState
 
 	bool key_f9_press {false};
 
+	bool key_z_press {false};
+	bool key_y_press {false};
+
 	bool focused {true};
 
 	mtp::vault<uint32_t, mtp::default_set> characters;
@@ -121,6 +124,9 @@ struct InputState
 		key_f5_press = false;
 		key_f6_press = false;
 		key_f9_press = false;
+
+		key_z_press = false;
+		key_y_press = false;
 	}
 };
 
@@ -1,5 +1,10 @@
+#include <bit>
+#include <array>
 #include <cmath>
 #include <limits>
+#include <string>
+#include <string_view>
+#include <algorithm>
 
 #include "camera_controller.hpp"
 #include "draw_view_data.hpp"
@@ -8,8 +13,10 @@
 #include "event.hpp"
 #include "scene_io.hpp"
 #include "scene_core.hpp"
+#include "scene_demo.hpp"
 #include "scene_layer.hpp"
 #include "scene_query.hpp"
+#include "voxel_mesher.hpp"
 #include "systems_scene.hpp"
 #include "systems_render.hpp"
 #include "draw_queue_data.hpp"
@@ -18,12 +25,9 @@
 namespace hpr {
 
 
-struct FrustumPlane
-{
-	vec3  normal;
-	vec3  abs_normal;
-	float offset;
-};
+// NOTE: model slices are culled in lane groups, so a slice has to start on one
+
+static_assert(cfg::job_grain % rdr::cfg::frustum_cull_lanes == 0);
 
 
 struct ModelDrawInstance
@@ -40,6 +44,32 @@ struct ModelDrawInstance
 };
 
 
+struct VoxelMeshJobSlice
+{
+	uint32_t begin;
+	uint32_t end;
+
+	const uint32_t*                 drawable_indices;
+	const rdr::VoxelChunkDrawable*  drawables;
+	const scn::VoxelField*          voxelfield;
+	float                           voxel_size;
+
+	scn::VoxelMeshBuffer* mesh_buffers;
+};
+
+
+struct OccludeeJobSlice
+{
+	uint32_t begin;
+	uint32_t end;
+
+	const rdr::OcclusionBuffer* occlusion;
+	const SceneLayer::Occludee* occludees;
+
+	uint8_t* occluded;
+};
+
+
 struct ModelDrawCmdJobSlice
 {
 	uint32_t begin;
@@ -50,8 +80,9 @@ struct ModelDrawCmdJobSlice
 
 	const mtp::vault<scn::ScenePrimitive, mtp::default_set>* scene_primitives;
 
-	const FrustumPlane* frustum_planes;
-	uint32_t            frustum_plane_count;
+	const rdr::CullFrustum*     frustum;
+	const rdr::CullBoundSet*    cull_bounds;
+	const rdr::OcclusionBuffer* occlusion;
 
 	uint32_t    layer_index;
 	ecs::Entity selected_entity;
@@ -116,9 +147,38 @@ void SceneLayer::on_attach()
 		return;
 	}
 
+	scn::build_demo_walls(m_scene);
+
+	m_scene.tile_sim().set_kernel(&scn::tile_spread_kernel, &scn::cfg::demo_spread_rule);
+
+	// NOTE: region files live next to the scene file
+
+	const std::string_view scene_path {m_scene_path};
+	const size_t           dir_end = scene_path.find_last_of('/');
+
+	std::string region_path {dir_end == std::string_view::npos ? std::string_view {"."} : scene_path.substr(0, dir_end)};
+	region_path += "/regions";
+
+	m_scene.tile_stream().open(region_path.c_str());
+	m_scene.voxel_stream().open(region_path.c_str());
+
+	m_render_forge.build_triangle_bvhs(m_job_scheduler, m_scene.scene_primitives());
+
 	ecs::TransformSystem::update(m_registry);
 	ecs::BoundSystem::update(m_registry);
 
+	// NOTE: models in scene primitive order, transforms and bounds follow for linear scans
+
+	m_registry.sort<ecs::ModelComponent, ecs::TransformComponent, ecs::BoundComponent>(
+		[](const ecs::ModelComponent& lhs, const ecs::ModelComponent& rhs)
+		{
+			return lhs.submesh_first < rhs.submesh_first;
+		}
+	);
+
+	m_scene.bound_tree().attach(m_registry);
+	m_scene.bound_tree().sync(m_registry);
+
 	m_active_cam_entity = ecs::CameraSystem::find_active_camera(m_registry);
 	HPR_ASSERT(m_active_cam_entity != ecs::invalid_entity);
 
@@ -132,7 +192,12 @@ void SceneLayer::on_attach()
 
 
 void SceneLayer::on_detach()
-{}
+{
+	m_scene.bound_tree().detach(m_registry);
+
+	m_scene.tile_stream().close(m_scene.tilefield());
+	m_scene.voxel_stream().close(m_scene.voxelfield());
+}
 
 
 bool SceneLayer::on_event(Event& event)
@@ -185,6 +250,28 @@ bool SceneLayer::on_actions(std::span<const Action> actions)
 		}
 		break;
 
+		case ActionKind::TileUndo: {
+			(void) m_scene.tile_journal().undo(
+				m_scene.tilefield(),
+				[this](scn::TileChunkCoord chunk_coord, const scn::TileChunkMask& mask) {
+					mark_tiles_changed(chunk_coord, mask);
+				}
+			);
+			action_consumed = true;
+		}
+		break;
+
+		case ActionKind::TileRedo: {
+			(void) m_scene.tile_journal().redo(
+				m_scene.tilefield(),
+				[this](scn::TileChunkCoord chunk_coord, const scn::TileChunkMask& mask) {
+					mark_tiles_changed(chunk_coord, mask);
+				}
+			);
+			action_consumed = true;
+		}
+		break;
+
 		case ActionKind::SelectClick:
 		{
 			const auto& payload = std::get<SelectClickAction>(action.payload);
@@ -253,6 +340,53 @@ void SceneLayer::on_update(float delta_time)
 	ecs::TransformSystem::update(m_registry);
 	ecs::BoundSystem::update(m_registry);
 
+	m_scene.bound_tree().sync(m_registry);
+	m_scene.agent_hash().rebuild(m_job_scheduler, m_registry, m_scene.grid_params());
+
+	stream_regions();
+
+	auto& tile_edits = m_scene.tile_edits();
+
+	if (!tile_edits.empty()) {
+
+		(void) m_scene.tile_journal().apply(
+			tile_edits,
+			m_scene.tilefield(),
+			[this](scn::TileChunkCoord chunk_coord, const scn::TileChunkMask& mask) {
+				mark_tiles_changed(chunk_coord, mask);
+			}
+		);
+
+		tile_edits.clear();
+	}
+
+	m_scene.tile_sim().advance(
+		delta_time,
+		m_job_scheduler,
+		m_scene.tilefield(),
+		[this](scn::TileChunkCoord chunk_coord) {
+			scn::mark_dirty_chunk(m_scene.stratum(), m_scene.grid_params(), chunk_coord, m_scene.tile_chunk_drawable_set());
+			m_scene.tile_changes().record(chunk_coord);
+		}
+	);
+
+	m_scene.tile_changes().end_tick();
+
+	m_scene.tile_paths().consume(m_scene.tile_changes());
+	m_scene.tile_paths().update(m_job_scheduler, m_scene.tilefield());
+
+	auto& ghost_infra = m_scene.ghost_infra();
+	auto& ghost_links = m_scene.ghost_links();
+	auto& ghost_flow  = m_scene.ghost_flow();
+
+	ghost_links.power.sync(ghost_infra.power);
+	ghost_links.data.sync(ghost_infra.data);
+	ghost_links.pipe.sync(ghost_infra.pipe);
+
+	ghost_flow.power.solve(m_job_scheduler, ghost_infra.power, ghost_links.power);
+	ghost_flow.data.solve(m_job_scheduler, ghost_infra.data, ghost_links.data);
+	ghost_flow.pipe.solve(m_job_scheduler, ghost_infra.pipe, ghost_links.pipe);
+
 	const float aspect_ratio = m_renderer.surface_info().aspect;
 
 	ecs::CameraSystem::build_view(
@@ -275,73 +409,207 @@ void SceneLayer::on_submit(rdr::Renderer& renderer, uint32_t layer_index)
 
 	const auto& scene_primitives = m_scene.scene_primitives();
 
-	std::array<FrustumPlane, math::frustum_plane_count> frustum_planes;
+	rdr::CullFrustum frustum;
+	frustum.set_planes(m_draw_view.frustum);
+
+	/* tiles */
+
+	auto& chunk_drawable_set = m_scene.tile_chunk_drawable_set();
+	auto& chunk_drawables    = chunk_drawable_set.drawables;
 
-	for (size_t plane_idx = 0; plane_idx < frustum_planes.size(); ++plane_idx) {
+	// NOTE: only last frame's visible chunks carry the flag, so resetting it and gathering
+	//       through the cull tree both scale with what is on screen
 
-		const vec4 raw_plane = m_draw_view.frustum[plane_idx];
+	auto& visible_chunk_indices = m_visible_chunk_indices;
 
-		const vec3 raw_normal {
-			raw_plane.x,
-			raw_plane.y,
-			raw_plane.z
-		};
+	for (const uint32_t drawable_idx : visible_chunk_indices) {
+		chunk_drawables[drawable_idx].visible = false;
+	}
 
-		const float normal_len = glm::length(raw_normal);
+	visible_chunk_indices.clear();
 
-		const float inv_normal_len =
-			(normal_len > 0.0f) ? (1.0f / normal_len) : 0.0f;
+	if (chunk_drawable_set.enabled) {
 
-		const vec3 unit_normal = raw_normal * inv_normal_len;
+		HPR_ASSERT_MSG(chunk_drawable_set.cull_tree.size() == chunk_drawables.size(),
+			"tile chunk cull tree out of step with drawables");
 
-		frustum_planes[plane_idx] = {
-			unit_normal,
-			glm::abs(unit_normal),
-			raw_plane.w * inv_normal_len
-		};
+		chunk_drawable_set.cull_tree.gather(
+			frustum,
+			chunk_drawable_set.storey_min,
+			chunk_drawable_set.storey_max,
+			visible_chunk_indices
+		);
+
+		for (const uint32_t drawable_idx : visible_chunk_indices) {
+			chunk_drawables[drawable_idx].visible = true;
+		}
 	}
 
-	/* tiles */
+	/* occluders */
 
-	auto& chunk_drawable_set = m_scene.tile_chunk_drawable_set();
+	// NOTE: storey slabs of the visible chunks and fully solid voxel chunks go into the
+	//       software depth buffer, everything drawn below is tested against it
 
-	if (chunk_drawable_set.enabled) {
+	auto& voxel_drawable_set = m_scene.voxel_chunk_drawable_set();
+
+	m_occlusion.begin(m_draw_view.mtx_VP);
+
+	for (const uint32_t drawable_idx : visible_chunk_indices) {
+
+		const auto& chunk_drawable = chunk_drawables[drawable_idx];
 
-		for (auto& chunk_drawable : chunk_drawable_set.drawables) {
+		const auto* chunk = m_scene.tilefield().find_chunk(chunk_drawable.coord);
+		if (!chunk) {
+			continue;
+		}
+
+		const vec3 slab_min = chunk_drawable.bounds_center - chunk_drawable.bounds_half;
+		const float slab_y  = chunk_drawable.bounds_center.y;
 
-			const int32_t storey_index = chunk_drawable.coord.storey_index;
+		scn::for_each_filled_rect(*chunk, [this, &slab_min, slab_y](int32_t x_beg, int32_t z_beg, int32_t x_end, int32_t z_end)
+		{
+			if ((x_end - x_beg) * (z_end - z_beg) < cfg::min_occluder_tiles) {
+				return;
+			}
+
+			const float min_x = slab_min.x + static_cast<float>(x_beg) * scn::cfg::tile_size;
+			const float min_z = slab_min.z + static_cast<float>(z_beg) * scn::cfg::tile_size;
+			const float max_x = slab_min.x + static_cast<float>(x_end) * scn::cfg::tile_size;
+			const float max_z = slab_min.z + static_cast<float>(z_end) * scn::cfg::tile_size;
+
+			m_occlusion.add_quad(
+				vec3 {min_x, slab_y, min_z},
+				vec3 {max_x, slab_y, min_z},
+				vec3 {max_x, slab_y, max_z},
+				vec3 {min_x, slab_y, max_z}
+			);
+		});
+	}
 
-			if (storey_index < chunk_drawable_set.storey_min || storey_index > chunk_drawable_set.storey_max) {
+	auto& visible_voxel_indices = m_visible_voxel_indices;
+
+	visible_voxel_indices.clear();
+
+	if (voxel_drawable_set.enabled) {
+
+		const uint32_t voxel_drawable_count = static_cast<uint32_t>(voxel_drawable_set.drawables.size());
+
+		for (uint32_t drawable_idx = 0; drawable_idx < voxel_drawable_count; ++drawable_idx) {
+
+			const auto& voxel_drawable = voxel_drawable_set.drawables[drawable_idx];
+
+			if (frustum.is_culled(voxel_drawable.bounds_center, voxel_drawable.bounds_half)) {
 				continue;
 			}
 
-			const vec3 aabb_center = chunk_drawable.bounds_center;
-			const vec3 aabb_half   = chunk_drawable.bounds_half;
+			visible_voxel_indices.emplace_back(drawable_idx);
 
-			bool is_culled = false;
+			const auto* voxel_chunk = m_scene.voxelfield().find_chunk(voxel_drawable.coord);
 
-			for (const auto& plane : frustum_planes) {
+			if (voxel_chunk && voxel_chunk->voxels.uniform() && voxel_chunk->voxels.get(0) != 0) {
+				m_occlusion.add_box(voxel_drawable.bounds_center, voxel_drawable.bounds_half);
+			}
+		}
+	}
 
-				const float aabb_proj_radius =
-					plane.abs_normal.x * aabb_half.x +
-					plane.abs_normal.y * aabb_half.y +
-					plane.abs_normal.z * aabb_half.z;
+	m_occlusion.rasterize(m_job_scheduler);
 
-				const float signed_distance = glm::dot(plane.normal, aabb_center) + plane.offset;
+	/* occludees */
 
-				if (signed_distance < -aabb_proj_radius) {
-					is_culled = true;
-					break;
-				}
+	// NOTE: visible tile chunks first, then visible voxel chunks, tested in parallel. each job
+	//       writes its own range of flags
+
+	const uint32_t visible_chunk_count = static_cast<uint32_t>(visible_chunk_indices.size());
+	const uint32_t visible_voxel_count = static_cast<uint32_t>(visible_voxel_indices.size());
+	const uint32_t occludee_count      = visible_chunk_count + visible_voxel_count;
+
+	m_occludees.resize(occludee_count);
+	m_occludee_flags.resize(occludee_count);
+
+	for (uint32_t visible_idx = 0; visible_idx < visible_chunk_count; ++visible_idx) {
+		const auto& chunk_drawable = chunk_drawables[visible_chunk_indices[visible_idx]];
+		m_occludees[visible_idx] = Occludee {chunk_drawable.bounds_center, chunk_drawable.bounds_half};
+	}
+
+	for (uint32_t visible_idx = 0; visible_idx < visible_voxel_count; ++visible_idx) {
+		const auto& voxel_drawable = voxel_drawable_set.drawables[visible_voxel_indices[visible_idx]];
+		m_occludees[visible_chunk_count + visible_idx] = Occludee {voxel_drawable.bounds_center, voxel_drawable.bounds_half};
+	}
+
+	if (occludee_count != 0) {
+
+		const uint32_t occludee_slice_count = (occludee_count + cfg::occludee_job_grain - 1) / cfg::occludee_job_grain;
+
+		mtp::slag<OccludeeJobSlice, mtp::default_set> occludee_job_slices;
+		occludee_job_slices.resize(occludee_slice_count);
+
+		for (auto& slice : occludee_job_slices) {
+			slice.occlusion = &m_occlusion;
+			slice.occludees = m_occludees.data();
+			slice.occluded  = m_occludee_flags.data();
+		}
+
+		job::JobLatch job_latch;
+
+		m_job_scheduler.dispatch_range(
+			job_latch,
+			&test_occludees,
+			occludee_count,
+			cfg::occludee_job_grain,
+			occludee_job_slices.data()
+		);
+
+		job_latch.wait();
+	}
+
+	if (chunk_drawable_set.enabled) {
+
+		uint32_t unoccluded_chunk_count = 0;
+
+		for (uint32_t visible_idx = 0; visible_idx < visible_chunk_count; ++visible_idx) {
+
+			const uint32_t drawable_idx = visible_chunk_indices[visible_idx];
+
+			if (m_occludee_flags[visible_idx]) {
+				chunk_drawables[drawable_idx].visible = false;
+				continue;
 			}
 
-			if (is_culled) {
+			visible_chunk_indices[unoccluded_chunk_count++] = drawable_idx;
+		}
+
+		visible_chunk_indices.resize(unoccluded_chunk_count);
+
+		// NOTE: each dirty chunk is uploaded at most once per frame within the byte budget,
+		//       at least one upload goes through so a small budget cannot stall the queue
+
+		static constexpr uint32_t chunk_upload_bytes =
+			static_cast<uint32_t>(scn::cfg::chunk_area) * sizeof(scn::TileType);
+
+		auto& dirty_queue = chunk_drawable_set.dirty_queue;
+
+		uint32_t budget_left = chunk_drawable_set.upload_budget_bytes;
+		uint32_t queue_kept  = 0;
+		bool     uploaded    = false;
+
+		for (uint32_t queue_idx = 0; queue_idx < dirty_queue.size(); ++queue_idx) {
+
+			const uint32_t drawable_idx = dirty_queue[queue_idx];
+			auto& chunk_drawable = chunk_drawables[drawable_idx];
+
+			const bool within_budget = !uploaded || chunk_upload_bytes <= budget_left;
+
+			if (!chunk_drawable.visible || !within_budget) {
+				dirty_queue[queue_kept++] = drawable_idx;
 				continue;
 			}
 
-			if (!chunk_drawable.mesh.is_valid()) {
-				chunk_drawable.mesh = m_render_forge.quad();
-				chunk_drawable.submesh_idx = 0;
+			// NOTE: the chunk may have been streamed out while queued, drop it - a reload marks it dirty again
+
+			const auto* chunk = m_scene.tilefield().find_chunk(chunk_drawable.coord);
+			if (!chunk) {
+				chunk_drawable.dirty = false;
+				continue;
 			}
 
 			if (!chunk_drawable.tilemap.is_valid()) {
@@ -351,20 +619,34 @@ void SceneLayer::on_submit(rdr::Renderer& renderer, uint32_t layer_index)
 				);
 			}
 
-			if (chunk_drawable.dirty) {
+			m_render_forge.update_tilemap_texture(
+				chunk_drawable.tilemap,
+				std::span<const uint16_t>(chunk->tiles.data(), chunk->tiles.size()),
+				scn::cfg::chunk_size,
+				scn::cfg::chunk_size
+			);
 
-				auto* chunk = m_scene.tilefield().find_chunk(chunk_drawable.coord_hash);
-				HPR_ASSERT_MSG(chunk,
-				   "missing tile chunk for drawable hash");
+			chunk_drawable.dirty = false;
 
-				m_render_forge.update_tilemap_texture(
-					chunk_drawable.tilemap,
-					std::span<const uint16_t>(chunk->tiles.data(), chunk->tiles.size()),
-					scn::cfg::chunk_size,
-					scn::cfg::chunk_size
-				);
+			budget_left = (chunk_upload_bytes < budget_left) ? (budget_left - chunk_upload_bytes) : 0;
+			uploaded    = true;
+		}
 
-				chunk_drawable.dirty = false;
+		dirty_queue.resize(queue_kept);
+
+		for (const uint32_t drawable_idx : visible_chunk_indices) {
+
+			auto& chunk_drawable = chunk_drawables[drawable_idx];
+
+			// NOTE: tilemap is created on first upload, skip chunks still waiting for it
+
+			if (!chunk_drawable.tilemap.is_valid()) {
+				continue;
+			}
+
+			if (!chunk_drawable.mesh.is_valid()) {
+				chunk_drawable.mesh = m_render_forge.quad();
+				chunk_drawable.submesh_idx = 0;
 			}
 
 			const uint64_t sort_key =
@@ -385,12 +667,52 @@ void SceneLayer::on_submit(rdr::Renderer& renderer, uint32_t layer_index)
 		}
 	}
 
+	/* voxels */
+
+	if (voxel_drawable_set.enabled) {
+
+		remesh_voxel_chunks();
+
+		const Handle<rdr::MaterialInstance> voxel_material = m_render_forge.default_material();
+
+		for (uint32_t visible_idx = 0; visible_idx < visible_voxel_count; ++visible_idx) {
+
+			const auto& voxel_drawable = voxel_drawable_set.drawables[visible_voxel_indices[visible_idx]];
+
+			if (!voxel_drawable.mesh.is_valid() || voxel_drawable.idx_count == 0) {
+				continue;
+			}
+
+			if (m_occludee_flags[visible_chunk_count + visible_idx]) {
+				continue;
+			}
+
+			const uint64_t sort_key =
+				(static_cast<uint64_t>(layer_index) << 56) |
+				(voxel_drawable.key & 0x00FFFFFFFFFFFFFFULL);
+
+			const rdr::SceneDrawCommand voxel_cmd {
+				.mesh        = voxel_drawable.mesh,
+				.submesh_idx = 0,
+				.material    = voxel_material,
+				.sort_key    = sort_key,
+				.layer_index = layer_index,
+				.mtx_M       = voxel_drawable.mtx_M,
+				.flags       = 0
+			};
+
+			renderer.scene_queue().push(voxel_cmd);
+		}
+	}
+
 	/* models */
 
 	mtp::slag<ModelDrawInstance, mtp::default_set> model_draw_instances;
 
+	m_model_cull_bounds.clear();
+
 	m_registry.template scan<ecs::ModelComponent, ecs::TransformComponent, ecs::BoundComponent>(
-		[&model_draw_instances, &renderer](
+		[this, &model_draw_instances, &renderer](
 			ecs::Entity entity,
 			ecs::ModelComponent& model,
 			const ecs::TransformComponent& transform,
@@ -408,6 +730,8 @@ void SceneLayer::on_submit(rdr::Renderer& renderer, uint32_t layer_index)
 				.aabb_half          = aabb.world_half,
 				.world_units_per_px = world_units_per_px
 			});
+
+			m_model_cull_bounds.push(aabb.world_center, aabb.world_half);
 		}
 	);
 
@@ -430,8 +754,9 @@ void SceneLayer::on_submit(rdr::Renderer& renderer, uint32_t layer_index)
 		slice.instances           = model_draw_instances.data();
 		slice.instance_count      = model_instance_count;
 		slice.scene_primitives    = &scene_primitives;
-		slice.frustum_planes      = frustum_planes.data();
-		slice.frustum_plane_count = static_cast<uint32_t>(frustum_planes.size());
+		slice.frustum             = &frustum;
+		slice.cull_bounds         = &m_model_cull_bounds;
+		slice.occlusion           = &m_occlusion;
 		slice.layer_index         = layer_index;
 		slice.selected_entity     = m_selection.entity;
 
@@ -465,43 +790,252 @@ void SceneLayer::on_result(Event& event)
 }
 
 
-void SceneLayer::build_model_draw_cmds(void* slice_raw)
+// NOTE: keeps the chunks around the point the camera looks at resident. chunks streamed in
+//       are remeshed and logged as changed, chunks streamed out leave the cull tree and the
+//       voxel draw list. tile chunks follow the visible storey range
+
+void SceneLayer::stream_regions()
 {
-	auto* slice = static_cast<ModelDrawCmdJobSlice*>(slice_raw);
+	const auto* cam_transform = m_registry.get<ecs::TransformComponent>(m_active_cam_entity);
+	if (!cam_transform) {
+		return;
+	}
 
-	auto& slice_draw_cmds = *slice->draw_cmd_result;
-	slice_draw_cmds.clear();
+	const auto& grid_params = m_scene.grid_params();
+	const auto& voxel_grid  = m_scene.voxel_grid();
 
-	const ModelDrawInstance* model_draw_instances = slice->instances;
+	const vec3 cam_pos = cam_transform->world_pos();
+	const vec3 cam_fwd = cam_transform->world_fwd();
 
-	for (uint32_t instance_idx = slice->begin; instance_idx < slice->end; ++instance_idx) {
+	vec3 focus = cam_pos;
 
-		const ModelDrawInstance& model_instance = model_draw_instances[instance_idx];
+	if (cam_fwd.y < -1.0e-3f) {
+		focus += cam_fwd * ((grid_params.origin_world.y - cam_pos.y) / cam_fwd.y);
+	}
 
-		const vec3 aabb_center = model_instance.aabb_center;
-		const vec3 aabb_half   = model_instance.aabb_half;
+	/* tiles */
 
-		bool is_culled = false;
+	auto& tile_draw = m_scene.tile_chunk_drawable_set();
 
-		for (uint32_t plane_idx = 0; plane_idx < slice->frustum_plane_count; ++plane_idx) {
+	const scn::TileCoord focus_tile = scn::world_to_tile(focus, grid_params);
 
-			const auto& plane = slice->frustum_planes[plane_idx];
+	scn::gather_tile_chunks_near(
+		scn::get_chunk_coord(focus_tile),
+		cfg::tile_stream_radius,
+		tile_draw.storey_min,
+		tile_draw.storey_max + 1,
+		m_wanted_tile_chunks
+	);
 
-			const float aabb_proj_radius =
-				plane.abs_normal.x * aabb_half.x +
-				plane.abs_normal.y * aabb_half.y +
-				plane.abs_normal.z * aabb_half.z;
+	m_scene.tile_stream().update(
+		m_scene.tilefield(),
+		std::span<const scn::TileChunkCoord> {m_wanted_tile_chunks.data(), m_wanted_tile_chunks.size()},
+		[this, &grid_params, &tile_draw](scn::TileChunkCoord chunk_coord) {
+			scn::mark_dirty_chunk(m_scene.stratum(), grid_params, chunk_coord, tile_draw);
+			m_scene.tile_changes().record(chunk_coord);
+			m_scene.tile_sim().activate(chunk_coord);
+		},
+		[this, &tile_draw](scn::TileChunkCoord chunk_coord) {
+			scn::release_tile_chunk(chunk_coord, tile_draw);
+			m_scene.tile_changes().record(chunk_coord);
+		}
+	);
 
-			const float signed_distance =
-				glm::dot(plane.normal, aabb_center) + plane.offset;
+	/* voxels */
 
-			if (signed_distance < -aabb_proj_radius) {
-				is_culled = true;
-				break;
+	auto& voxelfield = m_scene.voxelfield();
+	auto& voxel_draw = m_scene.voxel_chunk_drawable_set();
+
+	const vec3 focus_voxel = (focus - voxel_grid.origin_world) / voxel_grid.voxel_size;
+
+	const scn::VoxelCoord focus_voxel_coord {
+		static_cast<int32_t>(floorf(focus_voxel.x)),
+		static_cast<int32_t>(floorf(focus_voxel.y)),
+		static_cast<int32_t>(floorf(focus_voxel.z))
+	};
+
+	scn::gather_voxel_chunks_near(
+		scn::VoxelField::chunk_of(focus_voxel_coord),
+		cfg::voxel_stream_radius_xz,
+		cfg::voxel_stream_radius_y,
+		m_wanted_voxel_chunks
+	);
+
+	m_scene.voxel_stream().update(
+		voxelfield,
+		std::span<const scn::VoxelChunkCoord> {m_wanted_voxel_chunks.data(), m_wanted_voxel_chunks.size()},
+		[&voxelfield, &voxel_grid, &voxel_draw](scn::VoxelChunkCoord chunk_coord) {
+			scn::mark_voxel_chunk_loaded(voxelfield, voxel_grid, chunk_coord, voxel_draw);
+		},
+		[&voxelfield, &voxel_grid, &voxel_draw](scn::VoxelChunkCoord chunk_coord) {
+			scn::mark_voxel_chunk_evicted(voxelfield, voxel_grid, chunk_coord, voxel_draw);
+		}
+	);
+}
+
+
+// NOTE: tiles written outside the simulation, by edit batches or the journal. the chunk is
+//       remeshed, the tiles go into this tick of the change log for the pathfinder and the
+//       chunk wakes up in the simulation
+
+void SceneLayer::mark_tiles_changed(scn::TileChunkCoord chunk_coord, const scn::TileChunkMask& mask)
+{
+	scn::mark_dirty_chunk(m_scene.stratum(), m_scene.grid_params(), chunk_coord, m_scene.tile_chunk_drawable_set());
+	m_scene.tile_changes().record(chunk_coord, mask);
+	m_scene.tile_sim().activate(chunk_coord);
+}
+
+
+// NOTE: meshing runs on the workers, uploads stay on the render thread
+
+void SceneLayer::remesh_voxel_chunks()
+{
+	auto& voxel_drawable_set = m_scene.voxel_chunk_drawable_set();
+	auto& dirty_queue        = voxel_drawable_set.dirty_queue;
+
+	if (dirty_queue.empty()) {
+		return;
+	}
+
+	const uint32_t remesh_count =
+		std::min(static_cast<uint32_t>(dirty_queue.size()), cfg::max_voxel_remesh_per_frame);
+
+	if (m_voxel_mesh_buffers.size() < remesh_count) {
+		m_voxel_mesh_buffers.resize(remesh_count);
+	}
+
+	mtp::slag<VoxelMeshJobSlice, mtp::default_set> voxel_mesh_job_slices;
+	voxel_mesh_job_slices.resize(remesh_count);
+
+	for (auto& slice : voxel_mesh_job_slices) {
+		slice.drawable_indices = dirty_queue.data();
+		slice.drawables        = voxel_drawable_set.drawables.data();
+		slice.voxelfield       = &m_scene.voxelfield();
+		slice.voxel_size       = m_scene.voxel_grid().voxel_size;
+		slice.mesh_buffers     = m_voxel_mesh_buffers.data();
+	}
+
+	job::JobLatch job_latch;
+
+	m_job_scheduler.dispatch_range(
+		job_latch,
+		&build_voxel_chunk_meshes,
+		remesh_count,
+		1,
+		voxel_mesh_job_slices.data()
+	);
+
+	job_latch.wait();
+
+	for (uint32_t remesh_idx = 0; remesh_idx < remesh_count; ++remesh_idx) {
+
+		auto& voxel_drawable = voxel_drawable_set.drawables[dirty_queue[remesh_idx]];
+		const auto& mesh_buffer = m_voxel_mesh_buffers[remesh_idx];
+
+		const uint32_t vtx_count = static_cast<uint32_t>(mesh_buffer.vertices.size());
+		const uint32_t idx_count = static_cast<uint32_t>(mesh_buffer.indices.size());
+
+		const bool needs_grow =
+			vtx_count > voxel_drawable.vtx_capacity ||
+			idx_count > voxel_drawable.idx_capacity;
+
+		if (needs_grow) {
+
+			if (voxel_drawable.mesh.is_valid()) {
+				m_render_forge.destroy_dynamic_mesh(voxel_drawable.mesh);
 			}
+
+			voxel_drawable.vtx_capacity = std::bit_ceil(std::max(vtx_count, cfg::min_voxel_mesh_vtx_capacity));
+			voxel_drawable.idx_capacity = std::bit_ceil(std::max(idx_count, cfg::min_voxel_mesh_vtx_capacity * 3 / 2));
+
+			voxel_drawable.mesh = m_render_forge.create_dynamic_mesh(
+				static_cast<uint32_t>(sizeof(rdr::SceneVertex)),
+				voxel_drawable.vtx_capacity,
+				voxel_drawable.idx_capacity
+			);
 		}
 
-		if (is_culled) {
+		if (voxel_drawable.mesh.is_valid()) {
+			m_render_forge.update_dynamic_mesh(
+				voxel_drawable.mesh,
+				std::as_bytes(std::span<const rdr::SceneVertex>(mesh_buffer.vertices.data(), vtx_count)),
+				vtx_count,
+				std::as_bytes(std::span<const uint32_t>(mesh_buffer.indices.data(), idx_count)),
+				idx_count
+			);
+		}
+
+		voxel_drawable.idx_count = idx_count;
+		voxel_drawable.dirty     = false;
+	}
+
+	const uint32_t queue_count = static_cast<uint32_t>(dirty_queue.size());
+
+	for (uint32_t queue_idx = remesh_count; queue_idx < queue_count; ++queue_idx) {
+		dirty_queue[queue_idx - remesh_count] = dirty_queue[queue_idx];
+	}
+
+	dirty_queue.resize(queue_count - remesh_count);
+}
+
+
+void SceneLayer::build_voxel_chunk_meshes(void* slice_raw)
+{
+	auto* slice = static_cast<VoxelMeshJobSlice*>(slice_raw);
+
+	for (uint32_t remesh_idx = slice->begin; remesh_idx < slice->end; ++remesh_idx) {
+
+		const auto& voxel_drawable = slice->drawables[slice->drawable_indices[remesh_idx]];
+
+		scn::build_voxel_chunk_mesh(
+			*slice->voxelfield,
+			voxel_drawable.coord,
+			slice->voxel_size,
+			slice->mesh_buffers[remesh_idx]
+		);
+	}
+}
+
+
+void SceneLayer::test_occludees(void* slice_raw)
+{
+	auto* slice = static_cast<OccludeeJobSlice*>(slice_raw);
+
+	for (uint32_t occludee_idx = slice->begin; occludee_idx < slice->end; ++occludee_idx) {
+
+		const Occludee& occludee = slice->occludees[occludee_idx];
+
+		slice->occluded[occludee_idx] = slice->occlusion->is_occluded(occludee.center, occludee.half) ? 1 : 0;
+	}
+}
+
+
+void SceneLayer::build_model_draw_cmds(void* slice_raw)
+{
+	auto* slice = static_cast<ModelDrawCmdJobSlice*>(slice_raw);
+
+	auto& slice_draw_cmds = *slice->draw_cmd_result;
+	slice_draw_cmds.clear();
+
+	const ModelDrawInstance* model_draw_instances = slice->instances;
+
+	std::array<uint32_t, cfg::job_grain> visible_instance_indices;
+
+	const uint32_t visible_instance_count = rdr::cull_frustum(
+		*slice->frustum,
+		*slice->cull_bounds,
+		slice->begin,
+		slice->end,
+		visible_instance_indices.data()
+	);
+
+	for (uint32_t visible_idx = 0; visible_idx < visible_instance_count; ++visible_idx) {
+
+		const ModelDrawInstance& model_instance = model_draw_instances[visible_instance_indices[visible_idx]];
+
+		const vec3 aabb_half = model_instance.aabb_half;
+
+		if (slice->occlusion->is_occluded(model_instance.aabb_center, aabb_half)) {
 			continue;
 		}
 
@@ -582,7 +1116,11 @@ void SceneLayer::process_commands(CmdStream::Reader reader)
 				const SetLight* cmd = static_cast<const SetLight*>(payload);
 
 				if (auto* light_comp = m_registry.get<ecs::LightComponent>(cmd->entity)) {
-					light_comp->enabled   = cmd->light.enabled;
+					if (cmd->light.enabled)
+						m_registry.add<ecs::LightEnabledTag>(cmd->entity);
+					else
+						m_registry.remove<ecs::LightEnabledTag>(cmd->entity);
+
 					light_comp->type      = static_cast<scn::LightType>(cmd->light.type);
 					light_comp->color_rgb = cmd->light.color_rgb;
 					light_comp->intensity = cmd->light.intensity;
@@ -643,7 +1181,7 @@ edt::InspectorSnapshot SceneLayer::selection_properties() const
 
 	if (const auto* light = m_registry.get<ecs::LightComponent>(entity)) {
 		inspector_snapshot.has_light = true;
-		inspector_snapshot.light.enabled   = light->enabled ? 1 : 0;
+		inspector_snapshot.light.enabled   = m_registry.has<ecs::LightEnabledTag>(entity) ? 1 : 0;
 		inspector_snapshot.light.color_rgb = light->color_rgb;
 		inspector_snapshot.light.intensity = light->intensity;
 		inspector_snapshot.light.range     = light->range;
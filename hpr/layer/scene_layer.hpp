@@ -16,8 +16,11 @@
 #include "scene.hpp"
 #include "scene_data.hpp"
 #include "scene_resolver.hpp"
+#include "voxel_mesher.hpp"
 
 #include "renderer.hpp"
+#include "frustum_cull.hpp"
+#include "occlusion_cull.hpp"
 #include "scheduler.hpp"
 #include "render_forge.hpp"
 #include "asset_keeper.hpp"
@@ -37,6 +40,16 @@ inline constexpr uint32_t max_models_per_scene    = 256U;
 inline constexpr uint32_t max_submeshes_per_model = 32U;
 inline constexpr uint32_t max_draw_cmds_per_slice = job_grain * max_submeshes_per_model;
 
+inline constexpr uint32_t max_voxel_remesh_per_frame  = 32U;
+inline constexpr uint32_t min_voxel_mesh_vtx_capacity = 1024U;
+
+inline constexpr int32_t  min_occluder_tiles = 16;
+inline constexpr uint32_t occludee_job_grain = 32U;
+
+inline constexpr int32_t tile_stream_radius     = 4;
+inline constexpr int32_t voxel_stream_radius_xz = 4;
+inline constexpr int32_t voxel_stream_radius_y  = 1;
+
 }; // hpr::cfg
 
 
@@ -74,6 +87,12 @@ public:
 
 	using DrawCmdAsyncResult = DrawCmdAsyncResult_t<cfg::max_draw_cmds_per_slice>;
 
+	struct Occludee
+	{
+		vec3 center;
+		vec3 half;
+	};
+
 	static constexpr uint32_t mtp_scn_max_stride =
 		sizeof(DrawCmdAsyncResult) * cfg::max_models_per_scene / cfg::job_grain;
 
@@ -95,7 +114,9 @@ public:
 		ecs::ModelComponent,
 		ecs::BoundComponent,
 		ecs::CameraComponent,
-		ecs::LightComponent
+		ecs::LightComponent,
+		ecs::CameraActiveTag,
+		ecs::LightEnabledTag
 	>;
 
 public:
@@ -123,11 +144,19 @@ public:
 	{ m_event_queue = &queue; }
 
 	static void build_model_draw_cmds(void* job_input_ptr);
+	static void build_voxel_chunk_meshes(void* job_input_ptr);
+	static void test_occludees(void* job_input_ptr);
 
 	void process_commands(CmdStream::Reader reader) override;
 
 	edt::InspectorSnapshot selection_properties() const override;
 
+private:
+
+	void stream_regions();
+	void remesh_voxel_chunks();
+	void mark_tiles_changed(scn::TileChunkCoord chunk_coord, const scn::TileChunkMask& mask);
+
 private:
 
 	ECSRegistry& m_registry;
@@ -155,6 +184,20 @@ private:
 	scn::CameraController m_cam_controller;
 
 	mtp::slag<DrawCmdAsyncResult, mtp_scn_set> m_slice_draw_cmd_results;
+
+	rdr::CullBoundSet     m_model_cull_bounds;
+	rdr::OcclusionBuffer  m_occlusion;
+
+	mtp::vault<uint32_t, mtp::default_set> m_visible_chunk_indices;
+	mtp::vault<uint32_t, mtp::default_set> m_visible_voxel_indices;
+
+	mtp::vault<Occludee, mtp::default_set> m_occludees;
+	mtp::vault<uint8_t,  mtp::default_set> m_occludee_flags;
+
+	mtp::vault<scn::TileChunkCoord,  mtp::default_set> m_wanted_tile_chunks;
+	mtp::vault<scn::VoxelChunkCoord, mtp::default_set> m_wanted_voxel_chunks;
+
+	mtp::vault<scn::VoxelMeshBuffer, mtp::default_set> m_voxel_mesh_buffers;
 };
 
 } // hpr
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <array>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "math.hpp"
+
+
+namespace hpr::rdr {
+
+
+namespace cfg {
+
+inline constexpr uint32_t frustum_cull_lanes = 8U;
+
+} // hpr::rdr::cfg
+
+
+// NOTE: unit plane normals split per axis, abs normals give the projected radius of a box
+
+struct CullFrustum
+{
+	alignas(32) float normal_x [math::frustum_plane_count];
+	alignas(32) float normal_y [math::frustum_plane_count];
+	alignas(32) float normal_z [math::frustum_plane_count];
+	alignas(32) float abs_x    [math::frustum_plane_count];
+	alignas(32) float abs_y    [math::frustum_plane_count];
+	alignas(32) float abs_z    [math::frustum_plane_count];
+	alignas(32) float offset   [math::frustum_plane_count];
+
+
+	void set_planes(const std::array<vec4, math::frustum_plane_count>& raw_planes)
+	{
+		for (uint32_t plane_idx = 0; plane_idx < math::frustum_plane_count; ++plane_idx) {
+
+			const vec4 raw_plane = raw_planes[plane_idx];
+
+			const float normal_len     = glm::length(vec3 {raw_plane.x, raw_plane.y, raw_plane.z});
+			const float inv_normal_len = (normal_len > 0.0f) ? (1.0f / normal_len) : 0.0f;
+
+			normal_x[plane_idx] = raw_plane.x * inv_normal_len;
+			normal_y[plane_idx] = raw_plane.y * inv_normal_len;
+			normal_z[plane_idx] = raw_plane.z * inv_normal_len;
+			abs_x[plane_idx]    = std::abs(normal_x[plane_idx]);
+			abs_y[plane_idx]    = std::abs(normal_y[plane_idx]);
+			abs_z[plane_idx]    = std::abs(normal_z[plane_idx]);
+			offset[plane_idx]   = raw_plane.w * inv_normal_len;
+		}
+	}
+
+
+	// NOTE: single box path for sets too small or too scattered to batch
+
+	[[nodiscard]] bool is_culled(const vec3& aabb_center, const vec3& aabb_half) const
+	{
+		for (uint32_t plane_idx = 0; plane_idx < math::frustum_plane_count; ++plane_idx) {
+
+			const float aabb_proj_radius =
+				abs_x[plane_idx] * aabb_half.x +
+				abs_y[plane_idx] * aabb_half.y +
+				abs_z[plane_idx] * aabb_half.z;
+
+			const float signed_distance =
+				normal_x[plane_idx] * aabb_center.x +
+				normal_y[plane_idx] * aabb_center.y +
+				normal_z[plane_idx] * aabb_center.z +
+				offset[plane_idx];
+
+			if (signed_distance < -aabb_proj_radius)
+				return true;
+		}
+
+		return false;
+	}
+
+
+	// NOTE: box entirely on the inner side of all six planes, its contents need no further test
+
+	[[nodiscard]] bool is_contained(const vec3& aabb_center, const vec3& aabb_half) const
+	{
+		for (uint32_t plane_idx = 0; plane_idx < math::frustum_plane_count; ++plane_idx) {
+
+			const float aabb_proj_radius =
+				abs_x[plane_idx] * aabb_half.x +
+				abs_y[plane_idx] * aabb_half.y +
+				abs_z[plane_idx] * aabb_half.z;
+
+			const float signed_distance =
+				normal_x[plane_idx] * aabb_center.x +
+				normal_y[plane_idx] * aabb_center.y +
+				normal_z[plane_idx] * aabb_center.z +
+				offset[plane_idx];
+
+			if (signed_distance < aabb_proj_radius)
+				return false;
+		}
+
+		return true;
+	}
+};
+
+
+// NOTE: boxes as center and half extent streams, storage is kept at a whole number of
+//       cull lanes so the kernel never reads past the end. padding lanes are zero boxes
+
+class CullBoundSet
+{
+public:
+
+	void clear()
+	{
+		m_count = 0;
+
+		for (auto* stream : streams())
+			stream->clear();
+	}
+
+
+	void reserve(uint32_t count)
+	{
+		const uint32_t padded = padded_count(count);
+
+		for (auto* stream : streams())
+			stream->reserve(padded);
+	}
+
+
+	uint32_t push(const vec3& center, const vec3& half)
+	{
+		const uint32_t bound_idx = m_count++;
+
+		if (m_count > m_center_x.size()) {
+			for (auto* stream : streams())
+				stream->resize(padded_count(m_count), 0.0f);
+		}
+
+		set(bound_idx, center, half);
+
+		return bound_idx;
+	}
+
+
+	void set(uint32_t bound_idx, const vec3& center, const vec3& half)
+	{
+		HPR_ASSERT_MSG(bound_idx < m_count, "[cull bounds] index out of range");
+
+		m_center_x[bound_idx] = center.x;
+		m_center_y[bound_idx] = center.y;
+		m_center_z[bound_idx] = center.z;
+		m_half_x[bound_idx]   = half.x;
+		m_half_y[bound_idx]   = half.y;
+		m_half_z[bound_idx]   = half.z;
+	}
+
+
+	// NOTE: the last box takes over bound_idx, the freed lane goes back to a zero box
+
+	void swap_remove(uint32_t bound_idx)
+	{
+		HPR_ASSERT_MSG(bound_idx < m_count, "[cull bounds] index out of range");
+
+		const uint32_t last_idx = --m_count;
+
+		for (auto* stream : streams()) {
+			(*stream)[bound_idx] = (*stream)[last_idx];
+			(*stream)[last_idx]  = 0.0f;
+		}
+	}
+
+
+	[[nodiscard]] uint32_t size() const
+	{
+		return m_count;
+	}
+
+
+	[[nodiscard]] const float* center_x() const { return m_center_x.data(); }
+	[[nodiscard]] const float* center_y() const { return m_center_y.data(); }
+	[[nodiscard]] const float* center_z() const { return m_center_z.data(); }
+	[[nodiscard]] const float* half_x()   const { return m_half_x.data(); }
+	[[nodiscard]] const float* half_y()   const { return m_half_y.data(); }
+	[[nodiscard]] const float* half_z()   const { return m_half_z.data(); }
+
+private:
+
+	[[nodiscard]] static uint32_t padded_count(uint32_t count)
+	{
+		return (count + cfg::frustum_cull_lanes - 1) / cfg::frustum_cull_lanes * cfg::frustum_cull_lanes;
+	}
+
+
+	[[nodiscard]] std::array<mtp::vault<float, mtp::default_set>*, 6> streams()
+	{
+		return {&m_center_x, &m_center_y, &m_center_z, &m_half_x, &m_half_y, &m_half_z};
+	}
+
+private:
+
+	mtp::vault<float, mtp::default_set> m_center_x;
+	mtp::vault<float, mtp::default_set> m_center_y;
+	mtp::vault<float, mtp::default_set> m_center_z;
+	mtp::vault<float, mtp::default_set> m_half_x;
+	mtp::vault<float, mtp::default_set> m_half_y;
+	mtp::vault<float, mtp::default_set> m_half_z;
+
+	uint32_t m_count {0};
+};
+
+
+namespace detail {
+
+	// NOTE: each kernel returns one bit per lane of the group at base, set when the box
+	//       survives all six planes
+
+#if defined(__AVX2__)
+
+	[[nodiscard]] inline uint32_t cull_lane_group(const CullFrustum& frustum, const CullBoundSet& bounds, uint32_t base)
+	{
+		const __m256 center_x = _mm256_loadu_ps(bounds.center_x() + base);
+		const __m256 center_y = _mm256_loadu_ps(bounds.center_y() + base);
+		const __m256 center_z = _mm256_loadu_ps(bounds.center_z() + base);
+		const __m256 half_x   = _mm256_loadu_ps(bounds.half_x() + base);
+		const __m256 half_y   = _mm256_loadu_ps(bounds.half_y() + base);
+		const __m256 half_z   = _mm256_loadu_ps(bounds.half_z() + base);
+
+		const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+
+		__m256 culled = _mm256_setzero_ps();
+
+		for (uint32_t plane_idx = 0; plane_idx < math::frustum_plane_count; ++plane_idx) {
+
+			const __m256 radius = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_broadcast_ss(&frustum.abs_x[plane_idx]), half_x),
+				_mm256_mul_ps(_mm256_broadcast_ss(&frustum.abs_y[plane_idx]), half_y)),
+				_mm256_mul_ps(_mm256_broadcast_ss(&frustum.abs_z[plane_idx]), half_z));
+
+			const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_broadcast_ss(&frustum.normal_x[plane_idx]), center_x),
+				_mm256_mul_ps(_mm256_broadcast_ss(&frustum.normal_y[plane_idx]), center_y)),
+				_mm256_mul_ps(_mm256_broadcast_ss(&frustum.normal_z[plane_idx]), center_z)),
+				_mm256_broadcast_ss(&frustum.offset[plane_idx]));
+
+			culled = _mm256_or_ps(culled, _mm256_cmp_ps(distance, _mm256_xor_ps(radius, sign_bit), _CMP_LT_OQ));
+		}
+
+		return ~static_cast<uint32_t>(_mm256_movemask_ps(culled)) & 0xFFU;
+	}
+
+#elif defined(__SSE2__)
+
+	[[nodiscard]] inline uint32_t cull_lane_half(const CullFrustum& frustum, const CullBoundSet& bounds, uint32_t base)
+	{
+		const __m128 center_x = _mm_loadu_ps(bounds.center_x() + base);
+		const __m128 center_y = _mm_loadu_ps(bounds.center_y() + base);
+		const __m128 center_z = _mm_loadu_ps(bounds.center_z() + base);
+		const __m128 half_x   = _mm_loadu_ps(bounds.half_x() + base);
+		const __m128 half_y   = _mm_loadu_ps(bounds.half_y() + base);
+		const __m128 half_z   = _mm_loadu_ps(bounds.half_z() + base);
+
+		const __m128 sign_bit = _mm_set1_ps(-0.0f);
+
+		__m128 culled = _mm_setzero_ps();
+
+		for (uint32_t plane_idx = 0; plane_idx < math::frustum_plane_count; ++plane_idx) {
+
+			const __m128 radius = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(frustum.abs_x[plane_idx]), half_x),
+				_mm_mul_ps(_mm_set1_ps(frustum.abs_y[plane_idx]), half_y)),
+				_mm_mul_ps(_mm_set1_ps(frustum.abs_z[plane_idx]), half_z));
+
+			const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(frustum.normal_x[plane_idx]), center_x),
+				_mm_mul_ps(_mm_set1_ps(frustum.normal_y[plane_idx]), center_y)),
+				_mm_mul_ps(_mm_set1_ps(frustum.normal_z[plane_idx]), center_z)),
+				_mm_set1_ps(frustum.offset[plane_idx]));
+
+			culled = _mm_or_ps(culled, _mm_cmplt_ps(distance, _mm_xor_ps(radius, sign_bit)));
+		}
+
+		return ~static_cast<uint32_t>(_mm_movemask_ps(culled)) & 0xFU;
+	}
+
+
+	[[nodiscard]] inline uint32_t cull_lane_group(const CullFrustum& frustum, const CullBoundSet& bounds, uint32_t base)
+	{
+		return cull_lane_half(frustum, bounds, base) | (cull_lane_half(frustum, bounds, base + 4) << 4);
+	}
+
+#elif defined(__ARM_NEON)
+
+	[[nodiscard]] inline uint32_t cull_lane_half(const CullFrustum& frustum, const CullBoundSet& bounds, uint32_t base)
+	{
+		const float32x4_t center_x = vld1q_f32(bounds.center_x() + base);
+		const float32x4_t center_y = vld1q_f32(bounds.center_y() + base);
+		const float32x4_t center_z = vld1q_f32(bounds.center_z() + base);
+		const float32x4_t half_x   = vld1q_f32(bounds.half_x() + base);
+		const float32x4_t half_y   = vld1q_f32(bounds.half_y() + base);
+		const float32x4_t half_z   = vld1q_f32(bounds.half_z() + base);
+
+		uint32x4_t culled = vdupq_n_u32(0);
+
+		for (uint32_t plane_idx = 0; plane_idx < math::frustum_plane_count; ++plane_idx) {
+
+			const float32x4_t radius = vaddq_f32(vaddq_f32(
+				vmulq_n_f32(half_x, frustum.abs_x[plane_idx]),
+				vmulq_n_f32(half_y, frustum.abs_y[plane_idx])),
+				vmulq_n_f32(half_z, frustum.abs_z[plane_idx]));
+
+			const float32x4_t distance = vaddq_f32(vaddq_f32(vaddq_f32(
+				vmulq_n_f32(center_x, frustum.normal_x[plane_idx]),
+				vmulq_n_f32(center_y, frustum.normal_y[plane_idx])),
+				vmulq_n_f32(center_z, frustum.normal_z[plane_idx])),
+				vdupq_n_f32(frustum.offset[plane_idx]));
+
+			culled = vorrq_u32(culled, vcltq_f32(distance, vnegq_f32(radius)));
+		}
+
+		const uint32_t lane_bits =
+			(vgetq_lane_u32(culled, 0) & 1U) |
+			(vgetq_lane_u32(culled, 1) & 2U) |
+			(vgetq_lane_u32(culled, 2) & 4U) |
+			(vgetq_lane_u32(culled, 3) & 8U);
+
+		return ~lane_bits & 0xFU;
+	}
+
+
+	[[nodiscard]] inline uint32_t cull_lane_group(const CullFrustum& frustum, const CullBoundSet& bounds, uint32_t base)
+	{
+		return cull_lane_half(frustum, bounds, base) | (cull_lane_half(frustum, bounds, base + 4) << 4);
+	}
+
+#else
+
+	[[nodiscard]] inline uint32_t cull_lane_group(const CullFrustum& frustum, const CullBoundSet& bounds, uint32_t base)
+	{
+		uint32_t visible_bits = 0;
+
+		for (uint32_t lane = 0; lane < cfg::frustum_cull_lanes; ++lane) {
+
+			const uint32_t bound_idx = base + lane;
+
+			const vec3 center {bounds.center_x()[bound_idx], bounds.center_y()[bound_idx], bounds.center_z()[bound_idx]};
+			const vec3 half   {bounds.half_x()[bound_idx],   bounds.half_y()[bound_idx],   bounds.half_z()[bound_idx]};
+
+			if (!frustum.is_culled(center, half))
+				visible_bits |= 1U << lane;
+		}
+
+		return visible_bits;
+	}
+
+#endif
+
+} // hpr::rdr::detail
+
+
+// NOTE: tests the boxes [begin, end) eight at a time and writes the indices of the visible
+//       ones in ascending order, returns how many were written. begin has to sit on a lane
+//       group so slices of a job split line up, visible_indices needs room for end - begin
+
+inline uint32_t cull_frustum(
+	const CullFrustum&  frustum,
+	const CullBoundSet& bounds,
+	uint32_t            begin,
+	uint32_t            end,
+	uint32_t*           visible_indices
+)
+{
+	HPR_ASSERT_MSG(begin % cfg::frustum_cull_lanes == 0, "[frustum cull] begin not lane aligned");
+	HPR_ASSERT_MSG(end <= bounds.size(), "[frustum cull] range past bound count");
+
+	uint32_t visible_count = 0;
+
+	for (uint32_t base = begin; base < end; base += cfg::frustum_cull_lanes) {
+
+		uint32_t visible_bits = detail::cull_lane_group(frustum, bounds, base);
+
+		if (end - base < cfg::frustum_cull_lanes)
+			visible_bits &= (1U << (end - base)) - 1U;
+
+		for (; visible_bits != 0; visible_bits &= visible_bits - 1)
+			visible_indices[visible_count++] = base + static_cast<uint32_t>(std::countr_zero(visible_bits));
+	}
+
+	return visible_count;
+}
+
+
+} // hpr::rdr
@@ -0,0 +1,583 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "job_latch.hpp"
+#include "scheduler.hpp"
+
+#include "math.hpp"
+
+
+namespace hpr::rdr {
+
+namespace cfg {
+
+inline constexpr uint32_t occlusion_width      = 320U;
+inline constexpr uint32_t occlusion_height     = 192U;
+inline constexpr uint32_t occlusion_band_rows  = 16U;
+inline constexpr uint32_t occlusion_hiz_levels = 6U;
+
+inline constexpr float    occlusion_near_w     = 1e-3f;
+
+} // hpr::rdr::cfg
+
+
+static_assert(cfg::occlusion_width % 4 == 0, "[occlusion] rows are rasterized four pixels at a time");
+static_assert(cfg::occlusion_height % cfg::occlusion_band_rows == 0, "[occlusion] bands have to tile the buffer");
+static_assert(cfg::occlusion_width % (1U << (cfg::occlusion_hiz_levels - 1)) == 0, "[occlusion] width has to halve down every hiz level");
+static_assert(cfg::occlusion_height % (1U << (cfg::occlusion_hiz_levels - 1)) == 0, "[occlusion] height has to halve down every hiz level");
+
+
+// NOTE: screen space convex occluder with up to four edges, triangles get a fourth edge
+//       that always passes. edges are oriented so inside is non negative at pixel centres and are
+//       pulled in by half a pixel, so only fully covered pixels pass. depth is 1/w as a
+//       screen space plane, larger is nearer, lowered to the farthest value inside the pixel.
+//       both keep the buffer from hiding anything that shows, which is also why quads are
+//       not split, the pixels along a shared diagonal would be covered by neither half
+
+struct OccluderPolygon
+{
+	float edge_a [4];
+	float edge_b [4];
+	float edge_c [4];
+
+	float depth_a;
+	float depth_b;
+	float depth_c;
+
+	int32_t x_min;
+	int32_t x_max;
+	int32_t y_min;
+	int32_t y_max;
+};
+
+
+// NOTE: low resolution software depth buffer for occluder geometry. begin() takes the frame's
+//       view projection, occluders are added as world quads and boxes, rasterize() fills the
+//       buffer in horizontal bands on the workers and builds the hierarchical z. the buffer
+//       keeps the nearest 1/w per pixel, so zero is open sky and never occludes anything.
+//       hiz level k keeps the farthest occluder depth of each 2^k square of pixels, level 0
+//       is the buffer itself.
+//       is_occluded() only reads and can be called from any job once rasterize() returned
+
+class OcclusionBuffer
+{
+public:
+
+	void begin(const mat4& mtx_VP)
+	{
+		m_mtx_VP = mtx_VP;
+		m_polygons.clear();
+		m_ready = false;
+	}
+
+
+	// NOTE: planar convex quad, corners in order around it. both sides occlude
+
+	void add_quad(const vec3& corner_0, const vec3& corner_1, const vec3& corner_2, const vec3& corner_3)
+	{
+		const std::array<vec4, 4> clip {
+			m_mtx_VP * vec4(corner_0, 1.0f),
+			m_mtx_VP * vec4(corner_1, 1.0f),
+			m_mtx_VP * vec4(corner_2, 1.0f),
+			m_mtx_VP * vec4(corner_3, 1.0f)
+		};
+
+		// NOTE: clip against w = near, a quad crossing it keeps up to five corners and its
+		//       last one goes out as a separate triangle
+
+		std::array<vec4, 5> polygon;
+		uint32_t            polygon_size = 0;
+
+		for (uint32_t corner = 0; corner < 4; ++corner) {
+
+			const vec4& current = clip[corner];
+			const vec4& next    = clip[(corner + 1) % 4];
+
+			const float current_side = current.w - cfg::occlusion_near_w;
+			const float next_side    = next.w - cfg::occlusion_near_w;
+
+			if (current_side >= 0.0f)
+				polygon[polygon_size++] = current;
+
+			if ((current_side >= 0.0f) != (next_side >= 0.0f))
+				polygon[polygon_size++] = current + (next - current) * (current_side / (current_side - next_side));
+		}
+
+		if (polygon_size < 3)
+			return;
+
+		add_screen_polygon(polygon.data(), std::min(polygon_size, 4U));
+
+		if (polygon_size == 5) {
+			const std::array<vec4, 3> remainder {polygon[0], polygon[3], polygon[4]};
+			add_screen_polygon(remainder.data(), 3);
+		}
+	}
+
+
+	void add_box(const vec3& center, const vec3& half)
+	{
+		const vec3 lo = center - half;
+		const vec3 hi = center + half;
+
+		add_quad({lo.x, lo.y, lo.z}, {hi.x, lo.y, lo.z}, {hi.x, hi.y, lo.z}, {lo.x, hi.y, lo.z});
+		add_quad({lo.x, lo.y, hi.z}, {hi.x, lo.y, hi.z}, {hi.x, hi.y, hi.z}, {lo.x, hi.y, hi.z});
+		add_quad({lo.x, lo.y, lo.z}, {lo.x, hi.y, lo.z}, {lo.x, hi.y, hi.z}, {lo.x, lo.y, hi.z});
+		add_quad({hi.x, lo.y, lo.z}, {hi.x, hi.y, lo.z}, {hi.x, hi.y, hi.z}, {hi.x, lo.y, hi.z});
+		add_quad({lo.x, lo.y, lo.z}, {hi.x, lo.y, lo.z}, {hi.x, lo.y, hi.z}, {lo.x, lo.y, hi.z});
+		add_quad({lo.x, hi.y, lo.z}, {hi.x, hi.y, lo.z}, {hi.x, hi.y, hi.z}, {lo.x, hi.y, hi.z});
+	}
+
+
+	void rasterize(job::Scheduler& job_scheduler)
+	{
+		if (m_hiz[0].texels.empty())
+			allocate_hiz();
+
+		m_ready = !m_polygons.empty();
+
+		if (!m_ready)
+			return;
+
+		static constexpr uint32_t band_count = cfg::occlusion_height / cfg::occlusion_band_rows;
+
+		std::array<BandJobSlice, band_count> band_slices;
+
+		for (BandJobSlice& slice : band_slices)
+			slice.buffer = this;
+
+		job::JobLatch job_latch;
+
+		job_scheduler.dispatch_range(
+			job_latch,
+			&rasterize_bands,
+			band_count,
+			1,
+			band_slices.data()
+		);
+
+		job_latch.wait();
+
+		build_hiz();
+	}
+
+
+	// NOTE: conservative, a box reaching the near plane stays visible. the part of the rect
+	//       outside the buffer is dropped, frustum culling already covers boxes fully outside
+
+	[[nodiscard]] bool is_occluded(const vec3& center, const vec3& half) const
+	{
+		if (!m_ready)
+			return false;
+
+		float screen_min_x = std::numeric_limits<float>::max();
+		float screen_min_y = std::numeric_limits<float>::max();
+		float screen_max_x = std::numeric_limits<float>::lowest();
+		float screen_max_y = std::numeric_limits<float>::lowest();
+		float nearest      = 0.0f;
+
+		// NOTE: corners as the clip center plus or minus the three clip half axes
+
+		const vec4 clip_center = m_mtx_VP * vec4(center, 1.0f);
+		const vec4 clip_half_x = m_mtx_VP[0] * half.x;
+		const vec4 clip_half_y = m_mtx_VP[1] * half.y;
+		const vec4 clip_half_z = m_mtx_VP[2] * half.z;
+
+		for (uint32_t corner = 0; corner < 8; ++corner) {
+
+			const vec4 clip = clip_center
+				+ ((corner & 1U) ? clip_half_x : -clip_half_x)
+				+ ((corner & 2U) ? clip_half_y : -clip_half_y)
+				+ ((corner & 4U) ? clip_half_z : -clip_half_z);
+
+			if (clip.w <= cfg::occlusion_near_w)
+				return false;
+
+			const float inv_w = 1.0f / clip.w;
+
+			const float screen_x = (clip.x * inv_w * 0.5f + 0.5f) * static_cast<float>(cfg::occlusion_width);
+			const float screen_y = (clip.y * inv_w * 0.5f + 0.5f) * static_cast<float>(cfg::occlusion_height);
+
+			screen_min_x = std::min(screen_min_x, screen_x);
+			screen_min_y = std::min(screen_min_y, screen_y);
+			screen_max_x = std::max(screen_max_x, screen_x);
+			screen_max_y = std::max(screen_max_y, screen_y);
+			nearest      = std::max(nearest, inv_w);
+		}
+
+		const float max_x = static_cast<float>(cfg::occlusion_width  - 1);
+		const float max_y = static_cast<float>(cfg::occlusion_height - 1);
+
+		if (screen_max_x < 0.0f || screen_max_y < 0.0f || screen_min_x > max_x || screen_min_y > max_y)
+			return false;
+
+		const int32_t pixel_x0 = static_cast<int32_t>(std::max(screen_min_x, 0.0f));
+		const int32_t pixel_y0 = static_cast<int32_t>(std::max(screen_min_y, 0.0f));
+		const int32_t pixel_x1 = static_cast<int32_t>(std::min(screen_max_x, max_x));
+		const int32_t pixel_y1 = static_cast<int32_t>(std::min(screen_max_y, max_y));
+
+		// NOTE: coarsest level that keeps the rect within five texels per axis, coarser levels
+		//       pull in more of the surroundings and get too pessimistic at occluder edges
+
+		const int32_t span = std::max(pixel_x1 - pixel_x0, pixel_y1 - pixel_y0);
+
+		uint32_t level = 0;
+		while (level + 1 < cfg::occlusion_hiz_levels && (span >> level) > 3)
+			++level;
+
+		const HizLevel& hiz = m_hiz[level];
+
+		for (int32_t texel_y = pixel_y0 >> level; texel_y <= (pixel_y1 >> level); ++texel_y) {
+			for (int32_t texel_x = pixel_x0 >> level; texel_x <= (pixel_x1 >> level); ++texel_x) {
+				if (hiz.texels[static_cast<size_t>(texel_y) * hiz.width + static_cast<size_t>(texel_x)] <= nearest)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	[[nodiscard]] uint32_t polygon_count() const
+	{
+		return static_cast<uint32_t>(m_polygons.size());
+	}
+
+
+	// NOTE: row major, occlusion_width floats per row
+
+	[[nodiscard]] const float* depth() const
+	{
+		return m_hiz[0].texels.data();
+	}
+
+private:
+
+	struct BandJobSlice
+	{
+		uint32_t begin;
+		uint32_t end;
+
+		OcclusionBuffer* buffer;
+	};
+
+
+	struct HizLevel
+	{
+		uint32_t width;
+		uint32_t height;
+
+		mtp::vault<float, mtp::default_set> texels;
+	};
+
+
+	void add_screen_polygon(const vec4* clip, uint32_t corner_count)
+	{
+		std::array<double, 4> screen_x;
+		std::array<double, 4> screen_y;
+		std::array<double, 4> inv_w;
+
+		for (uint32_t corner = 0; corner < corner_count; ++corner) {
+			inv_w[corner]    = 1.0 / static_cast<double>(clip[corner].w);
+			screen_x[corner] = (static_cast<double>(clip[corner].x) * inv_w[corner] * 0.5 + 0.5) * cfg::occlusion_width;
+			screen_y[corner] = (static_cast<double>(clip[corner].y) * inv_w[corner] * 0.5 + 0.5) * cfg::occlusion_height;
+		}
+
+		double area = 0.0;
+
+		for (uint32_t corner = 0; corner < corner_count; ++corner) {
+			const uint32_t next = (corner + 1) % corner_count;
+			area += screen_x[corner] * screen_y[next] - screen_x[next] * screen_y[corner];
+		}
+
+		if (!(std::abs(area) > 1e-9) || !std::isfinite(area))
+			return;
+
+		double min_x = screen_x[0];
+		double max_x = screen_x[0];
+		double min_y = screen_y[0];
+		double max_y = screen_y[0];
+
+		for (uint32_t corner = 1; corner < corner_count; ++corner) {
+			min_x = std::min(min_x, screen_x[corner]);
+			max_x = std::max(max_x, screen_x[corner]);
+			min_y = std::min(min_y, screen_y[corner]);
+			max_y = std::max(max_y, screen_y[corner]);
+		}
+
+		OccluderPolygon polygon;
+
+		polygon.x_min = static_cast<int32_t>(std::max(std::floor(min_x), 0.0));
+		polygon.y_min = static_cast<int32_t>(std::max(std::floor(min_y), 0.0));
+		polygon.x_max = static_cast<int32_t>(std::min(std::ceil(max_x), static_cast<double>(cfg::occlusion_width)  - 1.0));
+		polygon.y_max = static_cast<int32_t>(std::min(std::ceil(max_y), static_cast<double>(cfg::occlusion_height) - 1.0));
+
+		if (polygon.x_min > polygon.x_max || polygon.y_min > polygon.y_max)
+			return;
+
+		// NOTE: edge k runs from corner k to the next, evaluated at pixel centres x + 0.5,
+		//       y + 0.5 and shifted by the half pixel footprint along its normal
+
+		const double orient = area > 0.0 ? 1.0 : -1.0;
+
+		for (uint32_t edge = 0; edge < 4; ++edge) {
+
+			if (edge >= corner_count) {
+				polygon.edge_a[edge] = 0.0f;
+				polygon.edge_b[edge] = 0.0f;
+				polygon.edge_c[edge] = 1.0f;
+				continue;
+			}
+
+			const uint32_t from = edge;
+			const uint32_t to   = (edge + 1) % corner_count;
+
+			const double edge_a = -(screen_y[to] - screen_y[from]) * orient;
+			const double edge_b =  (screen_x[to] - screen_x[from]) * orient;
+			const double edge_c = -(edge_a * screen_x[from] + edge_b * screen_y[from]);
+
+			polygon.edge_a[edge] = static_cast<float>(edge_a);
+			polygon.edge_b[edge] = static_cast<float>(edge_b);
+			polygon.edge_c[edge] = static_cast<float>(edge_c + (edge_a + edge_b - std::abs(edge_a) - std::abs(edge_b)) * 0.5);
+		}
+
+		// NOTE: depth plane through the corner triple with the larger area, the polygon is planar
+
+		uint32_t base = 0;
+
+		if (corner_count == 4) {
+			const double area_012 = std::abs((screen_x[1] - screen_x[0]) * (screen_y[2] - screen_y[0]) - (screen_x[2] - screen_x[0]) * (screen_y[1] - screen_y[0]));
+			const double area_230 = std::abs((screen_x[3] - screen_x[2]) * (screen_y[0] - screen_y[2]) - (screen_x[0] - screen_x[2]) * (screen_y[3] - screen_y[2]));
+			base = area_230 > area_012 ? 2 : 0;
+		}
+
+		const uint32_t corner_0 = base;
+		const uint32_t corner_1 = (base + 1) % corner_count;
+		const uint32_t corner_2 = (base + 2) % corner_count;
+
+		const double dx_1 = screen_x[corner_1] - screen_x[corner_0];
+		const double dy_1 = screen_y[corner_1] - screen_y[corner_0];
+		const double dx_2 = screen_x[corner_2] - screen_x[corner_0];
+		const double dy_2 = screen_y[corner_2] - screen_y[corner_0];
+		const double dd_1 = inv_w[corner_1] - inv_w[corner_0];
+		const double dd_2 = inv_w[corner_2] - inv_w[corner_0];
+
+		const double plane_area = dx_1 * dy_2 - dx_2 * dy_1;
+
+		if (!(std::abs(plane_area) > 1e-9))
+			return;
+
+		const double depth_a = (dd_1 * dy_2 - dd_2 * dy_1) / plane_area;
+		const double depth_b = (dx_1 * dd_2 - dx_2 * dd_1) / plane_area;
+		const double depth_c = inv_w[corner_0] - depth_a * screen_x[corner_0] - depth_b * screen_y[corner_0];
+
+		polygon.depth_a = static_cast<float>(depth_a);
+		polygon.depth_b = static_cast<float>(depth_b);
+		polygon.depth_c = static_cast<float>(depth_c + (depth_a + depth_b - std::abs(depth_a) - std::abs(depth_b)) * 0.5);
+
+		m_polygons.emplace_back(polygon);
+	}
+
+
+	static void rasterize_bands(void* slice_raw)
+	{
+		auto* slice = static_cast<BandJobSlice*>(slice_raw);
+
+		for (uint32_t band_idx = slice->begin; band_idx < slice->end; ++band_idx)
+			slice->buffer->rasterize_band(band_idx);
+	}
+
+
+	void rasterize_band(uint32_t band_idx)
+	{
+		const int32_t row_beg = static_cast<int32_t>(band_idx * cfg::occlusion_band_rows);
+		const int32_t row_end = row_beg + static_cast<int32_t>(cfg::occlusion_band_rows);
+
+		float* depth = m_hiz[0].texels.data();
+
+		float* band_depth = depth + static_cast<size_t>(row_beg) * cfg::occlusion_width;
+
+		std::fill_n(band_depth, static_cast<size_t>(cfg::occlusion_band_rows) * cfg::occlusion_width, 0.0f);
+
+		for (const OccluderPolygon& polygon : m_polygons) {
+
+			const int32_t y_beg = std::max(polygon.y_min, row_beg);
+			const int32_t y_end = std::min(polygon.y_max + 1, row_end);
+
+			const int32_t x_beg = polygon.x_min & ~3;
+			const int32_t x_end = polygon.x_max + 1;
+
+			for (int32_t y = y_beg; y < y_end; ++y)
+				rasterize_row(polygon, depth + static_cast<size_t>(y) * cfg::occlusion_width, x_beg, x_end, static_cast<float>(y));
+		}
+	}
+
+
+#if defined(__SSE2__)
+
+	static void rasterize_row(const OccluderPolygon& polygon, float* row, int32_t x_beg, int32_t x_end, float y)
+	{
+		const __m128 lane_x = _mm_add_ps(_mm_set1_ps(static_cast<float>(x_beg)), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+
+		__m128 edge [4];
+		__m128 step [4];
+
+		for (uint32_t edge_idx = 0; edge_idx < 4; ++edge_idx) {
+			edge[edge_idx] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(polygon.edge_a[edge_idx]), lane_x), _mm_set1_ps(polygon.edge_b[edge_idx] * y + polygon.edge_c[edge_idx]));
+			step[edge_idx] = _mm_set1_ps(polygon.edge_a[edge_idx] * 4.0f);
+		}
+
+		__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(polygon.depth_a), lane_x), _mm_set1_ps(polygon.depth_b * y + polygon.depth_c));
+
+		const __m128 step_depth = _mm_set1_ps(polygon.depth_a * 4.0f);
+		const __m128 zero       = _mm_setzero_ps();
+
+		for (int32_t x = x_beg; x < x_end; x += 4) {
+
+			const __m128 inside = _mm_and_ps(
+				_mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_cmpge_ps(edge[1], zero)),
+				_mm_and_ps(_mm_cmpge_ps(edge[2], zero), _mm_cmpge_ps(edge[3], zero))
+			);
+
+			_mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), _mm_and_ps(inside, depth)));
+
+			for (uint32_t edge_idx = 0; edge_idx < 4; ++edge_idx)
+				edge[edge_idx] = _mm_add_ps(edge[edge_idx], step[edge_idx]);
+
+			depth = _mm_add_ps(depth, step_depth);
+		}
+	}
+
+#elif defined(__ARM_NEON)
+
+	static void rasterize_row(const OccluderPolygon& polygon, float* row, int32_t x_beg, int32_t x_end, float y)
+	{
+		static constexpr float lane_offsets[4] {0.0f, 1.0f, 2.0f, 3.0f};
+
+		const float32x4_t lane_x = vaddq_f32(vdupq_n_f32(static_cast<float>(x_beg)), vld1q_f32(lane_offsets));
+
+		float32x4_t edge [4];
+		float32x4_t step [4];
+
+		for (uint32_t edge_idx = 0; edge_idx < 4; ++edge_idx) {
+			edge[edge_idx] = vaddq_f32(vmulq_n_f32(lane_x, polygon.edge_a[edge_idx]), vdupq_n_f32(polygon.edge_b[edge_idx] * y + polygon.edge_c[edge_idx]));
+			step[edge_idx] = vdupq_n_f32(polygon.edge_a[edge_idx] * 4.0f);
+		}
+
+		float32x4_t depth = vaddq_f32(vmulq_n_f32(lane_x, polygon.depth_a), vdupq_n_f32(polygon.depth_b * y + polygon.depth_c));
+
+		const float32x4_t step_depth = vdupq_n_f32(polygon.depth_a * 4.0f);
+		const float32x4_t zero       = vdupq_n_f32(0.0f);
+
+		for (int32_t x = x_beg; x < x_end; x += 4) {
+
+			const uint32x4_t inside = vandq_u32(
+				vandq_u32(vcgeq_f32(edge[0], zero), vcgeq_f32(edge[1], zero)),
+				vandq_u32(vcgeq_f32(edge[2], zero), vcgeq_f32(edge[3], zero))
+			);
+
+			const float32x4_t covered = vreinterpretq_f32_u32(vandq_u32(inside, vreinterpretq_u32_f32(depth)));
+
+			vst1q_f32(row + x, vmaxq_f32(vld1q_f32(row + x), covered));
+
+			for (uint32_t edge_idx = 0; edge_idx < 4; ++edge_idx)
+				edge[edge_idx] = vaddq_f32(edge[edge_idx], step[edge_idx]);
+
+			depth = vaddq_f32(depth, step_depth);
+		}
+	}
+
+#else
+
+	static void rasterize_row(const OccluderPolygon& polygon, float* row, int32_t x_beg, int32_t x_end, float y)
+	{
+		float edge_row [4];
+
+		for (uint32_t edge_idx = 0; edge_idx < 4; ++edge_idx)
+			edge_row[edge_idx] = polygon.edge_b[edge_idx] * y + polygon.edge_c[edge_idx];
+
+		const float depth_row = polygon.depth_b * y + polygon.depth_c;
+
+		for (int32_t x = x_beg; x < x_end; ++x) {
+
+			const float pixel_x = static_cast<float>(x);
+
+			const bool inside =
+				polygon.edge_a[0] * pixel_x + edge_row[0] >= 0.0f &&
+				polygon.edge_a[1] * pixel_x + edge_row[1] >= 0.0f &&
+				polygon.edge_a[2] * pixel_x + edge_row[2] >= 0.0f &&
+				polygon.edge_a[3] * pixel_x + edge_row[3] >= 0.0f;
+
+			if (inside)
+				row[x] = std::max(row[x], polygon.depth_a * pixel_x + depth_row);
+		}
+	}
+
+#endif
+
+
+	void allocate_hiz()
+	{
+		for (uint32_t level = 0; level < cfg::occlusion_hiz_levels; ++level) {
+
+			HizLevel& hiz = m_hiz[level];
+
+			hiz.width  = cfg::occlusion_width  >> level;
+			hiz.height = cfg::occlusion_height >> level;
+
+			hiz.texels.resize(static_cast<size_t>(hiz.width) * hiz.height);
+		}
+	}
+
+
+	void build_hiz()
+	{
+		for (uint32_t level = 1; level < cfg::occlusion_hiz_levels; ++level) {
+
+			const HizLevel& finer = m_hiz[level - 1];
+			HizLevel&       hiz   = m_hiz[level];
+
+			for (uint32_t texel_y = 0; texel_y < hiz.height; ++texel_y) {
+
+				const float* finer_row_0 = finer.texels.data() + static_cast<size_t>(texel_y * 2) * finer.width;
+				const float* finer_row_1 = finer_row_0 + finer.width;
+
+				float* row = hiz.texels.data() + static_cast<size_t>(texel_y) * hiz.width;
+
+				for (uint32_t texel_x = 0; texel_x < hiz.width; ++texel_x) {
+					row[texel_x] = std::min(
+						std::min(finer_row_0[texel_x * 2], finer_row_0[texel_x * 2 + 1]),
+						std::min(finer_row_1[texel_x * 2], finer_row_1[texel_x * 2 + 1])
+					);
+				}
+			}
+		}
+	}
+
+private:
+
+	mat4 m_mtx_VP {1.0f};
+
+	mtp::vault<OccluderPolygon, mtp::default_set> m_polygons;
+
+	std::array<HizLevel, cfg::occlusion_hiz_levels> m_hiz;
+
+	bool m_ready {false};
+};
+
+
+} // hpr::rdr
@@ -8,6 +8,7 @@
 
 #include "math.hpp"
 #include "handle.hpp"
+#include "triangle_bvh.hpp"
 
 
 namespace hpr::rdr {
@@ -356,6 +357,8 @@ struct SubmeshGeometry
 {
 	mtp::vault<uint8_t, mtp::default_set> index_bytes;
 
+	TriangleBvh triangle_bvh;
+
 	SubmeshGeometry() = delete;
 	SubmeshGeometry(const SubmeshGeometry&) = delete;
 	SubmeshGeometry& operator=(const SubmeshGeometry&) = delete;
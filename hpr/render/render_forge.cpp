@@ -1,3 +1,5 @@
+#include <cstddef>
+
 #include "log.hpp"
 #include "handle.hpp"
 #include "engine.hpp"
@@ -22,6 +24,25 @@
 namespace hpr::rdr {
 
 
+struct TriangleBvhJobSlice
+{
+	uint32_t begin;
+	uint32_t end;
+
+	TriangleBvh* const* subtree_bvhs;
+	const uint32_t*     subtree_indices;
+};
+
+
+static void build_triangle_bvh_subtrees(void* slice_raw)
+{
+	auto* slice = static_cast<TriangleBvhJobSlice*>(slice_raw);
+
+	for (uint32_t task_idx = slice->begin; task_idx < slice->end; ++task_idx)
+		slice->subtree_bvhs[task_idx]->build_subtree(slice->subtree_indices[task_idx]);
+}
+
+
 RenderForge::RenderForge(RenderHub& hub, const ForgeResolver& resolver, SurfaceInfo surface_info)
 	: m_hub          {hub}
 	, m_resolver     {resolver}
@@ -421,6 +442,96 @@ scn::ScenePrimitive RenderForge::create_scene_primitive(res::ImportPrimitive& im
 }
 
 
+void RenderForge::build_triangle_bvhs(job::Scheduler& job_scheduler, std::span<const scn::ScenePrimitive> scene_primitives)
+{
+	mtp::vault<TriangleBvh*, mtp::default_set> started_bvhs;
+
+	mtp::vault<TriangleBvh*, mtp::default_set> subtree_bvhs;
+	mtp::vault<uint32_t,     mtp::default_set> subtree_indices;
+
+	for (const scn::ScenePrimitive& scene_primitive : scene_primitives) {
+
+		const Mesh* mesh = m_hub.get<Mesh>(scene_primitive.mesh);
+		if (!mesh)
+			continue;
+
+		MeshGeometry* mesh_geometry = m_hub.get<MeshGeometry>(mesh->geometry);
+		if (!mesh_geometry || scene_primitive.submesh_idx >= mesh_geometry->submeshes.size())
+			continue;
+
+		SubmeshGeometry& submesh_geometry = mesh_geometry->submeshes[scene_primitive.submesh_idx];
+
+		if (!submesh_geometry.triangle_bvh.empty())
+			continue;
+
+		const TriangleSource triangle_source {
+			.position_bytes  = mesh_geometry->vertex_bytes.data() + offsetof(SceneVertex, pos),
+			.position_stride = static_cast<uint32_t>(sizeof(SceneVertex)),
+			.vertex_count    = static_cast<uint32_t>(mesh_geometry->vertex_bytes.size() / sizeof(SceneVertex)),
+			.indices         = reinterpret_cast<const uint32_t*>(submesh_geometry.index_bytes.data()),
+			.triangle_count  = static_cast<uint32_t>(submesh_geometry.index_bytes.size() / (3 * sizeof(uint32_t)))
+		};
+
+		const uint32_t subtree_count = submesh_geometry.triangle_bvh.begin_build(triangle_source, cfg::triangle_bvh_subtree_size);
+
+		if (submesh_geometry.triangle_bvh.empty())
+			continue;
+
+		started_bvhs.emplace_back(&submesh_geometry.triangle_bvh);
+
+		for (uint32_t subtree_idx = 0; subtree_idx < subtree_count; ++subtree_idx) {
+			subtree_bvhs.emplace_back(&submesh_geometry.triangle_bvh);
+			subtree_indices.emplace_back(subtree_idx);
+		}
+	}
+
+	const uint32_t subtree_total = static_cast<uint32_t>(subtree_bvhs.size());
+
+	mtp::vault<TriangleBvhJobSlice, mtp::default_set> job_slices;
+	job_slices.resize(subtree_total);
+
+	for (TriangleBvhJobSlice& slice : job_slices) {
+		slice.subtree_bvhs    = subtree_bvhs.data();
+		slice.subtree_indices = subtree_indices.data();
+	}
+
+	job::JobLatch job_latch;
+
+	job_scheduler.dispatch_range(
+		job_latch,
+		&build_triangle_bvh_subtrees,
+		subtree_total,
+		1,
+		job_slices.data()
+	);
+
+	job_latch.wait();
+
+	uint32_t triangle_total = 0;
+	uint32_t node_total     = 0;
+	size_t   memory_total   = 0;
+
+	for (TriangleBvh* triangle_bvh : started_bvhs) {
+
+		triangle_bvh->finish_build();
+
+		triangle_total += triangle_bvh->triangle_count();
+		node_total     += triangle_bvh->node_count();
+		memory_total   += triangle_bvh->memory_bytes();
+	}
+
+	HPR_INFO(
+		log::LogCategory::render,
+		"[forge][build_triangle_bvhs] built [geometries %u][subtrees %u][triangles %u][nodes %u][bytes %zu]",
+		static_cast<unsigned>(started_bvhs.size()),
+		static_cast<unsigned>(subtree_total),
+		static_cast<unsigned>(triangle_total),
+		static_cast<unsigned>(node_total),
+		memory_total
+	);
+}
+
+
 Handle<MeshGeometry> RenderForge::create_geometry(res::ImportPrimitiveGeometry& import_geometry)
 {
 	return m_hub.create<MeshGeometry>(std::move(import_geometry.vtx_bytes), std::move(import_geometry.idx_bytes));
@@ -985,6 +1096,25 @@ void RenderForge::update_dynamic_mesh(
 }
 
 
+void RenderForge::destroy_dynamic_mesh(Handle<Mesh> mesh_hnd)
+{
+	Mesh* mesh = m_hub.get<Mesh>(mesh_hnd);
+	if (!mesh)
+		return;
+
+	if (mesh->bindings.vertex_buffers[0].id != 0) {
+		sg_destroy_buffer(mesh->bindings.vertex_buffers[0]);
+	}
+
+	if (mesh->bindings.index_buffer.id != 0) {
+		sg_destroy_buffer(mesh->bindings.index_buffer);
+	}
+
+	m_hub.destroy<MeshGeometry>(mesh->geometry);
+	m_hub.destroy<Mesh>(mesh_hnd);
+}
+
+
 RenderProgramSet RenderForge::get_render_programs() const
 {
 	return RenderProgramSet {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include "sokol_gfx.h"
 
 #include "render_hub.hpp"
@@ -12,6 +14,7 @@
 #include "fx_data.hpp"
 #include "editor_data.hpp"
 #include "handle_resolver.hpp"
+#include "scheduler.hpp"
 
 
 namespace hpr::rdr {
@@ -31,6 +34,10 @@ public:
 
 	scn::ScenePrimitive create_scene_primitive(res::ImportPrimitive& import_primitive);
 
+	// NOTE: picking bvhs for the geometry of the given primitives, geometry that has one is skipped
+
+	void build_triangle_bvhs(job::Scheduler& job_scheduler, std::span<const scn::ScenePrimitive> scene_primitives);
+
 	RenderProgramSet get_render_programs() const;
 
 	// TODO: reassess the shader-pipeline flow to the rendering subsystems
@@ -78,11 +85,16 @@ public:
 		uint32_t                   idx_count
 	);
 
+	void destroy_dynamic_mesh(Handle<Mesh> mesh_hnd);
+
 	Handle<TileStyle> create_tile_style();
 
 	Handle<Mesh> quad() const
 	{ return m_quad; }
 
+	Handle<MaterialInstance> default_material() const
+	{ return m_default_material_instance; }
+
 private:
 
 	void init_scene_pipeline();
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <limits>
+#include <cstdint>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "math.hpp"
+#include "tile_data.hpp"
+#include "frustum_cull.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::rdr {
+
+
+namespace cfg {
+
+inline constexpr int32_t tile_cull_region_shift = 3;
+
+} // hpr::rdr::cfg
+
+
+// NOTE: storey -> region of 8x8 chunks -> chunk. a storey out of the storey range or the
+//       frustum is rejected with one test, a region out of the frustum with one test and a
+//       region inside the frustum is taken whole. chunks are tested in lane batches only
+//       in regions the frustum cuts through. region and storey bounds only ever grow
+
+class TileChunkCullTree
+{
+public:
+
+	void clear()
+	{
+		m_storeys.clear();
+		m_regions.clear();
+		m_locations.clear();
+		m_region_index.clear();
+		m_visible_regions.clear();
+	}
+
+
+	[[nodiscard]] uint32_t size() const
+	{
+		return static_cast<uint32_t>(m_locations.size());
+	}
+
+
+	void insert(uint32_t drawable_idx, const scn::TileChunkCoord& coord, const vec3& center, const vec3& half)
+	{
+		HPR_ASSERT_MSG(drawable_idx == m_locations.size(), "[tile chunk cull] drawables are inserted in order");
+
+		const uint32_t region_idx = find_or_add_region(coord);
+
+		Region& region = m_regions[region_idx];
+
+		const uint32_t local_idx = region.chunk_bounds.push(center, half);
+		region.drawable_indices.emplace_back(drawable_idx);
+
+		m_locations.emplace_back(Location {
+			.region_idx = region_idx,
+			.local_idx  = local_idx
+		});
+
+		grow_region(region_idx, center, half);
+	}
+
+
+	// NOTE: also puts a removed drawable back into its region
+
+	void update(uint32_t drawable_idx, const vec3& center, const vec3& half)
+	{
+		HPR_ASSERT_MSG(drawable_idx < m_locations.size(), "[tile chunk cull] drawable index out of range");
+
+		Location& location = m_locations[drawable_idx];
+		Region&   region   = m_regions[location.region_idx];
+
+		if (location.local_idx == k_removed) {
+			location.local_idx = region.chunk_bounds.push(center, half);
+			region.drawable_indices.emplace_back(drawable_idx);
+		}
+		else {
+			region.chunk_bounds.set(location.local_idx, center, half);
+		}
+
+		grow_region(location.region_idx, center, half);
+	}
+
+
+	// NOTE: takes the drawable out of its region so gather() no longer returns it, the
+	//       drawable index stays reserved. region and storey bounds keep their size
+
+	void remove(uint32_t drawable_idx)
+	{
+		HPR_ASSERT_MSG(drawable_idx < m_locations.size(), "[tile chunk cull] drawable index out of range");
+
+		Location& location = m_locations[drawable_idx];
+
+		if (location.local_idx == k_removed)
+			return;
+
+		Region& region = m_regions[location.region_idx];
+
+		const uint32_t last_local   = region.chunk_bounds.size() - 1;
+		const uint32_t moved_idx    = region.drawable_indices[last_local];
+		const uint32_t removed_slot = location.local_idx;
+
+		region.chunk_bounds.swap_remove(removed_slot);
+
+		region.drawable_indices[removed_slot] = moved_idx;
+		region.drawable_indices.pop_back();
+
+		m_locations[moved_idx].local_idx = removed_slot;
+		location.local_idx               = k_removed;
+	}
+
+
+	[[nodiscard]] bool contains(uint32_t drawable_idx) const
+	{
+		return drawable_idx < m_locations.size() && m_locations[drawable_idx].local_idx != k_removed;
+	}
+
+
+	// NOTE: appends the drawable indices that pass the storey range and the frustum
+
+	void gather(
+		const CullFrustum&                      frustum,
+		int32_t                                 storey_min,
+		int32_t                                 storey_max,
+		mtp::vault<uint32_t, mtp::default_set>& visible_indices
+	)
+	{
+		for (const Storey& storey : m_storeys) {
+
+			if (storey.storey_index < storey_min || storey.storey_index > storey_max)
+				continue;
+
+			const vec3 storey_center = (storey.bounds_min + storey.bounds_max) * 0.5f;
+			const vec3 storey_half   = (storey.bounds_max - storey.bounds_min) * 0.5f;
+
+			if (frustum.is_culled(storey_center, storey_half))
+				continue;
+
+			if (frustum.is_contained(storey_center, storey_half)) {
+				for (const uint32_t region_idx : storey.region_indices)
+					append_region(m_regions[region_idx], visible_indices);
+				continue;
+			}
+
+			const uint32_t region_count = storey.region_bounds.size();
+
+			m_visible_regions.resize(region_count);
+
+			const uint32_t visible_region_count = cull_frustum(
+				frustum,
+				storey.region_bounds,
+				0,
+				region_count,
+				m_visible_regions.data()
+			);
+
+			for (uint32_t visible_idx = 0; visible_idx < visible_region_count; ++visible_idx) {
+
+				const Region& region = m_regions[storey.region_indices[m_visible_regions[visible_idx]]];
+
+				const vec3 region_center = (region.bounds_min + region.bounds_max) * 0.5f;
+				const vec3 region_half   = (region.bounds_max - region.bounds_min) * 0.5f;
+
+				if (frustum.is_contained(region_center, region_half)) {
+					append_region(region, visible_indices);
+					continue;
+				}
+
+				const uint32_t chunk_count = region.chunk_bounds.size();
+				const uint32_t base        = static_cast<uint32_t>(visible_indices.size());
+
+				visible_indices.resize(base + chunk_count);
+
+				const uint32_t visible_chunk_count = cull_frustum(
+					frustum,
+					region.chunk_bounds,
+					0,
+					chunk_count,
+					visible_indices.data() + base
+				);
+
+				for (uint32_t chunk_idx = base; chunk_idx < base + visible_chunk_count; ++chunk_idx)
+					visible_indices[chunk_idx] = region.drawable_indices[visible_indices[chunk_idx]];
+
+				visible_indices.resize(base + visible_chunk_count);
+			}
+		}
+	}
+
+private:
+
+	static constexpr uint32_t k_removed = 0xFFFFFFFFU;
+
+	struct Region
+	{
+		CullBoundSet chunk_bounds;
+
+		mtp::vault<uint32_t, mtp::default_set> drawable_indices;
+
+		vec3 bounds_min {std::numeric_limits<float>::max()};
+		vec3 bounds_max {std::numeric_limits<float>::lowest()};
+
+		uint32_t storey_idx;
+		uint32_t storey_slot;
+	};
+
+
+	struct Storey
+	{
+		CullBoundSet region_bounds;
+
+		mtp::vault<uint32_t, mtp::default_set> region_indices;
+
+		vec3 bounds_min {std::numeric_limits<float>::max()};
+		vec3 bounds_max {std::numeric_limits<float>::lowest()};
+
+		int32_t storey_stack;
+		int32_t storey_index;
+	};
+
+
+	struct Location
+	{
+		uint32_t region_idx;
+		uint32_t local_idx;
+	};
+
+private:
+
+	// NOTE: 16 bits per field, regions are 8 chunks wide so coords stay exact well past any map size
+
+	[[nodiscard]] static uint64_t region_key(const scn::TileChunkCoord& coord)
+	{
+		const uint64_t stack    = static_cast<uint16_t>(coord.storey_stack);
+		const uint64_t storey   = static_cast<uint16_t>(coord.storey_index);
+		const uint64_t region_x = static_cast<uint16_t>(coord.chunk_x >> cfg::tile_cull_region_shift);
+		const uint64_t region_z = static_cast<uint16_t>(coord.chunk_z >> cfg::tile_cull_region_shift);
+
+		return (stack << 48) | (storey << 32) | (region_x << 16) | region_z;
+	}
+
+
+	[[nodiscard]] uint32_t find_or_add_storey(int32_t storey_stack, int32_t storey_index)
+	{
+		for (uint32_t storey_idx = 0; storey_idx < m_storeys.size(); ++storey_idx) {
+
+			const Storey& storey = m_storeys[storey_idx];
+
+			if (storey.storey_stack == storey_stack && storey.storey_index == storey_index)
+				return storey_idx;
+		}
+
+		Storey& storey = m_storeys.emplace_back();
+
+		storey.storey_stack = storey_stack;
+		storey.storey_index = storey_index;
+
+		return static_cast<uint32_t>(m_storeys.size() - 1);
+	}
+
+
+	[[nodiscard]] uint32_t find_or_add_region(const scn::TileChunkCoord& coord)
+	{
+		const uint64_t key = region_key(coord);
+
+		const uint32_t found_idx = m_region_index.find(key);
+		if (found_idx != scn::ChunkDirectory::k_empty_slot)
+			return found_idx;
+
+		const uint32_t storey_idx = find_or_add_storey(coord.storey_stack, coord.storey_index);
+		const uint32_t region_idx = static_cast<uint32_t>(m_regions.size());
+
+		Storey& storey = m_storeys[storey_idx];
+
+		Region& region = m_regions.emplace_back();
+
+		region.storey_idx  = storey_idx;
+		region.storey_slot = storey.region_bounds.push(vec3 {0.0f}, vec3 {0.0f});
+
+		storey.region_indices.emplace_back(region_idx);
+
+		m_region_index.insert(key, region_idx);
+
+		return region_idx;
+	}
+
+
+	void grow_region(uint32_t region_idx, const vec3& center, const vec3& half)
+	{
+		Region& region = m_regions[region_idx];
+		Storey& storey = m_storeys[region.storey_idx];
+
+		region.bounds_min = glm::min(region.bounds_min, center - half);
+		region.bounds_max = glm::max(region.bounds_max, center + half);
+
+		storey.region_bounds.set(
+			region.storey_slot,
+			(region.bounds_min + region.bounds_max) * 0.5f,
+			(region.bounds_max - region.bounds_min) * 0.5f
+		);
+
+		storey.bounds_min = glm::min(storey.bounds_min, region.bounds_min);
+		storey.bounds_max = glm::max(storey.bounds_max, region.bounds_max);
+	}
+
+
+	static void append_region(const Region& region, mtp::vault<uint32_t, mtp::default_set>& visible_indices)
+	{
+		for (const uint32_t drawable_idx : region.drawable_indices)
+			visible_indices.emplace_back(drawable_idx);
+	}
+
+private:
+
+	mtp::vault<Storey, mtp::default_set>   m_storeys;
+	mtp::vault<Region, mtp::default_set>   m_regions;
+	mtp::vault<Location, mtp::default_set> m_locations;
+
+	scn::ChunkDirectory m_region_index;
+
+	mtp::vault<uint32_t, mtp::default_set> m_visible_regions;
+};
+
+
+} // hpr::rdr
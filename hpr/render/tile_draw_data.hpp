@@ -7,6 +7,8 @@
 #include "math.hpp"
 #include "tile_data.hpp"
 #include "render_data.hpp"
+#include "tile_chunk_cull.hpp"
+#include "chunk_directory.hpp"
 
 
 namespace hpr::rdr {
@@ -38,13 +40,27 @@ struct TileChunkDrawable
 
 	uint64_t coord_hash;
 
-	bool dirty {true};
+	bool dirty   {true};
+	bool visible {false};
 };
 
 
+// NOTE: dirty drawables are queued once and stay queued until uploaded,
+//       culled or out of storey range chunks keep their place in the queue.
+//       cull_tree holds the bounds of drawables[i] under drawable index i
+
 struct TileChunkDrawableSet
 {
+	static constexpr uint32_t k_default_upload_budget = 256U * 1024U;
+
 	mtp::vault<TileChunkDrawable, mtp::default_set> drawables;
+	mtp::vault<uint32_t, mtp::default_set>          dirty_queue;
+
+	TileChunkCullTree cull_tree;
+
+	scn::ChunkDirectory index;
+
+	uint32_t upload_budget_bytes {k_default_upload_budget};
 
 	bool enabled {true};
 
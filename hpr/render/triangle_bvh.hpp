@@ -0,0 +1,693 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <array>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "mtp_memory.hpp"
+#include "panic.hpp"
+
+#include "math.hpp"
+
+
+namespace hpr::rdr {
+
+namespace cfg {
+
+inline constexpr uint32_t triangle_bvh_bin_count    = 16U;
+inline constexpr uint32_t triangle_bvh_leaf_size    = 2U;
+inline constexpr uint32_t triangle_bvh_max_leaf     = 8U;
+inline constexpr uint32_t triangle_bvh_median_depth = 40U;
+inline constexpr uint32_t triangle_bvh_stack_size   = 96U;
+inline constexpr uint32_t triangle_bvh_subtree_size = 16384U;
+
+inline constexpr float    triangle_bvh_node_cost    = 1.0f;
+
+} // hpr::rdr::cfg
+
+
+// NOTE: strided view of an indexed triangle list, positions stay in the interleaved vertex bytes
+
+struct TriangleSource
+{
+	const uint8_t*  position_bytes;
+	uint32_t        position_stride;
+	uint32_t        vertex_count;
+	const uint32_t* indices;
+	uint32_t        triangle_count;
+
+	[[nodiscard]] vec3 position(uint32_t triangle, uint32_t corner) const
+	{
+		vec3 pos;
+		std::memcpy(&pos, position_bytes + static_cast<size_t>(position_stride) * indices[triangle * 3 + corner], sizeof(vec3));
+		return pos;
+	}
+};
+
+
+// NOTE: internal nodes keep their two children next to each other at first, leaves have
+//       count triangles starting at first in the triangle order
+
+struct TriangleBvhNode
+{
+	vec3     aabb_min;
+	uint32_t first;
+	vec3     aabb_max;
+	uint32_t count;
+};
+
+
+// NOTE: local space triangle bvh of one submesh geometry, binned sah with small leaves.
+//       build() runs in one go, begin_build() instead splits the top levels and leaves
+//       subtrees that build_subtree() fills independently, so jobs can share one big mesh.
+//       finish_build() splices them and drops the build scratch
+
+class TriangleBvh
+{
+public:
+
+	void clear()
+	{
+		m_nodes.clear();
+		m_triangles.clear();
+		release_scratch();
+	}
+
+
+	[[nodiscard]] bool empty() const
+	{
+		return m_nodes.empty();
+	}
+
+
+	[[nodiscard]] uint32_t node_count() const
+	{
+		return static_cast<uint32_t>(m_nodes.size());
+	}
+
+
+	[[nodiscard]] uint32_t triangle_count() const
+	{
+		return static_cast<uint32_t>(m_triangles.size());
+	}
+
+
+	[[nodiscard]] size_t memory_bytes() const
+	{
+		return m_nodes.size() * sizeof(TriangleBvhNode) + m_triangles.size() * sizeof(uint32_t);
+	}
+
+
+	void build(const TriangleSource& source)
+	{
+		const uint32_t subtree_count = begin_build(source, std::numeric_limits<uint32_t>::max());
+
+		for (uint32_t subtree_idx = 0; subtree_idx < subtree_count; ++subtree_idx)
+			build_subtree(subtree_idx);
+
+		finish_build();
+	}
+
+
+	// NOTE: returns the subtree count, triangles with indices past vertex_count are left out
+
+	uint32_t begin_build(const TriangleSource& source, uint32_t subtree_size)
+	{
+		clear();
+
+		for (uint32_t triangle = 0; triangle < source.triangle_count; ++triangle) {
+
+			const uint32_t* corners = source.indices + triangle * 3;
+
+			if (corners[0] >= source.vertex_count || corners[1] >= source.vertex_count || corners[2] >= source.vertex_count)
+				continue;
+
+			const vec3 pos_0 = source.position(triangle, 0);
+			const vec3 pos_1 = source.position(triangle, 1);
+			const vec3 pos_2 = source.position(triangle, 2);
+
+			m_refs.emplace_back(BuildRef {
+				.aabb_min = glm::min(pos_0, glm::min(pos_1, pos_2)),
+				.triangle = triangle,
+				.aabb_max = glm::max(pos_0, glm::max(pos_1, pos_2))
+			});
+		}
+
+		if (m_refs.empty()) {
+			release_scratch();
+			return 0;
+		}
+
+		m_nodes.emplace_back();
+
+		build_range(
+			BuildTask {.node = 0, .ref_beg = 0, .ref_end = static_cast<uint32_t>(m_refs.size()), .depth = 0},
+			m_nodes,
+			m_tasks,
+			subtree_size
+		);
+
+		m_subtrees.resize(m_deferred.size());
+
+		return static_cast<uint32_t>(m_deferred.size());
+	}
+
+
+	void build_subtree(uint32_t subtree_idx)
+	{
+		Subtree& subtree = m_subtrees[subtree_idx];
+
+		BuildTask root = m_deferred[subtree_idx];
+		root.node = 0;
+
+		subtree.nodes.clear();
+		subtree.nodes.emplace_back();
+
+		build_range(root, subtree.nodes, subtree.tasks, 0);
+	}
+
+
+	void finish_build()
+	{
+		for (uint32_t subtree_idx = 0; subtree_idx < m_deferred.size(); ++subtree_idx) {
+
+			const auto& local_nodes = m_subtrees[subtree_idx].nodes;
+
+			// NOTE: local node 0 replaces the deferred node, the rest are appended after base
+
+			const uint32_t base = static_cast<uint32_t>(m_nodes.size()) - 1;
+
+			for (uint32_t local_idx = 0; local_idx < local_nodes.size(); ++local_idx) {
+
+				TriangleBvhNode node = local_nodes[local_idx];
+
+				if (node.count == 0)
+					node.first += base;
+
+				if (local_idx == 0)
+					m_nodes[m_deferred[subtree_idx].node] = node;
+				else
+					m_nodes.emplace_back(node);
+			}
+		}
+
+		m_triangles.resize(m_refs.size());
+
+		for (uint32_t ref_idx = 0; ref_idx < m_refs.size(); ++ref_idx)
+			m_triangles[ref_idx] = m_refs[ref_idx].triangle;
+
+		release_scratch();
+	}
+
+
+	// NOTE: front to back, hit_fn(triangle) returns the closest hit so far and prunes every
+	//       node entered behind it. triangle is the index in the source triangle list
+
+	template <typename HitFn>
+	void raycast(const vec3& origin, const vec3& direction, float max_distance, HitFn&& hit_fn) const
+	{
+		if (m_nodes.empty())
+			return;
+
+		const vec3 inv_direction = 1.0f / direction;
+
+		std::array<uint32_t, cfg::triangle_bvh_stack_size> stack_nodes;
+		std::array<float,    cfg::triangle_bvh_stack_size> stack_entries;
+
+		float entry = 0.0f;
+
+		if (!intersect_slab(origin, inv_direction, m_nodes[0], max_distance, entry))
+			return;
+
+		stack_nodes[0]   = 0;
+		stack_entries[0] = entry;
+
+		uint32_t stack_size = 1;
+
+		while (stack_size > 0) {
+
+			--stack_size;
+
+			if (stack_entries[stack_size] > max_distance)
+				continue;
+
+			const TriangleBvhNode& node = m_nodes[stack_nodes[stack_size]];
+
+			if (node.count > 0) {
+
+				for (uint32_t tri_idx = node.first; tri_idx < node.first + node.count; ++tri_idx)
+					max_distance = std::min(max_distance, hit_fn(m_triangles[tri_idx]));
+
+				continue;
+			}
+
+			float lhs_entry = 0.0f;
+			float rhs_entry = 0.0f;
+
+			const bool lhs_hit = intersect_slab(origin, inv_direction, m_nodes[node.first],     max_distance, lhs_entry);
+			const bool rhs_hit = intersect_slab(origin, inv_direction, m_nodes[node.first + 1], max_distance, rhs_entry);
+
+			HPR_ASSERT_MSG(stack_size + 2 <= stack_nodes.size(), "[triangle bvh] traversal stack overflow");
+
+			if (lhs_hit && rhs_hit) {
+
+				const bool lhs_first = lhs_entry <= rhs_entry;
+
+				stack_nodes[stack_size]   = lhs_first ? node.first + 1 : node.first;
+				stack_entries[stack_size] = lhs_first ? rhs_entry : lhs_entry;
+				++stack_size;
+
+				stack_nodes[stack_size]   = lhs_first ? node.first : node.first + 1;
+				stack_entries[stack_size] = lhs_first ? lhs_entry : rhs_entry;
+				++stack_size;
+			}
+			else if (lhs_hit || rhs_hit) {
+
+				stack_nodes[stack_size]   = lhs_hit ? node.first : node.first + 1;
+				stack_entries[stack_size] = lhs_hit ? lhs_entry : rhs_entry;
+				++stack_size;
+			}
+		}
+	}
+
+	// NOTE: one traversal for a packet of up to 32 coherent rays, hit_fn(triangle, ray_mask)
+	//       gets the rays whose current max distance still reaches the leaf and shortens
+	//       max_distances as it finds hits
+
+	template <typename HitFn>
+	void raycast_packet(
+		std::span<const vec3>  origins,
+		std::span<const vec3>  directions,
+		std::span<const float> max_distances,
+		uint32_t               ray_mask,
+		HitFn&&                hit_fn
+	) const
+	{
+		const uint32_t ray_count = static_cast<uint32_t>(origins.size());
+
+		HPR_ASSERT_MSG(ray_count <= k_packet_capacity, "[triangle bvh] ray packet too large");
+		HPR_ASSERT_MSG(directions.size() >= ray_count && max_distances.size() >= ray_count, "[triangle bvh] ray packet spans differ");
+		HPR_ASSERT_MSG(ray_count == k_packet_capacity || (ray_mask >> ray_count) == 0, "[triangle bvh] ray mask past packet");
+
+		if (m_nodes.empty() || ray_mask == 0)
+			return;
+
+		std::array<vec3, k_packet_capacity> inv_directions;
+
+		for (uint32_t rays = ray_mask; rays != 0; rays &= rays - 1) {
+			const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+			inv_directions[ray] = 1.0f / directions[ray];
+		}
+
+		const PacketView packet {
+			.origins        = origins.data(),
+			.inv_directions = inv_directions.data(),
+			.max_distances  = max_distances.data()
+		};
+
+		float entry = 0.0f;
+
+		const uint32_t root_mask = intersect_packet(packet, ray_mask, m_nodes[0], entry);
+		if (root_mask == 0)
+			return;
+
+		std::array<uint32_t, cfg::triangle_bvh_stack_size> stack_nodes;
+		std::array<uint32_t, cfg::triangle_bvh_stack_size> stack_masks;
+
+		stack_nodes[0] = 0;
+		stack_masks[0] = root_mask;
+
+		uint32_t stack_size = 1;
+
+		while (stack_size > 0) {
+
+			--stack_size;
+
+			const TriangleBvhNode& node = m_nodes[stack_nodes[stack_size]];
+			const uint32_t         mask = stack_masks[stack_size];
+
+			if (node.count > 0) {
+
+				const uint32_t leaf_mask = intersect_packet(packet, mask, node, entry);
+
+				for (uint32_t tri_idx = node.first; leaf_mask != 0 && tri_idx < node.first + node.count; ++tri_idx)
+					hit_fn(m_triangles[tri_idx], leaf_mask);
+
+				continue;
+			}
+
+			float lhs_entry = 0.0f;
+			float rhs_entry = 0.0f;
+
+			const uint32_t lhs_mask = intersect_packet(packet, mask, m_nodes[node.first],     lhs_entry);
+			const uint32_t rhs_mask = intersect_packet(packet, mask, m_nodes[node.first + 1], rhs_entry);
+
+			HPR_ASSERT_MSG(stack_size + 2 <= stack_nodes.size(), "[triangle bvh] traversal stack overflow");
+
+			const bool lhs_first = lhs_entry <= rhs_entry;
+
+			if (lhs_mask != 0 && rhs_mask != 0) {
+				stack_nodes[stack_size] = lhs_first ? node.first + 1 : node.first;
+				stack_masks[stack_size] = lhs_first ? rhs_mask : lhs_mask;
+				++stack_size;
+
+				stack_nodes[stack_size] = lhs_first ? node.first : node.first + 1;
+				stack_masks[stack_size] = lhs_first ? lhs_mask : rhs_mask;
+				++stack_size;
+			}
+			else if (lhs_mask != 0 || rhs_mask != 0) {
+				stack_nodes[stack_size] = lhs_mask != 0 ? node.first : node.first + 1;
+				stack_masks[stack_size] = lhs_mask | rhs_mask;
+				++stack_size;
+			}
+		}
+	}
+
+private:
+
+	static constexpr uint32_t k_leaf_split      = 0xFFFFFFFFU;
+	static constexpr uint32_t k_packet_capacity = 32U;
+
+
+	struct PacketView
+	{
+		const vec3*  origins;
+		const vec3*  inv_directions;
+		const float* max_distances;
+	};
+
+
+	struct BuildTask
+	{
+		uint32_t node;
+		uint32_t ref_beg;
+		uint32_t ref_end;
+		uint32_t depth;
+	};
+
+
+	// NOTE: triangle bounds travel with the id so partitioning stays sequential in memory
+
+	struct BuildRef
+	{
+		vec3     aabb_min;
+		uint32_t triangle;
+		vec3     aabb_max;
+	};
+
+
+	struct Subtree
+	{
+		mtp::vault<TriangleBvhNode, mtp::default_set> nodes;
+		mtp::vault<BuildTask,       mtp::default_set> tasks;
+	};
+
+
+	[[nodiscard]] static float area(const vec3& aabb_min, const vec3& aabb_max)
+	{
+		const vec3 extent = aabb_max - aabb_min;
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+
+	// NOTE: nan from a zero direction on a slab border drops out of the min and max
+
+	[[nodiscard]] static bool intersect_slab(
+		const vec3&            origin,
+		const vec3&            inv_direction,
+		const TriangleBvhNode& node,
+		float                  max_distance,
+		float&                 entry_distance
+	)
+	{
+		float entry = 0.0f;
+		float exit  = max_distance;
+
+		for (int axis = 0; axis < 3; ++axis) {
+
+			const float slab_near = (node.aabb_min[axis] - origin[axis]) * inv_direction[axis];
+			const float slab_far  = (node.aabb_max[axis] - origin[axis]) * inv_direction[axis];
+
+			entry = std::max(entry, std::min(slab_near, slab_far));
+			exit  = std::min(exit,  std::max(slab_near, slab_far));
+		}
+
+		entry_distance = entry;
+		return entry <= exit;
+	}
+
+
+	// NOTE: returns the rays of ray_mask that hit the node, entry_distance is the nearest entry
+
+	[[nodiscard]] static uint32_t intersect_packet(
+		const PacketView&      packet,
+		uint32_t               ray_mask,
+		const TriangleBvhNode& node,
+		float&                 entry_distance
+	)
+	{
+		uint32_t hit_mask = 0;
+
+		entry_distance = std::numeric_limits<float>::infinity();
+
+		for (uint32_t rays = ray_mask; rays != 0; rays &= rays - 1) {
+
+			const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+
+			float entry = 0.0f;
+
+			if (intersect_slab(packet.origins[ray], packet.inv_directions[ray], node, packet.max_distances[ray], entry)) {
+				hit_mask      |= 1U << ray;
+				entry_distance = std::min(entry_distance, entry);
+			}
+		}
+
+		return hit_mask;
+	}
+
+
+	void release_scratch()
+	{
+		mtp::vault<BuildRef, mtp::default_set> {}.swap(m_refs);
+
+		mtp::vault<BuildTask, mtp::default_set> {}.swap(m_tasks);
+		mtp::vault<BuildTask, mtp::default_set> {}.swap(m_deferred);
+		mtp::vault<Subtree,   mtp::default_set> {}.swap(m_subtrees);
+	}
+
+
+	// NOTE: ranges of at most defer_size triangles go to m_deferred instead of being split,
+	//       a defer_size of 0 builds everything. touches only its own triangle range, so
+	//       subtrees can run on different threads
+
+	void build_range(
+		BuildTask                                      root,
+		mtp::vault<TriangleBvhNode, mtp::default_set>& nodes,
+		mtp::vault<BuildTask,       mtp::default_set>& tasks,
+		uint32_t                                       defer_size
+	)
+	{
+		tasks.clear();
+		tasks.emplace_back(root);
+
+		while (!tasks.empty()) {
+
+			const BuildTask task = tasks.back();
+			tasks.pop_back();
+
+			vec3 bounds_min   {std::numeric_limits<float>::max()};
+			vec3 bounds_max   {std::numeric_limits<float>::lowest()};
+			vec3 centroid_min {std::numeric_limits<float>::max()};
+			vec3 centroid_max {std::numeric_limits<float>::lowest()};
+
+			for (uint32_t ref_idx = task.ref_beg; ref_idx < task.ref_end; ++ref_idx) {
+
+				const BuildRef& ref      = m_refs[ref_idx];
+				const vec3      centroid = (ref.aabb_min + ref.aabb_max) * 0.5f;
+
+				bounds_min   = glm::min(bounds_min, ref.aabb_min);
+				bounds_max   = glm::max(bounds_max, ref.aabb_max);
+				centroid_min = glm::min(centroid_min, centroid);
+				centroid_max = glm::max(centroid_max, centroid);
+			}
+
+			const uint32_t ref_count = task.ref_end - task.ref_beg;
+
+			nodes[task.node].aabb_min = bounds_min;
+			nodes[task.node].aabb_max = bounds_max;
+			nodes[task.node].first    = task.ref_beg;
+			nodes[task.node].count    = ref_count;
+
+			if (ref_count <= cfg::triangle_bvh_leaf_size)
+				continue;
+
+			if (ref_count <= defer_size) {
+				m_deferred.emplace_back(task);
+				continue;
+			}
+
+			const uint32_t ref_mid = split(task, bounds_min, bounds_max, centroid_min, centroid_max);
+
+			if (ref_mid == k_leaf_split)
+				continue;
+
+			const uint32_t lhs = static_cast<uint32_t>(nodes.size());
+
+			nodes.emplace_back();
+			nodes.emplace_back();
+
+			nodes[task.node].first = lhs;
+			nodes[task.node].count = 0;
+
+			tasks.emplace_back(BuildTask {.node = lhs + 1, .ref_beg = ref_mid,      .ref_end = task.ref_end, .depth = task.depth + 1});
+			tasks.emplace_back(BuildTask {.node = lhs,     .ref_beg = task.ref_beg, .ref_end = ref_mid,      .depth = task.depth + 1});
+		}
+	}
+
+
+	[[nodiscard]] static uint32_t bin_index(const BuildRef& ref, int axis, float centroid_min, float bin_scale)
+	{
+		const float bin = ((ref.aabb_min[axis] + ref.aabb_max[axis]) * 0.5f - centroid_min) * bin_scale;
+		return std::min(static_cast<uint32_t>(std::max(bin, 0.0f)), cfg::triangle_bvh_bin_count - 1);
+	}
+
+
+	// NOTE: binned sah along the widest centroid axis, k_leaf_split when a small range is
+	//       cheaper as a leaf. past median_depth the split falls back to the centroid median
+
+	uint32_t split(
+		const BuildTask& task,
+		const vec3&      bounds_min,
+		const vec3&      bounds_max,
+		const vec3&      centroid_min,
+		const vec3&      centroid_max
+	)
+	{
+		constexpr uint32_t bin_count = cfg::triangle_bvh_bin_count;
+
+		const uint32_t ref_count = task.ref_end - task.ref_beg;
+		const uint32_t ref_mid   = task.ref_beg + ref_count / 2;
+
+		const vec3 extent = centroid_max - centroid_min;
+
+		const int widest_axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+		if (extent[widest_axis] <= 0.0f)
+			return ref_count <= cfg::triangle_bvh_max_leaf ? k_leaf_split : ref_mid;
+
+		uint32_t best_bin  = 0;
+		float    best_cost = std::numeric_limits<float>::max();
+
+		if (task.depth < cfg::triangle_bvh_median_depth) {
+
+			const float bin_scale = static_cast<float>(bin_count) / extent[widest_axis];
+
+			std::array<vec3,     bin_count> bin_min;
+			std::array<vec3,     bin_count> bin_max;
+			std::array<uint32_t, bin_count> bin_counts {};
+
+			bin_min.fill(vec3 {std::numeric_limits<float>::max()});
+			bin_max.fill(vec3 {std::numeric_limits<float>::lowest()});
+
+			for (uint32_t ref_idx = task.ref_beg; ref_idx < task.ref_end; ++ref_idx) {
+
+				const BuildRef& ref = m_refs[ref_idx];
+				const uint32_t  bin = bin_index(ref, widest_axis, centroid_min[widest_axis], bin_scale);
+
+				bin_min[bin] = glm::min(bin_min[bin], ref.aabb_min);
+				bin_max[bin] = glm::max(bin_max[bin], ref.aabb_max);
+				++bin_counts[bin];
+			}
+
+			std::array<float, bin_count> lhs_costs {};
+
+			vec3     sweep_min   {std::numeric_limits<float>::max()};
+			vec3     sweep_max   {std::numeric_limits<float>::lowest()};
+			uint32_t sweep_count {0};
+
+			for (uint32_t bin = 0; bin + 1 < bin_count; ++bin) {
+
+				sweep_min    = glm::min(sweep_min, bin_min[bin]);
+				sweep_max    = glm::max(sweep_max, bin_max[bin]);
+				sweep_count += bin_counts[bin];
+
+				lhs_costs[bin] = sweep_count > 0 ? area(sweep_min, sweep_max) * static_cast<float>(sweep_count) : 0.0f;
+			}
+
+			sweep_min   = vec3 {std::numeric_limits<float>::max()};
+			sweep_max   = vec3 {std::numeric_limits<float>::lowest()};
+			sweep_count = 0;
+
+			for (uint32_t bin = bin_count - 1; bin > 0; --bin) {
+
+				sweep_min    = glm::min(sweep_min, bin_min[bin]);
+				sweep_max    = glm::max(sweep_max, bin_max[bin]);
+				sweep_count += bin_counts[bin];
+
+				if (sweep_count == 0 || sweep_count == ref_count)
+					continue;
+
+				const float cost = lhs_costs[bin - 1] + area(sweep_min, sweep_max) * static_cast<float>(sweep_count);
+
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_bin  = bin - 1;
+				}
+			}
+		}
+
+		if (best_cost < std::numeric_limits<float>::max()) {
+
+			const float node_area  = area(bounds_min, bounds_max);
+			const float split_cost = node_area > 0.0f
+				? cfg::triangle_bvh_node_cost + best_cost / node_area
+				: static_cast<float>(ref_count);
+
+			if (ref_count <= cfg::triangle_bvh_max_leaf && static_cast<float>(ref_count) <= split_cost)
+				return k_leaf_split;
+
+			const float bin_scale = static_cast<float>(bin_count) / extent[widest_axis];
+
+			const BuildRef* partition_end = std::partition(
+				m_refs.data() + task.ref_beg,
+				m_refs.data() + task.ref_end,
+				[&centroid_min, widest_axis, best_bin, bin_scale](const BuildRef& ref) {
+					return bin_index(ref, widest_axis, centroid_min[widest_axis], bin_scale) <= best_bin;
+				}
+			);
+
+			const uint32_t partition_mid = static_cast<uint32_t>(partition_end - m_refs.data());
+
+			if (partition_mid > task.ref_beg && partition_mid < task.ref_end)
+				return partition_mid;
+		}
+
+		std::nth_element(
+			m_refs.data() + task.ref_beg,
+			m_refs.data() + ref_mid,
+			m_refs.data() + task.ref_end,
+			[widest_axis](const BuildRef& lhs, const BuildRef& rhs) {
+				return lhs.aabb_min[widest_axis] + lhs.aabb_max[widest_axis] < rhs.aabb_min[widest_axis] + rhs.aabb_max[widest_axis];
+			}
+		);
+
+		return ref_mid;
+	}
+
+private:
+
+	mtp::vault<TriangleBvhNode, mtp::default_set> m_nodes;
+	mtp::vault<uint32_t,        mtp::default_set> m_triangles;
+
+	mtp::vault<BuildRef,  mtp::default_set> m_refs;
+	mtp::vault<BuildTask, mtp::default_set> m_tasks;
+	mtp::vault<BuildTask, mtp::default_set> m_deferred;
+	mtp::vault<Subtree,   mtp::default_set> m_subtrees;
+};
+
+
+} // hpr::rdr
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mtp_memory.hpp"
+
+#include "math.hpp"
+#include "voxel_data.hpp"
+#include "render_data.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::rdr {
+
+
+struct VoxelChunkDrawable
+{
+	Handle<Mesh> mesh;
+
+	scn::VoxelChunkCoord coord;
+
+	mat4 mtx_M;
+
+	vec3 bounds_center;
+	vec3 bounds_half;
+
+	uint64_t key;
+
+	uint32_t vtx_capacity {0};
+	uint32_t idx_capacity {0};
+	uint32_t idx_count    {0};
+
+	bool dirty {true};
+};
+
+
+// NOTE: dirty chunks are queued once, the layer remeshes a bounded number per frame
+
+struct VoxelChunkDrawableSet
+{
+	mtp::vault<VoxelChunkDrawable, mtp::default_set> drawables;
+	mtp::vault<uint32_t,           mtp::default_set> dirty_queue;
+
+	scn::ChunkDirectory index;
+
+	bool enabled {true};
+};
+
+
+} // hpr::rdr
@@ -44,7 +44,9 @@ public:
 		ecs::ModelComponent,
 		ecs::BoundComponent,
 		ecs::CameraComponent,
-		ecs::LightComponent
+		ecs::LightComponent,
+		ecs::CameraActiveTag,
+		ecs::LightEnabledTag
 	>;
 
 	Engine();
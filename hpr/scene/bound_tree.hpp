@@ -0,0 +1,1148 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <array>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "mtp_memory.hpp"
+#include "panic.hpp"
+
+#include "math.hpp"
+#include "entity.hpp"
+#include "ecs_registry.hpp"
+#include "components_render.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr uint32_t bound_tree_bin_count     = 12U;
+	inline constexpr uint32_t bound_tree_max_height    = 64U;
+	inline constexpr uint32_t bound_tree_median_depth  = 32U;
+
+	inline constexpr float    bound_tree_fat_ratio     = 0.125f;
+	inline constexpr float    bound_tree_fat_min       = 0.05f;
+	inline constexpr float    bound_tree_rebuild_ratio = 1.5f;
+
+} // hpr::scn::cfg
+
+
+// NOTE: leaves have height 0 and keep the entity in child[0]. node bounds are fattened so
+//       small moves only touch the entity slot, not the tree
+
+struct BoundTreeNode
+{
+	vec3     aabb_min;
+	uint32_t parent;
+	vec3     aabb_max;
+	uint32_t height;
+	uint32_t child [2];
+};
+
+
+// NOTE: indexed by entity, the exact world bounds the leaf tests use. live while the entity
+//       has both model and bound, queued while a hook change waits for the next sync
+
+struct BoundTreeSlot
+{
+	static constexpr uint32_t k_live   = 1U << 0;
+	static constexpr uint32_t k_queued = 1U << 1;
+
+	vec3     aabb_min {};
+	uint32_t leaf     {0xFFFFFFFFU};
+	vec3     aabb_max {};
+	uint32_t flags    {0};
+};
+
+
+// NOTE: dynamic aabb tree over the world bounds of pickable entities. attach() connects to
+//       the model and bound hooks, so only entities added, removed or moved since the last
+//       sync() are visited. moved entities that leave their fat bounds are reinserted with
+//       rotations along the refitted path. a binned sah build runs for bulk changes and
+//       whenever the incremental tree drifts too far from its built cost.
+//       queries are const and safe to run from jobs between syncs
+
+class BoundTree
+{
+public:
+
+	static constexpr uint32_t k_null = 0xFFFFFFFFU;
+
+	void clear()
+	{
+		m_nodes.clear();
+		m_free_nodes.clear();
+		m_slots.clear();
+		m_queued.clear();
+
+		m_root       = k_null;
+		m_leaf_count = 0;
+
+		m_area_sum   = 0.0;
+		m_built_cost = 0.0f;
+	}
+
+
+	// NOTE: hooks only see later changes, entities already in the registry are queued here
+
+	template <typename Registry>
+	void attach(Registry& registry)
+	{
+		registry.template connect<ecs::ModelComponent, &BoundTree::queue_entity>(ecs::HookEvent::add,    *this);
+		registry.template connect<ecs::ModelComponent, &BoundTree::queue_entity>(ecs::HookEvent::remove, *this);
+		registry.template connect<ecs::BoundComponent, &BoundTree::queue_entity>(ecs::HookEvent::add,    *this);
+		registry.template connect<ecs::BoundComponent, &BoundTree::queue_entity>(ecs::HookEvent::remove, *this);
+		registry.template connect<ecs::BoundComponent, &BoundTree::queue_entity>(ecs::HookEvent::update, *this);
+
+		registry.template scan<ecs::ModelComponent, ecs::BoundComponent>(
+			[this](ecs::Entity entity, const ecs::ModelComponent&, const ecs::BoundComponent&)
+			{
+				queue_entity(entity);
+			}
+		);
+	}
+
+
+	template <typename Registry>
+	void detach(Registry& registry)
+	{
+		registry.template disconnect<ecs::ModelComponent>(this);
+		registry.template disconnect<ecs::BoundComponent>(this);
+	}
+
+
+	template <typename Registry>
+	void sync(const Registry& registry)
+	{
+		m_inserted.clear();
+		m_moved.clear();
+
+		uint32_t removed_count = 0;
+
+		for (const ecs::Entity entity : m_queued) {
+
+			BoundTreeSlot& slot = m_slots[entity];
+
+			slot.flags &= ~BoundTreeSlot::k_queued;
+
+			const auto* model = registry.template get<ecs::ModelComponent>(entity);
+			const auto* bound = registry.template get<ecs::BoundComponent>(entity);
+
+			if (!model || !bound) {
+
+				if (slot.leaf != k_null) {
+					remove_leaf(slot.leaf);
+					free_node(slot.leaf);
+
+					slot.leaf = k_null;
+					--m_leaf_count;
+				}
+
+				slot.flags &= ~BoundTreeSlot::k_live;
+				++removed_count;
+				continue;
+			}
+
+			const vec3 aabb_min = bound->world_center - bound->world_half;
+			const vec3 aabb_max = bound->world_center + bound->world_half;
+
+			slot.flags |= BoundTreeSlot::k_live;
+
+			if (slot.leaf == k_null) {
+				slot.aabb_min = aabb_min;
+				slot.aabb_max = aabb_max;
+				m_inserted.emplace_back(entity);
+				continue;
+			}
+
+			if (slot.aabb_min == aabb_min && slot.aabb_max == aabb_max)
+				continue;
+
+			slot.aabb_min = aabb_min;
+			slot.aabb_max = aabb_max;
+
+			const BoundTreeNode& leaf = m_nodes[slot.leaf];
+
+			if (!contains(leaf.aabb_min, leaf.aabb_max, aabb_min, aabb_max))
+				m_moved.emplace_back(entity);
+		}
+
+		m_queued.clear();
+
+		const uint32_t inserted_count = static_cast<uint32_t>(m_inserted.size());
+		const uint32_t changed_count  = inserted_count + static_cast<uint32_t>(m_moved.size());
+
+		if (changed_count == 0 && removed_count == 0)
+			return;
+
+		if (changed_count * 4 > m_leaf_count + inserted_count) {
+			rebuild();
+			return;
+		}
+
+		for (const ecs::Entity entity : m_moved) {
+
+			const uint32_t leaf = m_slots[entity].leaf;
+
+			remove_leaf(leaf);
+			fatten(leaf, m_slots[entity]);
+			insert_leaf(leaf);
+		}
+
+		for (const ecs::Entity entity : m_inserted) {
+
+			const uint32_t leaf = alloc_node();
+
+			m_nodes[leaf].height   = 0;
+			m_nodes[leaf].child[0] = entity;
+			m_nodes[leaf].child[1] = k_null;
+
+			m_slots[entity].leaf = leaf;
+
+			fatten(leaf, m_slots[entity]);
+			insert_leaf(leaf);
+
+			++m_leaf_count;
+		}
+
+		if (m_root == k_null)
+			return;
+
+		if (m_nodes[m_root].height > cfg::bound_tree_max_height || sah_cost() > m_built_cost * cfg::bound_tree_rebuild_ratio)
+			rebuild();
+	}
+
+
+	[[nodiscard]] uint32_t leaf_count() const
+	{
+		return m_leaf_count;
+	}
+
+
+	[[nodiscard]] uint32_t height() const
+	{
+		return m_root == k_null ? 0 : m_nodes[m_root].height;
+	}
+
+
+	// NOTE: summed internal node area over root area, what the rebuild heuristic watches
+
+	[[nodiscard]] float sah_cost() const
+	{
+		if (m_root == k_null)
+			return 0.0f;
+
+		const float root_area = area(m_nodes[m_root].aabb_min, m_nodes[m_root].aabb_max);
+		return root_area > 0.0f ? static_cast<float>(m_area_sum / root_area) : 0.0f;
+	}
+
+
+	// NOTE: front to back. hit_fn(entity, entry_distance) returns the closest hit so far,
+	//       everything entering behind it is pruned. distances are in units of direction
+
+	template <typename HitFn>
+	void raycast(const vec3& origin, const vec3& direction, float max_distance, HitFn&& hit_fn) const
+	{
+		if (m_root == k_null)
+			return;
+
+		const vec3 inv_direction = 1.0f / direction;
+
+		NodeStack stack_nodes;
+		DistStack stack_entries;
+
+		float entry = 0.0f;
+
+		if (!intersect_slab(origin, inv_direction, m_nodes[m_root].aabb_min, m_nodes[m_root].aabb_max, max_distance, entry))
+			return;
+
+		stack_nodes[0]   = m_root;
+		stack_entries[0] = entry;
+
+		uint32_t stack_size = 1;
+
+		while (stack_size > 0) {
+
+			--stack_size;
+
+			if (stack_entries[stack_size] > max_distance)
+				continue;
+
+			const BoundTreeNode& node = m_nodes[stack_nodes[stack_size]];
+
+			if (node.height == 0) {
+
+				const BoundTreeSlot& slot = m_slots[node.child[0]];
+
+				if (intersect_slab(origin, inv_direction, slot.aabb_min, slot.aabb_max, max_distance, entry))
+					max_distance = std::min(max_distance, hit_fn(static_cast<ecs::Entity>(node.child[0]), entry));
+
+				continue;
+			}
+
+			const BoundTreeNode& lhs = m_nodes[node.child[0]];
+			const BoundTreeNode& rhs = m_nodes[node.child[1]];
+
+			float near_entry = 0.0f;
+			float far_entry  = 0.0f;
+
+			const bool near_hit = intersect_slab(origin, inv_direction, lhs.aabb_min, lhs.aabb_max, max_distance, near_entry);
+			const bool far_hit  = intersect_slab(origin, inv_direction, rhs.aabb_min, rhs.aabb_max, max_distance, far_entry);
+
+			uint32_t near_idx = node.child[0];
+			uint32_t far_idx  = node.child[1];
+
+			if (near_hit && far_hit && far_entry < near_entry) {
+				std::swap(near_idx, far_idx);
+				std::swap(near_entry, far_entry);
+			}
+
+			HPR_ASSERT_MSG(stack_size + 2 <= stack_nodes.size(), "[bound tree] traversal stack overflow");
+
+			if (near_hit && far_hit) {
+				stack_nodes[stack_size]   = far_idx;
+				stack_entries[stack_size] = far_entry;
+				++stack_size;
+			}
+
+			if (near_hit || far_hit) {
+				stack_nodes[stack_size]   = near_hit ? near_idx : far_idx;
+				stack_entries[stack_size] = near_hit ? near_entry : far_entry;
+				++stack_size;
+			}
+		}
+	}
+
+
+	// NOTE: one traversal for a packet of up to 32 coherent rays. a node is entered when any
+	//       ray of ray_mask hits it within its current max distance, hit_fn(entity, hit_mask)
+	//       gets the rays that reach the entity bounds and shortens max_distances as it hits
+
+	template <typename HitFn>
+	void raycast_packet(
+		std::span<const vec3>  origins,
+		std::span<const vec3>  directions,
+		std::span<const float> max_distances,
+		uint32_t               ray_mask,
+		HitFn&&                hit_fn
+	) const
+	{
+		const uint32_t ray_count = static_cast<uint32_t>(origins.size());
+
+		HPR_ASSERT_MSG(ray_count <= k_packet_capacity, "[bound tree] ray packet too large");
+		HPR_ASSERT_MSG(directions.size() >= ray_count && max_distances.size() >= ray_count, "[bound tree] ray packet spans differ");
+		HPR_ASSERT_MSG(ray_count == k_packet_capacity || (ray_mask >> ray_count) == 0, "[bound tree] ray mask past packet");
+
+		if (m_root == k_null || ray_mask == 0)
+			return;
+
+		std::array<vec3, k_packet_capacity> inv_directions;
+
+		for (uint32_t rays = ray_mask; rays != 0; rays &= rays - 1) {
+			const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+			inv_directions[ray] = 1.0f / directions[ray];
+		}
+
+		const PacketView packet {
+			.origins        = origins.data(),
+			.inv_directions = inv_directions.data(),
+			.max_distances  = max_distances.data()
+		};
+
+		float entry = 0.0f;
+
+		const uint32_t root_mask = intersect_packet(packet, ray_mask, m_nodes[m_root].aabb_min, m_nodes[m_root].aabb_max, entry);
+		if (root_mask == 0)
+			return;
+
+		NodeStack stack_nodes;
+		NodeStack stack_masks;
+
+		stack_nodes[0] = m_root;
+		stack_masks[0] = root_mask;
+
+		uint32_t stack_size = 1;
+
+		while (stack_size > 0) {
+
+			--stack_size;
+
+			const BoundTreeNode& node = m_nodes[stack_nodes[stack_size]];
+			const uint32_t       mask = stack_masks[stack_size];
+
+			if (node.height == 0) {
+
+				const BoundTreeSlot& slot = m_slots[node.child[0]];
+
+				const uint32_t hit_mask = intersect_packet(packet, mask, slot.aabb_min, slot.aabb_max, entry);
+
+				if (hit_mask != 0)
+					hit_fn(static_cast<ecs::Entity>(node.child[0]), hit_mask);
+
+				continue;
+			}
+
+			const BoundTreeNode& lhs = m_nodes[node.child[0]];
+			const BoundTreeNode& rhs = m_nodes[node.child[1]];
+
+			float lhs_entry = 0.0f;
+			float rhs_entry = 0.0f;
+
+			const uint32_t lhs_mask = intersect_packet(packet, mask, lhs.aabb_min, lhs.aabb_max, lhs_entry);
+			const uint32_t rhs_mask = intersect_packet(packet, mask, rhs.aabb_min, rhs.aabb_max, rhs_entry);
+
+			HPR_ASSERT_MSG(stack_size + 2 <= stack_nodes.size(), "[bound tree] traversal stack overflow");
+
+			const bool lhs_first = lhs_entry <= rhs_entry;
+
+			if (lhs_mask != 0 && rhs_mask != 0) {
+				stack_nodes[stack_size] = lhs_first ? node.child[1] : node.child[0];
+				stack_masks[stack_size] = lhs_first ? rhs_mask : lhs_mask;
+				++stack_size;
+
+				stack_nodes[stack_size] = lhs_first ? node.child[0] : node.child[1];
+				stack_masks[stack_size] = lhs_first ? lhs_mask : rhs_mask;
+				++stack_size;
+			}
+			else if (lhs_mask != 0 || rhs_mask != 0) {
+				stack_nodes[stack_size] = lhs_mask != 0 ? node.child[0] : node.child[1];
+				stack_masks[stack_size] = lhs_mask | rhs_mask;
+				++stack_size;
+			}
+		}
+	}
+
+
+	template <typename Fn>
+	void query_box(const vec3& box_min, const vec3& box_max, Fn&& callback) const
+	{
+		traverse(
+			[&box_min, &box_max](const vec3& aabb_min, const vec3& aabb_max) -> Overlap
+			{
+				if (!overlaps(box_min, box_max, aabb_min, aabb_max))
+					return Overlap::outside;
+
+				return contains(box_min, box_max, aabb_min, aabb_max) ? Overlap::inside : Overlap::partial;
+			},
+			callback
+		);
+	}
+
+
+	template <typename Fn>
+	void query_sphere(const vec3& center, float radius, Fn&& callback) const
+	{
+		const float radius_sq = radius * radius;
+
+		traverse(
+			[&center, radius_sq](const vec3& aabb_min, const vec3& aabb_max) -> Overlap
+			{
+				const vec3 closest  = glm::clamp(center, aabb_min, aabb_max);
+				const vec3 farthest = glm::max(glm::abs(center - aabb_min), glm::abs(center - aabb_max));
+
+				if (glm::dot(closest - center, closest - center) > radius_sq)
+					return Overlap::outside;
+
+				return glm::dot(farthest, farthest) <= radius_sq ? Overlap::inside : Overlap::partial;
+			},
+			callback
+		);
+	}
+
+
+	// NOTE: planes as xyz normal and w offset pointing inward, DrawView::frustum works as is
+
+	template <typename Fn>
+	void query_frustum(std::span<const vec4> planes, Fn&& callback) const
+	{
+		traverse(
+			[planes](const vec3& aabb_min, const vec3& aabb_max) -> Overlap
+			{
+				const vec3 center = (aabb_min + aabb_max) * 0.5f;
+				const vec3 half   = (aabb_max - aabb_min) * 0.5f;
+
+				Overlap overlap = Overlap::inside;
+
+				for (const vec4& plane : planes) {
+
+					const vec3  normal   = vec3(plane);
+					const float radius   = glm::dot(glm::abs(normal), half);
+					const float distance = glm::dot(normal, center) + plane.w;
+
+					if (distance < -radius)
+						return Overlap::outside;
+
+					if (distance < radius)
+						overlap = Overlap::partial;
+				}
+
+				return overlap;
+			},
+			callback
+		);
+	}
+
+private:
+
+	enum class Overlap : uint8_t
+	{
+		outside,
+		partial,
+		inside
+	};
+
+
+	using NodeStack = std::array<uint32_t, cfg::bound_tree_max_height + 2>;
+	using DistStack = std::array<float,    cfg::bound_tree_max_height + 2>;
+
+	static constexpr uint32_t k_inside_bit      = 0x80000000U;
+	static constexpr uint32_t k_packet_capacity = 32U;
+
+
+	struct PacketView
+	{
+		const vec3*  origins;
+		const vec3*  inv_directions;
+		const float* max_distances;
+	};
+
+
+	struct BuildRef
+	{
+		vec3        aabb_min;
+		vec3        aabb_max;
+		vec3        centroid;
+		ecs::Entity entity;
+	};
+
+
+	struct BuildTask
+	{
+		uint32_t node;
+		uint32_t ref_beg;
+		uint32_t ref_end;
+		uint32_t depth;
+	};
+
+
+	void queue_entity(ecs::Entity entity)
+	{
+		if (entity >= m_slots.size())
+			m_slots.resize(static_cast<size_t>(entity) + 1, BoundTreeSlot {});
+
+		BoundTreeSlot& slot = m_slots[entity];
+
+		if (slot.flags & BoundTreeSlot::k_queued)
+			return;
+
+		slot.flags |= BoundTreeSlot::k_queued;
+		m_queued.emplace_back(entity);
+	}
+
+
+	[[nodiscard]] static float area(const vec3& aabb_min, const vec3& aabb_max)
+	{
+		const vec3 extent = aabb_max - aabb_min;
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+
+	[[nodiscard]] static bool contains(const vec3& outer_min, const vec3& outer_max, const vec3& inner_min, const vec3& inner_max)
+	{
+		return outer_min.x <= inner_min.x && outer_min.y <= inner_min.y && outer_min.z <= inner_min.z
+			&& inner_max.x <= outer_max.x && inner_max.y <= outer_max.y && inner_max.z <= outer_max.z;
+	}
+
+
+	[[nodiscard]] static bool overlaps(const vec3& lhs_min, const vec3& lhs_max, const vec3& rhs_min, const vec3& rhs_max)
+	{
+		return lhs_min.x <= rhs_max.x && lhs_min.y <= rhs_max.y && lhs_min.z <= rhs_max.z
+			&& rhs_min.x <= lhs_max.x && rhs_min.y <= lhs_max.y && rhs_min.z <= lhs_max.z;
+	}
+
+
+	// NOTE: nan from a zero direction on a slab border drops out of the min and max
+
+	[[nodiscard]] static bool intersect_slab(
+		const vec3& origin,
+		const vec3& inv_direction,
+		const vec3& aabb_min,
+		const vec3& aabb_max,
+		float       max_distance,
+		float&      entry_distance
+	)
+	{
+		float entry = 0.0f;
+		float exit  = max_distance;
+
+		for (int axis = 0; axis < 3; ++axis) {
+
+			const float slab_near = (aabb_min[axis] - origin[axis]) * inv_direction[axis];
+			const float slab_far  = (aabb_max[axis] - origin[axis]) * inv_direction[axis];
+
+			entry = std::max(entry, std::min(slab_near, slab_far));
+			exit  = std::min(exit,  std::max(slab_near, slab_far));
+		}
+
+		entry_distance = entry;
+		return entry <= exit;
+	}
+
+
+	// NOTE: returns the rays of ray_mask that hit the box, entry_distance is the nearest entry
+
+	[[nodiscard]] static uint32_t intersect_packet(
+		const PacketView& packet,
+		uint32_t          ray_mask,
+		const vec3&       aabb_min,
+		const vec3&       aabb_max,
+		float&            entry_distance
+	)
+	{
+		uint32_t hit_mask = 0;
+
+		entry_distance = std::numeric_limits<float>::infinity();
+
+		for (uint32_t rays = ray_mask; rays != 0; rays &= rays - 1) {
+
+			const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+
+			float entry = 0.0f;
+
+			if (intersect_slab(packet.origins[ray], packet.inv_directions[ray], aabb_min, aabb_max, packet.max_distances[ray], entry)) {
+				hit_mask      |= 1U << ray;
+				entry_distance = std::min(entry_distance, entry);
+			}
+		}
+
+		return hit_mask;
+	}
+
+
+	template <typename NodeTest, typename Fn>
+	void traverse(NodeTest&& node_test, Fn&& callback) const
+	{
+		if (m_root == k_null)
+			return;
+
+		NodeStack stack;
+
+		stack[0] = m_root;
+		uint32_t stack_size = 1;
+
+		while (stack_size > 0) {
+
+			const uint32_t entry    = stack[--stack_size];
+			const uint32_t node_idx = entry & ~k_inside_bit;
+
+			const BoundTreeNode& node = m_nodes[node_idx];
+
+			bool inside = (entry & k_inside_bit) != 0;
+
+			if (node.height == 0) {
+
+				const BoundTreeSlot& slot = m_slots[node.child[0]];
+
+				if (inside || node_test(slot.aabb_min, slot.aabb_max) != Overlap::outside)
+					callback(static_cast<ecs::Entity>(node.child[0]));
+
+				continue;
+			}
+
+			if (!inside) {
+
+				const Overlap overlap = node_test(node.aabb_min, node.aabb_max);
+
+				if (overlap == Overlap::outside)
+					continue;
+
+				inside = overlap == Overlap::inside;
+			}
+
+			HPR_ASSERT_MSG(stack_size + 2 <= stack.size(), "[bound tree] traversal stack overflow");
+
+			const uint32_t inside_bit = inside ? k_inside_bit : 0U;
+
+			stack[stack_size++] = node.child[1] | inside_bit;
+			stack[stack_size++] = node.child[0] | inside_bit;
+		}
+	}
+
+
+	uint32_t alloc_node()
+	{
+		uint32_t node_idx = 0;
+
+		if (!m_free_nodes.empty()) {
+			node_idx = m_free_nodes.back();
+			m_free_nodes.pop_back();
+		}
+		else {
+			node_idx = static_cast<uint32_t>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+
+		m_nodes[node_idx] = BoundTreeNode {
+			.aabb_min = vec3 {0.0f},
+			.parent   = k_null,
+			.aabb_max = vec3 {0.0f},
+			.height   = 0,
+			.child    = {k_null, k_null}
+		};
+
+		return node_idx;
+	}
+
+
+	void free_node(uint32_t node_idx)
+	{
+		m_free_nodes.emplace_back(node_idx);
+	}
+
+
+	void fatten(uint32_t leaf, const BoundTreeSlot& slot)
+	{
+		const vec3 margin = (slot.aabb_max - slot.aabb_min) * (0.5f * cfg::bound_tree_fat_ratio) + cfg::bound_tree_fat_min;
+
+		m_nodes[leaf].aabb_min = slot.aabb_min - margin;
+		m_nodes[leaf].aabb_max = slot.aabb_max + margin;
+	}
+
+
+	void replace_child(uint32_t parent, uint32_t old_child, uint32_t new_child)
+	{
+		if (parent == k_null) {
+			m_root = new_child;
+			return;
+		}
+
+		BoundTreeNode& node = m_nodes[parent];
+		node.child[node.child[0] == old_child ? 0 : 1] = new_child;
+	}
+
+
+	// NOTE: returns the change in area so callers keep m_area_sum current
+
+	float update_internal(uint32_t node_idx)
+	{
+		BoundTreeNode& node = m_nodes[node_idx];
+
+		const BoundTreeNode& lhs = m_nodes[node.child[0]];
+		const BoundTreeNode& rhs = m_nodes[node.child[1]];
+
+		const float old_area = area(node.aabb_min, node.aabb_max);
+
+		node.aabb_min = glm::min(lhs.aabb_min, rhs.aabb_min);
+		node.aabb_max = glm::max(lhs.aabb_max, rhs.aabb_max);
+		node.height   = 1 + std::max(lhs.height, rhs.height);
+
+		return area(node.aabb_min, node.aabb_max) - old_area;
+	}
+
+
+	// NOTE: branch and bound descent on the area the insertion adds to each ancestor
+
+	void insert_leaf(uint32_t leaf)
+	{
+		if (m_root == k_null) {
+			m_root = leaf;
+			m_nodes[leaf].parent = k_null;
+			return;
+		}
+
+		const vec3 leaf_min = m_nodes[leaf].aabb_min;
+		const vec3 leaf_max = m_nodes[leaf].aabb_max;
+
+		uint32_t sibling = m_root;
+
+		while (m_nodes[sibling].height > 0) {
+
+			const BoundTreeNode& node = m_nodes[sibling];
+
+			const float node_area     = area(node.aabb_min, node.aabb_max);
+			const float combined_area = area(glm::min(node.aabb_min, leaf_min), glm::max(node.aabb_max, leaf_max));
+
+			const float pair_cost    = 2.0f * combined_area;
+			const float inherit_cost = 2.0f * (combined_area - node_area);
+
+			float child_costs [2];
+
+			for (uint32_t side = 0; side < 2; ++side) {
+
+				const BoundTreeNode& child = m_nodes[node.child[side]];
+
+				const float union_area = area(glm::min(child.aabb_min, leaf_min), glm::max(child.aabb_max, leaf_max));
+
+				child_costs[side] = inherit_cost + (child.height == 0
+					? union_area
+					: union_area - area(child.aabb_min, child.aabb_max));
+			}
+
+			if (pair_cost < child_costs[0] && pair_cost < child_costs[1])
+				break;
+
+			sibling = node.child[child_costs[1] < child_costs[0] ? 1 : 0];
+		}
+
+		const uint32_t old_parent = m_nodes[sibling].parent;
+		const uint32_t new_parent = alloc_node();
+
+		m_nodes[new_parent].parent   = old_parent;
+		m_nodes[new_parent].child[0] = sibling;
+		m_nodes[new_parent].child[1] = leaf;
+
+		m_nodes[sibling].parent = new_parent;
+		m_nodes[leaf].parent    = new_parent;
+
+		replace_child(old_parent, sibling, new_parent);
+
+		m_area_sum += update_internal(new_parent);
+
+		refit(new_parent);
+	}
+
+
+	void remove_leaf(uint32_t leaf)
+	{
+		if (leaf == m_root) {
+			m_root = k_null;
+			return;
+		}
+
+		const uint32_t parent  = m_nodes[leaf].parent;
+		const uint32_t grand   = m_nodes[parent].parent;
+		const uint32_t sibling = m_nodes[parent].child[m_nodes[parent].child[0] == leaf ? 1 : 0];
+
+		m_area_sum -= area(m_nodes[parent].aabb_min, m_nodes[parent].aabb_max);
+
+		replace_child(grand, parent, sibling);
+
+		m_nodes[sibling].parent = grand;
+		m_nodes[leaf].parent    = k_null;
+
+		free_node(parent);
+
+		if (grand != k_null)
+			refit(grand);
+	}
+
+
+	void refit(uint32_t node_idx)
+	{
+		while (node_idx != k_null) {
+
+			rotate(node_idx);
+
+			m_area_sum += update_internal(node_idx);
+
+			node_idx = m_nodes[node_idx].parent;
+		}
+	}
+
+
+	// NOTE: swaps one child with a grandchild under the other child when that shrinks the
+	//       other child, the parent bounds stay the same
+
+	void rotate(uint32_t node_idx)
+	{
+		const BoundTreeNode& node = m_nodes[node_idx];
+
+		uint32_t best_side  = 0;
+		uint32_t best_grand = 0;
+		float    best_gain  = 0.0f;
+
+		for (uint32_t side = 0; side < 2; ++side) {
+
+			const BoundTreeNode& moved = m_nodes[node.child[side]];
+			const BoundTreeNode& other = m_nodes[node.child[side ^ 1U]];
+
+			if (other.height == 0)
+				continue;
+
+			const float other_area = area(other.aabb_min, other.aabb_max);
+
+			for (uint32_t grand = 0; grand < 2; ++grand) {
+
+				const BoundTreeNode& kept = m_nodes[other.child[grand ^ 1U]];
+
+				const float gain = other_area - area(glm::min(moved.aabb_min, kept.aabb_min), glm::max(moved.aabb_max, kept.aabb_max));
+
+				if (gain > best_gain) {
+					best_gain  = gain;
+					best_side  = side;
+					best_grand = grand;
+				}
+			}
+		}
+
+		if (best_gain <= 0.0f)
+			return;
+
+		const uint32_t moved_idx = node.child[best_side];
+		const uint32_t other_idx = node.child[best_side ^ 1U];
+		const uint32_t grand_idx = m_nodes[other_idx].child[best_grand];
+
+		m_nodes[node_idx].child[best_side]   = grand_idx;
+		m_nodes[other_idx].child[best_grand] = moved_idx;
+
+		m_nodes[grand_idx].parent = node_idx;
+		m_nodes[moved_idx].parent = other_idx;
+
+		m_area_sum += update_internal(other_idx);
+	}
+
+
+	void rebuild()
+	{
+		m_nodes.clear();
+		m_free_nodes.clear();
+		m_refs.clear();
+
+		m_root       = k_null;
+		m_leaf_count = 0;
+		m_area_sum   = 0.0;
+		m_built_cost = 0.0f;
+
+		for (uint32_t entity = 0; entity < m_slots.size(); ++entity) {
+
+			BoundTreeSlot& slot = m_slots[entity];
+
+			slot.leaf = k_null;
+
+			if ((slot.flags & BoundTreeSlot::k_live) == 0)
+				continue;
+
+			const vec3 margin = (slot.aabb_max - slot.aabb_min) * (0.5f * cfg::bound_tree_fat_ratio) + cfg::bound_tree_fat_min;
+
+			m_refs.emplace_back(BuildRef {
+				.aabb_min = slot.aabb_min - margin,
+				.aabb_max = slot.aabb_max + margin,
+				.centroid = (slot.aabb_min + slot.aabb_max) * 0.5f,
+				.entity   = entity
+			});
+		}
+
+		if (m_refs.empty())
+			return;
+
+		m_root = alloc_node();
+
+		m_tasks.clear();
+		m_tasks.emplace_back(BuildTask {.node = m_root, .ref_beg = 0, .ref_end = static_cast<uint32_t>(m_refs.size()), .depth = 0});
+
+		while (!m_tasks.empty()) {
+
+			const BuildTask task = m_tasks.back();
+			m_tasks.pop_back();
+
+			vec3 bounds_min   {std::numeric_limits<float>::max()};
+			vec3 bounds_max   {std::numeric_limits<float>::lowest()};
+			vec3 centroid_min {std::numeric_limits<float>::max()};
+			vec3 centroid_max {std::numeric_limits<float>::lowest()};
+
+			for (uint32_t ref_idx = task.ref_beg; ref_idx < task.ref_end; ++ref_idx) {
+
+				const BuildRef& ref = m_refs[ref_idx];
+
+				bounds_min   = glm::min(bounds_min, ref.aabb_min);
+				bounds_max   = glm::max(bounds_max, ref.aabb_max);
+				centroid_min = glm::min(centroid_min, ref.centroid);
+				centroid_max = glm::max(centroid_max, ref.centroid);
+			}
+
+			m_nodes[task.node].aabb_min = bounds_min;
+			m_nodes[task.node].aabb_max = bounds_max;
+
+			if (task.ref_end - task.ref_beg == 1) {
+
+				const ecs::Entity entity = m_refs[task.ref_beg].entity;
+
+				m_nodes[task.node].child[0] = entity;
+				m_slots[entity].leaf        = task.node;
+
+				++m_leaf_count;
+				continue;
+			}
+
+			const uint32_t ref_mid = split(task, centroid_min, centroid_max);
+
+			const uint32_t lhs = alloc_node();
+			const uint32_t rhs = alloc_node();
+
+			m_nodes[task.node].child[0] = lhs;
+			m_nodes[task.node].child[1] = rhs;
+
+			m_nodes[lhs].parent = task.node;
+			m_nodes[rhs].parent = task.node;
+
+			m_area_sum += area(bounds_min, bounds_max);
+
+			m_tasks.emplace_back(BuildTask {.node = rhs, .ref_beg = ref_mid,      .ref_end = task.ref_end, .depth = task.depth + 1});
+			m_tasks.emplace_back(BuildTask {.node = lhs, .ref_beg = task.ref_beg, .ref_end = ref_mid,      .depth = task.depth + 1});
+		}
+
+		// NOTE: children are always allocated after their parent
+
+		for (uint32_t node_idx = static_cast<uint32_t>(m_nodes.size()); node_idx-- > 0;) {
+
+			BoundTreeNode& node = m_nodes[node_idx];
+
+			if (node.child[1] != k_null)
+				node.height = 1 + std::max(m_nodes[node.child[0]].height, m_nodes[node.child[1]].height);
+		}
+
+		m_built_cost = sah_cost();
+	}
+
+
+	// NOTE: binned sah over all three axes, past median_depth the split falls back to the
+	//       centroid median so the height stays bounded
+
+	uint32_t split(const BuildTask& task, const vec3& centroid_min, const vec3& centroid_max)
+	{
+		constexpr uint32_t bin_count = cfg::bound_tree_bin_count;
+
+		const vec3 extent = centroid_max - centroid_min;
+
+		const int widest_axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+		const uint32_t ref_mid = task.ref_beg + (task.ref_end - task.ref_beg) / 2;
+
+		if (extent[widest_axis] <= 0.0f)
+			return ref_mid;
+
+		int      best_axis = -1;
+		uint32_t best_bin  = 0;
+		float    best_cost = std::numeric_limits<float>::max();
+
+		if (task.depth < cfg::bound_tree_median_depth) {
+
+			for (int axis = 0; axis < 3; ++axis) {
+
+				if (extent[axis] <= 0.0f)
+					continue;
+
+				const float bin_scale = static_cast<float>(bin_count) / extent[axis];
+
+				std::array<vec3,     bin_count> bin_min;
+				std::array<vec3,     bin_count> bin_max;
+				std::array<uint32_t, bin_count> bin_counts {};
+
+				bin_min.fill(vec3 {std::numeric_limits<float>::max()});
+				bin_max.fill(vec3 {std::numeric_limits<float>::lowest()});
+
+				for (uint32_t ref_idx = task.ref_beg; ref_idx < task.ref_end; ++ref_idx) {
+
+					const BuildRef& ref = m_refs[ref_idx];
+					const uint32_t  bin = bin_index(ref.centroid[axis], centroid_min[axis], bin_scale);
+
+					bin_min[bin] = glm::min(bin_min[bin], ref.aabb_min);
+					bin_max[bin] = glm::max(bin_max[bin], ref.aabb_max);
+					++bin_counts[bin];
+				}
+
+				std::array<float, bin_count> lhs_costs {};
+
+				vec3     sweep_min   {std::numeric_limits<float>::max()};
+				vec3     sweep_max   {std::numeric_limits<float>::lowest()};
+				uint32_t sweep_count {0};
+
+				for (uint32_t bin = 0; bin + 1 < bin_count; ++bin) {
+
+					sweep_min    = glm::min(sweep_min, bin_min[bin]);
+					sweep_max    = glm::max(sweep_max, bin_max[bin]);
+					sweep_count += bin_counts[bin];
+
+					lhs_costs[bin] = sweep_count > 0 ? area(sweep_min, sweep_max) * static_cast<float>(sweep_count) : 0.0f;
+				}
+
+				sweep_min   = vec3 {std::numeric_limits<float>::max()};
+				sweep_max   = vec3 {std::numeric_limits<float>::lowest()};
+				sweep_count = 0;
+
+				for (uint32_t bin = bin_count - 1; bin > 0; --bin) {
+
+					sweep_min    = glm::min(sweep_min, bin_min[bin]);
+					sweep_max    = glm::max(sweep_max, bin_max[bin]);
+					sweep_count += bin_counts[bin];
+
+					const uint32_t lhs_count = task.ref_end - task.ref_beg - sweep_count;
+
+					if (sweep_count == 0 || lhs_count == 0)
+						continue;
+
+					const float cost = lhs_costs[bin - 1] + area(sweep_min, sweep_max) * static_cast<float>(sweep_count);
+
+					if (cost < best_cost) {
+						best_cost = cost;
+						best_axis = axis;
+						best_bin  = bin - 1;
+					}
+				}
+			}
+		}
+
+		if (best_axis >= 0) {
+
+			const float bin_scale = static_cast<float>(bin_count) / extent[best_axis];
+
+			const BuildRef* partition_end = std::partition(
+				m_refs.data() + task.ref_beg,
+				m_refs.data() + task.ref_end,
+				[&centroid_min, best_axis, best_bin, bin_scale](const BuildRef& ref) {
+					return bin_index(ref.centroid[best_axis], centroid_min[best_axis], bin_scale) <= best_bin;
+				}
+			);
+
+			const uint32_t partition_mid = static_cast<uint32_t>(partition_end - m_refs.data());
+
+			if (partition_mid > task.ref_beg && partition_mid < task.ref_end)
+				return partition_mid;
+		}
+
+		std::nth_element(
+			m_refs.data() + task.ref_beg,
+			m_refs.data() + ref_mid,
+			m_refs.data() + task.ref_end,
+			[widest_axis](const BuildRef& lhs, const BuildRef& rhs) {
+				return lhs.centroid[widest_axis] < rhs.centroid[widest_axis];
+			}
+		);
+
+		return ref_mid;
+	}
+
+
+	[[nodiscard]] static uint32_t bin_index(float centroid, float centroid_min, float bin_scale)
+	{
+		const float bin = (centroid - centroid_min) * bin_scale;
+		return std::min(static_cast<uint32_t>(std::max(bin, 0.0f)), cfg::bound_tree_bin_count - 1);
+	}
+
+private:
+
+	mtp::vault<BoundTreeNode, mtp::default_set> m_nodes;
+	mtp::vault<uint32_t,      mtp::default_set> m_free_nodes;
+	mtp::vault<BoundTreeSlot, mtp::default_set> m_slots;
+
+	uint32_t m_root       {k_null};
+	uint32_t m_leaf_count {0};
+
+	double m_area_sum   {0.0};
+	float  m_built_cost {0.0f};
+
+	mtp::vault<ecs::Entity, mtp::default_set> m_queued;
+	mtp::vault<ecs::Entity, mtp::default_set> m_inserted;
+	mtp::vault<ecs::Entity, mtp::default_set> m_moved;
+
+	mtp::vault<BuildRef,  mtp::default_set> m_refs;
+	mtp::vault<BuildTask, mtp::default_set> m_tasks;
+};
+
+
+} // hpr::scn
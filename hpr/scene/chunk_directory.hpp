@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+
+namespace hpr::scn {
+
+
+// NOTE: open addressing chunk key -> chunk slot, linear probing, erase shifts back instead of tombstoning
+
+class ChunkDirectory
+{
+public:
+
+	static constexpr uint32_t k_empty_slot   = 0xFFFFFFFFU;
+	static constexpr uint32_t k_min_capacity = 16U;
+
+	struct Entry
+	{
+		uint64_t key  {0};
+		uint32_t slot {k_empty_slot};
+	};
+
+public:
+
+	void clear()
+	{
+		m_entries.clear();
+		m_count = 0;
+		m_mask  = 0;
+	}
+
+
+	[[nodiscard]] uint32_t size() const
+	{
+		return m_count;
+	}
+
+
+	void reserve(uint32_t count)
+	{
+		const uint32_t capacity = capacity_for(count);
+		if (capacity > m_entries.size())
+			rehash(capacity);
+	}
+
+
+	[[nodiscard]] uint32_t find(uint64_t key) const
+	{
+		if (m_count == 0)
+			return k_empty_slot;
+
+		uint32_t probe = probe_start(key);
+
+		for (;;) {
+			const Entry& entry = m_entries[probe];
+
+			if (entry.slot == k_empty_slot)
+				return k_empty_slot;
+			if (entry.key == key)
+				return entry.slot;
+
+			probe = (probe + 1) & m_mask;
+		}
+	}
+
+
+	void insert(uint64_t key, uint32_t slot)
+	{
+		HPR_ASSERT_MSG(slot != k_empty_slot, "[chunk directory] slot is reserved");
+
+		if ((m_count + 1) * 2 > static_cast<uint32_t>(m_entries.size()))
+			rehash(capacity_for(m_count + 1));
+
+		uint32_t probe = probe_start(key);
+
+		for (;;) {
+			Entry& entry = m_entries[probe];
+
+			if (entry.slot == k_empty_slot) {
+				entry.key  = key;
+				entry.slot = slot;
+				++m_count;
+				return;
+			}
+
+			if (entry.key == key) {
+				entry.slot = slot;
+				return;
+			}
+
+			probe = (probe + 1) & m_mask;
+		}
+	}
+
+
+	bool erase(uint64_t key)
+	{
+		if (m_count == 0)
+			return false;
+
+		uint32_t hole = probe_start(key);
+
+		for (;;) {
+			const Entry& entry = m_entries[hole];
+
+			if (entry.slot == k_empty_slot)
+				return false;
+			if (entry.key == key)
+				break;
+
+			hole = (hole + 1) & m_mask;
+		}
+
+		// NOTE: pull later entries of the chain back into the hole unless that would put
+		//       them in front of their home bucket
+
+		uint32_t probe = (hole + 1) & m_mask;
+
+		for (;;) {
+			const Entry& entry = m_entries[probe];
+
+			if (entry.slot == k_empty_slot)
+				break;
+
+			const uint32_t home = probe_start(entry.key);
+
+			if (((probe - home) & m_mask) >= ((probe - hole) & m_mask)) {
+				m_entries[hole] = entry;
+				hole = probe;
+			}
+
+			probe = (probe + 1) & m_mask;
+		}
+
+		m_entries[hole] = Entry {};
+		--m_count;
+
+		return true;
+	}
+
+private:
+
+	[[nodiscard]] uint32_t probe_start(uint64_t key) const
+	{
+		// NOTE: keys are fnv hashes already - fold the high bits in before masking
+
+		const uint64_t mixed = (key ^ (key >> 32)) * 0x9E3779B97F4A7C15ULL;
+		return static_cast<uint32_t>(mixed >> 32) & m_mask;
+	}
+
+
+	[[nodiscard]] static uint32_t capacity_for(uint32_t count)
+	{
+		uint32_t capacity = k_min_capacity;
+		while (capacity < count * 2)
+			capacity <<= 1;
+
+		return capacity;
+	}
+
+
+	void rehash(uint32_t capacity)
+	{
+		mtp::vault<Entry, mtp::default_set> old_entries = std::move(m_entries);
+
+		m_entries = mtp::vault<Entry, mtp::default_set> {};
+		m_entries.resize(capacity, Entry {});
+
+		m_mask  = capacity - 1;
+		m_count = 0;
+
+		for (const Entry& entry : old_entries) {
+			if (entry.slot != k_empty_slot)
+				insert(entry.key, entry.slot);
+		}
+	}
+
+private:
+
+	mtp::vault<Entry, mtp::default_set> m_entries;
+
+	uint32_t m_count {0};
+	uint32_t m_mask  {0};
+};
+
+
+} // hpr::scn
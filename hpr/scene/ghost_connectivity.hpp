@@ -0,0 +1,627 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "tile_data.hpp"
+#include "ghost_infra.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr uint32_t ghost_overlay_fold_min = 64U;
+
+} // hpr::scn::cfg
+
+
+// NOTE: compressed sparse rows over every edge of a graph, broken ones included so damage and
+//       repair never rebuild it. links of node n are [offsets[n], offsets[n + 1])
+
+struct GhostAdjacency
+{
+	mtp::vault<uint32_t, mtp::default_set> offsets;
+	mtp::vault<uint32_t, mtp::default_set> targets;
+	mtp::vault<uint32_t, mtp::default_set> edge_ids;
+
+	void clear()
+	{
+		offsets.clear();
+		targets.clear();
+		edge_ids.clear();
+	}
+
+	// NOTE: only the first edge_count edges of the graph are linked
+
+	void build(const GhostGraph& graph, uint32_t edge_count)
+	{
+		const uint32_t node_count = static_cast<uint32_t>(graph.nodes.size());
+
+		HPR_ASSERT_MSG(edge_count <= graph.edges.size(), "[ghostadjacency] edge count out of range");
+
+		offsets.clear();
+		offsets.resize(node_count + 1, 0U);
+
+		for (uint32_t edge_idx = 0; edge_idx < edge_count; ++edge_idx) {
+			++offsets[graph.edges[edge_idx].a + 1];
+			++offsets[graph.edges[edge_idx].b + 1];
+		}
+
+		for (uint32_t node = 0; node < node_count; ++node)
+			offsets[node + 1] += offsets[node];
+
+		targets.resize(edge_count * 2);
+		edge_ids.resize(edge_count * 2);
+
+		mtp::vault<uint32_t, mtp::default_set> cursor;
+		cursor.resize(node_count);
+		std::copy_n(offsets.data(), node_count, cursor.data());
+
+		for (uint32_t edge_idx = 0; edge_idx < edge_count; ++edge_idx) {
+
+			const GhostEdge& edge = graph.edges[edge_idx];
+
+			const uint32_t slot_a = cursor[edge.a]++;
+			targets[slot_a]  = edge.b;
+			edge_ids[slot_a] = edge_idx;
+
+			const uint32_t slot_b = cursor[edge.b]++;
+			targets[slot_b]  = edge.a;
+			edge_ids[slot_b] = edge_idx;
+		}
+	}
+
+	[[nodiscard]] uint32_t node_count() const
+	{
+		return offsets.empty() ? 0U : static_cast<uint32_t>(offsets.size() - 1);
+	}
+};
+
+
+// NOTE: dynamic connectivity for one ghost graph. every node carries its component label so
+//       queries are a lookup; inserting an edge unions by size and relabels the smaller side,
+//       cutting one searches from both ends in lockstep and stops as soon as they meet or the
+//       smaller side runs out, so a cut costs the piece that actually splits off.
+//       edges added after rebuild() live in an overlay until it is folded into the csr.
+//       the graph is append only, sync() picks up what was appended since the last call
+
+class GhostConnectivity
+{
+public:
+
+	static constexpr uint32_t k_none = 0xFFFFFFFFU;
+
+public:
+
+	void clear()
+	{
+		m_adjacency.clear();
+
+		m_labels.clear();
+		m_sources.clear();
+		m_member_prev.clear();
+		m_member_next.clear();
+
+		m_components.clear();
+		m_free_components.clear();
+		m_component_count = 0;
+
+		m_overlay_head.clear();
+		m_overlay_next.clear();
+		m_overlay_target.clear();
+		m_overlay_edge.clear();
+
+		m_edge_count = 0;
+
+		m_stamps.clear();
+		m_stamp = 0;
+
+		m_tile_index.clear();
+	}
+
+
+	void rebuild(const GhostGraph& graph)
+	{
+		mtp::vault<uint8_t, mtp::default_set> sources;
+		std::swap(sources, m_sources);
+
+		clear();
+
+		m_edge_count = static_cast<uint32_t>(graph.edges.size());
+
+		m_adjacency.build(graph, m_edge_count);
+		sync_nodes(graph);
+
+		for (uint32_t node = 0; node < sources.size() && node < m_sources.size(); ++node) {
+			if (sources[node])
+				set_source(node, true);
+		}
+
+		for (uint32_t edge_idx = 0; edge_idx < graph.edges.size(); ++edge_idx) {
+			const GhostEdge& edge = graph.edges[edge_idx];
+			if (!(edge.flags & ghost_edge_broken))
+				merge(edge.a, edge.b);
+		}
+	}
+
+
+	// NOTE: call after appending nodes to the graph, new nodes start as their own component
+
+	void add_nodes(const GhostGraph& graph)
+	{
+		sync_nodes(graph);
+	}
+
+
+	// NOTE: edges are added in graph order, edge_idx is the first edge not linked yet
+
+	void add_edge(const GhostGraph& graph, uint32_t edge_idx)
+	{
+		HPR_ASSERT_MSG(edge_idx < graph.edges.size(), "[ghostconnectivity] edge out of range");
+		HPR_ASSERT_MSG(edge_idx == m_edge_count, "[ghostconnectivity] edge added out of order");
+
+		sync_nodes(graph);
+
+		const GhostEdge& edge = graph.edges[edge_idx];
+
+		push_overlay(edge.a, edge.b, edge_idx);
+		push_overlay(edge.b, edge.a, edge_idx);
+
+		++m_edge_count;
+
+		const uint32_t fold_threshold = std::max(cfg::ghost_overlay_fold_min, static_cast<uint32_t>(graph.edges.size() / 8));
+
+		if (m_overlay_target.size() > fold_threshold * 2)
+			fold_overlay(graph);
+
+		if (!(edge.flags & ghost_edge_broken))
+			merge(edge.a, edge.b);
+
+		touch_component(m_labels[edge.a]);
+		touch_component(m_labels[edge.b]);
+	}
+
+
+	// NOTE: nodes and edges appended to the graph since the last rebuild or sync
+
+	void sync(const GhostGraph& graph)
+	{
+		sync_nodes(graph);
+
+		while (m_edge_count < graph.edges.size())
+			add_edge(graph, m_edge_count);
+	}
+
+
+	void set_edge_broken(GhostGraph& graph, uint32_t edge_idx, bool broken)
+	{
+		HPR_ASSERT_MSG(edge_idx < m_edge_count, "[ghostconnectivity] edge not linked yet");
+
+		GhostEdge& edge = graph.edges[edge_idx];
+
+		const bool was_broken = (edge.flags & ghost_edge_broken) != 0;
+		if (was_broken == broken)
+			return;
+
+		if (broken) {
+			edge.flags = static_cast<uint8_t>(edge.flags | ghost_edge_broken);
+			split(graph, edge.a, edge.b);
+		}
+		else {
+			edge.flags = static_cast<uint8_t>(edge.flags & ~ghost_edge_broken);
+			merge(edge.a, edge.b);
+		}
+
+		touch_component(m_labels[edge.a]);
+		touch_component(m_labels[edge.b]);
+	}
+
+
+	void set_source(uint32_t node, bool is_source)
+	{
+		HPR_ASSERT_MSG(node < m_labels.size(), "[ghostconnectivity] node out of range");
+
+		if ((m_sources[node] != 0) == is_source)
+			return;
+
+		m_sources[node] = is_source ? 1U : 0U;
+
+		Component& component = m_components[m_labels[node]];
+		if (is_source)
+			++component.sources;
+		else
+			--component.sources;
+
+		touch_component(m_labels[node]);
+	}
+
+
+	[[nodiscard]] uint32_t node_count() const
+	{
+		return static_cast<uint32_t>(m_labels.size());
+	}
+
+
+	[[nodiscard]] uint32_t component_of(uint32_t node) const
+	{
+		HPR_ASSERT_MSG(node < m_labels.size(), "[ghostconnectivity] node out of range");
+		return m_labels[node];
+	}
+
+
+	[[nodiscard]] bool connected(uint32_t node_a, uint32_t node_b) const
+	{
+		return component_of(node_a) == component_of(node_b);
+	}
+
+
+	// NOTE: supplied = the component holds at least one source node - powered, online, pressurised
+
+	[[nodiscard]] bool supplied(uint32_t node) const
+	{
+		return m_components[component_of(node)].sources != 0;
+	}
+
+
+	[[nodiscard]] uint32_t component_size(uint32_t component) const
+	{
+		return m_components[component].size;
+	}
+
+
+	[[nodiscard]] uint32_t component_count() const
+	{
+		return m_component_count;
+	}
+
+
+	// NOTE: bumped whenever members, sources or links of the component change - solvers compare
+	//       it against the version they last solved
+
+	[[nodiscard]] uint64_t component_version(uint32_t component) const
+	{
+		return m_components[component].version;
+	}
+
+
+	// NOTE: first node registered on the tile, k_none when the tile carries no node
+
+	[[nodiscard]] uint32_t find_node(TileCoord tile) const
+	{
+		return m_tile_index.find(tile_key(tile));
+	}
+
+
+	[[nodiscard]] bool tile_supplied(TileCoord tile) const
+	{
+		const uint32_t node = find_node(tile);
+		return node != k_none && supplied(node);
+	}
+
+
+	[[nodiscard]] const GhostAdjacency& adjacency() const
+	{
+		return m_adjacency;
+	}
+
+
+	// NOTE: upper bound for component ids, ids are recycled after merges
+
+	[[nodiscard]] uint32_t component_capacity() const
+	{
+		return static_cast<uint32_t>(m_components.size());
+	}
+
+
+	// NOTE: func(target) for every conducting link of node, csr first then the overlay
+
+	template <typename LinkFn>
+	void for_each_link(const GhostGraph& graph, uint32_t node, LinkFn&& func) const
+	{
+		if (node < m_adjacency.node_count()) {
+			for (uint32_t link = m_adjacency.offsets[node]; link < m_adjacency.offsets[node + 1]; ++link) {
+				if (!(graph.edges[m_adjacency.edge_ids[link]].flags & ghost_edge_broken))
+					func(m_adjacency.targets[link]);
+			}
+		}
+
+		for (uint32_t link = m_overlay_head[node]; link != k_none; link = m_overlay_next[link]) {
+			if (!(graph.edges[m_overlay_edge[link]].flags & ghost_edge_broken))
+				func(m_overlay_target[link]);
+		}
+	}
+
+private:
+
+	struct Component
+	{
+		uint32_t head    {k_none};
+		uint32_t size    {0};
+		uint32_t sources {0};
+		uint64_t version {0};
+	};
+
+
+	void touch_component(uint32_t component)
+	{
+		m_components[component].version = ++m_version;
+	}
+
+
+	[[nodiscard]] static uint64_t tile_key(TileCoord tile)
+	{
+		static constexpr uint64_t fnv1a_offset_basis = 14695981039346656037ULL;
+		static constexpr uint64_t fnv1a_prime        = 1099511628211ULL;
+
+		uint64_t fnv1a_hash = fnv1a_offset_basis;
+
+		fnv1a_hash ^= static_cast<uint32_t>(tile.storey_stack); fnv1a_hash *= fnv1a_prime;
+		fnv1a_hash ^= static_cast<uint32_t>(tile.storey_index); fnv1a_hash *= fnv1a_prime;
+		fnv1a_hash ^= static_cast<uint32_t>(tile.x);            fnv1a_hash *= fnv1a_prime;
+		fnv1a_hash ^= static_cast<uint32_t>(tile.z);            fnv1a_hash *= fnv1a_prime;
+
+		return fnv1a_hash;
+	}
+
+
+	void sync_nodes(const GhostGraph& graph)
+	{
+		const uint32_t old_count = static_cast<uint32_t>(m_labels.size());
+		const uint32_t new_count = static_cast<uint32_t>(graph.nodes.size());
+
+		if (new_count <= old_count)
+			return;
+
+		m_labels.resize(new_count, k_none);
+		m_sources.resize(new_count, uint8_t {0});
+		m_member_prev.resize(new_count, k_none);
+		m_member_next.resize(new_count, k_none);
+		m_overlay_head.resize(new_count, k_none);
+		m_stamps.resize(new_count, 0U);
+
+		for (uint32_t node = old_count; node < new_count; ++node) {
+
+			const uint32_t component = claim_component();
+			link_member(component, node);
+
+			const uint64_t key = tile_key(graph.nodes[node].tile);
+			if (m_tile_index.find(key) == ChunkDirectory::k_empty_slot)
+				m_tile_index.insert(key, node);
+		}
+	}
+
+
+	[[nodiscard]] uint32_t claim_component()
+	{
+		++m_component_count;
+
+		if (!m_free_components.empty()) {
+			const uint32_t component = m_free_components.back();
+			m_free_components.pop_back();
+			m_components[component] = Component {};
+			return component;
+		}
+
+		m_components.emplace_back(Component {});
+		return static_cast<uint32_t>(m_components.size() - 1);
+	}
+
+
+	void release_component(uint32_t component)
+	{
+		HPR_ASSERT_MSG(m_components[component].size == 0, "[ghostconnectivity] releasing a live component");
+
+		--m_component_count;
+		m_free_components.emplace_back(component);
+	}
+
+
+	void link_member(uint32_t component, uint32_t node)
+	{
+		Component& target = m_components[component];
+
+		m_member_prev[node] = k_none;
+		m_member_next[node] = target.head;
+
+		if (target.head != k_none)
+			m_member_prev[target.head] = node;
+
+		target.head = node;
+		++target.size;
+
+		if (m_sources[node])
+			++target.sources;
+
+		target.version = ++m_version;
+
+		m_labels[node] = component;
+	}
+
+
+	void unlink_member(uint32_t node)
+	{
+		Component& source = m_components[m_labels[node]];
+
+		if (m_member_prev[node] != k_none)
+			m_member_next[m_member_prev[node]] = m_member_next[node];
+		else
+			source.head = m_member_next[node];
+
+		if (m_member_next[node] != k_none)
+			m_member_prev[m_member_next[node]] = m_member_prev[node];
+
+		--source.size;
+
+		if (m_sources[node])
+			--source.sources;
+
+		source.version = ++m_version;
+	}
+
+
+	void merge(uint32_t node_a, uint32_t node_b)
+	{
+		uint32_t keep = m_labels[node_a];
+		uint32_t drop = m_labels[node_b];
+
+		if (keep == drop)
+			return;
+
+		if (m_components[keep].size < m_components[drop].size)
+			std::swap(keep, drop);
+
+		uint32_t node = m_components[drop].head;
+
+		while (node != k_none) {
+			const uint32_t next = m_member_next[node];
+
+			unlink_member(node);
+			link_member(keep, node);
+
+			node = next;
+		}
+
+		release_component(drop);
+	}
+
+
+	void split(const GhostGraph& graph, uint32_t node_a, uint32_t node_b)
+	{
+		if (node_a == node_b || m_labels[node_a] != m_labels[node_b])
+			return;
+
+		if (m_stamp > 0xFFFFFFFFU - 2) {
+			std::fill(m_stamps.begin(), m_stamps.end(), 0U);
+			m_stamp = 0;
+		}
+
+		const uint32_t stamp_a = ++m_stamp;
+		const uint32_t stamp_b = ++m_stamp;
+
+		m_queue_a.clear();
+		m_queue_b.clear();
+
+		m_queue_a.emplace_back(node_a);
+		m_queue_b.emplace_back(node_b);
+
+		m_stamps[node_a] = stamp_a;
+		m_stamps[node_b] = stamp_b;
+
+		uint32_t cursor_a = 0;
+		uint32_t cursor_b = 0;
+
+		bool met = false;
+
+		const auto expand = [&](mtp::vault<uint32_t, mtp::default_set>& queue, uint32_t& cursor, uint32_t own_stamp, uint32_t other_stamp) {
+			const uint32_t node = queue[cursor++];
+
+			for_each_link(graph, node, [&](uint32_t target) {
+				if (met || m_stamps[target] == own_stamp)
+					return;
+
+				if (m_stamps[target] == other_stamp) {
+					met = true;
+					return;
+				}
+
+				m_stamps[target] = own_stamp;
+				queue.emplace_back(target);
+			});
+		};
+
+		const mtp::vault<uint32_t, mtp::default_set>* separated = nullptr;
+
+		for (;;) {
+			if (cursor_a == m_queue_a.size()) {
+				separated = &m_queue_a;
+				break;
+			}
+			if (cursor_b == m_queue_b.size()) {
+				separated = &m_queue_b;
+				break;
+			}
+
+			expand(m_queue_a, cursor_a, stamp_a, stamp_b);
+			if (met)
+				return;
+
+			expand(m_queue_b, cursor_b, stamp_b, stamp_a);
+			if (met)
+				return;
+		}
+
+		const uint32_t component = claim_component();
+
+		for (const uint32_t node : *separated) {
+			unlink_member(node);
+			link_member(component, node);
+		}
+	}
+
+
+	void push_overlay(uint32_t node, uint32_t target, uint32_t edge_idx)
+	{
+		m_overlay_next.emplace_back(m_overlay_head[node]);
+		m_overlay_target.emplace_back(target);
+		m_overlay_edge.emplace_back(edge_idx);
+
+		m_overlay_head[node] = static_cast<uint32_t>(m_overlay_target.size() - 1);
+	}
+
+
+	void fold_overlay(const GhostGraph& graph)
+	{
+		m_adjacency.build(graph, m_edge_count);
+
+		std::fill(m_overlay_head.begin(), m_overlay_head.end(), k_none);
+
+		m_overlay_next.clear();
+		m_overlay_target.clear();
+		m_overlay_edge.clear();
+	}
+
+private:
+
+	GhostAdjacency m_adjacency;
+
+	mtp::vault<uint32_t, mtp::default_set> m_labels;
+	mtp::vault<uint8_t,  mtp::default_set> m_sources;
+	mtp::vault<uint32_t, mtp::default_set> m_member_prev;
+	mtp::vault<uint32_t, mtp::default_set> m_member_next;
+
+	mtp::vault<Component, mtp::default_set> m_components;
+	mtp::vault<uint32_t,  mtp::default_set> m_free_components;
+	uint32_t                                m_component_count {0};
+	uint64_t                                m_version         {0};
+
+	mtp::vault<uint32_t, mtp::default_set> m_overlay_head;
+	mtp::vault<uint32_t, mtp::default_set> m_overlay_next;
+	mtp::vault<uint32_t, mtp::default_set> m_overlay_target;
+	mtp::vault<uint32_t, mtp::default_set> m_overlay_edge;
+
+	uint32_t m_edge_count {0};
+
+	mtp::vault<uint32_t, mtp::default_set> m_stamps;
+	mtp::vault<uint32_t, mtp::default_set> m_queue_a;
+	mtp::vault<uint32_t, mtp::default_set> m_queue_b;
+	uint32_t                               m_stamp {0};
+
+	ChunkDirectory m_tile_index;
+};
+
+
+struct GhostInfraLinks
+{
+	GhostConnectivity power;
+	GhostConnectivity data;
+	GhostConnectivity pipe;
+};
+
+
+} // hpr::scn
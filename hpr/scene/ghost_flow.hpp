@@ -0,0 +1,418 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "job_latch.hpp"
+#include "scheduler.hpp"
+
+#include "ghost_infra.hpp"
+#include "ghost_connectivity.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr uint32_t ghost_flow_job_grain  = 8U;
+	inline constexpr uint32_t ghost_flow_max_sweeps = 16U;
+	inline constexpr float    ghost_flow_epsilon    = 1.0e-4f;
+
+} // hpr::scn::cfg
+
+
+// NOTE: balance  - power, supply shared out over demand per component, potential = satisfaction
+//       reach    - data, hop latency from the nearest supplying node, potential = 1 when reached
+//       pressure - pipes, supplying nodes hold their head, the rest relax towards the mean of
+//                  their links with demand draining to zero; warm started from the last tick
+
+enum class GhostFlowModel : uint8_t
+{
+	balance = 0,
+	reach,
+	pressure
+};
+
+
+// NOTE: per node results are structure of arrays indexed by graph node. a component is solved
+//       again only when its connectivity version moved, an input of one of its nodes changed or
+//       the pressure relaxation has not converged yet; components run in parallel on the workers
+
+class GhostFlow
+{
+public:
+
+	static constexpr uint32_t k_unreached = 0xFFFFFFFFU;
+
+public:
+
+	explicit GhostFlow(GhostFlowModel model = GhostFlowModel::balance)
+		: m_model {model}
+	{}
+
+
+	void clear()
+	{
+		m_supply.clear();
+		m_demand.clear();
+		m_potential.clear();
+		m_delivered.clear();
+		m_latency.clear();
+
+		m_solved_versions.clear();
+		m_converged.clear();
+		m_touched.clear();
+
+		m_solved_count = 0;
+	}
+
+
+	[[nodiscard]] GhostFlowModel model() const
+	{
+		return m_model;
+	}
+
+
+	void set_supply(uint32_t node, float supply)
+	{
+		reserve_nodes(node + 1);
+
+		if (m_supply[node] != supply) {
+			m_supply[node] = supply;
+			m_touched.emplace_back(node);
+		}
+	}
+
+
+	void set_demand(uint32_t node, float demand)
+	{
+		reserve_nodes(node + 1);
+
+		if (m_demand[node] != demand) {
+			m_demand[node] = demand;
+			m_touched.emplace_back(node);
+		}
+	}
+
+
+	[[nodiscard]] const mtp::vault<float,    mtp::default_set>& supply()    const { return m_supply; }
+	[[nodiscard]] const mtp::vault<float,    mtp::default_set>& demand()    const { return m_demand; }
+	[[nodiscard]] const mtp::vault<float,    mtp::default_set>& potential() const { return m_potential; }
+	[[nodiscard]] const mtp::vault<float,    mtp::default_set>& delivered() const { return m_delivered; }
+	[[nodiscard]] const mtp::vault<uint32_t, mtp::default_set>& latency()   const { return m_latency; }
+
+
+	// NOTE: components solved by the last solve(), zero once everything has settled
+
+	[[nodiscard]] uint32_t solved_count() const
+	{
+		return m_solved_count;
+	}
+
+
+	void solve(job::Scheduler& job_scheduler, const GhostGraph& graph, const GhostConnectivity& connectivity)
+	{
+		const uint32_t node_count      = connectivity.node_count();
+		const uint32_t component_limit = connectivity.component_capacity();
+
+		m_solved_count = 0;
+
+		reserve_nodes(node_count);
+
+		m_solved_versions.resize(component_limit, uint64_t {0});
+		m_converged.resize(component_limit, uint8_t {0});
+
+		for (const uint32_t node : m_touched) {
+			if (node < node_count)
+				m_converged[connectivity.component_of(node)] = 0;
+		}
+		m_touched.clear();
+
+		if (node_count == 0)
+			return;
+
+		// NOTE: counting sort by label, members of component c are [offsets[c], offsets[c + 1])
+
+		m_member_offsets.clear();
+		m_member_offsets.resize(component_limit + 1, 0U);
+		m_members.resize(node_count);
+
+		for (uint32_t node = 0; node < node_count; ++node)
+			++m_member_offsets[connectivity.component_of(node) + 1];
+
+		for (uint32_t component = 0; component < component_limit; ++component)
+			m_member_offsets[component + 1] += m_member_offsets[component];
+
+		m_member_cursor.resize(component_limit);
+		std::copy_n(m_member_offsets.data(), component_limit, m_member_cursor.data());
+
+		for (uint32_t node = 0; node < node_count; ++node)
+			m_members[m_member_cursor[connectivity.component_of(node)]++] = node;
+
+		m_tasks.clear();
+
+		for (uint32_t component = 0; component < component_limit; ++component) {
+
+			if (m_member_offsets[component + 1] == m_member_offsets[component])
+				continue;
+
+			const bool stale = m_solved_versions[component] != connectivity.component_version(component);
+
+			if (stale || !m_converged[component])
+				m_tasks.emplace_back(SolveTask {.component = component});
+		}
+
+		const uint32_t task_count = static_cast<uint32_t>(m_tasks.size());
+		if (task_count == 0)
+			return;
+
+		const uint32_t job_count = (task_count + cfg::ghost_flow_job_grain - 1) / cfg::ghost_flow_job_grain;
+
+		m_slices.resize(job_count);
+		m_slice_queues.resize(job_count);
+
+		for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx) {
+
+			SolveJobSlice& slice = m_slices[job_idx];
+
+			slice.flow         = this;
+			slice.graph        = &graph;
+			slice.connectivity = &connectivity;
+			slice.queue        = &m_slice_queues[job_idx];
+		}
+
+		job::JobLatch job_latch;
+
+		job_scheduler.dispatch_range(
+			job_latch,
+			&solve_components,
+			task_count,
+			cfg::ghost_flow_job_grain,
+			m_slices.data()
+		);
+
+		job_latch.wait();
+
+		for (const SolveTask& task : m_tasks) {
+			m_solved_versions[task.component] = connectivity.component_version(task.component);
+			m_converged[task.component]       = task.converged ? 1U : 0U;
+		}
+
+		m_solved_count = task_count;
+	}
+
+private:
+
+	struct SolveTask
+	{
+		uint32_t component {0};
+		bool     converged {false};
+	};
+
+	struct SolveJobSlice
+	{
+		uint32_t begin;
+		uint32_t end;
+
+		GhostFlow*               flow;
+		const GhostGraph*        graph;
+		const GhostConnectivity* connectivity;
+
+		mtp::vault<uint32_t, mtp::default_set>* queue;
+	};
+
+
+	void reserve_nodes(uint32_t node_count)
+	{
+		if (m_supply.size() >= node_count)
+			return;
+
+		m_supply.resize(node_count, 0.0f);
+		m_demand.resize(node_count, 0.0f);
+		m_potential.resize(node_count, 0.0f);
+		m_delivered.resize(node_count, 0.0f);
+		m_latency.resize(node_count, k_unreached);
+	}
+
+
+	static void solve_components(void* slice_raw)
+	{
+		auto* slice = static_cast<SolveJobSlice*>(slice_raw);
+
+		GhostFlow& flow = *slice->flow;
+
+		for (uint32_t task_idx = slice->begin; task_idx < slice->end; ++task_idx) {
+
+			SolveTask& task = flow.m_tasks[task_idx];
+
+			const uint32_t* members_beg = flow.m_members.data() + flow.m_member_offsets[task.component];
+			const uint32_t* members_end = flow.m_members.data() + flow.m_member_offsets[task.component + 1];
+
+			switch (flow.m_model) {
+				case GhostFlowModel::balance:
+					task.converged = flow.solve_balance(members_beg, members_end);
+					break;
+				case GhostFlowModel::reach:
+					task.converged = flow.solve_reach(*slice->graph, *slice->connectivity, members_beg, members_end, *slice->queue);
+					break;
+				case GhostFlowModel::pressure:
+					task.converged = flow.solve_pressure(*slice->graph, *slice->connectivity, members_beg, members_end);
+					break;
+			}
+		}
+	}
+
+
+	bool solve_balance(const uint32_t* members_beg, const uint32_t* members_end)
+	{
+		float total_supply = 0.0f;
+		float total_demand = 0.0f;
+
+		for (const uint32_t* member = members_beg; member != members_end; ++member) {
+			total_supply += m_supply[*member];
+			total_demand += m_demand[*member];
+		}
+
+		const float satisfaction = (total_demand > 0.0f) ? std::min(1.0f, total_supply / total_demand) : 1.0f;
+
+		for (const uint32_t* member = members_beg; member != members_end; ++member) {
+			m_potential[*member] = satisfaction;
+			m_delivered[*member] = m_demand[*member] * satisfaction;
+		}
+
+		return true;
+	}
+
+
+	bool solve_reach(
+		const GhostGraph&                       graph,
+		const GhostConnectivity&                connectivity,
+		const uint32_t*                         members_beg,
+		const uint32_t*                         members_end,
+		mtp::vault<uint32_t, mtp::default_set>& queue
+	)
+	{
+		queue.clear();
+
+		for (const uint32_t* member = members_beg; member != members_end; ++member) {
+			if (m_supply[*member] > 0.0f) {
+				m_latency[*member] = 0;
+				queue.emplace_back(*member);
+			}
+			else {
+				m_latency[*member] = k_unreached;
+			}
+		}
+
+		for (uint32_t cursor = 0; cursor < queue.size(); ++cursor) {
+
+			const uint32_t node    = queue[cursor];
+			const uint32_t latency = m_latency[node] + 1;
+
+			connectivity.for_each_link(graph, node, [&](uint32_t target) {
+				if (m_latency[target] == k_unreached) {
+					m_latency[target] = latency;
+					queue.emplace_back(target);
+				}
+			});
+		}
+
+		for (const uint32_t* member = members_beg; member != members_end; ++member) {
+			const bool reached = m_latency[*member] != k_unreached;
+
+			m_potential[*member] = reached ? 1.0f : 0.0f;
+			m_delivered[*member] = reached ? m_demand[*member] : 0.0f;
+		}
+
+		return true;
+	}
+
+
+	bool solve_pressure(
+		const GhostGraph&        graph,
+		const GhostConnectivity& connectivity,
+		const uint32_t*          members_beg,
+		const uint32_t*          members_end
+	)
+	{
+		float max_delta = 0.0f;
+
+		for (uint32_t sweep = 0; sweep < cfg::ghost_flow_max_sweeps; ++sweep) {
+
+			max_delta = 0.0f;
+
+			for (const uint32_t* member = members_beg; member != members_end; ++member) {
+
+				const uint32_t node = *member;
+
+				float pressure = m_supply[node];
+
+				if (pressure <= 0.0f) {
+
+					float    link_sum   = 0.0f;
+					uint32_t link_count = 0;
+
+					connectivity.for_each_link(graph, node, [&](uint32_t target) {
+						link_sum += m_potential[target];
+						++link_count;
+					});
+
+					const float weight = static_cast<float>(link_count) + m_demand[node];
+					pressure = (weight > 0.0f) ? link_sum / weight : 0.0f;
+				}
+
+				max_delta = std::max(max_delta, std::fabs(pressure - m_potential[node]));
+				m_potential[node] = pressure;
+			}
+
+			if (max_delta < cfg::ghost_flow_epsilon)
+				break;
+		}
+
+		for (const uint32_t* member = members_beg; member != members_end; ++member)
+			m_delivered[*member] = m_demand[*member] * m_potential[*member];
+
+		return max_delta < cfg::ghost_flow_epsilon;
+	}
+
+private:
+
+	GhostFlowModel m_model;
+
+	mtp::vault<float,    mtp::default_set> m_supply;
+	mtp::vault<float,    mtp::default_set> m_demand;
+	mtp::vault<float,    mtp::default_set> m_potential;
+	mtp::vault<float,    mtp::default_set> m_delivered;
+	mtp::vault<uint32_t, mtp::default_set> m_latency;
+
+	mtp::vault<uint64_t, mtp::default_set> m_solved_versions;
+	mtp::vault<uint8_t,  mtp::default_set> m_converged;
+	mtp::vault<uint32_t, mtp::default_set> m_touched;
+
+	mtp::vault<uint32_t, mtp::default_set> m_member_offsets;
+	mtp::vault<uint32_t, mtp::default_set> m_member_cursor;
+	mtp::vault<uint32_t, mtp::default_set> m_members;
+
+	mtp::vault<SolveTask,     mtp::default_set> m_tasks;
+	mtp::vault<SolveJobSlice, mtp::default_set> m_slices;
+
+	mtp::vault<mtp::vault<uint32_t, mtp::default_set>, mtp::default_set> m_slice_queues;
+
+	uint32_t m_solved_count {0};
+};
+
+
+struct GhostInfraFlow
+{
+	GhostFlow power {GhostFlowModel::balance};
+	GhostFlow data  {GhostFlowModel::reach};
+	GhostFlow pipe  {GhostFlowModel::pressure};
+};
+
+
+} // hpr::scn
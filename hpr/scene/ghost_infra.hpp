@@ -42,13 +42,16 @@ struct GhostNode
 };
 
 
+inline constexpr uint8_t ghost_edge_broken = 1U << 0;
+
+
 struct GhostEdge
 {
 	uint32_t a;
 	uint32_t b;
 	GhostChannel channel;
 
-	// TODO: per-edge damage state - broken segments
+	// NOTE: ghost_edge_broken segments stay in the graph but do not conduct
 
 	uint8_t flags {0};
 };
@@ -0,0 +1,513 @@
+#pragma once
+
+#include <span>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "panic.hpp"
+
+#include "math.hpp"
+#include "ray_data.hpp"
+#include "stratum.hpp"
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "voxel_data.hpp"
+#include "voxel_field.hpp"
+
+
+namespace hpr::scn {
+
+
+enum class GridFace : uint8_t
+{
+	none = 0,
+	pos_x,
+	neg_x,
+	pos_y,
+	neg_y,
+	pos_z,
+	neg_z
+};
+
+
+struct VoxelRayHit
+{
+	bool       hit      {false};
+	VoxelCoord coord    {};
+	GridFace   face     {GridFace::none};
+	float      distance {std::numeric_limits<float>::infinity()};
+	VoxelType  voxel    {0};
+};
+
+
+struct TileRayHit
+{
+	bool      hit      {false};
+	TileCoord coord    {};
+	GridFace  face     {GridFace::none};
+	float     distance {std::numeric_limits<float>::infinity()};
+	TileType  tile     {0};
+};
+
+
+struct GridCellNonEmpty
+{
+	[[nodiscard]] bool operator()(uint16_t cell) const
+	{
+		return cell != 0;
+	}
+};
+
+
+namespace detail {
+
+	// NOTE: amanatides-woo stepping, t_max is measured from the ray origin so long walks do not drift
+
+	template <uint32_t Dims>
+	struct GridDda
+	{
+		int32_t cell    [Dims];
+		int32_t step    [Dims];
+		float   t_max   [Dims];
+		float   t_delta [Dims];
+
+		void init(
+			const float*   origin,
+			const float*   direction,
+			float          cell_size,
+			float          t_start,
+			const int32_t* cell_min = nullptr,
+			const int32_t* cell_max = nullptr
+		)
+		{
+			static constexpr float inf = std::numeric_limits<float>::infinity();
+
+			for (uint32_t axis = 0; axis < Dims; ++axis) {
+
+				const float position = origin[axis] + direction[axis] * t_start;
+
+				cell[axis] = static_cast<int32_t>(floorf(position / cell_size));
+
+				if (cell_min)
+					cell[axis] = std::clamp(cell[axis], cell_min[axis], cell_max[axis]);
+
+				if (direction[axis] > 0.0f) {
+					step[axis]    = 1;
+					t_max[axis]   = (static_cast<float>(cell[axis] + 1) * cell_size - origin[axis]) / direction[axis];
+					t_delta[axis] = cell_size / direction[axis];
+				}
+				else if (direction[axis] < 0.0f) {
+					step[axis]    = -1;
+					t_max[axis]   = (static_cast<float>(cell[axis]) * cell_size - origin[axis]) / direction[axis];
+					t_delta[axis] = -cell_size / direction[axis];
+				}
+				else {
+					step[axis]    = 0;
+					t_max[axis]   = inf;
+					t_delta[axis] = inf;
+				}
+			}
+		}
+
+		[[nodiscard]] int32_t next_axis() const
+		{
+			uint32_t axis = 0;
+			for (uint32_t other = 1; other < Dims; ++other) {
+				if (t_max[other] < t_max[axis])
+					axis = other;
+			}
+			return static_cast<int32_t>(axis);
+		}
+
+		[[nodiscard]] float t_next() const
+		{
+			return t_max[next_axis()];
+		}
+
+		int32_t advance()
+		{
+			const int32_t axis = next_axis();
+
+			cell[axis]  += step[axis];
+			t_max[axis] += t_delta[axis];
+
+			return axis;
+		}
+
+		// NOTE: true once the walk is outside [cell_min, cell_max] on an axis it can not come back along
+
+		[[nodiscard]] bool has_left(const int32_t* cell_min, const int32_t* cell_max) const
+		{
+			for (uint32_t axis = 0; axis < Dims; ++axis) {
+				if (cell[axis] < cell_min[axis] && step[axis] <= 0)
+					return true;
+				if (cell[axis] > cell_max[axis] && step[axis] >= 0)
+					return true;
+			}
+			return false;
+		}
+	};
+
+
+	// NOTE: grid axis 0/1/2 = x/y/z, stepping +x enters the next cell through its -x face
+
+	[[nodiscard]] inline GridFace entry_face(int32_t axis, int32_t step)
+	{
+		static constexpr GridFace faces[3][2] {
+			{GridFace::neg_x, GridFace::pos_x},
+			{GridFace::neg_y, GridFace::pos_y},
+			{GridFace::neg_z, GridFace::pos_z}
+		};
+
+		return faces[axis][step > 0 ? 0 : 1];
+	}
+
+} // hpr::scn::detail
+
+
+// NOTE: walks chunks first and only descends into loaded chunks that can block,
+//       the walk ends once it leaves the field chunk extent so unbounded rays terminate,
+//       distance is in world units along the normalized ray
+
+template <typename BlockFn>
+[[nodiscard]] VoxelRayHit raycast_voxels(
+	const VoxelField&      voxelfield,
+	const VoxelGridParams& grid,
+	const Ray&             ray,
+	float                  max_distance,
+	BlockFn&&              is_blocking
+)
+{
+	static constexpr int32_t chunk_size = VoxelField::k_chunk_size;
+
+	VoxelRayHit ray_hit {};
+
+	const float direction_len = glm::length(ray.direction);
+	if (direction_len <= 0.0f)
+		return ray_hit;
+
+	const vec3  direction = ray.direction / direction_len;
+	const float size_inv  = 1.0f / grid.voxel_size;
+	const vec3  local     = (ray.origin - grid.origin_world) * size_inv;
+
+	const float origin_grid[3]    {local.x, local.y, local.z};
+	const float direction_grid[3] {direction.x, direction.y, direction.z};
+
+	const float t_limit = max_distance * size_inv;
+
+	if (voxelfield.empty())
+		return ray_hit;
+
+	const VoxelField::ChunkExtent& chunk_extent = voxelfield.chunk_extent();
+
+	const int32_t chunk_min[3] {chunk_extent.min.chunk_x, chunk_extent.min.chunk_y, chunk_extent.min.chunk_z};
+	const int32_t chunk_max[3] {chunk_extent.max.chunk_x, chunk_extent.max.chunk_y, chunk_extent.max.chunk_z};
+
+	detail::GridDda<3> chunk_dda;
+	chunk_dda.init(origin_grid, direction_grid, static_cast<float>(chunk_size), 0.0f);
+
+	int32_t entry_axis = -1;
+	float   t_enter    = 0.0f;
+
+	while (t_enter <= t_limit && !chunk_dda.has_left(chunk_min, chunk_max)) {
+
+		const float t_exit = std::min(chunk_dda.t_next(), t_limit);
+
+		const VoxelChunkCoord chunk_coord {chunk_dda.cell[0], chunk_dda.cell[1], chunk_dda.cell[2]};
+		const VoxelField::VoxelChunk* chunk = voxelfield.find_chunk(chunk_coord);
+
+		const bool can_block = chunk && !(chunk->voxels.uniform() && !is_blocking(chunk->voxels.get(0)));
+
+		if (can_block) {
+
+			const int32_t cell_min[3] {
+				chunk_coord.chunk_x * chunk_size,
+				chunk_coord.chunk_y * chunk_size,
+				chunk_coord.chunk_z * chunk_size
+			};
+
+			const int32_t cell_max[3] {
+				cell_min[0] + chunk_size - 1,
+				cell_min[1] + chunk_size - 1,
+				cell_min[2] + chunk_size - 1
+			};
+
+			detail::GridDda<3> voxel_dda;
+			voxel_dda.init(origin_grid, direction_grid, 1.0f, t_enter, cell_min, cell_max);
+
+			int32_t axis   = entry_axis;
+			float   t_cell = t_enter;
+
+			for (;;) {
+
+				const VoxelType voxel = chunk->voxels.get(VoxelField::chunk_local_index(
+					static_cast<uint32_t>(voxel_dda.cell[0] - cell_min[0]),
+					static_cast<uint32_t>(voxel_dda.cell[1] - cell_min[1]),
+					static_cast<uint32_t>(voxel_dda.cell[2] - cell_min[2])
+				));
+
+				if (is_blocking(voxel)) {
+					ray_hit.hit      = true;
+					ray_hit.coord    = VoxelCoord {voxel_dda.cell[0], voxel_dda.cell[1], voxel_dda.cell[2]};
+					ray_hit.face     = (axis < 0) ? GridFace::none : detail::entry_face(axis, voxel_dda.step[axis]);
+					ray_hit.distance = t_cell * grid.voxel_size;
+					ray_hit.voxel    = voxel;
+					return ray_hit;
+				}
+
+				t_cell = voxel_dda.t_next();
+				if (t_cell > t_exit || !std::isfinite(t_cell))
+					break;
+
+				axis = voxel_dda.advance();
+
+				if (voxel_dda.cell[axis] < cell_min[axis] || voxel_dda.cell[axis] > cell_max[axis])
+					break;
+			}
+		}
+
+		t_enter = chunk_dda.t_next();
+		if (!std::isfinite(t_enter))
+			break;
+
+		entry_axis = chunk_dda.advance();
+	}
+
+	return ray_hit;
+}
+
+
+[[nodiscard]] inline VoxelRayHit raycast_voxels(
+	const VoxelField&      voxelfield,
+	const VoxelGridParams& grid,
+	const Ray&             ray,
+	float                  max_distance
+)
+{
+	return raycast_voxels(voxelfield, grid, ray, max_distance, GridCellNonEmpty {});
+}
+
+
+// NOTE: 2d walk over one storey using the xz part of the ray, distance stays along the 3d ray;
+//       the y faces are never reported and a vertical ray only tests the tile under its origin
+
+template <typename BlockFn>
+[[nodiscard]] TileRayHit raycast_tiles(
+	const TileField&      tilefield,
+	const TileGridParams& grid,
+	const Ray&            ray,
+	int32_t               storey_index,
+	int32_t               storey_stack,
+	float                 max_distance,
+	BlockFn&&             is_blocking
+)
+{
+	static constexpr int32_t chunk_size = cfg::chunk_size;
+
+	TileRayHit ray_hit {};
+
+	const float direction_len = glm::length(ray.direction);
+	if (direction_len <= 0.0f)
+		return ray_hit;
+
+	const vec3  direction = ray.direction / direction_len;
+	const float size_inv  = 1.0f / grid.tile_size;
+	const vec3  local     = (ray.origin - grid.origin_world) * size_inv;
+
+	const float origin_grid[2]    {local.x, local.z};
+	const float direction_grid[2] {direction.x, direction.z};
+
+	static constexpr int32_t grid_axis_of[2] {0, 2};
+
+	const float t_limit = max_distance * size_inv;
+
+	if (tilefield.empty())
+		return ray_hit;
+
+	const TileField::ChunkExtent& chunk_extent = tilefield.chunk_extent();
+
+	const int32_t chunk_min[2] {chunk_extent.chunk_x_min, chunk_extent.chunk_z_min};
+	const int32_t chunk_max[2] {chunk_extent.chunk_x_max, chunk_extent.chunk_z_max};
+
+	detail::GridDda<2> chunk_dda;
+	chunk_dda.init(origin_grid, direction_grid, static_cast<float>(chunk_size), 0.0f);
+
+	int32_t entry_axis = -1;
+	float   t_enter    = 0.0f;
+
+	while (t_enter <= t_limit && !chunk_dda.has_left(chunk_min, chunk_max)) {
+
+		const float t_exit = std::min(chunk_dda.t_next(), t_limit);
+
+		const TileChunkCoord chunk_coord {
+			.chunk_x      = chunk_dda.cell[0],
+			.chunk_z      = chunk_dda.cell[1],
+			.storey_index = storey_index,
+			.storey_stack = storey_stack
+		};
+
+		if (const TileChunk* chunk = tilefield.find_chunk(chunk_coord)) {
+
+			const int32_t cell_min[2] {
+				chunk_coord.chunk_x << cfg::chunk_shift,
+				chunk_coord.chunk_z << cfg::chunk_shift
+			};
+
+			const int32_t cell_max[2] {
+				cell_min[0] + chunk_size - 1,
+				cell_min[1] + chunk_size - 1
+			};
+
+			detail::GridDda<2> tile_dda;
+			tile_dda.init(origin_grid, direction_grid, 1.0f, t_enter, cell_min, cell_max);
+
+			int32_t axis   = entry_axis;
+			float   t_cell = t_enter;
+
+			for (;;) {
+
+				const TileType tile = chunk->tiles[get_local_index(
+					tile_dda.cell[0] - cell_min[0],
+					tile_dda.cell[1] - cell_min[1]
+				)];
+
+				if (is_blocking(tile)) {
+					ray_hit.hit      = true;
+					ray_hit.coord    = TileCoord {tile_dda.cell[0], tile_dda.cell[1], storey_index, storey_stack};
+					ray_hit.face     = (axis < 0) ? GridFace::none : detail::entry_face(grid_axis_of[axis], tile_dda.step[axis]);
+					ray_hit.distance = t_cell * grid.tile_size;
+					ray_hit.tile     = tile;
+					return ray_hit;
+				}
+
+				t_cell = tile_dda.t_next();
+				if (t_cell > t_exit || !std::isfinite(t_cell))
+					break;
+
+				axis = tile_dda.advance();
+
+				if (tile_dda.cell[axis] < cell_min[axis] || tile_dda.cell[axis] > cell_max[axis])
+					break;
+			}
+		}
+
+		t_enter = chunk_dda.t_next();
+		if (!std::isfinite(t_enter))
+			break;
+
+		entry_axis = chunk_dda.advance();
+	}
+
+	return ray_hit;
+}
+
+
+[[nodiscard]] inline TileRayHit raycast_tiles(
+	const TileField&      tilefield,
+	const TileGridParams& grid,
+	const Ray&            ray,
+	int32_t               storey_index,
+	int32_t               storey_stack,
+	float                 max_distance
+)
+{
+	return raycast_tiles(tilefield, grid, ray, storey_index, storey_stack, max_distance, GridCellNonEmpty {});
+}
+
+
+// NOTE: picking against the storey floor planes drawn by the tile layer, nearest non-empty tile wins
+
+[[nodiscard]] inline TileRayHit raycast_tile_floors(
+	const TileField&      tilefield,
+	const Stratum&        stratum,
+	const TileGridParams& grid,
+	const Ray&            ray,
+	int32_t               storey_stack,
+	int32_t               storey_min,
+	int32_t               storey_max,
+	float                 max_distance
+)
+{
+	TileRayHit ray_hit {};
+
+	const float direction_len = glm::length(ray.direction);
+	if (direction_len <= 0.0f)
+		return ray_hit;
+
+	const vec3 direction = ray.direction / direction_len;
+
+	if (fabsf(direction.y) <= std::numeric_limits<float>::epsilon())
+		return ray_hit;
+
+	for (int32_t storey_index = storey_min; storey_index <= storey_max; ++storey_index) {
+
+		const Storey* storey = stratum.find_storey(storey_stack, storey_index);
+		if (!storey)
+			continue;
+
+		const float floor_y = grid.origin_world.y + static_cast<float>(storey->voxel_y_beg) * grid.tile_size;
+		const float hit_distance = (floor_y - ray.origin.y) / direction.y;
+
+		if (hit_distance < 0.0f || hit_distance > max_distance || hit_distance >= ray_hit.distance)
+			continue;
+
+		const vec3 hit_position = ray.origin + direction * hit_distance;
+
+		TileCoord tile_coord {
+			static_cast<int32_t>(floorf((hit_position.x - grid.origin_world.x) / grid.tile_size)),
+			static_cast<int32_t>(floorf((hit_position.z - grid.origin_world.z) / grid.tile_size)),
+			storey_index,
+			storey_stack
+		};
+
+		const TileType tile = tilefield.get(tile_coord);
+		if (tile == 0)
+			continue;
+
+		ray_hit.hit      = true;
+		ray_hit.coord    = tile_coord;
+		ray_hit.face     = direction.y < 0.0f ? GridFace::pos_y : GridFace::neg_y;
+		ray_hit.distance = hit_distance;
+		ray_hit.tile     = tile;
+	}
+
+	return ray_hit;
+}
+
+
+inline void raycast_voxels_batch(
+	const VoxelField&           voxelfield,
+	const VoxelGridParams&      grid,
+	std::span<const Ray>        rays,
+	float                       max_distance,
+	std::span<VoxelRayHit>      ray_hits
+)
+{
+	HPR_ASSERT_MSG(ray_hits.size() >= rays.size(), "[gridraycast] hit span smaller than ray span");
+
+	for (size_t ray_idx = 0; ray_idx < rays.size(); ++ray_idx)
+		ray_hits[ray_idx] = raycast_voxels(voxelfield, grid, rays[ray_idx], max_distance);
+}
+
+
+inline void raycast_tiles_batch(
+	const TileField&       tilefield,
+	const TileGridParams&  grid,
+	std::span<const Ray>   rays,
+	int32_t                storey_index,
+	int32_t                storey_stack,
+	float                  max_distance,
+	std::span<TileRayHit>  ray_hits
+)
+{
+	HPR_ASSERT_MSG(ray_hits.size() >= rays.size(), "[gridraycast] hit span smaller than ray span");
+
+	for (size_t ray_idx = 0; ray_idx < rays.size(); ++ray_idx)
+		ray_hits[ray_idx] = raycast_tiles(tilefield, grid, rays[ray_idx], storey_index, storey_stack, max_distance);
+}
+
+
+} // hpr::scn
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "math.hpp"
+
+
+namespace hpr::scn {
+
+
+struct Ray
+{
+	vec3 origin;
+	vec3 direction;
+};
+
+
+} // hpr::scn
@@ -0,0 +1,394 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "panic.hpp"
+
+#include "log.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr uint32_t region_sector_bytes = 4096U;
+	inline constexpr uint32_t region_slot_count   = 256U;
+
+} // hpr::scn::cfg
+
+
+enum class RegionKind : uint32_t
+{
+	tile  = 1,
+	voxel = 2
+};
+
+
+struct RegionCoord
+{
+	int32_t axis[4];
+};
+
+
+struct RegionSlot
+{
+	uint32_t sector_beg    {0};
+	uint32_t sector_count  {0};
+	uint32_t payload_bytes {0};
+};
+
+
+struct RegionHeader
+{
+	uint32_t    magic;
+	uint32_t    version;
+	RegionKind  kind;
+	uint32_t    slot_count;
+	RegionCoord coord;
+	RegionSlot  slots[cfg::region_slot_count];
+};
+
+
+// NOTE: one file per region - header index in the first sectors, chunk payloads in page aligned
+//       4 KiB sector runs after it. the whole file is mapped shared so opening a region touches
+//       only the header page and chunk pages fault in when read
+
+class RegionFile
+{
+public:
+
+	static constexpr uint32_t k_magic   = 0x47525048U; // HPRG
+	static constexpr uint32_t k_version = 1U;
+
+	static constexpr uint32_t k_header_sectors =
+		static_cast<uint32_t>((sizeof(RegionHeader) + cfg::region_sector_bytes - 1) / cfg::region_sector_bytes);
+
+public:
+
+	RegionFile() = default;
+
+	~RegionFile()
+	{
+		close();
+	}
+
+	RegionFile(const RegionFile&) = delete;
+	RegionFile& operator=(const RegionFile&) = delete;
+
+	RegionFile(RegionFile&& other) noexcept
+		: m_file_handle  {std::exchange(other.m_file_handle, -1)}
+		, m_base         {std::exchange(other.m_base, nullptr)}
+		, m_mapped_bytes {std::exchange(other.m_mapped_bytes, 0)}
+	{}
+
+	RegionFile& operator=(RegionFile&& other) noexcept
+	{
+		if (this != &other) {
+			close();
+			m_file_handle  = std::exchange(other.m_file_handle, -1);
+			m_base         = std::exchange(other.m_base, nullptr);
+			m_mapped_bytes = std::exchange(other.m_mapped_bytes, 0);
+		}
+		return *this;
+	}
+
+
+	bool open(const char* file_path, RegionKind kind, RegionCoord coord)
+	{
+		HPR_ASSERT_MSG(file_path, "file_path == null");
+
+		close();
+
+		m_file_handle = ::open(file_path, O_RDWR | O_CREAT, 0644);
+		if (m_file_handle < 0) {
+			HPR_ERROR(log::LogCategory::scene, "[regionfile][open] open fail [path %s]", file_path);
+			return false;
+		}
+
+		struct stat file_stat {};
+		if (::fstat(m_file_handle, &file_stat) != 0) {
+			HPR_ERROR(log::LogCategory::scene, "[regionfile][open] fstat fail [path %s]", file_path);
+			close();
+			return false;
+		}
+
+		const size_t file_bytes = static_cast<size_t>(file_stat.st_size);
+		const bool   created    = file_bytes == 0;
+
+		if (created) {
+			if (!resize_file(k_header_sectors)) {
+				close();
+				return false;
+			}
+		}
+		else if (file_bytes < k_header_sectors * cfg::region_sector_bytes || file_bytes % cfg::region_sector_bytes != 0) {
+			HPR_ERROR(log::LogCategory::scene, "[regionfile][open] bad size [path %s][bytes %zu]", file_path, file_bytes);
+			close();
+			return false;
+		}
+		else if (!map(file_bytes)) {
+			close();
+			return false;
+		}
+
+		RegionHeader& region_header = header();
+
+		if (created) {
+			region_header.magic      = k_magic;
+			region_header.version    = k_version;
+			region_header.kind       = kind;
+			region_header.slot_count = cfg::region_slot_count;
+			region_header.coord      = coord;
+			return true;
+		}
+
+		if (region_header.magic != k_magic ||
+			region_header.version != k_version ||
+			region_header.kind != kind ||
+			region_header.slot_count != cfg::region_slot_count) {
+			HPR_ERROR(log::LogCategory::scene, "[regionfile][open] header mismatch [path %s]", file_path);
+			close();
+			return false;
+		}
+
+		// NOTE: slots pointing outside the mapping or over the header come from a truncated
+		//       or corrupt file, they are dropped so reads and gap searches never see them
+
+		uint32_t dropped_count = 0;
+
+		for (RegionSlot& region_slot : region_header.slots) {
+			if (!is_slot_valid(region_slot)) {
+				region_slot = RegionSlot {};
+				++dropped_count;
+			}
+		}
+
+		if (dropped_count != 0)
+			HPR_WARN(log::LogCategory::scene, "[regionfile][open] dropped corrupt slots [path %s][count %u]", file_path, dropped_count);
+
+		return true;
+	}
+
+
+	void close()
+	{
+		if (m_base) {
+			::msync(m_base, m_mapped_bytes, MS_SYNC);
+			::munmap(m_base, m_mapped_bytes);
+		}
+		if (m_file_handle >= 0)
+			::close(m_file_handle);
+
+		m_file_handle  = -1;
+		m_base         = nullptr;
+		m_mapped_bytes = 0;
+	}
+
+
+	[[nodiscard]] bool is_open() const
+	{
+		return m_base != nullptr;
+	}
+
+
+	[[nodiscard]] size_t mapped_bytes() const
+	{
+		return m_mapped_bytes;
+	}
+
+
+	[[nodiscard]] RegionCoord coord() const
+	{
+		return header().coord;
+	}
+
+
+	// NOTE: points into the mapping, valid until the next write to this file
+
+	[[nodiscard]] std::span<const uint8_t> read(uint32_t slot) const
+	{
+		HPR_ASSERT_MSG(is_open(), "[regionfile] read on closed file");
+		HPR_ASSERT_MSG(slot < cfg::region_slot_count, "[regionfile] slot out of range");
+
+		const RegionSlot& region_slot = header().slots[slot];
+		if (region_slot.payload_bytes == 0 || !is_slot_valid(region_slot))
+			return {};
+
+		const uint8_t* payload = m_base + static_cast<size_t>(region_slot.sector_beg) * cfg::region_sector_bytes;
+		return {payload, region_slot.payload_bytes};
+	}
+
+
+	// NOTE: rewrites in place when the payload still fits its sector run, otherwise moves it
+	//       to the first gap large enough or the end of the file; an empty payload frees the slot
+
+	bool write(uint32_t slot, std::span<const uint8_t> payload)
+	{
+		HPR_ASSERT_MSG(is_open(), "[regionfile] write on closed file");
+		HPR_ASSERT_MSG(slot < cfg::region_slot_count, "[regionfile] slot out of range");
+
+		const uint32_t sector_count = sectors_for(payload.size());
+
+		if (sector_count > header().slots[slot].sector_count) {
+
+			const uint32_t sector_beg = find_gap(slot, sector_count);
+			const uint32_t sector_end = sector_beg + sector_count;
+
+			if (sector_end > file_sectors() && !resize_file(sector_end))
+				return false;
+
+			RegionSlot& region_slot = header().slots[slot];
+			region_slot.sector_beg   = sector_beg;
+			region_slot.sector_count = sector_count;
+		}
+
+		RegionSlot& region_slot = header().slots[slot];
+
+		if (!payload.empty())
+			std::memcpy(m_base + static_cast<size_t>(region_slot.sector_beg) * cfg::region_sector_bytes, payload.data(), payload.size());
+
+		region_slot.payload_bytes = static_cast<uint32_t>(payload.size());
+
+		if (payload.empty()) {
+			region_slot.sector_beg   = 0;
+			region_slot.sector_count = 0;
+		}
+
+		return true;
+	}
+
+
+	void flush()
+	{
+		if (m_base)
+			::msync(m_base, m_mapped_bytes, MS_ASYNC);
+	}
+
+private:
+
+	[[nodiscard]] RegionHeader& header()
+	{
+		return *reinterpret_cast<RegionHeader*>(m_base);
+	}
+
+
+	[[nodiscard]] const RegionHeader& header() const
+	{
+		return *reinterpret_cast<const RegionHeader*>(m_base);
+	}
+
+
+	[[nodiscard]] static uint32_t sectors_for(size_t bytes)
+	{
+		return static_cast<uint32_t>((bytes + cfg::region_sector_bytes - 1) / cfg::region_sector_bytes);
+	}
+
+
+	[[nodiscard]] uint32_t file_sectors() const
+	{
+		return static_cast<uint32_t>(m_mapped_bytes / cfg::region_sector_bytes);
+	}
+
+
+	// NOTE: an empty slot holds nothing, a used one lies after the header, inside the mapping
+	//       and its payload fits its sector run - 64 bit sums so corrupt values can not wrap
+
+	[[nodiscard]] bool is_slot_valid(const RegionSlot& region_slot) const
+	{
+		if (region_slot.sector_count == 0)
+			return region_slot.payload_bytes == 0;
+
+		const uint64_t sector_end = static_cast<uint64_t>(region_slot.sector_beg) + region_slot.sector_count;
+
+		return
+			region_slot.sector_beg >= k_header_sectors &&
+			sector_end * cfg::region_sector_bytes <= m_mapped_bytes &&
+			sectors_for(region_slot.payload_bytes) <= region_slot.sector_count;
+	}
+
+
+	// NOTE: first fit over the sector runs of the other slots, 256 slots keep the sort cheap
+
+	[[nodiscard]] uint32_t find_gap(uint32_t skip_slot, uint32_t sector_count) const
+	{
+		RegionSlot used[cfg::region_slot_count];
+		uint32_t   used_count = 0;
+
+		for (uint32_t slot = 0; slot < cfg::region_slot_count; ++slot) {
+			const RegionSlot& region_slot = header().slots[slot];
+			if (slot != skip_slot && region_slot.sector_count != 0)
+				used[used_count++] = region_slot;
+		}
+
+		std::sort(used, used + used_count, [](const RegionSlot& lhs, const RegionSlot& rhs) {
+			return lhs.sector_beg < rhs.sector_beg;
+		});
+
+		uint32_t cursor = k_header_sectors;
+
+		for (uint32_t used_idx = 0; used_idx < used_count; ++used_idx) {
+
+			const RegionSlot& used_slot = used[used_idx];
+
+			if (used_slot.sector_beg >= cursor && used_slot.sector_beg - cursor >= sector_count)
+				return cursor;
+
+			cursor = std::max(cursor, used_slot.sector_beg + used_slot.sector_count);
+		}
+
+		return cursor;
+	}
+
+
+	bool resize_file(uint32_t sector_count)
+	{
+		const size_t file_bytes = static_cast<size_t>(sector_count) * cfg::region_sector_bytes;
+
+		if (::ftruncate(m_file_handle, static_cast<off_t>(file_bytes)) != 0) {
+			HPR_ERROR(log::LogCategory::scene, "[regionfile][resize] ftruncate fail [bytes %zu]", file_bytes);
+			return false;
+		}
+
+		return map(file_bytes);
+	}
+
+
+	// NOTE: the old mapping goes only once the new one exists, a failed grow leaves the file
+	//       open and readable at its previous size
+
+	bool map(size_t file_bytes)
+	{
+		void* mapping = ::mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_file_handle, 0);
+		if (mapping == MAP_FAILED) {
+			HPR_ERROR(log::LogCategory::scene, "[regionfile][map] mmap fail [bytes %zu]", file_bytes);
+			return false;
+		}
+
+		if (m_base)
+			::munmap(m_base, m_mapped_bytes);
+
+		m_base         = static_cast<uint8_t*>(mapping);
+		m_mapped_bytes = file_bytes;
+
+		return true;
+	}
+
+private:
+
+	int      m_file_handle  {-1};
+	uint8_t* m_base         {nullptr};
+	size_t   m_mapped_bytes {0};
+};
+
+
+} // hpr::scn
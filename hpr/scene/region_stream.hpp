@@ -0,0 +1,650 @@
+#pragma once
+
+#include <span>
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "log.hpp"
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "voxel_data.hpp"
+#include "voxel_field.hpp"
+#include "region_file.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	// NOTE: 16 x 16 chunk columns of one storey, 8 x 4 x 8 voxel chunks - both fill the 256 slot index
+
+	inline constexpr int32_t tile_region_shift     = 4;
+	inline constexpr int32_t voxel_region_shift_xz = 3;
+	inline constexpr int32_t voxel_region_shift_y  = 2;
+
+	inline constexpr uint32_t region_resident_budget = 4096U;
+	inline constexpr uint32_t region_open_budget     = 64U;
+
+} // hpr::scn::cfg
+
+
+struct TileRegionTraits
+{
+	using Field      = TileField;
+	using ChunkCoord = TileChunkCoord;
+
+	static constexpr RegionKind kind       = RegionKind::tile;
+	static constexpr const char file_tag[] = "tile";
+
+	[[nodiscard]] static uint64_t key_of(ChunkCoord chunk_coord)
+	{
+		return get_chunk_coord_hash(chunk_coord);
+	}
+
+	[[nodiscard]] static RegionCoord region_of(ChunkCoord chunk_coord)
+	{
+		return RegionCoord {{
+			chunk_coord.chunk_x >> cfg::tile_region_shift,
+			chunk_coord.chunk_z >> cfg::tile_region_shift,
+			chunk_coord.storey_index,
+			chunk_coord.storey_stack
+		}};
+	}
+
+	[[nodiscard]] static uint32_t slot_of(ChunkCoord chunk_coord)
+	{
+		static constexpr int32_t mask = (1 << cfg::tile_region_shift) - 1;
+
+		return static_cast<uint32_t>((chunk_coord.chunk_x & mask) | ((chunk_coord.chunk_z & mask) << cfg::tile_region_shift));
+	}
+
+	[[nodiscard]] static bool contains(const Field& field, ChunkCoord chunk_coord)
+	{
+		return field.find_chunk(chunk_coord) != nullptr;
+	}
+
+	[[nodiscard]] static size_t encoded_bytes(const Field& field, ChunkCoord chunk_coord)
+	{
+		(void) field;
+		(void) chunk_coord;
+		return static_cast<size_t>(cfg::chunk_area) * sizeof(TileType);
+	}
+
+	static void encode(const Field& field, ChunkCoord chunk_coord, uint8_t* out)
+	{
+		const TileChunk* chunk = field.find_chunk(chunk_coord);
+		std::memcpy(out, chunk->tiles.data(), encoded_bytes(field, chunk_coord));
+	}
+
+	[[nodiscard]] static bool decode(Field& field, ChunkCoord chunk_coord, std::span<const uint8_t> payload)
+	{
+		if (payload.size() != encoded_bytes(field, chunk_coord))
+			return false;
+
+		TileChunk& chunk = field.ensure_chunk(chunk_coord, 0);
+		std::memcpy(chunk.tiles.data(), payload.data(), payload.size());
+
+		return true;
+	}
+
+	static void evict(Field& field, ChunkCoord chunk_coord)
+	{
+		(void) field.evict_chunk(chunk_coord);
+	}
+};
+
+
+struct VoxelRegionTraits
+{
+	using Field      = VoxelField;
+	using ChunkCoord = VoxelChunkCoord;
+
+	static constexpr RegionKind kind       = RegionKind::voxel;
+	static constexpr const char file_tag[] = "voxel";
+
+	[[nodiscard]] static uint64_t key_of(ChunkCoord chunk_coord)
+	{
+		return VoxelField::key_of(chunk_coord);
+	}
+
+	[[nodiscard]] static RegionCoord region_of(ChunkCoord chunk_coord)
+	{
+		return RegionCoord {{
+			chunk_coord.chunk_x >> cfg::voxel_region_shift_xz,
+			chunk_coord.chunk_y >> cfg::voxel_region_shift_y,
+			chunk_coord.chunk_z >> cfg::voxel_region_shift_xz,
+			0
+		}};
+	}
+
+	[[nodiscard]] static uint32_t slot_of(ChunkCoord chunk_coord)
+	{
+		static constexpr int32_t mask_xz = (1 << cfg::voxel_region_shift_xz) - 1;
+		static constexpr int32_t mask_y  = (1 << cfg::voxel_region_shift_y) - 1;
+
+		return static_cast<uint32_t>(
+			(chunk_coord.chunk_x & mask_xz) |
+			((chunk_coord.chunk_z & mask_xz) << cfg::voxel_region_shift_xz) |
+			((chunk_coord.chunk_y & mask_y) << (cfg::voxel_region_shift_xz * 2))
+		);
+	}
+
+	[[nodiscard]] static bool contains(const Field& field, ChunkCoord chunk_coord)
+	{
+		return field.find_chunk(chunk_coord) != nullptr;
+	}
+
+	[[nodiscard]] static size_t encoded_bytes(const Field& field, ChunkCoord chunk_coord)
+	{
+		return field.find_chunk(chunk_coord)->voxels.encoded_bytes();
+	}
+
+	static void encode(const Field& field, ChunkCoord chunk_coord, uint8_t* out)
+	{
+		field.find_chunk(chunk_coord)->voxels.write_bytes(out);
+	}
+
+	[[nodiscard]] static bool decode(Field& field, ChunkCoord chunk_coord, std::span<const uint8_t> payload)
+	{
+		VoxelField::VoxelChunk& chunk = field.ensure_chunk(chunk_coord, 0);
+
+		if (chunk.voxels.read_bytes(payload.data(), payload.size(), VoxelField::k_chunk_volume))
+			return true;
+
+		(void) field.evict_chunk(chunk_coord);
+		return false;
+	}
+
+	static void evict(Field& field, ChunkCoord chunk_coord)
+	{
+		(void) field.evict_chunk(chunk_coord);
+	}
+};
+
+
+// NOTE: lazy chunk residency over a directory of region files. chunks load on first request,
+//       every update() bumps the requested chunks in an intrusive lru and evicts the coldest
+//       ones beyond the budget, writing dirty chunks back first. chunks requested this update
+//       are never evicted, so the budget can be exceeded by the working set. chunks the stream
+//       did not load (generated or edited in place) count as dirty until written once.
+//       edits go to resident chunks only - request a chunk before writing to it and mark_dirty() after.
+//       open region files are capped separately, the least recently used one is closed first
+
+template <typename Traits>
+class RegionStream
+{
+public:
+
+	using Field      = typename Traits::Field;
+	using ChunkCoord = typename Traits::ChunkCoord;
+
+public:
+
+	RegionStream() = default;
+
+	~RegionStream()
+	{
+		HPR_ASSERT_MSG(m_regions.empty(), "[regionstream] close() with the field before destruction");
+	}
+
+	RegionStream(const RegionStream&) = delete;
+	RegionStream& operator=(const RegionStream&) = delete;
+
+
+	// NOTE: creates the directory when missing, region files appear in it on first write back
+
+	void open(const char* directory_path, uint32_t resident_budget = cfg::region_resident_budget)
+	{
+		HPR_ASSERT_MSG(directory_path, "directory_path == null");
+		HPR_ASSERT_MSG(m_regions.empty(), "[regionstream] already open");
+
+		if (::mkdir(directory_path, 0755) != 0 && errno != EEXIST)
+			HPR_ERROR(log::LogCategory::scene, "[regionstream][open] mkdir fail [path %s]", directory_path);
+
+		m_directory_path  = directory_path;
+		m_resident_budget = resident_budget;
+	}
+
+
+	// NOTE: writes back everything dirty and unmaps all regions, resident chunks stay in the field
+
+	void close(const Field& field)
+	{
+		flush(field);
+
+		m_regions.clear();
+		m_region_index.clear();
+		m_missing_regions.clear();
+		m_region_tick = 0;
+
+		m_entries.clear();
+		m_entry_index.clear();
+		m_free_entries.clear();
+
+		m_head = k_no_entry;
+		m_tail = k_no_entry;
+	}
+
+
+	[[nodiscard]] uint32_t resident_count() const
+	{
+		return m_entry_index.size();
+	}
+
+
+	[[nodiscard]] uint32_t resident_budget() const
+	{
+		return m_resident_budget;
+	}
+
+
+	void set_resident_budget(uint32_t resident_budget)
+	{
+		m_resident_budget = resident_budget;
+	}
+
+
+	[[nodiscard]] uint32_t open_region_count() const
+	{
+		return static_cast<uint32_t>(m_regions.size());
+	}
+
+
+	[[nodiscard]] size_t mapped_bytes() const
+	{
+		size_t bytes = 0;
+		for (const OpenRegion& open_region : m_regions)
+			bytes += open_region.file.mapped_bytes();
+
+		return bytes;
+	}
+
+
+	void mark_dirty(ChunkCoord chunk_coord)
+	{
+		Entry& entry = m_entries[touch(chunk_coord)];
+		entry.dirty = true;
+	}
+
+
+	// NOTE: on_load(ChunkCoord) fires for chunks brought in from disk, on_evict(ChunkCoord) after
+	//       a chunk has left the field - callers mark or drop render and sim state there
+
+	template <typename LoadFn, typename EvictFn>
+	void update(Field& field, std::span<const ChunkCoord> wanted, LoadFn&& on_load, EvictFn&& on_evict)
+	{
+		++m_frame;
+
+		for (const ChunkCoord& chunk_coord : wanted) {
+
+			const uint64_t key = Traits::key_of(chunk_coord);
+
+			if (m_entry_index.find(key) != ChunkDirectory::k_empty_slot) {
+				(void) touch(chunk_coord);
+				continue;
+			}
+
+			if (Traits::contains(field, chunk_coord)) {
+				mark_dirty(chunk_coord);
+				continue;
+			}
+
+			if (load_chunk(field, chunk_coord)) {
+				(void) touch(chunk_coord);
+				on_load(chunk_coord);
+			}
+		}
+
+		while (m_entry_index.size() > m_resident_budget && m_tail != k_no_entry) {
+
+			const Entry& coldest = m_entries[m_tail];
+			if (coldest.frame == m_frame)
+				break;
+
+			const ChunkCoord chunk_coord = coldest.coord;
+
+			if (coldest.dirty && !write_back(field, chunk_coord)) {
+				(void) touch(chunk_coord);
+				break;
+			}
+
+			release(m_tail);
+
+			Traits::evict(field, chunk_coord);
+			on_evict(chunk_coord);
+		}
+	}
+
+
+	void flush(const Field& field)
+	{
+		for (uint32_t entry_idx = m_head; entry_idx != k_no_entry; entry_idx = m_entries[entry_idx].next) {
+
+			Entry& entry = m_entries[entry_idx];
+
+			if (entry.dirty && write_back(field, entry.coord))
+				entry.dirty = false;
+		}
+
+		for (OpenRegion& open_region : m_regions)
+			open_region.file.flush();
+	}
+
+private:
+
+	static constexpr uint32_t k_no_entry = 0xFFFFFFFFU;
+
+	struct Entry
+	{
+		ChunkCoord coord {};
+		uint64_t   key   {0};
+		uint64_t   frame {0};
+
+		uint32_t prev {k_no_entry};
+		uint32_t next {k_no_entry};
+
+		bool dirty {false};
+	};
+
+	struct OpenRegion
+	{
+		RegionFile file;
+		uint64_t   key      {0};
+		uint64_t   last_use {0};
+	};
+
+
+	[[nodiscard]] static uint64_t region_key(RegionCoord region_coord)
+	{
+		static constexpr uint64_t fnv1a_offset_basis = 14695981039346656037ULL;
+		static constexpr uint64_t fnv1a_prime        = 1099511628211ULL;
+
+		uint64_t fnv1a_hash = fnv1a_offset_basis;
+
+		for (const int32_t axis : region_coord.axis) {
+			fnv1a_hash ^= static_cast<uint32_t>(axis);
+			fnv1a_hash *= fnv1a_prime;
+		}
+
+		return fnv1a_hash;
+	}
+
+
+	// NOTE: create_missing = false keeps reads of never written regions from creating files,
+	//       regions found missing are remembered so wanted chunks over empty ground cost no
+	//       file system call per update
+
+	[[nodiscard]] RegionFile* find_region(ChunkCoord chunk_coord, bool create_missing)
+	{
+		const RegionCoord region_coord = Traits::region_of(chunk_coord);
+		const uint64_t    key          = region_key(region_coord);
+
+		const uint32_t region_idx = m_region_index.find(key);
+		if (region_idx != ChunkDirectory::k_empty_slot) {
+			OpenRegion& open_region = m_regions[region_idx];
+			open_region.last_use = ++m_region_tick;
+			return &open_region.file;
+		}
+
+		const bool known_missing = m_missing_regions.find(key) != ChunkDirectory::k_empty_slot;
+
+		if (!create_missing && known_missing)
+			return nullptr;
+
+		char file_path[512];
+		std::snprintf(
+			file_path,
+			sizeof(file_path),
+			"%s/%s_%d_%d_%d_%d.hrg",
+			m_directory_path.c_str(),
+			Traits::file_tag,
+			region_coord.axis[0],
+			region_coord.axis[1],
+			region_coord.axis[2],
+			region_coord.axis[3]
+		);
+
+		if (!create_missing && ::access(file_path, F_OK) != 0) {
+			m_missing_regions.insert(key, 0);
+			return nullptr;
+		}
+
+		// NOTE: a region that fails to open is treated as missing for reads, so a corrupt file
+		//       logs once instead of every update
+
+		RegionFile region;
+		if (!region.open(file_path, Traits::kind, region_coord)) {
+			if (!create_missing)
+				m_missing_regions.insert(key, 0);
+			return nullptr;
+		}
+
+		if (known_missing)
+			(void) m_missing_regions.erase(key);
+
+		if (m_regions.size() >= cfg::region_open_budget)
+			close_coldest_region();
+
+		m_region_index.insert(key, static_cast<uint32_t>(m_regions.size()));
+		m_regions.emplace_back(OpenRegion {.file = std::move(region), .key = key, .last_use = ++m_region_tick});
+
+		return &m_regions.back().file;
+	}
+
+
+	// NOTE: linear scan is fine at the open budget, swap-removes so region pointers are not stable
+
+	void close_coldest_region()
+	{
+		uint32_t coldest_idx = 0;
+
+		for (uint32_t region_idx = 1; region_idx < m_regions.size(); ++region_idx) {
+			if (m_regions[region_idx].last_use < m_regions[coldest_idx].last_use)
+				coldest_idx = region_idx;
+		}
+
+		(void) m_region_index.erase(m_regions[coldest_idx].key);
+
+		const uint32_t last_idx = static_cast<uint32_t>(m_regions.size() - 1);
+
+		if (coldest_idx != last_idx) {
+			m_regions[coldest_idx] = std::move(m_regions[last_idx]);
+			m_region_index.insert(m_regions[coldest_idx].key, coldest_idx);
+		}
+
+		m_regions.pop_back();
+	}
+
+
+	bool load_chunk(Field& field, ChunkCoord chunk_coord)
+	{
+		RegionFile* region = find_region(chunk_coord, false);
+		if (!region)
+			return false;
+
+		const std::span<const uint8_t> payload = region->read(Traits::slot_of(chunk_coord));
+		if (payload.empty())
+			return false;
+
+		if (!Traits::decode(field, chunk_coord, payload)) {
+			HPR_ERROR(log::LogCategory::scene, "[regionstream][load] corrupt chunk payload [%s]", Traits::file_tag);
+			return false;
+		}
+
+		return true;
+	}
+
+
+	// NOTE: chunks gone from the field are written as empty slots so they do not come back
+
+	bool write_back(const Field& field, ChunkCoord chunk_coord)
+	{
+		RegionFile* region = find_region(chunk_coord, true);
+		if (!region)
+			return false;
+
+		const uint32_t slot = Traits::slot_of(chunk_coord);
+
+		if (!Traits::contains(field, chunk_coord))
+			return region->write(slot, {});
+
+		const size_t bytes = Traits::encoded_bytes(field, chunk_coord);
+
+		m_scratch.resize(static_cast<uint32_t>(bytes));
+		Traits::encode(field, chunk_coord, m_scratch.data());
+
+		return region->write(slot, std::span<const uint8_t> {m_scratch.data(), bytes});
+	}
+
+
+	uint32_t touch(ChunkCoord chunk_coord)
+	{
+		const uint64_t key = Traits::key_of(chunk_coord);
+
+		uint32_t entry_idx = m_entry_index.find(key);
+
+		if (entry_idx == ChunkDirectory::k_empty_slot) {
+
+			if (!m_free_entries.empty()) {
+				entry_idx = m_free_entries.back();
+				m_free_entries.pop_back();
+			}
+			else {
+				entry_idx = static_cast<uint32_t>(m_entries.size());
+				m_entries.emplace_back();
+			}
+
+			m_entries[entry_idx] = Entry {.coord = chunk_coord, .key = key};
+			m_entry_index.insert(key, entry_idx);
+		}
+		else {
+			unlink(entry_idx);
+		}
+
+		Entry& entry = m_entries[entry_idx];
+		entry.frame = m_frame;
+		entry.prev  = k_no_entry;
+		entry.next  = m_head;
+
+		if (m_head != k_no_entry)
+			m_entries[m_head].prev = entry_idx;
+		m_head = entry_idx;
+
+		if (m_tail == k_no_entry)
+			m_tail = entry_idx;
+
+		return entry_idx;
+	}
+
+
+	void unlink(uint32_t entry_idx)
+	{
+		Entry& entry = m_entries[entry_idx];
+
+		if (entry.prev != k_no_entry)
+			m_entries[entry.prev].next = entry.next;
+		else
+			m_head = entry.next;
+
+		if (entry.next != k_no_entry)
+			m_entries[entry.next].prev = entry.prev;
+		else
+			m_tail = entry.prev;
+
+		entry.prev = k_no_entry;
+		entry.next = k_no_entry;
+	}
+
+
+	void release(uint32_t entry_idx)
+	{
+		unlink(entry_idx);
+
+		(void) m_entry_index.erase(m_entries[entry_idx].key);
+		m_free_entries.emplace_back(entry_idx);
+	}
+
+private:
+
+	std::string m_directory_path;
+
+	mtp::vault<OpenRegion, mtp::default_set> m_regions;
+	ChunkDirectory                           m_region_index;
+	ChunkDirectory                           m_missing_regions;
+	uint64_t                                 m_region_tick {0};
+
+	mtp::vault<Entry,    mtp::default_set> m_entries;
+	mtp::vault<uint32_t, mtp::default_set> m_free_entries;
+	ChunkDirectory                         m_entry_index;
+
+	mtp::vault<uint8_t, mtp::default_set> m_scratch;
+
+	uint32_t m_head {k_no_entry};
+	uint32_t m_tail {k_no_entry};
+
+	uint64_t m_frame           {0};
+	uint32_t m_resident_budget {cfg::region_resident_budget};
+};
+
+
+using TileRegionStream  = RegionStream<TileRegionTraits>;
+using VoxelRegionStream = RegionStream<VoxelRegionTraits>;
+
+
+// NOTE: square of chunk columns around the focus chunk over a storey range, the usual wanted set
+
+inline void gather_tile_chunks_near(
+	TileChunkCoord                                center,
+	int32_t                                       radius,
+	int32_t                                       storey_beg,
+	int32_t                                       storey_end,
+	mtp::vault<TileChunkCoord, mtp::default_set>& out
+)
+{
+	out.clear();
+
+	for (int32_t storey_index = storey_beg; storey_index < storey_end; ++storey_index) {
+		for (int32_t chunk_z = center.chunk_z - radius; chunk_z <= center.chunk_z + radius; ++chunk_z) {
+			for (int32_t chunk_x = center.chunk_x - radius; chunk_x <= center.chunk_x + radius; ++chunk_x) {
+				out.emplace_back(TileChunkCoord {
+					.chunk_x      = chunk_x,
+					.chunk_z      = chunk_z,
+					.storey_index = storey_index,
+					.storey_stack = center.storey_stack
+				});
+			}
+		}
+	}
+}
+
+
+inline void gather_voxel_chunks_near(
+	VoxelChunkCoord                                center,
+	int32_t                                        radius_xz,
+	int32_t                                        radius_y,
+	mtp::vault<VoxelChunkCoord, mtp::default_set>& out
+)
+{
+	out.clear();
+
+	for (int32_t chunk_y = center.chunk_y - radius_y; chunk_y <= center.chunk_y + radius_y; ++chunk_y) {
+		for (int32_t chunk_z = center.chunk_z - radius_xz; chunk_z <= center.chunk_z + radius_xz; ++chunk_z) {
+			for (int32_t chunk_x = center.chunk_x - radius_xz; chunk_x <= center.chunk_x + radius_xz; ++chunk_x)
+				out.emplace_back(VoxelChunkCoord {chunk_x, chunk_y, chunk_z});
+		}
+	}
+}
+
+
+} // hpr::scn
@@ -22,11 +22,14 @@ public:
 	Scene() = default;
 	~Scene() = default;
 
+	// NOTE: the bound tree hands itself to the registry hooks and the region streams own
+	//       worker state, both by address, so a scene stays where it was built
+
 	Scene(const Scene&) = delete;
 	Scene& operator=(const Scene&) = delete;
 
-	Scene(Scene&&) noexcept = default;
-	Scene& operator=(Scene&&) noexcept = default;
+	Scene(Scene&&) = delete;
+	Scene& operator=(Scene&&) = delete;
 
 public:
 
@@ -93,6 +96,87 @@ public:
 	const rdr::TileChunkDrawableSet& tile_draw_data() const
 	{ return m_sim_data.draw_data; }
 
+	TileSimulation& tile_sim()
+	{ return m_sim_data.tile_sim; }
+
+	const TileSimulation& tile_sim() const
+	{ return m_sim_data.tile_sim; }
+
+	TileChangeLog& tile_changes()
+	{ return m_sim_data.tile_changes; }
+
+	const TileChangeLog& tile_changes() const
+	{ return m_sim_data.tile_changes; }
+
+	TilePathfinder& tile_paths()
+	{ return m_sim_data.tile_paths; }
+
+	const TilePathfinder& tile_paths() const
+	{ return m_sim_data.tile_paths; }
+
+	TileEditBatch& tile_edits()
+	{ return m_sim_data.tile_edits; }
+
+	const TileEditBatch& tile_edits() const
+	{ return m_sim_data.tile_edits; }
+
+	TileEditJournal& tile_journal()
+	{ return m_sim_data.tile_journal; }
+
+	const TileEditJournal& tile_journal() const
+	{ return m_sim_data.tile_journal; }
+
+	VoxelField& voxelfield()
+	{ return m_sim_data.voxelfield; }
+
+	const VoxelField& voxelfield() const
+	{ return m_sim_data.voxelfield; }
+
+	VoxelGridParams& voxel_grid()
+	{ return m_sim_data.voxel_grid; }
+
+	const VoxelGridParams& voxel_grid() const
+	{ return m_sim_data.voxel_grid; }
+
+	rdr::VoxelChunkDrawableSet& voxel_chunk_drawable_set()
+	{ return m_sim_data.voxel_draw_data; }
+
+	TileRegionStream& tile_stream()
+	{ return m_sim_data.tile_stream; }
+
+	VoxelRegionStream& voxel_stream()
+	{ return m_sim_data.voxel_stream; }
+
+	BoundTree& bound_tree()
+	{ return m_sim_data.bound_tree; }
+
+	const BoundTree& bound_tree() const
+	{ return m_sim_data.bound_tree; }
+
+	SpatialHash& agent_hash()
+	{ return m_sim_data.agent_hash; }
+
+	const SpatialHash& agent_hash() const
+	{ return m_sim_data.agent_hash; }
+
+	GhostInfra& ghost_infra()
+	{ return m_sim_data.ghost_infra; }
+
+	const GhostInfra& ghost_infra() const
+	{ return m_sim_data.ghost_infra; }
+
+	GhostInfraLinks& ghost_links()
+	{ return m_sim_data.ghost_links; }
+
+	const GhostInfraLinks& ghost_links() const
+	{ return m_sim_data.ghost_links; }
+
+	GhostInfraFlow& ghost_flow()
+	{ return m_sim_data.ghost_flow; }
+
+	const GhostInfraFlow& ghost_flow() const
+	{ return m_sim_data.ghost_flow; }
+
 private:
 
 	vec3 m_ambient_rgb {0.0f, 0.0f, 0.0f};
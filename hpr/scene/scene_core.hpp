@@ -13,6 +13,7 @@
 #include "render_forge.hpp"
 #include "scene.hpp"
 #include "scene_io_data.hpp"
+#include "voxel_draw_data.hpp"
 #include "components_scene.hpp"
 #include "components_render.hpp"
 
@@ -96,17 +97,61 @@ bool instantiate(
 		scene.rebuild_stratum();
 	}
 
-	for (int32_t storey = 0; storey < floors; ++storey) {
-		for (int32_t z = 0; z < 32; ++z) {
-			for (int32_t x = 0; x < 32; ++x) {
+	const TileRegion floor_region {
+		.x_beg        = 0,
+		.z_beg        = 0,
+		.x_end        = 32,
+		.z_end        = 32,
+		.storey_beg   = 0,
+		.storey_end   = floors,
+		.storey_stack = storey_stack
+	};
 
-				TileCoord tile_coord {x, z, storey, storey_stack};
-				tilefield.set(tile_coord, TileType {2});
-				scn::mark_dirty_chunk(stratum, grid_params, tile_coord, tile_draw);
-			}
-		}
+	tilefield.fill_region(floor_region, TileType {2}, [&](TileChunkCoord chunk_coord) {
+		scn::mark_dirty_chunk(stratum, grid_params, chunk_coord, tile_draw);
+	});
+
+
+	/* voxel field */
+
+	// NOTE: a re-instantiate drops the previous chunk meshes, drawables and dirty queue,
+	//       voxel content is written afterwards through set_voxel
+
+	auto& voxelfield = scene.voxelfield();
+	auto& voxel_grid = scene.voxel_grid();
+	auto& voxel_draw = scene.voxel_chunk_drawable_set();
+
+	for (const rdr::VoxelChunkDrawable& voxel_drawable : voxel_draw.drawables) {
+		if (voxel_drawable.mesh.is_valid())
+			render_forge.destroy_dynamic_mesh(voxel_drawable.mesh);
 	}
 
+	voxel_draw = rdr::VoxelChunkDrawableSet {};
+	voxelfield.clear();
+
+	voxel_grid.origin_world = grid_params.origin_world;
+	voxel_grid.voxel_size   = grid_params.tile_size;
+
+
+	/* ghost infra */
+
+	// NOTE: the graphs belong to the tile layout above and start empty, links are rebuilt
+	//       from them here and follow later appends through sync
+
+	auto& ghost_infra = scene.ghost_infra();
+	auto& ghost_links = scene.ghost_links();
+	auto& ghost_flow  = scene.ghost_flow();
+
+	ghost_infra = GhostInfra {};
+
+	ghost_links.power.rebuild(ghost_infra.power);
+	ghost_links.data.rebuild(ghost_infra.data);
+	ghost_links.pipe.rebuild(ghost_infra.pipe);
+
+	ghost_flow.power.clear();
+	ghost_flow.data.clear();
+	ghost_flow.pipe.clear();
+
 
 	/* create entities and parent links */
 
@@ -225,9 +270,11 @@ bool instantiate(
 					camera_comp.aspect  = 1.0f;
 					camera_comp.znear   = camera_doc.znear;
 					camera_comp.zfar    = camera_doc.zfar;
-					camera_comp.active  = camera_doc.active ? 1U : 0U;
 
 					registry.template add<ecs::CameraComponent>(entity, camera_comp);
+
+					if (camera_doc.active)
+						registry.template add<ecs::CameraActiveTag>(entity);
 				}
 				break;
 
@@ -238,7 +285,6 @@ bool instantiate(
 					ecs::LightComponent light_comp {};
 
 					light_comp.type      = static_cast<scn::LightType>(static_cast<uint8_t>(light_doc.type));
-					light_comp.enabled   = light_doc.enabled ? 1U : 0U;
 					light_comp.intensity = light_doc.intensity;
 					light_comp.range     = light_doc.range;
 					light_comp.inner_deg = light_doc.inner_deg;
@@ -247,6 +293,9 @@ bool instantiate(
 
 					registry.template add<ecs::LightComponent>(entity, light_comp);
 
+					if (light_doc.enabled)
+						registry.template add<ecs::LightEnabledTag>(entity);
+
 					if (!registry.template has<ecs::BoundComponent>(entity)) {
 
 						ecs::BoundComponent bound_comp {};
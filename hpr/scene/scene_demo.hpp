@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+#include "scene.hpp"
+#include "tile_sim.hpp"
+#include "tile_data.hpp"
+#include "voxel_data.hpp"
+#include "voxel_query.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	// NOTE: the mvp tile floor laid out by instantiate, ground storey of stack 0
+
+	inline constexpr TileRegion demo_room_region {
+		.x_beg        = 0,
+		.z_beg        = 0,
+		.x_end        = 32,
+		.z_end        = 32,
+		.storey_beg   = 0,
+		.storey_end   = 1,
+		.storey_stack = 0
+	};
+
+	// NOTE: flood tiles painted onto the floor spread across it
+
+	inline constexpr TileSpreadRule demo_spread_rule {
+		.source = 3,
+		.medium = 2
+	};
+
+} // hpr::scn::cfg
+
+
+// NOTE: demo content, not scene data. ground storey walls around the room with a doorway
+//       on the near side, written through set_voxel so every touched chunk is queued for meshing
+
+inline void build_demo_walls(Scene& scene, const TileRegion& room = cfg::demo_room_region)
+{
+	static constexpr VoxelType wall_voxel = 1;
+	static constexpr int32_t   door_width = 4;
+
+	const Storey* storey = scene.stratum().find_storey(room.storey_stack, room.storey_beg);
+	if (!storey)
+		return;
+
+	auto& voxelfield = scene.voxelfield();
+	auto& voxel_grid = scene.voxel_grid();
+	auto& voxel_draw = scene.voxel_chunk_drawable_set();
+
+	const int32_t door_x_beg = (room.x_beg + room.x_end - door_width) / 2;
+	const int32_t door_x_end = door_x_beg + door_width;
+
+	const auto set_wall = [&](int32_t x, int32_t z) {
+		for (int32_t y = storey->voxel_y_beg; y < storey->voxel_y_end; ++y)
+			set_voxel(voxelfield, voxel_grid, VoxelCoord {x, y, z}, wall_voxel, voxel_draw);
+	};
+
+	for (int32_t x = room.x_beg; x < room.x_end; ++x) {
+		if (x < door_x_beg || x >= door_x_end)
+			set_wall(x, room.z_beg);
+		set_wall(x, room.z_end - 1);
+	}
+
+	for (int32_t z = room.z_beg + 1; z < room.z_end - 1; ++z) {
+		set_wall(room.x_beg, z);
+		set_wall(room.x_end - 1, z);
+	}
+}
+
+
+} // hpr::scn
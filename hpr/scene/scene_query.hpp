@@ -1,10 +1,22 @@
 #pragma once
 
+#include <bit>
+#include <span>
+#include <array>
+#include <cmath>
 #include <limits>
 #include <cstdint>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "job_latch.hpp"
+#include "scheduler.hpp"
 
 #include "math.hpp"
 #include "entity.hpp"
+#include "ray_data.hpp"
 #include "scene.hpp"
 #include "render_data.hpp"
 #include "draw_view_data.hpp"
@@ -16,11 +28,13 @@
 namespace hpr::scn {
 
 
-struct Ray
-{
-	vec3 origin;
-	vec3 direction;
-};
+namespace cfg {
+
+	inline constexpr uint32_t scene_ray_packet_size  = 8U;
+	inline constexpr uint32_t scene_ray_job_grain    = 4U;
+	inline constexpr uint32_t scene_ray_morton_scale = 511U;
+
+} // hpr::scn::cfg
 
 
 struct RayHit
@@ -153,52 +167,82 @@ void for_each_pickable_entity(Registry& registry, Fn&& callback)
 }
 
 
-template <typename Registry, typename Fn>
-void for_each_triangle(
+struct SubmeshGeometryView
+{
+	const rdr::Submesh*         render_submesh   {nullptr};
+	const rdr::MeshGeometry*    mesh_geometry    {nullptr};
+	const rdr::SubmeshGeometry* geometry_submesh {nullptr};
+};
+
+
+template <typename Registry>
+SubmeshGeometryView resolve_submesh_geometry(
 	Registry&                 registry,
 	scn::Scene&               scene,
 	const scn::SceneResolver& resolver,
 	ecs::Entity               entity,
-	uint32_t                  local_submesh_index,
-	Fn&&                      callback
+	uint32_t                  local_submesh_index
 )
 {
 	const auto* model_component = registry.template get<ecs::ModelComponent>(entity);
 	if (!model_component) {
-		return;
+		return {};
 	}
 
 	const uint32_t absolute_primitive_index = model_component->submesh_first + local_submesh_index;
 	const auto& scene_primitives = scene.scene_primitives();
 
 	if (absolute_primitive_index >= scene_primitives.size()) {
-		return;
+		return {};
 	}
 
 	const auto& scene_primitive = scene_primitives[absolute_primitive_index];
 
 	auto* mesh = resolver.template resolve<rdr::Mesh>(scene_primitive.mesh);
 	if (!mesh) {
-		return;
+		return {};
 	}
 
 	const uint32_t mesh_submesh_index = scene_primitive.submesh_idx;
 	if (mesh_submesh_index >= mesh->submeshes.size()) {
-		return;
+		return {};
 	}
 
 	auto* mesh_geometry = resolver.template resolve<rdr::MeshGeometry>(mesh->geometry);
 	if (!mesh_geometry) {
-		return;
+		return {};
 	}
 	if (mesh_submesh_index >= mesh_geometry->submeshes.size()) {
+		return {};
+	}
+
+	return SubmeshGeometryView {
+		.render_submesh   = &mesh->submeshes[mesh_submesh_index],
+		.mesh_geometry    = mesh_geometry,
+		.geometry_submesh = &mesh_geometry->submeshes[mesh_submesh_index]
+	};
+}
+
+
+template <typename Registry, typename Fn>
+void for_each_triangle(
+	Registry&                 registry,
+	scn::Scene&               scene,
+	const scn::SceneResolver& resolver,
+	ecs::Entity               entity,
+	uint32_t                  local_submesh_index,
+	Fn&&                      callback
+)
+{
+	const SubmeshGeometryView geometry_view = resolve_submesh_geometry(registry, scene, resolver, entity, local_submesh_index);
+	if (!geometry_view.geometry_submesh) {
 		return;
 	}
 
-	const rdr::Submesh& render_submesh = mesh->submeshes[mesh_submesh_index];
-	const rdr::SubmeshGeometry& geometry_submesh = mesh_geometry->submeshes[mesh_submesh_index];
+	const rdr::Submesh& render_submesh = *geometry_view.render_submesh;
+	const rdr::SubmeshGeometry& geometry_submesh = *geometry_view.geometry_submesh;
 
-	const uint8_t* vertex_bytes = mesh_geometry->vertex_bytes.data();
+	const uint8_t* vertex_bytes = geometry_view.mesh_geometry->vertex_bytes.data();
 	const uint32_t* index_data = reinterpret_cast<const uint32_t*>(geometry_submesh.index_bytes.data());
 
 	const uint32_t triangle_index_start = render_submesh.first_idx;
@@ -243,6 +287,292 @@ void for_each_triangle(
 }
 
 
+template <typename Registry>
+float raycast_submesh(
+	Registry&                 registry,
+	scn::Scene&               scene,
+	const scn::SceneResolver& resolver,
+	ecs::Entity               entity,
+	uint32_t                  local_submesh_index,
+	const vec3&               ray_origin,
+	const vec3&               ray_direction,
+	float                     max_distance
+)
+{
+	float closest_hit_distance = std::numeric_limits<float>::infinity();
+
+	const SubmeshGeometryView geometry_view = resolve_submesh_geometry(registry, scene, resolver, entity, local_submesh_index);
+	if (!geometry_view.geometry_submesh) {
+		return closest_hit_distance;
+	}
+
+	const rdr::TriangleBvh& triangle_bvh = geometry_view.geometry_submesh->triangle_bvh;
+
+	// NOTE: geometry without a bvh yet is tested triangle by triangle in world space
+
+	if (triangle_bvh.empty()) {
+		for_each_triangle(
+			registry,
+			scene,
+			resolver,
+			entity,
+			local_submesh_index,
+			[&ray_origin, &ray_direction, &closest_hit_distance](
+				const vec3& vtx_world_0,
+				const vec3& vtx_world_1,
+				const vec3& vtx_world_2
+			)
+			{
+				float barycentric_U;
+				float barycentric_V;
+				float triangle_hit_distance;
+
+				if (intersect_ray_triangle(
+					ray_origin,
+					ray_direction,
+					vtx_world_0,
+					vtx_world_1,
+					vtx_world_2,
+					triangle_hit_distance,
+					barycentric_U,
+					barycentric_V
+				)) {
+					if (triangle_hit_distance < closest_hit_distance) {
+						closest_hit_distance = triangle_hit_distance;
+					}
+				}
+			}
+		);
+
+		return closest_hit_distance;
+	}
+
+	vec3 ray_origin_local    = ray_origin;
+	vec3 ray_direction_local = ray_direction;
+
+	const auto* transform_component = registry.template get<ecs::TransformComponent>(entity);
+
+	if (transform_component) {
+		const quat inverse_rotation = glm::conjugate(transform_component->rotation);
+
+		ray_origin_local    = glm::rotate(inverse_rotation, ray_origin - transform_component->position) / transform_component->scale;
+		ray_direction_local = glm::rotate(inverse_rotation, ray_direction) / transform_component->scale;
+	}
+
+	// NOTE: with a unit local direction, local distances are world distances times its length
+
+	const float direction_local_len = glm::length(ray_direction_local);
+
+	if (!(direction_local_len > 0.0f) || !std::isfinite(direction_local_len)) {
+		return closest_hit_distance;
+	}
+
+	ray_direction_local /= direction_local_len;
+
+	const rdr::Submesh& render_submesh = *geometry_view.render_submesh;
+
+	const uint32_t triangle_beg = render_submesh.first_idx / 3;
+	const uint32_t triangle_end = (render_submesh.first_idx + render_submesh.idx_count) / 3;
+
+	const uint8_t* vertex_bytes = geometry_view.mesh_geometry->vertex_bytes.data();
+	const uint32_t* index_data = reinterpret_cast<const uint32_t*>(geometry_view.geometry_submesh->index_bytes.data());
+
+	bool  is_hit                     = false;
+	float closest_hit_distance_local = max_distance * direction_local_len;
+
+	triangle_bvh.raycast(
+		ray_origin_local,
+		ray_direction_local,
+		closest_hit_distance_local,
+		[&](uint32_t triangle_index) -> float
+		{
+			if (triangle_index < triangle_beg || triangle_index >= triangle_end) {
+				return closest_hit_distance_local;
+			}
+
+			const rdr::SceneVertex* vtx_0 = reinterpret_cast<const rdr::SceneVertex*>(vertex_bytes + sizeof(rdr::SceneVertex) * index_data[triangle_index * 3 + 0]);
+			const rdr::SceneVertex* vtx_1 = reinterpret_cast<const rdr::SceneVertex*>(vertex_bytes + sizeof(rdr::SceneVertex) * index_data[triangle_index * 3 + 1]);
+			const rdr::SceneVertex* vtx_2 = reinterpret_cast<const rdr::SceneVertex*>(vertex_bytes + sizeof(rdr::SceneVertex) * index_data[triangle_index * 3 + 2]);
+
+			float barycentric_U;
+			float barycentric_V;
+			float triangle_hit_distance;
+
+			if (intersect_ray_triangle(
+				ray_origin_local,
+				ray_direction_local,
+				vtx_0->pos,
+				vtx_1->pos,
+				vtx_2->pos,
+				triangle_hit_distance,
+				barycentric_U,
+				barycentric_V
+			)) {
+				if (triangle_hit_distance < closest_hit_distance_local) {
+					closest_hit_distance_local = triangle_hit_distance;
+					is_hit = true;
+				}
+			}
+
+			return closest_hit_distance_local;
+		}
+	);
+
+	return is_hit ? closest_hit_distance_local / direction_local_len : closest_hit_distance;
+}
+
+
+// NOTE: packet form of raycast_submesh for the rays of ray_mask, the slots of closest_distances
+//       get each ray's nearest hit or infinity. one triangle bvh traversal serves the packet
+
+template <typename Registry>
+void raycast_submesh_packet(
+	Registry&                 registry,
+	scn::Scene&               scene,
+	const scn::SceneResolver& resolver,
+	ecs::Entity               entity,
+	uint32_t                  local_submesh_index,
+	std::span<const vec3>     ray_origins,
+	std::span<const vec3>     ray_directions,
+	std::span<const float>    max_distances,
+	uint32_t                  ray_mask,
+	std::span<float>          closest_distances
+)
+{
+	for (uint32_t rays = ray_mask; rays != 0; rays &= rays - 1) {
+		closest_distances[static_cast<uint32_t>(std::countr_zero(rays))] = std::numeric_limits<float>::infinity();
+	}
+
+	const SubmeshGeometryView geometry_view = resolve_submesh_geometry(registry, scene, resolver, entity, local_submesh_index);
+	if (!geometry_view.geometry_submesh) {
+		return;
+	}
+
+	const rdr::TriangleBvh& triangle_bvh = geometry_view.geometry_submesh->triangle_bvh;
+
+	if (triangle_bvh.empty()) {
+		for (uint32_t rays = ray_mask; rays != 0; rays &= rays - 1) {
+
+			const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+
+			closest_distances[ray] = raycast_submesh(
+				registry,
+				scene,
+				resolver,
+				entity,
+				local_submesh_index,
+				ray_origins[ray],
+				ray_directions[ray],
+				max_distances[ray]
+			);
+		}
+		return;
+	}
+
+	const uint32_t ray_count = static_cast<uint32_t>(ray_origins.size());
+
+	HPR_ASSERT_MSG(ray_count <= cfg::scene_ray_packet_size, "[scenequery] ray packet too large");
+
+	// NOTE: zeroed so lanes outside the mask hold defined values, the bvh reads every lane
+
+	std::array<vec3,  cfg::scene_ray_packet_size> ray_origins_local           {};
+	std::array<vec3,  cfg::scene_ray_packet_size> ray_directions_local        {};
+	std::array<float, cfg::scene_ray_packet_size> direction_local_lens        {};
+	std::array<float, cfg::scene_ray_packet_size> closest_hit_distances_local {};
+
+	const auto* transform_component = registry.template get<ecs::TransformComponent>(entity);
+
+	quat inverse_rotation {1.0f, 0.0f, 0.0f, 0.0f};
+	if (transform_component) {
+		inverse_rotation = glm::conjugate(transform_component->rotation);
+	}
+
+	uint32_t local_mask = 0;
+
+	for (uint32_t rays = ray_mask; rays != 0; rays &= rays - 1) {
+
+		const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+
+		ray_origins_local[ray]    = ray_origins[ray];
+		ray_directions_local[ray] = ray_directions[ray];
+
+		if (transform_component) {
+			ray_origins_local[ray]    = glm::rotate(inverse_rotation, ray_origins[ray] - transform_component->position) / transform_component->scale;
+			ray_directions_local[ray] = glm::rotate(inverse_rotation, ray_directions[ray]) / transform_component->scale;
+		}
+
+		const float direction_local_len = glm::length(ray_directions_local[ray]);
+
+		if (!(direction_local_len > 0.0f) || !std::isfinite(direction_local_len)) {
+			continue;
+		}
+
+		ray_directions_local[ray]        /= direction_local_len;
+		direction_local_lens[ray]         = direction_local_len;
+		closest_hit_distances_local[ray]  = max_distances[ray] * direction_local_len;
+
+		local_mask |= 1U << ray;
+	}
+
+	const rdr::Submesh& render_submesh = *geometry_view.render_submesh;
+
+	const uint32_t triangle_beg = render_submesh.first_idx / 3;
+	const uint32_t triangle_end = (render_submesh.first_idx + render_submesh.idx_count) / 3;
+
+	const uint8_t* vertex_bytes = geometry_view.mesh_geometry->vertex_bytes.data();
+	const uint32_t* index_data = reinterpret_cast<const uint32_t*>(geometry_view.geometry_submesh->index_bytes.data());
+
+	uint32_t hit_mask = 0;
+
+	triangle_bvh.raycast_packet(
+		std::span<const vec3>(ray_origins_local.data(), ray_count),
+		std::span<const vec3>(ray_directions_local.data(), ray_count),
+		std::span<const float>(closest_hit_distances_local.data(), ray_count),
+		local_mask,
+		[&](uint32_t triangle_index, uint32_t triangle_mask)
+		{
+			if (triangle_index < triangle_beg || triangle_index >= triangle_end) {
+				return;
+			}
+
+			const rdr::SceneVertex* vtx_0 = reinterpret_cast<const rdr::SceneVertex*>(vertex_bytes + sizeof(rdr::SceneVertex) * index_data[triangle_index * 3 + 0]);
+			const rdr::SceneVertex* vtx_1 = reinterpret_cast<const rdr::SceneVertex*>(vertex_bytes + sizeof(rdr::SceneVertex) * index_data[triangle_index * 3 + 1]);
+			const rdr::SceneVertex* vtx_2 = reinterpret_cast<const rdr::SceneVertex*>(vertex_bytes + sizeof(rdr::SceneVertex) * index_data[triangle_index * 3 + 2]);
+
+			for (uint32_t rays = triangle_mask; rays != 0; rays &= rays - 1) {
+
+				const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+
+				float barycentric_U;
+				float barycentric_V;
+				float triangle_hit_distance;
+
+				if (intersect_ray_triangle(
+					ray_origins_local[ray],
+					ray_directions_local[ray],
+					vtx_0->pos,
+					vtx_1->pos,
+					vtx_2->pos,
+					triangle_hit_distance,
+					barycentric_U,
+					barycentric_V
+				)) {
+					if (triangle_hit_distance < closest_hit_distances_local[ray]) {
+						closest_hit_distances_local[ray] = triangle_hit_distance;
+						hit_mask |= 1U << ray;
+					}
+				}
+			}
+		}
+	);
+
+	for (uint32_t rays = hit_mask; rays != 0; rays &= rays - 1) {
+		const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+		closest_distances[ray] = closest_hit_distances_local[ray] / direction_local_lens[ray];
+	}
+}
+
+
 template <typename Registry>
 RayHit raycast_scene(Ray& ray, Registry& registry, scn::Scene& scene, const scn::SceneResolver& resolver)
 {
@@ -250,61 +580,31 @@ RayHit raycast_scene(Ray& ray, Registry& registry, scn::Scene& scene, const scn:
 
 	RayHit best_hit {};
 
-	// TODO: replace with BVH traversal
+	// NOTE: bound tree visits entity bounds front to back, returning the best hit so far
+	//       prunes every entity whose bounds the ray enters behind it
 
-	for_each_pickable_entity(registry, [&ray, &ray_direction, &registry, &scene, &resolver, &best_hit](
+	const auto on_bound_hit = [&ray, &ray_direction, &registry, &scene, &resolver, &best_hit](
 		ecs::Entity entity,
-		const vec3& entity_aabb_min,
-		const vec3& entity_aabb_max
-	)
+		float
+	) -> float
 	{
-		float aabb_entry_distance = 0.0f;
-
-		if (!intersect_ray_aabb(ray.origin, ray_direction, entity_aabb_min, entity_aabb_max, aabb_entry_distance)) {
-			return;
-		}
-
 		const auto* model_component = registry.template get<ecs::ModelComponent>(entity);
 		if (!model_component) {
-			return;
+			return best_hit.closest_hit_distance;
 		}
 		const uint32_t submesh_count = model_component->submesh_count;
 
 		for (uint32_t submesh_index = 0; submesh_index < submesh_count; ++submesh_index) {
 
-			float closest_hit_distance_for_submesh = std::numeric_limits<float>::infinity();
-
-			for_each_triangle(
+			const float closest_hit_distance_for_submesh = raycast_submesh(
 				registry,
 				scene,
 				resolver,
 				entity,
 				submesh_index,
-				[&ray, &ray_direction, &closest_hit_distance_for_submesh](
-					const vec3& vtx_world_0,
-					const vec3& vtx_world_1,
-					const vec3& vtx_world_2
-				)
-				{
-					float barycentric_U;
-					float barycentric_V;
-					float triangle_hit_distance;
-
-					if (intersect_ray_triangle(
-						ray.origin,
-						ray_direction,
-						vtx_world_0,
-						vtx_world_1,
-						vtx_world_2,
-						triangle_hit_distance,
-						barycentric_U,
-						barycentric_V
-					)) {
-						if (triangle_hit_distance < closest_hit_distance_for_submesh) {
-							closest_hit_distance_for_submesh = triangle_hit_distance;
-						}
-					}
-				}
+				ray.origin,
+				ray_direction,
+				best_hit.closest_hit_distance
 			);
 
 			if (closest_hit_distance_for_submesh < best_hit.closest_hit_distance) {
@@ -314,12 +614,227 @@ RayHit raycast_scene(Ray& ray, Registry& registry, scn::Scene& scene, const scn:
 				best_hit.closest_hit_distance = closest_hit_distance_for_submesh;
 			}
 		}
-	});
+
+		return best_hit.closest_hit_distance;
+	};
+
+	scene.bound_tree().raycast(ray.origin, ray_direction, std::numeric_limits<float>::infinity(), on_bound_hit);
 
 	return best_hit;
 }
 
 
+template <typename Registry>
+struct SceneRayJobSlice
+{
+	uint32_t begin;
+	uint32_t end;
+
+	const Ray*                rays;
+	const uint32_t*           ray_order;
+	uint32_t                  ray_count;
+	RayHit*                   ray_hits;
+	const Registry*           registry;
+	scn::Scene*               scene;
+	const scn::SceneResolver* resolver;
+};
+
+
+// NOTE: a slice covers packets [begin, end), packet k holds the sorted rays
+//       [k * scene_ray_packet_size, ...) and walks the bound tree once for all of them
+
+template <typename Registry>
+void raycast_scene_packets(void* slice_raw)
+{
+	auto* slice = static_cast<SceneRayJobSlice<Registry>*>(slice_raw);
+
+	const Registry&           registry = *slice->registry;
+	scn::Scene&               scene    = *slice->scene;
+	const scn::SceneResolver& resolver = *slice->resolver;
+
+	std::array<vec3,   cfg::scene_ray_packet_size> ray_origins;
+	std::array<vec3,   cfg::scene_ray_packet_size> ray_directions;
+	std::array<float,  cfg::scene_ray_packet_size> best_distances;
+	std::array<float,  cfg::scene_ray_packet_size> submesh_distances;
+	std::array<RayHit, cfg::scene_ray_packet_size> packet_hits;
+
+	for (uint32_t packet_idx = slice->begin; packet_idx < slice->end; ++packet_idx) {
+
+		const uint32_t order_beg = packet_idx * cfg::scene_ray_packet_size;
+		const uint32_t ray_count = std::min(cfg::scene_ray_packet_size, slice->ray_count - order_beg);
+
+		for (uint32_t ray = 0; ray < ray_count; ++ray) {
+
+			const Ray& source_ray = slice->rays[slice->ray_order[order_beg + ray]];
+
+			ray_origins[ray]    = source_ray.origin;
+			ray_directions[ray] = glm::normalize(source_ray.direction);
+			best_distances[ray] = std::numeric_limits<float>::infinity();
+			packet_hits[ray]    = RayHit {};
+		}
+
+		const std::span<const vec3>  origin_span(ray_origins.data(), ray_count);
+		const std::span<const vec3>  direction_span(ray_directions.data(), ray_count);
+		const std::span<const float> best_span(best_distances.data(), ray_count);
+
+		const auto on_bound_hit = [&](ecs::Entity entity, uint32_t entity_mask)
+		{
+			const auto* model_component = registry.template get<ecs::ModelComponent>(entity);
+			if (!model_component) {
+				return;
+			}
+			const uint32_t submesh_count = model_component->submesh_count;
+
+			for (uint32_t submesh_index = 0; submesh_index < submesh_count; ++submesh_index) {
+
+				raycast_submesh_packet(
+					registry,
+					scene,
+					resolver,
+					entity,
+					submesh_index,
+					origin_span,
+					direction_span,
+					best_span,
+					entity_mask,
+					std::span<float>(submesh_distances.data(), ray_count)
+				);
+
+				for (uint32_t rays = entity_mask; rays != 0; rays &= rays - 1) {
+
+					const uint32_t ray = static_cast<uint32_t>(std::countr_zero(rays));
+
+					if (submesh_distances[ray] < best_distances[ray]) {
+						best_distances[ray] = submesh_distances[ray];
+						packet_hits[ray] = RayHit {
+							.hit                  = true,
+							.entity               = entity,
+							.submesh              = submesh_index,
+							.closest_hit_distance = submesh_distances[ray]
+						};
+					}
+				}
+			}
+		};
+
+		const uint32_t packet_mask = (1U << ray_count) - 1U;
+
+		scene.bound_tree().raycast_packet(origin_span, direction_span, best_span, packet_mask, on_bound_hit);
+
+		for (uint32_t ray = 0; ray < ray_count; ++ray) {
+			slice->ray_hits[slice->ray_order[order_beg + ray]] = packet_hits[ray];
+		}
+	}
+}
+
+
+inline uint32_t spread_morton_bits(uint32_t value)
+{
+	value &= 0x000001FFU;
+	value = (value | (value << 16)) & 0x030000FFU;
+	value = (value | (value <<  8)) & 0x0300F00FU;
+	value = (value | (value <<  4)) & 0x030C30C3U;
+	value = (value | (value <<  2)) & 0x09249249U;
+	return value;
+}
+
+
+// NOTE: answers many rays at once on the workers, ray_hits[i] matches raycast_scene(rays[i]).
+//       rays are sorted by direction octant, then by the morton code of their origin inside
+//       the batch bounds, so each packet shares most of its bound tree and bvh walk.
+//       registry and scene are only read while the jobs run
+
+template <typename Registry>
+void raycast_scene_batch(
+	job::Scheduler&           job_scheduler,
+	std::span<const Ray>      rays,
+	std::span<RayHit>         ray_hits,
+	const Registry&           registry,
+	scn::Scene&               scene,
+	const scn::SceneResolver& resolver
+)
+{
+	HPR_ASSERT_MSG(ray_hits.size() >= rays.size(), "[scenequery] hit span smaller than ray span");
+
+	const uint32_t ray_count = static_cast<uint32_t>(rays.size());
+	if (ray_count == 0) {
+		return;
+	}
+
+	vec3 origin_min = rays[0].origin;
+	vec3 origin_max = rays[0].origin;
+
+	for (const Ray& ray : rays) {
+		origin_min = glm::min(origin_min, ray.origin);
+		origin_max = glm::max(origin_max, ray.origin);
+	}
+
+	const vec3 origin_extent = glm::max(origin_max - origin_min, vec3 {1e-6f});
+	const vec3 origin_scale  = vec3 {static_cast<float>(cfg::scene_ray_morton_scale)} / origin_extent;
+
+	// NOTE: key is the octant in bits 61..59, the 27 bit morton code in 58..32, ray index below
+
+	mtp::vault<uint64_t, mtp::default_set> ray_keys;
+	ray_keys.resize(ray_count);
+
+	for (uint32_t ray_idx = 0; ray_idx < ray_count; ++ray_idx) {
+
+		const Ray& ray = rays[ray_idx];
+
+		const uint32_t octant =
+			(ray.direction.x < 0.0f ? 1U : 0U) |
+			(ray.direction.y < 0.0f ? 2U : 0U) |
+			(ray.direction.z < 0.0f ? 4U : 0U);
+
+		const vec3 cell = glm::clamp((ray.origin - origin_min) * origin_scale, vec3 {0.0f}, vec3 {static_cast<float>(cfg::scene_ray_morton_scale)});
+
+		const uint32_t morton =
+			spread_morton_bits(static_cast<uint32_t>(cell.x)) |
+			(spread_morton_bits(static_cast<uint32_t>(cell.y)) << 1) |
+			(spread_morton_bits(static_cast<uint32_t>(cell.z)) << 2);
+
+		ray_keys[ray_idx] = static_cast<uint64_t>(octant) << 59 | static_cast<uint64_t>(morton) << 32 | ray_idx;
+	}
+
+	std::sort(ray_keys.begin(), ray_keys.end());
+
+	mtp::vault<uint32_t, mtp::default_set> ray_order;
+	ray_order.resize(ray_count);
+
+	for (uint32_t order_idx = 0; order_idx < ray_count; ++order_idx) {
+		ray_order[order_idx] = static_cast<uint32_t>(ray_keys[order_idx]);
+	}
+
+	const uint32_t packet_count = (ray_count + cfg::scene_ray_packet_size - 1) / cfg::scene_ray_packet_size;
+	const uint32_t job_count    = (packet_count + cfg::scene_ray_job_grain - 1) / cfg::scene_ray_job_grain;
+
+	mtp::vault<SceneRayJobSlice<Registry>, mtp::default_set> job_slices;
+	job_slices.resize(job_count);
+
+	for (SceneRayJobSlice<Registry>& slice : job_slices) {
+		slice.rays      = rays.data();
+		slice.ray_order = ray_order.data();
+		slice.ray_count = ray_count;
+		slice.ray_hits  = ray_hits.data();
+		slice.registry  = &registry;
+		slice.scene     = &scene;
+		slice.resolver  = &resolver;
+	}
+
+	job::JobLatch job_latch;
+
+	job_scheduler.dispatch_range(
+		job_latch,
+		&raycast_scene_packets<Registry>,
+		packet_count,
+		cfg::scene_ray_job_grain,
+		job_slices.data()
+	);
+
+	job_latch.wait();
+}
+
+
 inline Ray make_pick_ray(
 	float                mouse_x,
 	float                mouse_y,
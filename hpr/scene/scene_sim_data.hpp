@@ -3,11 +3,22 @@
 #include "mtp_memory.hpp"
 
 #include "stratum.hpp"
+#include "bound_tree.hpp"
+#include "spatial_hash.hpp"
+#include "tile_sim.hpp"
+#include "tile_change.hpp"
+#include "tile_path.hpp"
+#include "tile_edit.hpp"
+#include "tile_journal.hpp"
 #include "tile_field.hpp"
 #include "voxel_field.hpp"
+#include "region_stream.hpp"
 #include "ghost_infra.hpp"
+#include "ghost_flow.hpp"
+#include "ghost_connectivity.hpp"
 #include "storey_data.hpp"
 #include "tile_draw_data.hpp"
+#include "voxel_draw_data.hpp"
 
 
 namespace hpr::scn {
@@ -21,12 +32,29 @@ struct SceneSimData
 
 	rdr::TileChunkDrawableSet draw_data;
 
+	TileSimulation tile_sim;
+	TileChangeLog  tile_changes;
+	TilePathfinder tile_paths;
+
+	TileEditBatch   tile_edits;
+	TileEditJournal tile_journal;
+
 	mtp::vault<StoreyStackSpec, mtp::default_set> storey_stack_specs;
 
 	VoxelGridParams voxel_grid;
 	VoxelField      voxelfield;
 
-	GhostInfra ghost_infra;
+	rdr::VoxelChunkDrawableSet voxel_draw_data;
+
+	TileRegionStream  tile_stream;
+	VoxelRegionStream voxel_stream;
+
+	BoundTree   bound_tree;
+	SpatialHash agent_hash;
+
+	GhostInfra      ghost_infra;
+	GhostInfraLinks ghost_links;
+	GhostInfraFlow  ghost_flow;
 };
 
 
@@ -0,0 +1,476 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "mtp_memory.hpp"
+#include "panic.hpp"
+
+#include "job_latch.hpp"
+#include "scheduler.hpp"
+
+#include "math.hpp"
+#include "entity.hpp"
+#include "tile_data.hpp"
+#include "components_scene.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr int32_t  spatial_hash_cell_tiles  = 4;
+	inline constexpr uint32_t spatial_hash_job_grain   = 2048U;
+	inline constexpr uint32_t spatial_hash_min_buckets = 64U;
+
+} // hpr::scn::cfg
+
+
+struct SpatialHashEntry
+{
+	vec3        position;
+	ecs::Entity entity;
+	int32_t     cell_x;
+	int32_t     cell_z;
+};
+
+
+struct SpatialHashNeighbor
+{
+	ecs::Entity entity;
+	float       distance_sq;
+};
+
+
+// NOTE: uniform grid over tile x/z hashed into a power of two bucket table, rebuilt from
+//       the transforms every tick. entries are counting sorted by bucket on the workers, each
+//       job owns one histogram row so the scatter is stable and needs no atomics. buckets
+//       mix cells, entries keep their cell so queries skip foreign cells and never revisit.
+//       height is ignored by the cells, distances are full 3d. queries are const and safe
+//       to run from jobs between rebuilds
+
+class SpatialHash
+{
+public:
+
+	void clear()
+	{
+		m_entries.clear();
+		m_scan.clear();
+		m_scan_buckets.clear();
+		m_bucket_start.clear();
+		m_slice_offsets.clear();
+		m_slices.clear();
+
+		m_bucket_mask = 0;
+	}
+
+
+	template <typename Registry>
+	void rebuild(job::Scheduler& job_scheduler, Registry& registry, const TileGridParams& grid)
+	{
+		m_origin_world = grid.origin_world;
+		m_cell_size    = grid.tile_size * static_cast<float>(cfg::spatial_hash_cell_tiles);
+
+		m_scan.clear();
+
+		registry.template scan<ecs::TransformComponent>(
+			[this](ecs::Entity entity, const ecs::TransformComponent& transform)
+			{
+				m_scan.emplace_back(SpatialHashEntry {
+					.position = transform.world_pos(),
+					.entity   = entity,
+					.cell_x   = 0,
+					.cell_z   = 0
+				});
+			}
+		);
+
+		const uint32_t entry_count  = static_cast<uint32_t>(m_scan.size());
+		const uint32_t bucket_count = std::max(cfg::spatial_hash_min_buckets, std::bit_ceil(entry_count));
+		const uint32_t job_count    = (entry_count + cfg::spatial_hash_job_grain - 1) / cfg::spatial_hash_job_grain;
+
+		m_bucket_mask = bucket_count - 1;
+
+		m_entries.resize(entry_count);
+		m_scan_buckets.resize(entry_count);
+		m_bucket_start.resize(static_cast<size_t>(bucket_count) + 1);
+		m_slice_offsets.resize(static_cast<size_t>(job_count) * bucket_count);
+		m_slices.resize(job_count);
+
+		if (entry_count == 0) {
+			std::fill(m_bucket_start.begin(), m_bucket_start.end(), 0U);
+			return;
+		}
+
+		for (RebuildJobSlice& slice : m_slices)
+			slice.hash = this;
+
+		// NOTE: first pass bins into per job histogram rows, the prefix over bucket major
+		//       order turns each row into that job's write cursors for the scatter pass
+
+		job::JobLatch count_latch;
+
+		job_scheduler.dispatch_range(
+			count_latch,
+			&count_entries,
+			entry_count,
+			cfg::spatial_hash_job_grain,
+			m_slices.data()
+		);
+
+		count_latch.wait();
+
+		uint32_t running = 0;
+
+		for (uint32_t bucket_idx = 0; bucket_idx < bucket_count; ++bucket_idx) {
+
+			m_bucket_start[bucket_idx] = running;
+
+			for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx) {
+
+				uint32_t& offset = m_slice_offsets[static_cast<size_t>(job_idx) * bucket_count + bucket_idx];
+
+				const uint32_t count = offset;
+				offset   = running;
+				running += count;
+			}
+		}
+
+		m_bucket_start[bucket_count] = running;
+
+		job::JobLatch scatter_latch;
+
+		job_scheduler.dispatch_range(
+			scatter_latch,
+			&scatter_entries,
+			entry_count,
+			cfg::spatial_hash_job_grain,
+			m_slices.data()
+		);
+
+		scatter_latch.wait();
+	}
+
+
+	[[nodiscard]] uint32_t size() const
+	{
+		return static_cast<uint32_t>(m_entries.size());
+	}
+
+
+	[[nodiscard]] float cell_size() const
+	{
+		return m_cell_size;
+	}
+
+
+	[[nodiscard]] std::span<const SpatialHashEntry> entries() const
+	{
+		return {m_entries.data(), m_entries.size()};
+	}
+
+
+	// NOTE: on_hit(entity, position, distance_sq) for every entry within radius of center
+
+	template <typename HitFn>
+	void query_radius(const vec3& center, float radius, HitFn&& on_hit) const
+	{
+		if (m_entries.empty() || !(radius >= 0.0f))
+			return;
+
+		const float radius_sq = radius * radius;
+
+		const int32_t cell_x_beg = cell_coord(center.x - radius, m_origin_world.x);
+		const int32_t cell_x_end = cell_coord(center.x + radius, m_origin_world.x);
+		const int32_t cell_z_beg = cell_coord(center.z - radius, m_origin_world.z);
+		const int32_t cell_z_end = cell_coord(center.z + radius, m_origin_world.z);
+
+		const uint64_t cell_count =
+			static_cast<uint64_t>(cell_x_end - cell_x_beg + 1) * static_cast<uint64_t>(cell_z_end - cell_z_beg + 1);
+
+		// NOTE: a query wider than the population is cheaper as a flat scan
+
+		if (cell_count > m_entries.size()) {
+			for (const SpatialHashEntry& entry : m_entries) {
+				const float distance_sq = glm::dot(entry.position - center, entry.position - center);
+				if (distance_sq <= radius_sq)
+					on_hit(entry.entity, entry.position, distance_sq);
+			}
+			return;
+		}
+
+		for (int32_t cell_z = cell_z_beg; cell_z <= cell_z_end; ++cell_z) {
+			for (int32_t cell_x = cell_x_beg; cell_x <= cell_x_end; ++cell_x) {
+
+				for_each_in_cell(cell_x, cell_z, [&](const SpatialHashEntry& entry)
+				{
+					const float distance_sq = glm::dot(entry.position - center, entry.position - center);
+					if (distance_sq <= radius_sq)
+						on_hit(entry.entity, entry.position, distance_sq);
+				});
+			}
+		}
+	}
+
+
+	// NOTE: the nearest.size() closest entries within max_radius, nearest first. rings of
+	//       cells are walked outwards until the closest unvisited ring is farther than the
+	//       current k-th neighbour, returns the number written
+
+	[[nodiscard]] uint32_t query_nearest(
+		const vec3&                    center,
+		float                          max_radius,
+		std::span<SpatialHashNeighbor> nearest,
+		ecs::Entity                    exclude_entity = ecs::invalid_entity
+	) const
+	{
+		const uint32_t k = static_cast<uint32_t>(nearest.size());
+
+		if (k == 0 || m_entries.empty() || !(max_radius >= 0.0f))
+			return 0;
+
+		const float max_radius_sq = max_radius * max_radius;
+
+		uint32_t found_count = 0;
+
+		const auto by_distance = [](const SpatialHashNeighbor& lhs, const SpatialHashNeighbor& rhs)
+		{
+			return lhs.distance_sq < rhs.distance_sq;
+		};
+
+		const auto consider = [&](const SpatialHashEntry& entry)
+		{
+			if (entry.entity == exclude_entity)
+				return;
+
+			const float distance_sq = glm::dot(entry.position - center, entry.position - center);
+
+			if (distance_sq > max_radius_sq)
+				return;
+
+			if (found_count < k) {
+				nearest[found_count++] = SpatialHashNeighbor {entry.entity, distance_sq};
+				std::push_heap(nearest.begin(), nearest.begin() + found_count, by_distance);
+				return;
+			}
+
+			if (distance_sq < nearest[0].distance_sq) {
+				std::pop_heap(nearest.begin(), nearest.end(), by_distance);
+				nearest[k - 1] = SpatialHashNeighbor {entry.entity, distance_sq};
+				std::push_heap(nearest.begin(), nearest.end(), by_distance);
+			}
+		};
+
+		const int32_t center_x = cell_coord(center.x, m_origin_world.x);
+		const int32_t center_z = cell_coord(center.z, m_origin_world.z);
+
+		const uint32_t entry_count = static_cast<uint32_t>(m_entries.size());
+		uint32_t       seen_count  = 0;
+
+		for (int32_t ring = 0; ; ++ring) {
+
+			// NOTE: any point of ring n is at least n - 1 whole cells away horizontally
+
+			const float ring_gap = static_cast<float>(std::max(ring - 1, 0)) * m_cell_size;
+
+			if (ring_gap > max_radius)
+				break;
+			if (found_count == k && ring_gap * ring_gap > nearest[0].distance_sq)
+				break;
+			if (seen_count == entry_count)
+				break;
+
+			const uint64_t ring_side = static_cast<uint64_t>(ring) * 2 + 1;
+
+			if (ring_side * ring_side > entry_count) {
+				found_count = 0;
+				for (const SpatialHashEntry& entry : m_entries)
+					consider(entry);
+				break;
+			}
+
+			const auto visit_cell = [&](int32_t cell_x, int32_t cell_z)
+			{
+				for_each_in_cell(cell_x, cell_z, [&](const SpatialHashEntry& entry)
+				{
+					++seen_count;
+					consider(entry);
+				});
+			};
+
+			if (ring == 0) {
+				visit_cell(center_x, center_z);
+				continue;
+			}
+
+			for (int32_t offset = -ring; offset <= ring; ++offset) {
+				visit_cell(center_x + offset, center_z - ring);
+				visit_cell(center_x + offset, center_z + ring);
+			}
+
+			for (int32_t offset = -ring + 1; offset <= ring - 1; ++offset) {
+				visit_cell(center_x - ring, center_z + offset);
+				visit_cell(center_x + ring, center_z + offset);
+			}
+		}
+
+		std::sort_heap(nearest.begin(), nearest.begin() + found_count, by_distance);
+
+		return found_count;
+	}
+
+
+	// NOTE: on_pair(entity_a, entity_b, distance_sq) once per unordered pair closer than
+	//       radius. radius is capped at one cell so a half stencil of neighbour cells is enough
+
+	template <typename PairFn>
+	void for_each_pair(float radius, PairFn&& on_pair) const
+	{
+		HPR_ASSERT_MSG(radius <= m_cell_size, "[spatial hash] pair radius wider than a cell");
+
+		const float radius_sq = radius * radius;
+
+		static constexpr int32_t half_stencil [4][2] {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+		for (uint32_t entry_idx = 0; entry_idx < m_entries.size(); ++entry_idx) {
+
+			const SpatialHashEntry& entry = m_entries[entry_idx];
+
+			const auto test_pair = [&](const SpatialHashEntry& other)
+			{
+				const float distance_sq = glm::dot(other.position - entry.position, other.position - entry.position);
+				if (distance_sq <= radius_sq)
+					on_pair(entry.entity, other.entity, distance_sq);
+			};
+
+			// NOTE: a cell lives in one bucket, so same cell partners are the later entries of it
+
+			const uint32_t bucket_end = m_bucket_start[bucket_index(entry.cell_x, entry.cell_z) + 1];
+
+			for (uint32_t other_idx = entry_idx + 1; other_idx < bucket_end; ++other_idx) {
+
+				const SpatialHashEntry& other = m_entries[other_idx];
+
+				if (other.cell_x == entry.cell_x && other.cell_z == entry.cell_z)
+					test_pair(other);
+			}
+
+			for (const auto& step : half_stencil)
+				for_each_in_cell(entry.cell_x + step[0], entry.cell_z + step[1], test_pair);
+		}
+	}
+
+private:
+
+	struct RebuildJobSlice
+	{
+		uint32_t begin;
+		uint32_t end;
+
+		SpatialHash* hash;
+	};
+
+private:
+
+	// NOTE: clamped well inside int range so far off queries stay defined
+
+	[[nodiscard]] int32_t cell_coord(float world, float origin) const
+	{
+		static constexpr float cell_limit = 1.0e9f;
+
+		return static_cast<int32_t>(std::clamp(std::floor((world - origin) / m_cell_size), -cell_limit, cell_limit));
+	}
+
+
+	[[nodiscard]] uint32_t bucket_index(int32_t cell_x, int32_t cell_z) const
+	{
+		const uint32_t hash =
+			static_cast<uint32_t>(cell_x) * 73856093U ^
+			static_cast<uint32_t>(cell_z) * 19349663U;
+
+		return (hash ^ (hash >> 16)) & m_bucket_mask;
+	}
+
+
+	template <typename EntryFn>
+	void for_each_in_cell(int32_t cell_x, int32_t cell_z, EntryFn&& on_entry) const
+	{
+		const uint32_t bucket_idx = bucket_index(cell_x, cell_z);
+
+		const uint32_t entry_beg = m_bucket_start[bucket_idx];
+		const uint32_t entry_end = m_bucket_start[bucket_idx + 1];
+
+		for (uint32_t entry_idx = entry_beg; entry_idx < entry_end; ++entry_idx) {
+
+			const SpatialHashEntry& entry = m_entries[entry_idx];
+
+			if (entry.cell_x == cell_x && entry.cell_z == cell_z)
+				on_entry(entry);
+		}
+	}
+
+
+	static void count_entries(void* slice_raw)
+	{
+		auto*        slice = static_cast<RebuildJobSlice*>(slice_raw);
+		SpatialHash& hash  = *slice->hash;
+
+		const uint32_t bucket_count = hash.m_bucket_mask + 1;
+		const uint32_t job_idx      = slice->begin / cfg::spatial_hash_job_grain;
+
+		uint32_t* counts = hash.m_slice_offsets.data() + static_cast<size_t>(job_idx) * bucket_count;
+
+		std::fill(counts, counts + bucket_count, 0U);
+
+		for (uint32_t entry_idx = slice->begin; entry_idx < slice->end; ++entry_idx) {
+
+			SpatialHashEntry& entry = hash.m_scan[entry_idx];
+
+			entry.cell_x = hash.cell_coord(entry.position.x, hash.m_origin_world.x);
+			entry.cell_z = hash.cell_coord(entry.position.z, hash.m_origin_world.z);
+
+			const uint32_t bucket_idx = hash.bucket_index(entry.cell_x, entry.cell_z);
+
+			hash.m_scan_buckets[entry_idx] = bucket_idx;
+			++counts[bucket_idx];
+		}
+	}
+
+
+	static void scatter_entries(void* slice_raw)
+	{
+		auto*        slice = static_cast<RebuildJobSlice*>(slice_raw);
+		SpatialHash& hash  = *slice->hash;
+
+		const uint32_t bucket_count = hash.m_bucket_mask + 1;
+		const uint32_t job_idx      = slice->begin / cfg::spatial_hash_job_grain;
+
+		uint32_t* cursors = hash.m_slice_offsets.data() + static_cast<size_t>(job_idx) * bucket_count;
+
+		for (uint32_t entry_idx = slice->begin; entry_idx < slice->end; ++entry_idx)
+			hash.m_entries[cursors[hash.m_scan_buckets[entry_idx]]++] = hash.m_scan[entry_idx];
+	}
+
+private:
+
+	mtp::vault<SpatialHashEntry, mtp::default_set> m_entries;
+	mtp::vault<uint32_t, mtp::default_set>         m_bucket_start;
+
+	mtp::vault<SpatialHashEntry, mtp::default_set> m_scan;
+	mtp::vault<uint32_t, mtp::default_set>         m_scan_buckets;
+	mtp::vault<uint32_t, mtp::default_set>         m_slice_offsets;
+	mtp::vault<RebuildJobSlice, mtp::default_set>  m_slices;
+
+	vec3     m_origin_world {0.0f};
+	float    m_cell_size    {1.0f};
+	uint32_t m_bucket_mask  {0};
+};
+
+
+} // hpr::scn
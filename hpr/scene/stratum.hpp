@@ -12,27 +12,111 @@
 namespace hpr::scn {
 
 
+// NOTE: storeys of one stack are contiguous and ordered by index_y and voxel_y,
+//       stack ranges resolve through a direct table over [stack_id_min, stack_id_max],
+//       ids too sparse for the table fall back to a binary search over stack_order
+
+struct StoreyStackRange
+{
+	int32_t stack_id {0};
+	int32_t index_beg {0};
+
+	uint32_t storey_first {0};
+	uint32_t storey_count {0};
+};
+
+
 struct Stratum
 {
+	static constexpr uint32_t k_invalid_range = 0xFFFFFFFFU;
+
 	mtp::vault<Storey,  mtp::default_set> storeys;
 	mtp::vault<int32_t, mtp::default_set> strata_voxel_y;
 
+	mtp::vault<StoreyStackRange, mtp::default_set> stack_ranges;
+	mtp::vault<uint32_t,         mtp::default_set> stack_lookup;
+	mtp::vault<uint32_t,         mtp::default_set> stack_order;
+
+	int32_t stack_id_min {0};
+
 	void clear()
 	{
 		storeys.clear();
 		strata_voxel_y.clear();
+
+		stack_ranges.clear();
+		stack_lookup.clear();
+		stack_order.clear();
+
+		stack_id_min = 0;
 	}
 
-	[[nodiscard]] const Storey* find_storey(int32_t storey_stack, int32_t storey_index) const
+	[[nodiscard]] const StoreyStackRange* find_stack(int32_t storey_stack) const
 	{
-		// TODO: replace linear traversal
+		if (!stack_order.empty()) {
 
-		for (const Storey& storey : storeys) {
-			if (storey.stack_id == storey_stack && storey.index_y == storey_index) {
-				return &storey;
-			}
+			const auto order_it = std::lower_bound(stack_order.begin(), stack_order.end(), storey_stack,
+				[this](uint32_t range_idx, int32_t stack_id) { return stack_ranges[range_idx].stack_id < stack_id; });
+
+			if (order_it == stack_order.end() || stack_ranges[*order_it].stack_id != storey_stack)
+				return nullptr;
+
+			return &stack_ranges[*order_it];
 		}
-		return nullptr;
+
+		const int64_t lookup_offset = static_cast<int64_t>(storey_stack) - stack_id_min;
+
+		if (lookup_offset < 0 || lookup_offset >= static_cast<int64_t>(stack_lookup.size()))
+			return nullptr;
+
+		const uint32_t range_idx = stack_lookup[static_cast<size_t>(lookup_offset)];
+		return range_idx == k_invalid_range ? nullptr : &stack_ranges[range_idx];
+	}
+
+	[[nodiscard]] const Storey* find_storey(int32_t storey_stack, int32_t storey_index) const
+	{
+		const StoreyStackRange* range = find_stack(storey_stack);
+		if (!range)
+			return nullptr;
+
+		const uint32_t local_idx = static_cast<uint32_t>(storey_index - range->index_beg);
+		if (local_idx >= range->storey_count)
+			return nullptr;
+
+		return &storeys[range->storey_first + local_idx];
+	}
+
+	[[nodiscard]] const Storey* find_storey_at_voxel_y(int32_t storey_stack, int32_t voxel_y) const
+	{
+		const StoreyStackRange* range = find_stack(storey_stack);
+		if (!range || range->storey_count == 0)
+			return nullptr;
+
+		const Storey* first = storeys.data() + range->storey_first;
+		const Storey* last  = first + range->storey_count;
+
+		if (voxel_y < first->voxel_y_beg || voxel_y >= (last - 1)->voxel_y_end)
+			return nullptr;
+
+		const Storey* storey = std::upper_bound(first, last, voxel_y,
+			[](int32_t y, const Storey& rhs) { return y < rhs.voxel_y_beg; });
+
+		return storey - 1;
+	}
+
+	// NOTE: index of the slab [strata_voxel_y[i], strata_voxel_y[i + 1]) holding voxel_y, -1 outside
+
+	[[nodiscard]] int32_t find_stratum(int32_t voxel_y) const
+	{
+		if (strata_voxel_y.size() < 2)
+			return -1;
+
+		if (voxel_y < strata_voxel_y[0] || voxel_y >= strata_voxel_y[strata_voxel_y.size() - 1])
+			return -1;
+
+		const auto slab_end = std::upper_bound(strata_voxel_y.begin(), strata_voxel_y.end(), voxel_y);
+
+		return static_cast<int32_t>(slab_end - strata_voxel_y.begin()) - 1;
 	}
 
 	void rebuild(const mtp::vault<StoreyStackSpec, mtp::default_set>& storey_stack_specs)
@@ -46,9 +130,17 @@ struct Stratum
 
 		storeys.reserve(total_storeys);
 		strata_voxel_y.reserve(total_storeys * 2);
+		stack_ranges.reserve(static_cast<uint32_t>(storey_stack_specs.size()));
 
 		for (const StoreyStackSpec& storey_stack_spec : storey_stack_specs) {
 
+			stack_ranges.emplace_back(StoreyStackRange {
+				.stack_id     = storey_stack_spec.stack_id,
+				.index_beg    = storey_stack_spec.base_storey_index,
+				.storey_first = static_cast<uint32_t>(storeys.size()),
+				.storey_count = static_cast<uint32_t>(storey_stack_spec.storey_specs.size())
+			});
+
 			int32_t storey_base_voxel_y = storey_stack_spec.base_voxel_y;
 
 			for (uint32_t i = 0; i < storey_stack_spec.storey_specs.size(); ++i) {
@@ -84,6 +176,58 @@ struct Stratum
 			}
 		}
 		strata_voxel_y.resize(strata_dst);
+
+		rebuild_stack_lookup();
+	}
+
+private:
+
+	void rebuild_stack_lookup()
+	{
+		if (stack_ranges.empty())
+			return;
+
+		int32_t stack_id_max = stack_ranges[0].stack_id;
+		stack_id_min = stack_ranges[0].stack_id;
+
+		for (const StoreyStackRange& range : stack_ranges) {
+			stack_id_min = std::min(stack_id_min, range.stack_id);
+			stack_id_max = std::max(stack_id_max, range.stack_id);
+		}
+
+		const int64_t lookup_span  = static_cast<int64_t>(stack_id_max) - stack_id_min + 1;
+		const int64_t lookup_limit = static_cast<int64_t>(stack_ranges.size()) * 64 + 64;
+
+		if (lookup_span > lookup_limit) {
+
+			stack_order.resize(stack_ranges.size());
+
+			for (uint32_t range_idx = 0; range_idx < stack_ranges.size(); ++range_idx)
+				stack_order[range_idx] = range_idx;
+
+			std::sort(stack_order.begin(), stack_order.end(),
+				[this](uint32_t lhs, uint32_t rhs) { return stack_ranges[lhs].stack_id < stack_ranges[rhs].stack_id; });
+
+			for (uint32_t order_idx = 1; order_idx < stack_order.size(); ++order_idx) {
+				HPR_ASSERT_MSG(stack_ranges[stack_order[order_idx - 1]].stack_id != stack_ranges[stack_order[order_idx]].stack_id,
+					"[stratum] duplicate stack id");
+			}
+
+			return;
+		}
+
+		const uint32_t lookup_size = static_cast<uint32_t>(lookup_span);
+
+		stack_lookup.resize(lookup_size, k_invalid_range);
+
+		for (uint32_t range_idx = 0; range_idx < stack_ranges.size(); ++range_idx) {
+
+			const uint32_t lookup_idx = static_cast<uint32_t>(static_cast<int64_t>(stack_ranges[range_idx].stack_id) - stack_id_min);
+
+			HPR_ASSERT_MSG(stack_lookup[lookup_idx] == k_invalid_range, "[stratum] duplicate stack id");
+
+			stack_lookup[lookup_idx] = range_idx;
+		}
 	}
 };
 
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+
+#include "mtp_memory.hpp"
+
+#include "tile_data.hpp"
+#include "tile_query.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr uint32_t tile_change_history = 64U;
+
+} // hpr::scn::cfg
+
+
+// NOTE: one bit per tile of a chunk, bit i is local index i
+
+struct TileChunkMask
+{
+	static constexpr uint32_t k_words = static_cast<uint32_t>(cfg::chunk_area) / 64U;
+
+	uint64_t bits [k_words] {};
+
+	void set(uint32_t local_index)
+	{
+		bits[local_index >> 6] |= uint64_t {1} << (local_index & 63U);
+	}
+
+	void fill()
+	{
+		std::fill_n(bits, k_words, ~uint64_t {0});
+	}
+
+	void merge(const TileChunkMask& other)
+	{
+		for (uint32_t word = 0; word < k_words; ++word)
+			bits[word] |= other.bits[word];
+	}
+
+	[[nodiscard]] bool test(uint32_t local_index) const
+	{
+		return (bits[local_index >> 6] >> (local_index & 63U)) & 1U;
+	}
+
+	[[nodiscard]] uint32_t count() const
+	{
+		uint32_t total = 0;
+		for (const uint64_t word : bits)
+			total += static_cast<uint32_t>(std::popcount(word));
+		return total;
+	}
+
+	// NOTE: chunk_size is 32 so one row of tiles is half a word
+
+	[[nodiscard]] bool touches_row(int32_t local_z) const
+	{
+		const uint32_t row = static_cast<uint32_t>(local_z);
+		return ((bits[row >> 1] >> ((row & 1U) * 32U)) & 0xFFFFFFFFULL) != 0;
+	}
+
+	[[nodiscard]] bool touches_column(int32_t local_x) const
+	{
+		const uint64_t column = (uint64_t {1} << local_x) | (uint64_t {1} << (local_x + 32));
+
+		for (const uint64_t word : bits) {
+			if (word & column)
+				return true;
+		}
+		return false;
+	}
+};
+
+static_assert(cfg::chunk_size == 32, "[tile_change] row helpers assume 32 tiles per row");
+
+
+struct TileChange
+{
+	TileChunkCoord coord {};
+	uint64_t       key   {0};
+	TileChunkMask  mask  {};
+};
+
+
+// NOTE: owned by each consumer, the last log version it has seen
+
+struct TileChangeCursor
+{
+	uint64_t version {0};
+};
+
+
+// NOTE: per tick log of changed tiles. producers record during the tick, end_tick() seals
+//       the open records under a new version, consumers pull everything newer than their
+//       cursor whenever they like. a chunk touched in several pulled ticks is reported once
+//       with the merged mask. only the last tile_change_history sealed ticks are kept, a
+//       cursor older than that gets false from pull() and has to rescan instead
+
+class TileChangeLog
+{
+public:
+
+	void clear()
+	{
+		m_changes.clear();
+		m_ticks.clear();
+		m_tick_first = 0;
+
+		m_open_index.clear();
+		m_open_beg = 0;
+
+		m_version         = 0;
+		m_dropped_version = 0;
+	}
+
+
+	void record(TileCoord coord)
+	{
+		open_change(get_chunk_coord(coord)).mask.set(get_local_index(coord));
+	}
+
+
+	// NOTE: whole chunk, for region ops and producers that do not track single tiles
+
+	void record(TileChunkCoord chunk_coord)
+	{
+		open_change(chunk_coord).mask.fill();
+	}
+
+
+	void record(TileChunkCoord chunk_coord, const TileChunkMask& mask)
+	{
+		open_change(chunk_coord).mask.merge(mask);
+	}
+
+
+	[[nodiscard]] uint64_t version() const
+	{
+		return m_version;
+	}
+
+
+	// NOTE: a cursor that starts at the current version, earlier changes are not reported
+
+	[[nodiscard]] TileChangeCursor subscribe() const
+	{
+		return TileChangeCursor {.version = m_version};
+	}
+
+
+	// NOTE: ticks without records do not move the version
+
+	uint64_t end_tick()
+	{
+		const uint32_t change_count = static_cast<uint32_t>(m_changes.size()) - m_open_beg;
+
+		if (change_count == 0)
+			return m_version;
+
+		m_ticks.emplace_back(TickRange {
+			.version      = ++m_version,
+			.change_beg   = m_open_beg,
+			.change_count = change_count
+		});
+
+		m_open_index.clear();
+		m_open_beg = static_cast<uint32_t>(m_changes.size());
+
+		if (m_ticks.size() - m_tick_first > cfg::tile_change_history)
+			drop_oldest();
+
+		return m_version;
+	}
+
+
+	template <typename ChangeFn>
+	bool pull(TileChangeCursor& cursor, ChangeFn&& on_change)
+	{
+		const bool complete = cursor.version >= m_dropped_version;
+
+		uint32_t tick_beg = static_cast<uint32_t>(m_ticks.size());
+		while (tick_beg > m_tick_first && m_ticks[tick_beg - 1].version > cursor.version)
+			--tick_beg;
+
+		cursor.version = m_version;
+
+		if (tick_beg == m_ticks.size())
+			return complete;
+
+		// NOTE: a single tick has no duplicates, more are merged by sorting on the chunk key
+
+		if (tick_beg + 1 == m_ticks.size()) {
+
+			const TickRange& tick = m_ticks[tick_beg];
+
+			for (uint32_t change_idx = tick.change_beg; change_idx < tick.change_beg + tick.change_count; ++change_idx)
+				on_change(m_changes[change_idx]);
+
+			return complete;
+		}
+
+		m_merge_order.clear();
+
+		for (uint32_t tick_idx = tick_beg; tick_idx < m_ticks.size(); ++tick_idx) {
+			const TickRange& tick = m_ticks[tick_idx];
+			for (uint32_t change_idx = tick.change_beg; change_idx < tick.change_beg + tick.change_count; ++change_idx)
+				m_merge_order.emplace_back(change_idx);
+		}
+
+		std::sort(m_merge_order.begin(), m_merge_order.end(), [this](uint32_t lhs, uint32_t rhs) {
+			return m_changes[lhs].key != m_changes[rhs].key ? m_changes[lhs].key < m_changes[rhs].key : lhs < rhs;
+		});
+
+		for (uint32_t order_idx = 0; order_idx < m_merge_order.size();) {
+
+			m_merged = m_changes[m_merge_order[order_idx]];
+
+			for (++order_idx; order_idx < m_merge_order.size()
+				&& m_changes[m_merge_order[order_idx]].key == m_merged.key
+				&& same_chunk(m_changes[m_merge_order[order_idx]].coord, m_merged.coord); ++order_idx) {
+				m_merged.mask.merge(m_changes[m_merge_order[order_idx]].mask);
+			}
+
+			on_change(m_merged);
+		}
+
+		return complete;
+	}
+
+private:
+
+	struct TickRange
+	{
+		uint64_t version;
+		uint32_t change_beg;
+		uint32_t change_count;
+	};
+
+
+	TileChange& open_change(TileChunkCoord chunk_coord)
+	{
+		const uint64_t key  = get_chunk_coord_hash(chunk_coord);
+		const uint32_t slot = m_open_index.find(key);
+
+		if (slot != ChunkDirectory::k_empty_slot)
+			return m_changes[slot];
+
+		m_open_index.insert(key, static_cast<uint32_t>(m_changes.size()));
+
+		TileChange& change = m_changes.emplace_back();
+
+		change.coord = chunk_coord;
+		change.key   = key;
+
+		return change;
+	}
+
+
+	// NOTE: only runs right after a seal, so no open record has to be rebased. the dropped
+	//       prefix is compacted once it outweighs the live ticks
+
+	void drop_oldest()
+	{
+		m_dropped_version = m_ticks[m_tick_first].version;
+		++m_tick_first;
+
+		if (m_tick_first * 2 < m_ticks.size())
+			return;
+
+		const uint32_t change_shift = m_ticks[m_tick_first].change_beg;
+
+		std::copy(m_ticks.begin() + m_tick_first, m_ticks.end(), m_ticks.begin());
+		m_ticks.resize(m_ticks.size() - m_tick_first);
+
+		m_tick_first = 0;
+
+		std::copy(m_changes.begin() + change_shift, m_changes.end(), m_changes.begin());
+		m_changes.resize(m_changes.size() - change_shift);
+
+		for (TickRange& tick : m_ticks)
+			tick.change_beg -= change_shift;
+
+		m_open_beg -= change_shift;
+	}
+
+private:
+
+	mtp::vault<TileChange, mtp::default_set> m_changes;
+	mtp::vault<TickRange,  mtp::default_set> m_ticks;
+	uint32_t                                 m_tick_first {0};
+
+	ChunkDirectory m_open_index;
+	uint32_t       m_open_beg {0};
+
+	uint64_t m_version         {0};
+	uint64_t m_dropped_version {0};
+
+	mtp::vault<uint32_t, mtp::default_set> m_merge_order;
+	TileChange                             m_merged {};
+};
+
+
+} // hpr::scn
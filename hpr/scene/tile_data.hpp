@@ -13,8 +13,13 @@ using TileType = uint16_t;
 
 namespace cfg {
 
-	inline constexpr int32_t chunk_size = 32;
-	inline constexpr float   tile_size  = 0.5f;
+	inline constexpr int32_t chunk_size  = 32;
+	inline constexpr int32_t chunk_shift = 5;
+	inline constexpr int32_t chunk_mask  = chunk_size - 1;
+	inline constexpr int32_t chunk_area  = chunk_size * chunk_size;
+	inline constexpr float   tile_size   = 0.5f;
+
+	static_assert(chunk_size == (1 << chunk_shift), "[tile] chunk_size must be a power of two");
 
 } // hpr::scn::cfg
 
@@ -37,6 +42,21 @@ struct TileChunkCoord
 };
 
 
+// NOTE: half-open on every axis, one storey stack
+
+struct TileRegion
+{
+	int32_t x_beg;
+	int32_t z_beg;
+	int32_t x_end;
+	int32_t z_end;
+
+	int32_t storey_beg;
+	int32_t storey_end;
+	int32_t storey_stack;
+};
+
+
 struct TileChunk
 {
 	TileChunkCoord coord {};
@@ -40,6 +40,9 @@ public:
 		return m_edits;
 	}
 
+	// NOTE: mark_dirty sees every applied tile. edits queued on Scene::tile_edits() go through
+	//       TileEditJournal::apply instead, so they can be undone
+
 	template <typename MarkDirtyFn>
 	uint32_t apply(TileField& tilefield, MarkDirtyFn&& mark_dirty)
 	{
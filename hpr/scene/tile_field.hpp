@@ -1,29 +1,64 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
 
 #include "panic.hpp"
 #include "mtp_memory.hpp"
 
 #include "tile_data.hpp"
 #include "tile_query.hpp"
+#include "chunk_directory.hpp"
 
 
 namespace hpr::scn {
 
 
+struct TileChunkSpan
+{
+	TileChunkCoord coord;
+
+	int32_t local_x_beg;
+	int32_t local_x_end;
+	int32_t local_z_beg;
+	int32_t local_z_end;
+};
+
+
+// NOTE: chunks inside the resize() bounds resolve through a dense slot grid,
+//       everything else through the open addressing directory keyed by chunk hash
+
 class TileField
 {
 public:
 
-	using IndexMap = decltype(mtp::make_unordered_map<uint64_t, uint32_t, mtp::default_set>());
+	static constexpr uint32_t k_invalid_slot = ChunkDirectory::k_empty_slot;
+
+	// NOTE: xz chunk bounds over every storey and stack, grows with each chunk created
+	//       and resets when the field empties, eviction leaves it conservative
+
+	struct ChunkExtent
+	{
+		int32_t chunk_x_min {0};
+		int32_t chunk_z_min {0};
+		int32_t chunk_x_max {0};
+		int32_t chunk_z_max {0};
+	};
 
 public:
 
 	void clear()
 	{
 		m_chunks.clear();
-		m_index.clear();
+		m_directory.clear();
+
+		m_dense_slots.clear();
+		m_dense_count_x = 0;
+		m_dense_count_z = 0;
+		m_dense_storeys = 0;
+		m_dense_stack   = 0;
+
+		m_chunk_extent = {};
 	}
 
 
@@ -33,6 +68,12 @@ public:
 	}
 
 
+	[[nodiscard]] const ChunkExtent& chunk_extent() const
+	{
+		return m_chunk_extent;
+	}
+
+
 	void resize(int32_t width, int32_t height, int32_t storeys, TileType fill_value = 0)
 	{
 		clear();
@@ -52,7 +93,14 @@ public:
 			static_cast<uint32_t>(storeys);
 
 		m_chunks.reserve(total_chunks);
-		m_index.reserve(total_chunks);
+		m_directory.reserve(total_chunks);
+
+		m_dense_count_x = static_cast<uint32_t>(chunk_count_x);
+		m_dense_count_z = static_cast<uint32_t>(chunk_count_z);
+		m_dense_storeys = static_cast<uint32_t>(storeys);
+		m_dense_stack   = storey_stack;
+
+		m_dense_slots.resize(total_chunks, k_invalid_slot);
 
 		for (int32_t storey_index = 0; storey_index < storeys; ++storey_index) {
 			for (int32_t chunk_z = 0; chunk_z < chunk_count_z; ++chunk_z) {
@@ -74,133 +122,524 @@ public:
 
 	[[nodiscard]] TileType get(TileCoord coord) const
 	{
-		const TileChunkCoord chunk_coord = get_chunk_coord(coord);
-		const uint64_t key = get_chunk_coord_hash(chunk_coord);
-
-		const TileChunk* chunk = find_chunk(key);
+		const TileChunk* chunk = find_chunk(get_chunk_coord(coord));
 		if (!chunk)
 			return 0;
 
-		const uint32_t idx = local_index(coord, chunk_coord);
-		return chunk->tiles[idx];
+		return chunk->tiles[get_local_index(coord)];
 	}
 
 
+	// NOTE: resident chunks take the lookup only, ensure_chunk stays off the hot path
+
 	void set(TileCoord coord, TileType tile_type)
 	{
 		const TileChunkCoord chunk_coord = get_chunk_coord(coord);
-		TileChunk& chunk = ensure_chunk(chunk_coord, 0);
 
-		const uint32_t idx = local_index(coord, chunk_coord);
-		chunk.tiles[idx]   = tile_type;
+		TileChunk* chunk = find_chunk(chunk_coord);
+		if (!chunk)
+			chunk = &ensure_chunk(chunk_coord, 0);
+
+		chunk->tiles[get_local_index(coord)] = tile_type;
 	}
 
 
 	[[nodiscard]] TileType* get_ptr(TileCoord coord)
 	{
-		const TileChunkCoord chunk_coord = get_chunk_coord(coord);
-		const uint64_t key = get_chunk_coord_hash(chunk_coord);
-
-		TileChunk* chunk = find_chunk(key);
+		TileChunk* chunk = find_chunk(get_chunk_coord(coord));
 		if (!chunk)
 			return nullptr;
 
-		const uint32_t idx = local_index(coord, chunk_coord);
-		return &chunk->tiles[idx];
+		return &chunk->tiles[get_local_index(coord)];
 	}
 
 
 	[[nodiscard]] const TileType* get_ptr(TileCoord coord) const
 	{
-		const TileChunkCoord chunk_coord = get_chunk_coord(coord);
-		const uint64_t key = get_chunk_coord_hash(chunk_coord);
-
-		const TileChunk* chunk = find_chunk(key);
+		const TileChunk* chunk = find_chunk(get_chunk_coord(coord));
 		if (!chunk)
 			return nullptr;
 
-		const uint32_t idx = local_index(coord, chunk_coord);
-		return &chunk->tiles[idx];
+		return &chunk->tiles[get_local_index(coord)];
 	}
 
 
-	[[nodiscard]] TileChunk* find_chunk(uint64_t key)
+	[[nodiscard]] TileChunk* find_chunk(TileChunkCoord chunk_coord)
 	{
-		auto it = m_index.find(key);
-		if (it == m_index.end()) {
-			return nullptr;
-		}
+		const uint32_t slot = find_slot(chunk_coord);
+		return slot == k_invalid_slot ? nullptr : &m_chunks[slot];
+	}
 
-		const uint32_t index = it->second;
-		HPR_ASSERT_MSG(index < m_chunks.size(), "[tilefield] index map out of range");
 
-		return &m_chunks[index];
+	[[nodiscard]] const TileChunk* find_chunk(TileChunkCoord chunk_coord) const
+	{
+		const uint32_t slot = find_slot(chunk_coord);
+		return slot == k_invalid_slot ? nullptr : &m_chunks[slot];
 	}
 
 
-	[[nodiscard]] const TileChunk* find_chunk(uint64_t key) const
+	[[nodiscard]] TileChunk* find_chunk(uint64_t key)
 	{
-		auto it = m_index.find(key);
-		if (it == m_index.end()) {
+		const uint32_t slot = m_directory.find(key);
+		if (slot == k_invalid_slot)
 			return nullptr;
-		}
 
-		const uint32_t index = it->second;
-		HPR_ASSERT_MSG(index < m_chunks.size(), "[tilefield] index map out of range");
+		HPR_ASSERT_MSG(slot < m_chunks.size(), "[tilefield] index map out of range");
 
-		return &m_chunks[index];
+		return &m_chunks[slot];
 	}
 
-private:
 
-	[[nodiscard]] static uint32_t local_index(TileCoord coord, TileChunkCoord chunk_coord)
+	[[nodiscard]] const TileChunk* find_chunk(uint64_t key) const
 	{
-		const int32_t base_x = chunk_coord.chunk_x * cfg::chunk_size;
-		const int32_t base_z = chunk_coord.chunk_z * cfg::chunk_size;
-
-		const int32_t local_x = coord.x - base_x;
-		const int32_t local_z = coord.z - base_z;
+		const uint32_t slot = m_directory.find(key);
+		if (slot == k_invalid_slot)
+			return nullptr;
 
-		HPR_ASSERT_MSG(local_x >= 0 && local_x < cfg::chunk_size, "[tilefield] local_x out of range");
-		HPR_ASSERT_MSG(local_z >= 0 && local_z < cfg::chunk_size, "[tilefield] local_z out of range");
+		HPR_ASSERT_MSG(slot < m_chunks.size(), "[tilefield] index map out of range");
 
-		return static_cast<uint32_t>(local_x) + static_cast<uint32_t>(local_z) * static_cast<uint32_t>(cfg::chunk_size);
+		return &m_chunks[slot];
 	}
 
 
 	TileChunk& ensure_chunk(TileChunkCoord chunk_coord, TileType fill_value)
 	{
-		const uint64_t key = get_chunk_coord_hash(chunk_coord);
-
-		if (TileChunk* existing = find_chunk(key)) {
+		if (TileChunk* existing = find_chunk(chunk_coord)) {
 			return *existing;
 		}
 
+		const uint64_t key = get_chunk_coord_hash(chunk_coord);
+
 		TileChunk chunk {};
 		chunk.coord = chunk_coord;
 		chunk.key   = key;
 
-		const uint32_t count = static_cast<uint32_t>(cfg::chunk_size) * static_cast<uint32_t>(cfg::chunk_size);
-		chunk.tiles.reserve(count);
+		chunk.tiles.resize(static_cast<uint32_t>(cfg::chunk_area), fill_value);
 
-		for (uint32_t i = 0; i < count; ++i) {
-			chunk.tiles.emplace_back(fill_value);
+		if (m_chunks.empty()) {
+			m_chunk_extent = ChunkExtent {chunk_coord.chunk_x, chunk_coord.chunk_z, chunk_coord.chunk_x, chunk_coord.chunk_z};
+		}
+		else {
+			m_chunk_extent.chunk_x_min = std::min(m_chunk_extent.chunk_x_min, chunk_coord.chunk_x);
+			m_chunk_extent.chunk_z_min = std::min(m_chunk_extent.chunk_z_min, chunk_coord.chunk_z);
+			m_chunk_extent.chunk_x_max = std::max(m_chunk_extent.chunk_x_max, chunk_coord.chunk_x);
+			m_chunk_extent.chunk_z_max = std::max(m_chunk_extent.chunk_z_max, chunk_coord.chunk_z);
 		}
 
-		const uint32_t new_index = static_cast<uint32_t>(m_chunks.size());
+		const uint32_t new_slot = static_cast<uint32_t>(m_chunks.size());
 		m_chunks.emplace_back(std::move(chunk));
-		m_index[key] = new_index;
+		m_directory.insert(key, new_slot);
+
+		const uint32_t dense_index = dense_index_of(chunk_coord);
+		if (dense_index != k_invalid_slot)
+			m_dense_slots[dense_index] = new_slot;
 
 		return m_chunks.back();
 	}
 
+
+	// NOTE: swap-removes the chunk, the last chunk takes over its slot so chunk pointers are not stable
+
+	bool evict_chunk(TileChunkCoord chunk_coord)
+	{
+		const uint32_t slot = find_slot(chunk_coord);
+		if (slot == k_invalid_slot)
+			return false;
+
+		release_slot(chunk_coord, m_chunks[slot].key);
+
+		const uint32_t last_slot = static_cast<uint32_t>(m_chunks.size() - 1);
+
+		if (slot != last_slot) {
+			m_chunks[slot] = std::move(m_chunks[last_slot]);
+
+			const TileChunk& moved = m_chunks[slot];
+			m_directory.insert(moved.key, slot);
+
+			const uint32_t dense_index = dense_index_of(moved.coord);
+			if (dense_index != k_invalid_slot)
+				m_dense_slots[dense_index] = slot;
+		}
+
+		m_chunks.pop_back();
+
+		return true;
+	}
+
+
+	// NOTE: region ops walk chunk by chunk and call mark_dirty(TileChunkCoord) once per touched chunk
+
+	template <typename MarkDirtyFn>
+	uint32_t fill_region(const TileRegion& region, TileType tile_type, MarkDirtyFn&& mark_dirty)
+	{
+		uint32_t chunk_count = 0;
+
+		for_each_chunk_span(region, [&](const TileChunkSpan& span) {
+
+			TileChunk& chunk = ensure_chunk(span.coord, 0);
+			TileType* tiles  = chunk.tiles.data();
+
+			const int32_t row_count = span.local_x_end - span.local_x_beg;
+
+			if (row_count == cfg::chunk_size) {
+				const uint32_t first = get_local_index(0, span.local_z_beg);
+				const uint32_t count = static_cast<uint32_t>((span.local_z_end - span.local_z_beg) << cfg::chunk_shift);
+				std::fill_n(tiles + first, count, tile_type);
+			}
+			else {
+				for (int32_t local_z = span.local_z_beg; local_z < span.local_z_end; ++local_z) {
+					std::fill_n(tiles + get_local_index(span.local_x_beg, local_z), row_count, tile_type);
+				}
+			}
+
+			mark_dirty(span.coord);
+			++chunk_count;
+		});
+
+		return chunk_count;
+	}
+
+
+	// NOTE: tiles in missing source chunks read as 0, same as get()
+
+	template <typename MarkDirtyFn>
+	uint32_t blit(const TileField& source, const TileRegion& source_region, TileCoord target_origin, MarkDirtyFn&& mark_dirty)
+	{
+		if (region_empty(source_region))
+			return 0;
+
+		const TileRegion target_region = shift_region(source_region, target_origin);
+
+		if (&source == this && regions_overlap(source_region, target_region))
+			return copy_overlapping(source_region, target_region, mark_dirty);
+
+		const int32_t offset_x      = source_region.x_beg      - target_region.x_beg;
+		const int32_t offset_z      = source_region.z_beg      - target_region.z_beg;
+		const int32_t offset_storey = source_region.storey_beg - target_region.storey_beg;
+
+		uint32_t chunk_count = 0;
+
+		for_each_chunk_span(target_region, [&](const TileChunkSpan& span) {
+
+			// NOTE: ensure before reading the source, growth may move chunks when source is this
+
+			TileType* target_tiles = ensure_chunk(span.coord, 0).tiles.data();
+
+			const int32_t base_x = span.coord.chunk_x << cfg::chunk_shift;
+			const int32_t base_z = span.coord.chunk_z << cfg::chunk_shift;
+
+			for (int32_t local_z = span.local_z_beg; local_z < span.local_z_end; ++local_z) {
+
+				const TileCoord source_row {
+					.x            = base_x + span.local_x_beg + offset_x,
+					.z            = base_z + local_z + offset_z,
+					.storey_index = span.coord.storey_index + offset_storey,
+					.storey_stack = source_region.storey_stack
+				};
+
+				source.read_row(source_row, span.local_x_end - span.local_x_beg,
+					target_tiles + get_local_index(span.local_x_beg, local_z));
+			}
+
+			mark_dirty(span.coord);
+			++chunk_count;
+		});
+
+		return chunk_count;
+	}
+
+
+	template <typename MarkDirtyFn>
+	uint32_t copy_region(const TileRegion& source_region, TileCoord target_origin, MarkDirtyFn&& mark_dirty)
+	{
+		return blit(*this, source_region, target_origin, mark_dirty);
+	}
+
+
+	// NOTE: func(TileCoord row_coord, TileType* row, int32_t count) per contiguous row,
+	//       missing chunks are skipped
+
+	template <typename RowFn>
+	void for_each_in_region(const TileRegion& region, RowFn&& func)
+	{
+		for_each_chunk_span(region, [&](const TileChunkSpan& span) {
+			if (TileChunk* chunk = find_chunk(span.coord))
+				visit_rows(span, chunk->tiles.data(), func);
+		});
+	}
+
+
+	template <typename RowFn>
+	void for_each_in_region(const TileRegion& region, RowFn&& func) const
+	{
+		for_each_chunk_span(region, [&](const TileChunkSpan& span) {
+			if (const TileChunk* chunk = find_chunk(span.coord))
+				visit_rows(span, chunk->tiles.data(), func);
+		});
+	}
+
+
+	template <typename SpanFn>
+	static void for_each_chunk_span(const TileRegion& region, SpanFn&& func)
+	{
+		if (region_empty(region))
+			return;
+
+		const int32_t chunk_x_beg  = region.x_beg >> cfg::chunk_shift;
+		const int32_t chunk_z_beg  = region.z_beg >> cfg::chunk_shift;
+		const int32_t chunk_x_last = (region.x_end - 1) >> cfg::chunk_shift;
+		const int32_t chunk_z_last = (region.z_end - 1) >> cfg::chunk_shift;
+
+		for (int32_t storey_index = region.storey_beg; storey_index < region.storey_end; ++storey_index) {
+			for (int32_t chunk_z = chunk_z_beg; chunk_z <= chunk_z_last; ++chunk_z) {
+
+				const int32_t base_z = chunk_z << cfg::chunk_shift;
+
+				for (int32_t chunk_x = chunk_x_beg; chunk_x <= chunk_x_last; ++chunk_x) {
+
+					const int32_t base_x = chunk_x << cfg::chunk_shift;
+
+					const TileChunkSpan span {
+						.coord = TileChunkCoord {
+							.chunk_x      = chunk_x,
+							.chunk_z      = chunk_z,
+							.storey_index = storey_index,
+							.storey_stack = region.storey_stack
+						},
+						.local_x_beg = std::max(region.x_beg - base_x, 0),
+						.local_x_end = std::min(region.x_end - base_x, cfg::chunk_size),
+						.local_z_beg = std::max(region.z_beg - base_z, 0),
+						.local_z_end = std::min(region.z_end - base_z, cfg::chunk_size)
+					};
+
+					func(span);
+				}
+			}
+		}
+	}
+
+
+	[[nodiscard]] const mtp::vault<TileChunk, mtp::default_set>& chunks() const
+	{
+		return m_chunks;
+	}
+
+
+	[[nodiscard]] mtp::vault<TileChunk, mtp::default_set>& chunks()
+	{
+		return m_chunks;
+	}
+
+private:
+
+	[[nodiscard]] static TileRegion shift_region(const TileRegion& region, TileCoord origin)
+	{
+		return TileRegion {
+			.x_beg        = origin.x,
+			.z_beg        = origin.z,
+			.x_end        = origin.x + (region.x_end - region.x_beg),
+			.z_end        = origin.z + (region.z_end - region.z_beg),
+			.storey_beg   = origin.storey_index,
+			.storey_end   = origin.storey_index + (region.storey_end - region.storey_beg),
+			.storey_stack = origin.storey_stack
+		};
+	}
+
+
+	// NOTE: row may straddle source chunks
+
+	void read_row(TileCoord row_coord, int32_t count, TileType* out) const
+	{
+		while (count > 0) {
+
+			const int32_t local_x = row_coord.x & cfg::chunk_mask;
+			const int32_t step    = std::min(count, cfg::chunk_size - local_x);
+
+			if (const TileChunk* chunk = find_chunk(get_chunk_coord(row_coord)))
+				std::copy_n(chunk->tiles.data() + get_local_index(row_coord), step, out);
+			else
+				std::fill_n(out, step, TileType {0});
+
+			row_coord.x += step;
+			out         += step;
+			count       -= step;
+		}
+	}
+
+
+	template <typename MarkDirtyFn>
+	uint32_t copy_overlapping(const TileRegion& source_region, const TileRegion& target_region, MarkDirtyFn&& mark_dirty)
+	{
+		const int32_t size_x = source_region.x_end - source_region.x_beg;
+		const int32_t size_z = source_region.z_end - source_region.z_beg;
+
+		const uint32_t row_area =
+			static_cast<uint32_t>(size_x) * static_cast<uint32_t>(size_z);
+
+		mtp::vault<TileType, mtp::default_set> scratch;
+		scratch.resize(row_area * static_cast<uint32_t>(source_region.storey_end - source_region.storey_beg));
+
+		for (int32_t storey_index = source_region.storey_beg; storey_index < source_region.storey_end; ++storey_index) {
+			for (int32_t z = source_region.z_beg; z < source_region.z_end; ++z) {
+
+				const uint32_t scratch_row =
+					static_cast<uint32_t>(storey_index - source_region.storey_beg) * row_area +
+					static_cast<uint32_t>(z - source_region.z_beg) * static_cast<uint32_t>(size_x);
+
+				read_row(TileCoord {source_region.x_beg, z, storey_index, source_region.storey_stack},
+					size_x, scratch.data() + scratch_row);
+			}
+		}
+
+		uint32_t chunk_count = 0;
+
+		for_each_chunk_span(target_region, [&](const TileChunkSpan& span) {
+
+			TileType* target_tiles = ensure_chunk(span.coord, 0).tiles.data();
+
+			const int32_t base_x = span.coord.chunk_x << cfg::chunk_shift;
+			const int32_t base_z = span.coord.chunk_z << cfg::chunk_shift;
+
+			for (int32_t local_z = span.local_z_beg; local_z < span.local_z_end; ++local_z) {
+
+				const uint32_t scratch_row =
+					static_cast<uint32_t>(span.coord.storey_index - target_region.storey_beg) * row_area +
+					static_cast<uint32_t>(base_z + local_z - target_region.z_beg) * static_cast<uint32_t>(size_x) +
+					static_cast<uint32_t>(base_x + span.local_x_beg - target_region.x_beg);
+
+				std::copy_n(scratch.data() + scratch_row, span.local_x_end - span.local_x_beg,
+					target_tiles + get_local_index(span.local_x_beg, local_z));
+			}
+
+			mark_dirty(span.coord);
+			++chunk_count;
+		});
+
+		return chunk_count;
+	}
+
+
+	template <typename TilePtr, typename RowFn>
+	static void visit_rows(const TileChunkSpan& span, TilePtr tiles, RowFn& func)
+	{
+		const int32_t base_x = span.coord.chunk_x << cfg::chunk_shift;
+		const int32_t base_z = span.coord.chunk_z << cfg::chunk_shift;
+
+		for (int32_t local_z = span.local_z_beg; local_z < span.local_z_end; ++local_z) {
+
+			const TileCoord row_coord {
+				.x            = base_x + span.local_x_beg,
+				.z            = base_z + local_z,
+				.storey_index = span.coord.storey_index,
+				.storey_stack = span.coord.storey_stack
+			};
+
+			func(row_coord, tiles + get_local_index(span.local_x_beg, local_z), span.local_x_end - span.local_x_beg);
+		}
+	}
+
+
+	[[nodiscard]] uint32_t dense_index_of(TileChunkCoord chunk_coord) const
+	{
+		const uint32_t chunk_x = static_cast<uint32_t>(chunk_coord.chunk_x);
+		const uint32_t chunk_z = static_cast<uint32_t>(chunk_coord.chunk_z);
+		const uint32_t storey  = static_cast<uint32_t>(chunk_coord.storey_index);
+
+		// NOTE: negative coords wrap to large unsigned values and fail the bounds test
+
+		if (chunk_coord.storey_stack != m_dense_stack ||
+			chunk_x >= m_dense_count_x ||
+			chunk_z >= m_dense_count_z ||
+			storey  >= m_dense_storeys) {
+			return k_invalid_slot;
+		}
+
+		return chunk_x + m_dense_count_x * (chunk_z + m_dense_count_z * storey);
+	}
+
+
+	[[nodiscard]] uint32_t find_slot(TileChunkCoord chunk_coord) const
+	{
+		const uint32_t dense_index = dense_index_of(chunk_coord);
+		if (dense_index != k_invalid_slot)
+			return m_dense_slots[dense_index];
+
+		return m_directory.find(get_chunk_coord_hash(chunk_coord));
+	}
+
+
+	void release_slot(TileChunkCoord chunk_coord, uint64_t key)
+	{
+		(void) m_directory.erase(key);
+
+		const uint32_t dense_index = dense_index_of(chunk_coord);
+		if (dense_index != k_invalid_slot)
+			m_dense_slots[dense_index] = k_invalid_slot;
+	}
+
 private:
 
 	mtp::vault<TileChunk, mtp::default_set> m_chunks;
 
-	IndexMap m_index {mtp::make_unordered_map<uint64_t, uint32_t, mtp::default_set>()};
+	ChunkDirectory m_directory;
+
+	mtp::vault<uint32_t, mtp::default_set> m_dense_slots;
+
+	uint32_t m_dense_count_x {0};
+	uint32_t m_dense_count_z {0};
+	uint32_t m_dense_storeys {0};
+	int32_t  m_dense_stack   {0};
+
+	ChunkExtent m_chunk_extent {};
 };
 
 
-} // hpr::scn
+// NOTE: caller-owned last-chunk cache for neighbourhood reads, one per thread,
+//       reset() after chunks are added to or evicted from the field
+
+class TileCursor
+{
+public:
+
+	explicit TileCursor(const TileField& tilefield)
+		: m_tilefield {&tilefield}
+	{}
+
+	[[nodiscard]] TileType get(TileCoord coord)
+	{
+		const TileChunk* chunk = resolve(get_chunk_coord(coord));
+		if (!chunk)
+			return 0;
+
+		return chunk->tiles[get_local_index(coord)];
+	}
+
+	[[nodiscard]] const TileChunk* resolve(TileChunkCoord chunk_coord)
+	{
+		if (!m_has_chunk || !same_chunk(chunk_coord, m_chunk_coord)) {
+			m_chunk       = m_tilefield->find_chunk(chunk_coord);
+			m_chunk_coord = chunk_coord;
+			m_has_chunk   = true;
+		}
 
+		return m_chunk;
+	}
+
+	void reset()
+	{
+		m_has_chunk = false;
+		m_chunk     = nullptr;
+	}
+
+private:
+
+	const TileField* m_tilefield;
+	const TileChunk* m_chunk {nullptr};
+
+	TileChunkCoord m_chunk_coord {};
+
+	bool m_has_chunk {false};
+};
+
+
+} // hpr::scn
@@ -0,0 +1,667 @@
+#pragma once
+
+#include <span>
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "job_latch.hpp"
+#include "scheduler.hpp"
+
+#include "math.hpp"
+#include "tile_data.hpp"
+#include "tile_path.hpp"
+#include "tile_query.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr uint32_t tile_flow_job_grain = 2U;
+
+	inline constexpr int32_t  tile_flow_padded_size = chunk_size + 2;
+	inline constexpr uint32_t tile_flow_padded_area = static_cast<uint32_t>(tile_flow_padded_size * tile_flow_padded_size);
+
+} // hpr::scn::cfg
+
+
+// NOTE: direction codes, 0..7 step to a neighbour counter clockwise from +x, goal marks the goal
+//       tile, exit a transition end whose far side is cheaper, see TileFlowField::exit_target
+
+inline constexpr uint8_t tile_flow_goal      = 8U;
+inline constexpr uint8_t tile_flow_exit      = 9U;
+inline constexpr uint8_t tile_flow_unreached = 0xFFU;
+
+
+struct TileFlowExit
+{
+	uint16_t  local_index;
+	TileCoord target;
+};
+
+
+struct TileFlowChunk
+{
+	TileChunkCoord coord {};
+	uint64_t       key   {0};
+
+	mtp::vault<int32_t,      mtp::default_set> integration;
+	mtp::vault<uint8_t,      mtp::default_set> direction;
+	mtp::vault<TileFlowExit, mtp::default_set> exits;
+};
+
+
+namespace detail {
+
+	inline constexpr int32_t flow_step_x [8] {1,  1,  0, -1, -1, -1,  0,  1};
+	inline constexpr int32_t flow_step_z [8] {0,  1,  1,  1,  0, -1, -1, -1};
+
+
+	[[nodiscard]] inline uint8_t flow_step_code(int32_t step_x, int32_t step_z)
+	{
+		for (uint8_t code = 0; code < 8; ++code) {
+			if (flow_step_x[code] == step_x && flow_step_z[code] == step_z)
+				return code;
+		}
+
+		return tile_flow_unreached;
+	}
+
+
+	// NOTE: padded holds the chunk integration with an unreached ring. every tile steps to its
+	//       lowest neighbour if that one is lower than the tile itself, diagonals only when
+	//       both orthogonal tiles are reachable
+
+	inline void flow_directions_scalar(const int32_t* padded, uint8_t* direction)
+	{
+		static constexpr int32_t s = cfg::chunk_size;
+		static constexpr int32_t p = cfg::tile_flow_padded_size;
+		static constexpr int32_t k_unreached = std::numeric_limits<int32_t>::max();
+
+		for (int32_t z = 0; z < s; ++z) {
+			for (int32_t x = 0; x < s; ++x) {
+
+				const int32_t* centre = padded + (z + 1) * p + (x + 1);
+
+				int32_t best = k_unreached;
+				uint8_t code = tile_flow_unreached;
+
+				for (uint8_t step = 0; step < 8; ++step) {
+
+					const int32_t step_x = flow_step_x[step];
+					const int32_t step_z = flow_step_z[step];
+
+					if (step_x != 0 && step_z != 0 && (centre[step_x] == k_unreached || centre[step_z * p] == k_unreached))
+						continue;
+
+					const int32_t value = centre[step_z * p + step_x];
+
+					if (value < best) {
+						best = value;
+						code = step;
+					}
+				}
+
+				direction[get_local_index(x, z)] = (best < *centre) ? code : tile_flow_unreached;
+			}
+		}
+	}
+
+
+#if defined(__SSE2__)
+
+	inline void flow_directions_simd(const int32_t* padded, uint8_t* direction)
+	{
+		static constexpr int32_t s = cfg::chunk_size;
+		static constexpr int32_t p = cfg::tile_flow_padded_size;
+
+		const __m128i unreached      = _mm_set1_epi32(std::numeric_limits<int32_t>::max());
+		const __m128i unreached_code = _mm_set1_epi32(tile_flow_unreached);
+
+		auto load = [](const int32_t* source) {
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+		};
+
+		auto select = [](__m128i mask, __m128i lhs, __m128i rhs) {
+			return _mm_or_si128(_mm_and_si128(mask, lhs), _mm_andnot_si128(mask, rhs));
+		};
+
+		for (int32_t z = 0; z < s; ++z) {
+			for (int32_t x = 0; x < s; x += 4) {
+
+				const int32_t* centre = padded + (z + 1) * p + (x + 1);
+
+				__m128i best = unreached;
+				__m128i code = unreached_code;
+
+				for (int32_t step = 0; step < 8; ++step) {
+
+					const int32_t step_x = flow_step_x[step];
+					const int32_t step_z = flow_step_z[step];
+
+					__m128i value = load(centre + step_z * p + step_x);
+
+					if (step_x != 0 && step_z != 0) {
+						const __m128i cut = _mm_or_si128(
+							_mm_cmpeq_epi32(load(centre + step_x), unreached),
+							_mm_cmpeq_epi32(load(centre + step_z * p), unreached)
+						);
+						value = select(cut, unreached, value);
+					}
+
+					const __m128i lower = _mm_cmplt_epi32(value, best);
+
+					best = select(lower, value, best);
+					code = select(lower, _mm_set1_epi32(step), code);
+				}
+
+				code = select(_mm_cmplt_epi32(best, load(centre)), code, unreached_code);
+
+				const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(code, code), _mm_setzero_si128());
+				const int32_t bytes  = _mm_cvtsi128_si32(packed);
+
+				std::memcpy(direction + get_local_index(x, z), &bytes, 4);
+			}
+		}
+	}
+
+#elif defined(__ARM_NEON)
+
+	inline void flow_directions_simd(const int32_t* padded, uint8_t* direction)
+	{
+		static constexpr int32_t s = cfg::chunk_size;
+		static constexpr int32_t p = cfg::tile_flow_padded_size;
+
+		const int32x4_t  unreached      = vdupq_n_s32(std::numeric_limits<int32_t>::max());
+		const uint32x4_t unreached_code = vdupq_n_u32(tile_flow_unreached);
+
+		for (int32_t z = 0; z < s; ++z) {
+			for (int32_t x = 0; x < s; x += 4) {
+
+				const int32_t* centre = padded + (z + 1) * p + (x + 1);
+
+				int32x4_t  best = unreached;
+				uint32x4_t code = unreached_code;
+
+				for (int32_t step = 0; step < 8; ++step) {
+
+					const int32_t step_x = flow_step_x[step];
+					const int32_t step_z = flow_step_z[step];
+
+					int32x4_t value = vld1q_s32(centre + step_z * p + step_x);
+
+					if (step_x != 0 && step_z != 0) {
+						const uint32x4_t cut = vorrq_u32(
+							vceqq_s32(vld1q_s32(centre + step_x), unreached),
+							vceqq_s32(vld1q_s32(centre + step_z * p), unreached)
+						);
+						value = vbslq_s32(cut, unreached, value);
+					}
+
+					const uint32x4_t lower = vcltq_s32(value, best);
+
+					best = vbslq_s32(lower, value, best);
+					code = vbslq_u32(lower, vdupq_n_u32(static_cast<uint32_t>(step)), code);
+				}
+
+				code = vbslq_u32(vcltq_s32(best, vld1q_s32(centre)), code, unreached_code);
+
+				const uint8x8_t packed = vmovn_u16(vcombine_u16(vmovn_u32(code), vdup_n_u16(0)));
+
+				uint8_t bytes[8];
+				vst1_u8(bytes, packed);
+
+				std::memcpy(direction + get_local_index(x, z), bytes, 4);
+			}
+		}
+	}
+
+#endif
+
+
+	inline void flow_directions(const int32_t* padded, uint8_t* direction)
+	{
+#if defined(__SSE2__) || defined(__ARM_NEON)
+		flow_directions_simd(padded, direction);
+#else
+		flow_directions_scalar(padded, direction);
+#endif
+	}
+
+} // hpr::scn::detail
+
+
+// NOTE: flow field towards one goal on top of the path abstraction. reset() prices every
+//       abstract node with one search run backwards from the goal, chunks then integrate
+//       lazily with a wavefront seeded from their nodes, only where agents ask for them
+
+class TileFlowField
+{
+public:
+
+	static constexpr int32_t k_unreached = std::numeric_limits<int32_t>::max();
+
+public:
+
+	void reset(const TilePathfinder& pathfinder, TileCoord goal)
+	{
+		m_goal    = goal;
+		m_version = pathfinder.version();
+
+		m_chunks.clear();
+		m_directory.clear();
+
+		price_nodes(pathfinder);
+	}
+
+
+	[[nodiscard]] TileCoord goal() const
+	{
+		return m_goal;
+	}
+
+
+	[[nodiscard]] uint64_t version() const
+	{
+		return m_version;
+	}
+
+
+	[[nodiscard]] uint32_t chunk_count() const
+	{
+		return static_cast<uint32_t>(m_chunks.size());
+	}
+
+
+	// NOTE: integrates the chunks under the given agents that have not been integrated yet,
+	//       returns how many were added. the field must match the pathfinder version
+
+	uint32_t generate(job::Scheduler& job_scheduler, const TilePathfinder& pathfinder, std::span<const TileCoord> agent_tiles)
+	{
+		HPR_ASSERT_MSG(m_version == pathfinder.version(), "[tile_flow][generate] field is stale, reset it first");
+
+		const uint32_t chunk_beg = static_cast<uint32_t>(m_chunks.size());
+
+		for (const TileCoord& agent_tile : agent_tiles) {
+
+			const TileChunkCoord chunk_coord = get_chunk_coord(agent_tile);
+			const uint64_t       key         = get_chunk_coord_hash(chunk_coord);
+
+			if (m_directory.find(key) != ChunkDirectory::k_empty_slot)
+				continue;
+
+			m_directory.insert(key, static_cast<uint32_t>(m_chunks.size()));
+
+			TileFlowChunk& chunk = m_chunks.emplace_back();
+
+			chunk.coord = chunk_coord;
+			chunk.key   = key;
+		}
+
+		const uint32_t task_count = static_cast<uint32_t>(m_chunks.size()) - chunk_beg;
+		if (task_count == 0)
+			return 0;
+
+		const uint32_t job_count = (task_count + cfg::tile_flow_job_grain - 1) / cfg::tile_flow_job_grain;
+
+		m_slices.resize(job_count);
+		m_scratch.resize(job_count);
+
+		for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx) {
+
+			GenerateJobSlice& slice = m_slices[job_idx];
+
+			slice.field      = this;
+			slice.pathfinder = &pathfinder;
+			slice.chunk_beg  = chunk_beg;
+			slice.scratch    = &m_scratch[job_idx];
+		}
+
+		job::JobLatch job_latch;
+
+		job_scheduler.dispatch_range(
+			job_latch,
+			&generate_chunks,
+			task_count,
+			cfg::tile_flow_job_grain,
+			m_slices.data()
+		);
+
+		job_latch.wait();
+
+		return task_count;
+	}
+
+
+	[[nodiscard]] const TileFlowChunk* find_chunk(TileChunkCoord chunk_coord) const
+	{
+		const uint32_t slot = m_directory.find(get_chunk_coord_hash(chunk_coord));
+		return slot == ChunkDirectory::k_empty_slot ? nullptr : &m_chunks[slot];
+	}
+
+
+	// NOTE: tile_flow_unreached as well for chunks that have not been generated
+
+	[[nodiscard]] uint8_t direction(TileCoord coord) const
+	{
+		const TileFlowChunk* chunk = find_chunk(get_chunk_coord(coord));
+		return chunk ? chunk->direction[get_local_index(coord)] : tile_flow_unreached;
+	}
+
+
+	[[nodiscard]] int32_t integration(TileCoord coord) const
+	{
+		const TileFlowChunk* chunk = find_chunk(get_chunk_coord(coord));
+		return chunk ? chunk->integration[get_local_index(coord)] : k_unreached;
+	}
+
+
+	[[nodiscard]] const TileCoord* exit_target(TileCoord coord) const
+	{
+		const TileFlowChunk* chunk = find_chunk(get_chunk_coord(coord));
+		if (!chunk)
+			return nullptr;
+
+		const uint16_t local_index = static_cast<uint16_t>(get_local_index(coord));
+
+		for (const TileFlowExit& exit : chunk->exits) {
+			if (exit.local_index == local_index)
+				return &exit.target;
+		}
+
+		return nullptr;
+	}
+
+
+	// NOTE: unit xz steps per agent, zero on the goal, on exits and where the field has nothing
+
+	void sample(std::span<const TileCoord> agent_tiles, std::span<vec2> out_directions) const
+	{
+		HPR_ASSERT_MSG(out_directions.size() >= agent_tiles.size(), "[tile_flow][sample] output too small");
+
+		const TileFlowChunk* chunk     = nullptr;
+		uint64_t             chunk_key = 0;
+
+		for (size_t agent_idx = 0; agent_idx < agent_tiles.size(); ++agent_idx) {
+
+			const TileCoord      agent_tile  = agent_tiles[agent_idx];
+			const TileChunkCoord chunk_coord = get_chunk_coord(agent_tile);
+			const uint64_t       key         = get_chunk_coord_hash(chunk_coord);
+
+			if (!chunk || key != chunk_key) {
+				const uint32_t slot = m_directory.find(key);
+
+				chunk     = (slot == ChunkDirectory::k_empty_slot) ? nullptr : &m_chunks[slot];
+				chunk_key = key;
+			}
+
+			const uint8_t code = chunk ? chunk->direction[get_local_index(agent_tile)] : tile_flow_unreached;
+
+			if (code >= 8) {
+				out_directions[agent_idx] = vec2 {0.0f, 0.0f};
+				continue;
+			}
+
+			const float step_x = static_cast<float>(detail::flow_step_x[code]);
+			const float step_z = static_cast<float>(detail::flow_step_z[code]);
+			const float scale  = (code & 1U) ? 0.70710678f : 1.0f;
+
+			out_directions[agent_idx] = vec2 {step_x * scale, step_z * scale};
+		}
+	}
+
+private:
+
+	static constexpr uint32_t k_infinite_cost = TilePathfinder::k_infinite_cost;
+
+	struct GenerateScratch
+	{
+		TilePathfinder::LocalSearch search;
+
+		mtp::vault<uint64_t, mtp::default_set> heap;
+		mtp::vault<uint64_t, mtp::default_set> seeds;
+		mtp::vault<int32_t,  mtp::default_set> padded;
+	};
+
+
+	struct GenerateJobSlice
+	{
+		uint32_t begin;
+		uint32_t end;
+
+		TileFlowField*        field;
+		const TilePathfinder* pathfinder;
+		uint32_t              chunk_beg;
+		GenerateScratch*      scratch;
+	};
+
+
+	// NOTE: dijkstra over the abstract graph walking edges backwards, intra chunk edges and
+	//       entrances are symmetric, transitions go through the incoming link lists
+
+	void price_nodes(const TilePathfinder& pathfinder)
+	{
+		m_node_costs.clear();
+		m_node_costs.resize(pathfinder.m_node_total, k_infinite_cost);
+
+		const uint32_t goal_slot = pathfinder.m_directory.find(get_chunk_coord_hash(get_chunk_coord(m_goal)));
+		if (goal_slot == ChunkDirectory::k_empty_slot)
+			return;
+
+		const TilePathfinder::PathChunk& goal_chunk = pathfinder.m_chunks[goal_slot];
+
+		const uint32_t goal_local = get_local_index(m_goal);
+		if (goal_chunk.costs[goal_local] == 0)
+			return;
+
+		TilePathfinder::search_local(
+			goal_chunk.costs.data(),
+			goal_local,
+			m_price_search,
+			m_price_heap,
+			goal_chunk.node_mask,
+			static_cast<uint32_t>(goal_chunk.nodes.size())
+		);
+
+		m_price_heap.clear();
+
+		auto relax = [&](uint32_t node, uint32_t cost) {
+			if (cost >= m_node_costs[node])
+				return;
+
+			m_node_costs[node] = cost;
+
+			m_price_heap.emplace_back(TilePathfinder::heap_key(cost, node));
+			std::push_heap(m_price_heap.begin(), m_price_heap.end(), std::greater<> {});
+		};
+
+		for (uint32_t node_idx = 0; node_idx < goal_chunk.nodes.size(); ++node_idx) {
+			const uint32_t cost = m_price_search.cost[goal_chunk.nodes[node_idx].local_index];
+			if (cost != k_infinite_cost)
+				relax(goal_chunk.node_base + node_idx, cost);
+		}
+
+		while (!m_price_heap.empty()) {
+
+			std::pop_heap(m_price_heap.begin(), m_price_heap.end(), std::greater<> {});
+			const uint32_t entry_cost = static_cast<uint32_t>(m_price_heap.back() >> 32);
+			const uint32_t node       = static_cast<uint32_t>(m_price_heap.back());
+			m_price_heap.pop_back();
+
+			if (entry_cost != m_node_costs[node])
+				continue;
+
+			const TilePathfinder::PathChunk& chunk = pathfinder.m_chunks[pathfinder.m_node_chunks[node]];
+			const TilePathfinder::PathNode&  info  = chunk.nodes[node - chunk.node_base];
+
+			for (uint32_t edge_idx = info.edge_beg; edge_idx < info.edge_beg + info.edge_count; ++edge_idx) {
+				const TilePathfinder::PathEdge& edge = chunk.edges[edge_idx];
+				relax(chunk.node_base + edge.target, entry_cost + edge.cost);
+			}
+
+			for (uint32_t in_idx = pathfinder.m_in_offsets[node]; in_idx < pathfinder.m_in_offsets[node + 1]; ++in_idx) {
+				const TilePathfinder::InLink& in_link = pathfinder.m_in_links[in_idx];
+				relax(in_link.source, entry_cost + in_link.cost);
+			}
+		}
+	}
+
+
+	static void generate_chunks(void* slice_raw)
+	{
+		auto* slice = static_cast<GenerateJobSlice*>(slice_raw);
+
+		for (uint32_t task_idx = slice->begin; task_idx < slice->end; ++task_idx) {
+			TileFlowChunk& chunk = slice->field->m_chunks[slice->chunk_beg + task_idx];
+			slice->field->generate_chunk(*slice->pathfinder, chunk, *slice->scratch);
+		}
+	}
+
+
+	void generate_chunk(const TilePathfinder& pathfinder, TileFlowChunk& chunk, GenerateScratch& scratch) const
+	{
+		static constexpr int32_t  s = cfg::chunk_size;
+		static constexpr int32_t  p = cfg::tile_flow_padded_size;
+		static constexpr uint64_t k_no_targets [TilePathfinder::k_mask_words] {};
+
+		chunk.integration.resize(cfg::chunk_area);
+		chunk.direction.resize(cfg::chunk_area);
+		chunk.exits.clear();
+
+		std::fill_n(chunk.integration.data(), cfg::chunk_area, k_unreached);
+		std::fill_n(chunk.direction.data(), cfg::chunk_area, tile_flow_unreached);
+
+		const uint32_t slot = pathfinder.m_directory.find(chunk.key);
+		if (slot == ChunkDirectory::k_empty_slot)
+			return;
+
+		const TilePathfinder::PathChunk& path_chunk = pathfinder.m_chunks[slot];
+
+		// NOTE: wavefront from every priced node of the chunk, and from the goal if it is here
+
+		const bool     goal_here  = same_chunk(get_chunk_coord(m_goal), chunk.coord);
+		const uint32_t goal_local = goal_here ? get_local_index(m_goal) : 0;
+
+		scratch.seeds.clear();
+
+		if (goal_here)
+			scratch.seeds.emplace_back(TilePathfinder::heap_key(0, goal_local));
+
+		for (uint32_t node_idx = 0; node_idx < path_chunk.nodes.size(); ++node_idx) {
+			const uint32_t cost = m_node_costs[path_chunk.node_base + node_idx];
+			if (cost != k_infinite_cost)
+				scratch.seeds.emplace_back(TilePathfinder::heap_key(cost, path_chunk.nodes[node_idx].local_index));
+		}
+
+		if (scratch.seeds.empty())
+			return;
+
+		TilePathfinder::search_local(
+			path_chunk.costs.data(),
+			std::span<const uint64_t> {scratch.seeds.data(), scratch.seeds.size()},
+			scratch.search,
+			scratch.heap,
+			k_no_targets,
+			0
+		);
+
+		scratch.padded.resize(cfg::tile_flow_padded_area);
+		std::fill_n(scratch.padded.data(), cfg::tile_flow_padded_area, k_unreached);
+
+		for (int32_t z = 0; z < s; ++z) {
+			for (int32_t x = 0; x < s; ++x) {
+
+				const uint32_t local_index = get_local_index(x, z);
+				const uint32_t cost        = scratch.search.cost[local_index];
+
+				const int32_t value = (cost == k_infinite_cost) ? k_unreached : static_cast<int32_t>(cost);
+
+				chunk.integration[local_index] = value;
+				scratch.padded[static_cast<uint32_t>((z + 1) * p + (x + 1))] = value;
+			}
+		}
+
+		detail::flow_directions(scratch.padded.data(), chunk.direction.data());
+
+		// NOTE: a node whose cheapest way out is one of its links leaves the chunk there
+
+		for (const TilePathfinder::PathNode& node : path_chunk.nodes) {
+
+			uint32_t best_cost = k_infinite_cost;
+			uint32_t best_link = TilePathfinder::k_invalid_node;
+
+			for (uint32_t link_idx = node.link_beg; link_idx < node.link_beg + node.link_count; ++link_idx) {
+
+				const TilePathfinder::PathLink& link = path_chunk.links[link_idx];
+
+				if (link.target_node == TilePathfinder::k_invalid_node || m_node_costs[link.target_node] == k_infinite_cost)
+					continue;
+
+				const uint32_t cost = link.cost + m_node_costs[link.target_node];
+
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_link = link_idx;
+				}
+			}
+
+			if (best_link == TilePathfinder::k_invalid_node || best_cost != scratch.search.cost[node.local_index])
+				continue;
+
+			const TileCoord  from   = TilePathfinder::tile_of(chunk.coord, node.local_index);
+			const TileCoord& target = path_chunk.links[best_link].target;
+
+			const int32_t step_x = target.x - from.x;
+			const int32_t step_z = target.z - from.z;
+
+			const bool adjacent = target.storey_index == from.storey_index
+				&& target.storey_stack == from.storey_stack
+				&& std::abs(step_x) + std::abs(step_z) == 1;
+
+			if (adjacent) {
+				chunk.direction[node.local_index] = detail::flow_step_code(step_x, step_z);
+			}
+			else {
+				chunk.direction[node.local_index] = tile_flow_exit;
+				chunk.exits.emplace_back(TileFlowExit {.local_index = node.local_index, .target = target});
+			}
+		}
+
+		if (goal_here)
+			chunk.direction[goal_local] = tile_flow_goal;
+	}
+
+private:
+
+	TileCoord m_goal    {};
+	uint64_t  m_version {0};
+
+	mtp::vault<uint32_t, mtp::default_set> m_node_costs;
+
+	TilePathfinder::LocalSearch            m_price_search;
+	mtp::vault<uint64_t, mtp::default_set> m_price_heap;
+
+	mtp::vault<TileFlowChunk, mtp::default_set> m_chunks;
+	ChunkDirectory                              m_directory;
+
+	mtp::vault<GenerateJobSlice, mtp::default_set> m_slices;
+	mtp::vault<GenerateScratch,  mtp::default_set> m_scratch;
+};
+
+
+} // hpr::scn
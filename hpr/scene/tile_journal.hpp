@@ -0,0 +1,371 @@
+#pragma once
+
+#include <tuple>
+#include <cstdint>
+#include <algorithm>
+
+#include "mtp_memory.hpp"
+
+#include "tile_data.hpp"
+#include "tile_edit.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "tile_change.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr size_t   tile_journal_budget_bytes = size_t {8} << 20;
+	inline constexpr uint32_t tile_journal_max_entries  = 256U;
+
+} // hpr::scn::cfg
+
+
+// NOTE: tiles [local_beg, local_beg + count) of one chunk went from before to after
+
+struct TileJournalRun
+{
+	uint16_t local_beg;
+	uint16_t count;
+	TileType before;
+	TileType after;
+};
+
+
+struct TileJournalChunk
+{
+	TileChunkCoord coord;
+	uint32_t       run_beg;
+	uint32_t       run_count;
+};
+
+
+struct TileJournalEntry
+{
+	uint32_t chunk_beg;
+	uint32_t chunk_count;
+	uint32_t tile_count;
+};
+
+
+// NOTE: undo history of applied edit batches. a batch is stored per chunk as runs over the
+//       local tile index, so a rectangle painted over uniform ground is one run per row or
+//       less, never a chunk snapshot. undo and redo walk the runs only and write a tile back
+//       when it still holds the value they expect. the oldest entries are dropped to stay
+//       within budget, recording after an undo discards the redo tail
+
+class TileEditJournal
+{
+public:
+
+	void clear()
+	{
+		m_entries.clear();
+		m_chunks.clear();
+		m_runs.clear();
+
+		m_entry_first = 0;
+		m_cursor      = 0;
+	}
+
+
+	[[nodiscard]] bool can_undo() const
+	{
+		return m_cursor > m_entry_first;
+	}
+
+
+	[[nodiscard]] bool can_redo() const
+	{
+		return m_cursor < m_entries.size();
+	}
+
+
+	[[nodiscard]] uint32_t entry_count() const
+	{
+		return static_cast<uint32_t>(m_entries.size()) - m_entry_first;
+	}
+
+
+	[[nodiscard]] size_t memory_bytes() const
+	{
+		if (m_entry_first == m_entries.size())
+			return 0;
+
+		const TileJournalEntry& first = m_entries[m_entry_first];
+
+		const size_t chunk_count = m_chunks.size() - first.chunk_beg;
+		const size_t run_count   = m_runs.size()   - m_chunks[first.chunk_beg].run_beg;
+
+		return entry_count() * sizeof(TileJournalEntry)
+			+ chunk_count * sizeof(TileJournalChunk)
+			+ run_count   * sizeof(TileJournalRun);
+	}
+
+
+	// NOTE: applies the batch like TileEditBatch::apply and records what actually changed,
+	//       mark_dirty(TileChunkCoord, const TileChunkMask&) runs once per changed chunk with
+	//       the tiles that changed in it
+
+	template <typename MarkDirtyFn>
+	uint32_t apply(const TileEditBatch& batch, TileField& tilefield, MarkDirtyFn&& mark_dirty)
+	{
+		m_pending.clear();
+
+		uint32_t order = 0;
+
+		for (const TileEdit& edit : batch.edits()) {
+
+			TileType* tile_ptr = tilefield.get_ptr(edit.coord);
+
+			if (!tile_ptr || *tile_ptr != edit.before || *tile_ptr == edit.after)
+				continue;
+
+			*tile_ptr = edit.after;
+
+			m_pending.emplace_back(PendingEdit {
+				.coord  = get_chunk_coord(edit.coord),
+				.local  = static_cast<uint16_t>(get_local_index(edit.coord)),
+				.order  = order++,
+				.before = edit.before,
+				.after  = edit.after
+			});
+		}
+
+		if (m_pending.empty())
+			return 0;
+
+		std::sort(m_pending.begin(), m_pending.end(), [](const PendingEdit& lhs, const PendingEdit& rhs) {
+			return std::tie(lhs.coord.storey_stack, lhs.coord.storey_index, lhs.coord.chunk_z, lhs.coord.chunk_x, lhs.local, lhs.order)
+				<  std::tie(rhs.coord.storey_stack, rhs.coord.storey_index, rhs.coord.chunk_z, rhs.coord.chunk_x, rhs.local, rhs.order);
+		});
+
+		truncate_redo();
+
+		TileJournalEntry entry {
+			.chunk_beg   = static_cast<uint32_t>(m_chunks.size()),
+			.chunk_count = 0,
+			.tile_count  = 0
+		};
+
+		for (uint32_t pending_idx = 0; pending_idx < m_pending.size();) {
+
+			const TileChunkCoord chunk_coord = m_pending[pending_idx].coord;
+
+			TileJournalChunk chunk {
+				.coord     = chunk_coord,
+				.run_beg   = static_cast<uint32_t>(m_runs.size()),
+				.run_count = 0
+			};
+
+			TileChunkMask mask {};
+
+			for (; pending_idx < m_pending.size() && same_chunk(m_pending[pending_idx].coord, chunk_coord);) {
+
+				// NOTE: a tile edited twice keeps the first before and the last after
+
+				const uint16_t local  = m_pending[pending_idx].local;
+				const TileType before = m_pending[pending_idx].before;
+
+				TileType after = m_pending[pending_idx].after;
+
+				for (++pending_idx; pending_idx < m_pending.size()
+					&& same_chunk(m_pending[pending_idx].coord, chunk_coord)
+					&& m_pending[pending_idx].local == local; ++pending_idx) {
+					after = m_pending[pending_idx].after;
+				}
+
+				if (before == after)
+					continue;
+
+				TileJournalRun* last = (chunk.run_count > 0) ? &m_runs[m_runs.size() - 1] : nullptr;
+
+				const bool extends = last
+					&& last->local_beg + last->count == local
+					&& last->before == before
+					&& last->after  == after;
+
+				if (extends) {
+					++last->count;
+				}
+				else {
+					m_runs.emplace_back(TileJournalRun {.local_beg = local, .count = 1, .before = before, .after = after});
+					++chunk.run_count;
+				}
+
+				mask.set(local);
+				++entry.tile_count;
+			}
+
+			if (chunk.run_count > 0) {
+				mark_dirty(chunk_coord, mask);
+
+				m_chunks.emplace_back(chunk);
+				++entry.chunk_count;
+			}
+		}
+
+		if (entry.tile_count == 0)
+			return 0;
+
+		m_entries.emplace_back(entry);
+		m_cursor = static_cast<uint32_t>(m_entries.size());
+
+		enforce_budget();
+
+		return entry.tile_count;
+	}
+
+
+	template <typename MarkDirtyFn>
+	bool undo(TileField& tilefield, MarkDirtyFn&& mark_dirty)
+	{
+		if (!can_undo())
+			return false;
+
+		--m_cursor;
+		replay(m_entries[m_cursor], tilefield, true, mark_dirty);
+
+		return true;
+	}
+
+
+	template <typename MarkDirtyFn>
+	bool redo(TileField& tilefield, MarkDirtyFn&& mark_dirty)
+	{
+		if (!can_redo())
+			return false;
+
+		replay(m_entries[m_cursor], tilefield, false, mark_dirty);
+		++m_cursor;
+
+		return true;
+	}
+
+private:
+
+	struct PendingEdit
+	{
+		TileChunkCoord coord;
+		uint16_t       local;
+		uint32_t       order;
+		TileType       before;
+		TileType       after;
+	};
+
+
+	// NOTE: tiles that no longer hold the value being replaced are left alone, chunks that
+	//       were evicted since are skipped. mark_dirty gets the tiles actually written back
+
+	template <typename MarkDirtyFn>
+	void replay(const TileJournalEntry& entry, TileField& tilefield, bool backward, MarkDirtyFn&& mark_dirty)
+	{
+		for (uint32_t chunk_idx = entry.chunk_beg; chunk_idx < entry.chunk_beg + entry.chunk_count; ++chunk_idx) {
+
+			const TileJournalChunk& journal_chunk = m_chunks[chunk_idx];
+
+			TileChunk* chunk = tilefield.find_chunk(journal_chunk.coord);
+			if (!chunk)
+				continue;
+
+			TileType* tiles = chunk->tiles.data();
+
+			TileChunkMask mask {};
+			bool changed = false;
+
+			for (uint32_t run_idx = journal_chunk.run_beg; run_idx < journal_chunk.run_beg + journal_chunk.run_count; ++run_idx) {
+
+				const TileJournalRun& run = m_runs[run_idx];
+
+				const TileType expected = backward ? run.after  : run.before;
+				const TileType replaced = backward ? run.before : run.after;
+
+				for (uint32_t local = run.local_beg; local < static_cast<uint32_t>(run.local_beg) + run.count; ++local) {
+					if (tiles[local] == expected) {
+						tiles[local] = replaced;
+						mask.set(local);
+						changed = true;
+					}
+				}
+			}
+
+			if (changed)
+				mark_dirty(journal_chunk.coord, mask);
+		}
+	}
+
+
+	void truncate_redo()
+	{
+		if (m_cursor == m_entries.size())
+			return;
+
+		const TileJournalEntry& first_redo = m_entries[m_cursor];
+
+		m_runs.resize(m_chunks[first_redo.chunk_beg].run_beg);
+		m_chunks.resize(first_redo.chunk_beg);
+		m_entries.resize(m_cursor);
+	}
+
+
+	template <typename T>
+	static void drop_front(mtp::vault<T, mtp::default_set>& items, uint32_t count)
+	{
+		std::copy(items.begin() + count, items.end(), items.begin());
+		items.resize(items.size() - count);
+	}
+
+
+	// NOTE: drops from the oldest end, the dropped prefix is compacted once it outweighs the rest
+
+	void enforce_budget()
+	{
+		while (entry_count() > 0
+			&& (entry_count() > cfg::tile_journal_max_entries || memory_bytes() > cfg::tile_journal_budget_bytes)) {
+			++m_entry_first;
+		}
+
+		m_cursor = std::max(m_cursor, m_entry_first);
+
+		if (m_entry_first * 2 < m_entries.size() + 1)
+			return;
+
+		if (m_entry_first == m_entries.size()) {
+			clear();
+			return;
+		}
+
+		const uint32_t chunk_shift = m_entries[m_entry_first].chunk_beg;
+		const uint32_t run_shift   = m_chunks[chunk_shift].run_beg;
+
+		drop_front(m_entries, m_entry_first);
+		drop_front(m_chunks,  chunk_shift);
+		drop_front(m_runs,    run_shift);
+
+		for (TileJournalEntry& entry : m_entries)
+			entry.chunk_beg -= chunk_shift;
+
+		for (TileJournalChunk& chunk : m_chunks)
+			chunk.run_beg -= run_shift;
+
+		m_cursor     -= m_entry_first;
+		m_entry_first = 0;
+	}
+
+private:
+
+	mtp::vault<TileJournalEntry, mtp::default_set> m_entries;
+	mtp::vault<TileJournalChunk, mtp::default_set> m_chunks;
+	mtp::vault<TileJournalRun,   mtp::default_set> m_runs;
+
+	uint32_t m_entry_first {0};
+	uint32_t m_cursor      {0};
+
+	mtp::vault<PendingEdit, mtp::default_set> m_pending;
+};
+
+
+} // hpr::scn
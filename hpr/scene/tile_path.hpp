@@ -0,0 +1,1337 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "job_latch.hpp"
+#include "scheduler.hpp"
+
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "tile_change.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr uint32_t tile_path_job_grain   = 8U;
+	inline constexpr uint32_t tile_path_build_grain = 4U;
+
+	// NOTE: border runs at least this long get an entrance at both ends instead of one in the middle
+
+	inline constexpr int32_t tile_path_entrance_split = 6;
+
+	// NOTE: a step costs (cost(a) + cost(b)) * weight, 10 straight and 14 diagonal between cost 1 tiles
+
+	inline constexpr uint32_t tile_path_weight_straight = 5U;
+	inline constexpr uint32_t tile_path_weight_diagonal = 7U;
+
+} // hpr::scn::cfg
+
+
+// NOTE: 0 blocks the tile, anything else is its traversal cost
+
+using TilePathCostFn = uint8_t (*)(TileType tile, const void* rule_data);
+
+
+struct TilePathRequest
+{
+	TileCoord start;
+	TileCoord goal;
+};
+
+
+enum class TilePathStatus : uint8_t
+{
+	found = 0,
+	unreachable,
+	blocked
+};
+
+
+// NOTE: tiles [tile_beg, tile_beg + tile_count) of the batch, start and goal included
+
+struct TilePathResult
+{
+	TilePathStatus status     {TilePathStatus::unreachable};
+	uint32_t       cost       {0};
+	uint32_t       tile_beg   {0};
+	uint32_t       tile_count {0};
+};
+
+
+struct TilePathBatch
+{
+	mtp::vault<TilePathResult, mtp::default_set> results;
+	mtp::vault<TileCoord,      mtp::default_set> tiles;
+
+	void clear()
+	{
+		results.clear();
+		tiles.clear();
+	}
+};
+
+
+// NOTE: one way link between any two tiles, stairs, ladders and lifts between storeys or stacks.
+//       the search heuristic ignores storeys and is scaled down to the cheapest transition cost
+//       per unit of flat octile distance, so a long cheap transition keeps paths shortest
+
+struct TilePathTransition
+{
+	TileCoord from;
+	TileCoord to;
+	uint32_t  cost;
+};
+
+
+class TileFlowField;
+
+
+// NOTE: hpa* over tile chunks. every chunk keeps its border entrances and transition ends as
+//       abstract nodes with the cached tile paths between them, searches run on that graph and
+//       only touch tiles inside the start and goal chunks. edits invalidate a chunk and, on a
+//       border, the neighbour sharing it; dirty chunks rebuild on the workers in update()
+
+class TilePathfinder
+{
+	friend class TileFlowField;
+
+public:
+
+	static constexpr uint32_t k_invalid_node = 0xFFFFFFFFU;
+
+public:
+
+	void clear()
+	{
+		m_chunks.clear();
+		m_directory.clear();
+
+		m_transitions.clear();
+
+		m_node_chunks.clear();
+		m_node_tiles.clear();
+
+		m_in_offsets.clear();
+		m_in_links.clear();
+
+		m_node_total = 0;
+		++m_version;
+
+		m_heuristic_scale = k_heuristic_unit;
+	}
+
+
+	void set_cost(TilePathCostFn cost_fn, const void* rule_data)
+	{
+		m_cost_fn   = cost_fn;
+		m_rule_data = rule_data;
+
+		for (PathChunk& chunk : m_chunks)
+			chunk.dirty = true;
+	}
+
+
+	void add_transition(TileCoord from, TileCoord to, uint32_t cost)
+	{
+		m_transitions.emplace_back(TilePathTransition {.from = from, .to = to, .cost = cost});
+
+		m_heuristic_scale = std::min(m_heuristic_scale, transition_scale(m_transitions.back()));
+
+		invalidate_chunk(get_chunk_coord(from));
+		invalidate_chunk(get_chunk_coord(to));
+	}
+
+
+	// NOTE: drops every transition starting or ending on the tile
+
+	void remove_transitions(TileCoord coord)
+	{
+		uint32_t transition_dst = 0;
+
+		for (uint32_t transition_src = 0; transition_src < m_transitions.size(); ++transition_src) {
+
+			const TilePathTransition transition = m_transitions[transition_src];
+
+			if (same_tile(transition.from, coord) || same_tile(transition.to, coord)) {
+				invalidate_chunk(get_chunk_coord(transition.from));
+				invalidate_chunk(get_chunk_coord(transition.to));
+				continue;
+			}
+
+			m_transitions[transition_dst++] = transition;
+		}
+
+		m_transitions.resize(transition_dst);
+
+		m_heuristic_scale = k_heuristic_unit;
+
+		for (const TilePathTransition& transition : m_transitions)
+			m_heuristic_scale = std::min(m_heuristic_scale, transition_scale(transition));
+	}
+
+
+	[[nodiscard]] const mtp::vault<TilePathTransition, mtp::default_set>& transitions() const
+	{
+		return m_transitions;
+	}
+
+
+	// NOTE: border tiles also dirty the chunk across that border, entrances depend on both sides
+
+	void invalidate(TileCoord coord)
+	{
+		const TileChunkCoord chunk_coord = get_chunk_coord(coord);
+
+		invalidate_chunk(chunk_coord);
+
+		const int32_t local_x = coord.x & cfg::chunk_mask;
+		const int32_t local_z = coord.z & cfg::chunk_mask;
+
+		if (local_x == 0)               invalidate_chunk(offset_chunk(chunk_coord, -1,  0));
+		if (local_x == cfg::chunk_mask) invalidate_chunk(offset_chunk(chunk_coord,  1,  0));
+		if (local_z == 0)               invalidate_chunk(offset_chunk(chunk_coord,  0, -1));
+		if (local_z == cfg::chunk_mask) invalidate_chunk(offset_chunk(chunk_coord,  0,  1));
+	}
+
+
+	// NOTE: chunk granular hook for region ops and the tile simulation
+
+	void invalidate(TileChunkCoord chunk_coord)
+	{
+		invalidate_chunk(chunk_coord);
+
+		invalidate_chunk(offset_chunk(chunk_coord, -1,  0));
+		invalidate_chunk(offset_chunk(chunk_coord,  1,  0));
+		invalidate_chunk(offset_chunk(chunk_coord,  0, -1));
+		invalidate_chunk(offset_chunk(chunk_coord,  0,  1));
+	}
+
+
+	void invalidate(TileChunkCoord chunk_coord, const TileChunkMask& mask)
+	{
+		invalidate_chunk(chunk_coord);
+
+		if (mask.touches_column(0))               invalidate_chunk(offset_chunk(chunk_coord, -1,  0));
+		if (mask.touches_column(cfg::chunk_mask)) invalidate_chunk(offset_chunk(chunk_coord,  1,  0));
+		if (mask.touches_row(0))                  invalidate_chunk(offset_chunk(chunk_coord,  0, -1));
+		if (mask.touches_row(cfg::chunk_mask))    invalidate_chunk(offset_chunk(chunk_coord,  0,  1));
+	}
+
+
+	// NOTE: pulls the changes logged since the last call, a cursor that fell out of the log
+	//       history has missed edits and dirties every chunk
+
+	void consume(TileChangeLog& change_log)
+	{
+		const bool complete = change_log.pull(m_change_cursor, [this](const TileChange& change) {
+			invalidate(change.coord, change.mask);
+		});
+
+		if (complete)
+			return;
+
+		for (PathChunk& chunk : m_chunks)
+			chunk.dirty = true;
+	}
+
+
+	[[nodiscard]] uint32_t chunk_count() const
+	{
+		return static_cast<uint32_t>(m_chunks.size());
+	}
+
+
+	[[nodiscard]] uint32_t node_count() const
+	{
+		return m_node_total;
+	}
+
+
+	// NOTE: moves whenever update() changed the abstract graph, caches built on it key on this
+
+	[[nodiscard]] uint64_t version() const
+	{
+		return m_version;
+	}
+
+
+	// NOTE: follows chunks added to or evicted from the field, rebuilds dirty chunks in parallel
+	//       and relinks the abstract graph, returns the number of rebuilt chunks
+
+	uint32_t update(job::Scheduler& job_scheduler, const TileField& tilefield)
+	{
+		bool changed = sync_chunks(tilefield);
+
+		m_build_tasks.clear();
+
+		for (uint32_t slot = 0; slot < m_chunks.size(); ++slot) {
+			if (m_chunks[slot].dirty)
+				m_build_tasks.emplace_back(slot);
+		}
+
+		const uint32_t task_count = static_cast<uint32_t>(m_build_tasks.size());
+
+		if (task_count > 0) {
+
+			const uint32_t job_count = (task_count + cfg::tile_path_build_grain - 1) / cfg::tile_path_build_grain;
+
+			m_build_slices.resize(job_count);
+			m_build_scratch.resize(job_count);
+
+			for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx) {
+
+				BuildJobSlice& slice = m_build_slices[job_idx];
+
+				slice.pathfinder = this;
+				slice.tilefield  = &tilefield;
+				slice.scratch    = &m_build_scratch[job_idx];
+			}
+
+			job::JobLatch job_latch;
+
+			job_scheduler.dispatch_range(
+				job_latch,
+				&build_chunks,
+				task_count,
+				cfg::tile_path_build_grain,
+				m_build_slices.data()
+			);
+
+			job_latch.wait();
+
+			changed = true;
+		}
+
+		if (changed)
+			relink();
+
+		return task_count;
+	}
+
+
+	// NOTE: brings the abstraction up to date, then answers every request on the workers.
+	//       results line up with requests, batch tiles are packed in request order
+
+	void find_paths(
+		job::Scheduler&                  job_scheduler,
+		const TileField&                 tilefield,
+		std::span<const TilePathRequest> requests,
+		TilePathBatch&                   batch
+	)
+	{
+		(void) update(job_scheduler, tilefield);
+
+		batch.clear();
+
+		const uint32_t request_count = static_cast<uint32_t>(requests.size());
+		if (request_count == 0)
+			return;
+
+		batch.results.resize(request_count);
+
+		const uint32_t job_count = (request_count + cfg::tile_path_job_grain - 1) / cfg::tile_path_job_grain;
+
+		m_search_slices.resize(job_count);
+		m_search_scratch.resize(job_count);
+
+		for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx) {
+
+			SearchJobSlice& slice = m_search_slices[job_idx];
+
+			slice.pathfinder = this;
+			slice.requests   = requests.data();
+			slice.results    = batch.results.data();
+			slice.scratch    = &m_search_scratch[job_idx];
+		}
+
+		job::JobLatch job_latch;
+
+		job_scheduler.dispatch_range(
+			job_latch,
+			&search_paths,
+			request_count,
+			cfg::tile_path_job_grain,
+			m_search_slices.data()
+		);
+
+		job_latch.wait();
+
+		// NOTE: pack the per job tile lists, slice k answered requests [k * grain, ...)
+
+		uint32_t tile_total = 0;
+		for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx)
+			tile_total += static_cast<uint32_t>(m_search_scratch[job_idx].tiles.size());
+
+		batch.tiles.resize(tile_total);
+
+		uint32_t tile_base = 0;
+
+		for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx) {
+
+			const SearchJobSlice& slice   = m_search_slices[job_idx];
+			const SearchScratch&  scratch = m_search_scratch[job_idx];
+
+			std::copy_n(scratch.tiles.data(), scratch.tiles.size(), batch.tiles.data() + tile_base);
+
+			for (uint32_t request_idx = slice.begin; request_idx < slice.end; ++request_idx)
+				batch.results[request_idx].tile_beg += tile_base;
+
+			tile_base += static_cast<uint32_t>(scratch.tiles.size());
+		}
+	}
+
+private:
+
+	static constexpr uint32_t k_infinite_cost = 0xFFFFFFFFU;
+
+	// NOTE: 16.16 fixed point heuristic scale, one unit is the flat octile bound itself
+
+	static constexpr uint32_t k_heuristic_unit = 1U << 16;
+	static constexpr uint16_t k_no_parent     = 0xFFFFU;
+	static constexpr uint32_t k_mask_words    = static_cast<uint32_t>(cfg::chunk_area) / 64U;
+
+	// NOTE: edge paths are chunk local tile indices from the source (exclusive) to the target
+
+	struct PathEdge
+	{
+		uint32_t target;
+		uint32_t cost;
+		uint32_t path_beg;
+		uint32_t path_count;
+	};
+
+
+	// NOTE: an entrance pairs with the tile across the border, a transition with its far end;
+	//       target_node is resolved by relink() once every chunk is built
+
+	struct PathLink
+	{
+		TileCoord target;
+		uint32_t  cost;
+		uint32_t  target_node;
+	};
+
+
+	struct InLink
+	{
+		uint32_t source;
+		uint32_t cost;
+	};
+
+
+	struct PathNode
+	{
+		uint16_t local_index;
+
+		uint32_t edge_beg;
+		uint32_t edge_count;
+		uint32_t link_beg;
+		uint32_t link_count;
+	};
+
+
+	struct PathChunk
+	{
+		TileChunkCoord coord     {};
+		uint64_t       key       {0};
+		uint32_t       node_base {0};
+		bool           dirty     {true};
+
+		uint64_t node_mask [k_mask_words] {};
+
+		mtp::vault<uint8_t,  mtp::default_set> costs;
+		mtp::vault<PathNode, mtp::default_set> nodes;
+		mtp::vault<PathEdge, mtp::default_set> edges;
+		mtp::vault<PathLink, mtp::default_set> links;
+		mtp::vault<uint16_t, mtp::default_set> paths;
+	};
+
+
+	// NOTE: cost in the high word, index in the low one, ties pop the lower index first
+
+	[[nodiscard]] static uint64_t heap_key(uint32_t cost, uint32_t index)
+	{
+		return (static_cast<uint64_t>(cost) << 32) | index;
+	}
+
+
+	// NOTE: single chunk dijkstra, parent points one step back towards the source
+
+	struct LocalSearch
+	{
+		uint32_t cost   [cfg::chunk_area];
+		uint16_t parent [cfg::chunk_area];
+	};
+
+
+	// NOTE: per job scratch, reused across frames so builds and searches do not allocate once warm
+
+	struct BuildScratch
+	{
+		LocalSearch search;
+
+		mtp::vault<uint64_t,  mtp::default_set> heap;
+		mtp::vault<uint32_t,  mtp::default_set> node_of;
+		mtp::vault<uint16_t,  mtp::default_set> path;
+
+		mtp::vault<PathLink, mtp::default_set> node_links;
+		mtp::vault<uint16_t, mtp::default_set> node_link_owner;
+	};
+
+
+	struct SearchScratch
+	{
+		LocalSearch start_search;
+		LocalSearch goal_search;
+
+		uint64_t target_mask [k_mask_words];
+
+		mtp::vault<uint64_t,  mtp::default_set> heap;
+
+		mtp::vault<uint32_t, mtp::default_set> node_cost;
+		mtp::vault<uint32_t, mtp::default_set> node_parent;
+		mtp::vault<uint32_t, mtp::default_set> node_stamp;
+		mtp::vault<uint8_t,  mtp::default_set> node_via_link;
+		uint32_t                               stamp {0};
+
+		mtp::vault<uint32_t,  mtp::default_set> chain;
+		mtp::vault<TileCoord, mtp::default_set> tiles;
+	};
+
+
+	struct BuildJobSlice
+	{
+		uint32_t begin;
+		uint32_t end;
+
+		TilePathfinder*  pathfinder;
+		const TileField* tilefield;
+		BuildScratch*    scratch;
+	};
+
+
+	struct SearchJobSlice
+	{
+		uint32_t begin;
+		uint32_t end;
+
+		const TilePathfinder*  pathfinder;
+		const TilePathRequest* requests;
+		TilePathResult*        results;
+		SearchScratch*         scratch;
+	};
+
+
+	[[nodiscard]] static bool same_tile(TileCoord lhs, TileCoord rhs)
+	{
+		return lhs.x == rhs.x && lhs.z == rhs.z
+			&& lhs.storey_index == rhs.storey_index
+			&& lhs.storey_stack == rhs.storey_stack;
+	}
+
+
+	[[nodiscard]] static TileChunkCoord offset_chunk(TileChunkCoord chunk_coord, int32_t offset_x, int32_t offset_z)
+	{
+		return TileChunkCoord {
+			.chunk_x      = chunk_coord.chunk_x + offset_x,
+			.chunk_z      = chunk_coord.chunk_z + offset_z,
+			.storey_index = chunk_coord.storey_index,
+			.storey_stack = chunk_coord.storey_stack
+		};
+	}
+
+
+	[[nodiscard]] static TileCoord tile_of(TileChunkCoord chunk_coord, uint32_t local_index)
+	{
+		return TileCoord {
+			.x            = (chunk_coord.chunk_x << cfg::chunk_shift) + static_cast<int32_t>(local_index & cfg::chunk_mask),
+			.z            = (chunk_coord.chunk_z << cfg::chunk_shift) + static_cast<int32_t>(local_index >> cfg::chunk_shift),
+			.storey_index = chunk_coord.storey_index,
+			.storey_stack = chunk_coord.storey_stack
+		};
+	}
+
+
+	// NOTE: octile distance in step cost units, a cost 1 tile is the cheapest there is
+
+	[[nodiscard]] static uint32_t octile_distance(TileCoord from, TileCoord to)
+	{
+		const uint32_t delta_x = static_cast<uint32_t>(std::abs(from.x - to.x));
+		const uint32_t delta_z = static_cast<uint32_t>(std::abs(from.z - to.z));
+
+		const uint32_t straight = 2U * cfg::tile_path_weight_straight;
+		const uint32_t diagonal = 2U * cfg::tile_path_weight_diagonal;
+
+		return straight * std::max(delta_x, delta_z) + (diagonal - straight) * std::min(delta_x, delta_z);
+	}
+
+
+	// NOTE: cost per unit of octile distance a transition charges, rounded down, walking is one unit
+
+	[[nodiscard]] static uint32_t transition_scale(const TilePathTransition& transition)
+	{
+		const uint32_t distance = octile_distance(transition.from, transition.to);
+		if (distance == 0)
+			return k_heuristic_unit;
+
+		const uint64_t scale = (static_cast<uint64_t>(transition.cost) * k_heuristic_unit) / distance;
+
+		return static_cast<uint32_t>(std::min<uint64_t>(scale, k_heuristic_unit));
+	}
+
+
+	// NOTE: every walked step and every transition covers at least scale times its octile distance,
+	//       so the scaled bound stays admissible and consistent across cheap long transitions
+
+	[[nodiscard]] uint32_t heuristic(TileCoord from, TileCoord to) const
+	{
+		return static_cast<uint32_t>((static_cast<uint64_t>(octile_distance(from, to)) * m_heuristic_scale) >> 16);
+	}
+
+
+	[[nodiscard]] uint8_t tile_cost(TileType tile) const
+	{
+		if (m_cost_fn)
+			return m_cost_fn(tile, m_rule_data);
+
+		return tile != 0 ? uint8_t {1} : uint8_t {0};
+	}
+
+
+	void invalidate_chunk(TileChunkCoord chunk_coord)
+	{
+		const uint32_t slot = m_directory.find(get_chunk_coord_hash(chunk_coord));
+
+		if (slot != ChunkDirectory::k_empty_slot)
+			m_chunks[slot].dirty = true;
+	}
+
+
+	// NOTE: a chunk entering or leaving the field changes the entrances of its four neighbours
+
+	bool sync_chunks(const TileField& tilefield)
+	{
+		bool changed = false;
+
+		for (uint32_t slot = 0; slot < m_chunks.size();) {
+
+			if (tilefield.find_chunk(m_chunks[slot].key)) {
+				++slot;
+				continue;
+			}
+
+			const TileChunkCoord chunk_coord = m_chunks[slot].coord;
+
+			(void) m_directory.erase(m_chunks[slot].key);
+
+			const uint32_t last_slot = static_cast<uint32_t>(m_chunks.size() - 1);
+
+			if (slot != last_slot) {
+				std::swap(m_chunks[slot], m_chunks[last_slot]);
+				(void) m_directory.erase(m_chunks[slot].key);
+				m_directory.insert(m_chunks[slot].key, slot);
+			}
+
+			m_chunks.pop_back();
+
+			invalidate(chunk_coord);
+			changed = true;
+		}
+
+		for (const TileChunk& tile_chunk : tilefield.chunks()) {
+
+			if (m_directory.find(tile_chunk.key) != ChunkDirectory::k_empty_slot)
+				continue;
+
+			m_directory.insert(tile_chunk.key, static_cast<uint32_t>(m_chunks.size()));
+
+			PathChunk& chunk = m_chunks.emplace_back();
+
+			chunk.coord = tile_chunk.coord;
+			chunk.key   = tile_chunk.key;
+			chunk.dirty = true;
+
+			invalidate(tile_chunk.coord);
+			changed = true;
+		}
+
+		return changed;
+	}
+
+
+	// NOTE: global node ids are chunk node_base + node index, links resolve to them here
+
+	void relink()
+	{
+		m_node_total = 0;
+
+		for (PathChunk& chunk : m_chunks) {
+			chunk.node_base = m_node_total;
+			m_node_total += static_cast<uint32_t>(chunk.nodes.size());
+		}
+
+		m_node_chunks.resize(m_node_total);
+		m_node_tiles.resize(m_node_total);
+
+		for (uint32_t slot = 0; slot < m_chunks.size(); ++slot) {
+
+			PathChunk& chunk = m_chunks[slot];
+
+			for (uint32_t node_idx = 0; node_idx < chunk.nodes.size(); ++node_idx) {
+				m_node_chunks[chunk.node_base + node_idx] = slot;
+				m_node_tiles[chunk.node_base + node_idx]  = tile_of(chunk.coord, chunk.nodes[node_idx].local_index);
+			}
+
+			for (PathLink& link : chunk.links) {
+
+				link.target_node = k_invalid_node;
+
+				const uint32_t target_slot = m_directory.find(get_chunk_coord_hash(get_chunk_coord(link.target)));
+				if (target_slot == ChunkDirectory::k_empty_slot)
+					continue;
+
+				const PathChunk& target_chunk = m_chunks[target_slot];
+				const uint16_t   target_local = static_cast<uint16_t>(get_local_index(link.target));
+
+				for (uint32_t node_idx = 0; node_idx < target_chunk.nodes.size(); ++node_idx) {
+					if (target_chunk.nodes[node_idx].local_index == target_local) {
+						link.target_node = target_chunk.node_base + node_idx;
+						break;
+					}
+				}
+			}
+		}
+
+		// NOTE: incoming links per node for searches run towards a goal, transitions are one way
+
+		m_in_offsets.clear();
+		m_in_offsets.resize(m_node_total + 1, 0U);
+
+		for (const PathChunk& chunk : m_chunks) {
+			for (const PathLink& link : chunk.links) {
+				if (link.target_node != k_invalid_node)
+					++m_in_offsets[link.target_node + 1];
+			}
+		}
+
+		for (uint32_t node = 0; node < m_node_total; ++node)
+			m_in_offsets[node + 1] += m_in_offsets[node];
+
+		m_in_links.resize(m_in_offsets[m_node_total]);
+
+		m_in_cursor.resize(m_node_total);
+		std::copy_n(m_in_offsets.data(), m_node_total, m_in_cursor.data());
+
+		for (const PathChunk& chunk : m_chunks) {
+			for (uint32_t node_idx = 0; node_idx < chunk.nodes.size(); ++node_idx) {
+
+				const PathNode& node = chunk.nodes[node_idx];
+
+				for (uint32_t link_idx = node.link_beg; link_idx < node.link_beg + node.link_count; ++link_idx) {
+
+					const PathLink& link = chunk.links[link_idx];
+					if (link.target_node == k_invalid_node)
+						continue;
+
+					m_in_links[m_in_cursor[link.target_node]++] = InLink {
+						.source = chunk.node_base + node_idx,
+						.cost   = link.cost
+					};
+				}
+			}
+		}
+
+		++m_version;
+	}
+
+
+	static void search_local(
+		const uint8_t*                           costs,
+		uint32_t                                 source,
+		LocalSearch&                             search,
+		mtp::vault<uint64_t,  mtp::default_set>& heap,
+		const uint64_t*                          target_mask,
+		uint32_t                                 target_count
+	)
+	{
+		const uint64_t seed = heap_key(0, source);
+
+		search_local(costs, std::span<const uint64_t> {&seed, 1}, search, heap, target_mask, target_count);
+	}
+
+
+	// NOTE: 8 connected inside one chunk, diagonals may not cut a blocked corner. seeds are
+	//       heap_key(start cost, local index), blocked seeds are dropped. stops early once
+	//       target_count tiles flagged in target_mask have been settled, costs and parents
+	//       are final for settled tiles only
+
+	static void search_local(
+		const uint8_t*                           costs,
+		std::span<const uint64_t>                seeds,
+		LocalSearch&                             search,
+		mtp::vault<uint64_t,  mtp::default_set>& heap,
+		const uint64_t*                          target_mask,
+		uint32_t                                 target_count
+	)
+	{
+		static constexpr int32_t s = cfg::chunk_size;
+
+		std::fill_n(search.cost, cfg::chunk_area, k_infinite_cost);
+		std::fill_n(search.parent, cfg::chunk_area, k_no_parent);
+
+		heap.clear();
+
+		for (const uint64_t seed : seeds) {
+
+			const uint32_t seed_cost  = static_cast<uint32_t>(seed >> 32);
+			const uint32_t seed_index = static_cast<uint32_t>(seed);
+
+			if (costs[seed_index] == 0 || seed_cost >= search.cost[seed_index])
+				continue;
+
+			search.cost[seed_index]   = seed_cost;
+			search.parent[seed_index] = static_cast<uint16_t>(seed_index);
+
+			heap.emplace_back(seed);
+			std::push_heap(heap.begin(), heap.end(), std::greater<> {});
+		}
+
+		uint32_t settled_targets = 0;
+
+		while (!heap.empty()) {
+
+			std::pop_heap(heap.begin(), heap.end(), std::greater<> {});
+			const uint32_t entry_cost  = static_cast<uint32_t>(heap.back() >> 32);
+			const uint32_t entry_index = static_cast<uint32_t>(heap.back());
+			heap.pop_back();
+
+			if (entry_cost != search.cost[entry_index])
+				continue;
+
+			if ((target_mask[entry_index >> 6] >> (entry_index & 63U)) & 1U) {
+				if (++settled_targets == target_count)
+					return;
+			}
+
+			const int32_t x = static_cast<int32_t>(entry_index & cfg::chunk_mask);
+			const int32_t z = static_cast<int32_t>(entry_index >> cfg::chunk_shift);
+
+			const uint32_t cost_here = costs[entry_index];
+
+			for (int32_t offset_z = -1; offset_z <= 1; ++offset_z) {
+				for (int32_t offset_x = -1; offset_x <= 1; ++offset_x) {
+
+					const int32_t next_x = x + offset_x;
+					const int32_t next_z = z + offset_z;
+
+					if ((offset_x == 0 && offset_z == 0) || next_x < 0 || next_x >= s || next_z < 0 || next_z >= s)
+						continue;
+
+					const uint32_t next = get_local_index(next_x, next_z);
+					const uint32_t cost_next = costs[next];
+
+					if (cost_next == 0)
+						continue;
+
+					const bool diagonal = offset_x != 0 && offset_z != 0;
+
+					if (diagonal && (costs[get_local_index(next_x, z)] == 0 || costs[get_local_index(x, next_z)] == 0))
+						continue;
+
+					const uint32_t weight    = diagonal ? cfg::tile_path_weight_diagonal : cfg::tile_path_weight_straight;
+					const uint32_t next_cost = entry_cost + (cost_here + cost_next) * weight;
+
+					if (next_cost < search.cost[next]) {
+						search.cost[next]   = next_cost;
+						search.parent[next] = static_cast<uint16_t>(entry_index);
+
+						heap.emplace_back(heap_key(next_cost, next));
+						std::push_heap(heap.begin(), heap.end(), std::greater<> {});
+					}
+				}
+			}
+		}
+	}
+
+
+	static void build_chunks(void* slice_raw)
+	{
+		auto* slice = static_cast<BuildJobSlice*>(slice_raw);
+
+		TilePathfinder& pathfinder = *slice->pathfinder;
+
+		for (uint32_t task_idx = slice->begin; task_idx < slice->end; ++task_idx) {
+			PathChunk& chunk = pathfinder.m_chunks[pathfinder.m_build_tasks[task_idx]];
+			pathfinder.build_chunk(*slice->tilefield, chunk, *slice->scratch);
+		}
+	}
+
+
+	// NOTE: only writes its own chunk, neighbour tiles are read straight from the field so
+	//       both sides of a border agree on the entrances without a build order
+
+	void build_chunk(const TileField& tilefield, PathChunk& chunk, BuildScratch& scratch) const
+	{
+		static constexpr int32_t s = cfg::chunk_size;
+
+		chunk.dirty = false;
+
+		chunk.costs.resize(cfg::chunk_area);
+		chunk.nodes.clear();
+		chunk.edges.clear();
+		chunk.links.clear();
+		chunk.paths.clear();
+
+		const TileChunk* tile_chunk = tilefield.find_chunk(chunk.key);
+		HPR_ASSERT_MSG(tile_chunk, "[tile_path][build_chunk] chunk left the field before update");
+
+		for (uint32_t local_idx = 0; local_idx < cfg::chunk_area; ++local_idx)
+			chunk.costs[local_idx] = tile_cost(tile_chunk->tiles[local_idx]);
+
+		scratch.node_of.resize(cfg::chunk_area);
+		std::fill_n(scratch.node_of.data(), cfg::chunk_area, k_invalid_node);
+
+		scratch.node_links.clear();
+		scratch.node_link_owner.clear();
+
+		auto add_node = [&](uint32_t local_index) -> uint32_t {
+			if (scratch.node_of[local_index] == k_invalid_node) {
+				scratch.node_of[local_index] = static_cast<uint32_t>(chunk.nodes.size());
+				chunk.nodes.emplace_back(PathNode {
+					.local_index = static_cast<uint16_t>(local_index),
+					.edge_beg    = 0,
+					.edge_count  = 0,
+					.link_beg    = 0,
+					.link_count  = 0
+				});
+			}
+			return scratch.node_of[local_index];
+		};
+
+		auto add_link = [&](uint32_t local_index, TileCoord target, uint32_t cost) {
+			const uint32_t node_idx = add_node(local_index);
+			scratch.node_links.emplace_back(PathLink {.target = target, .cost = cost, .target_node = k_invalid_node});
+			scratch.node_link_owner.emplace_back(static_cast<uint16_t>(node_idx));
+		};
+
+		// NOTE: entrances, side (axis, offset) walks the border tiles paired with the neighbour
+
+		for (uint32_t side = 0; side < 4; ++side) {
+
+			const bool    along_z = side < 2;
+			const int32_t offset  = (side & 1U) ? 1 : -1;
+
+			const TileChunkCoord neighbour_coord = along_z
+				? offset_chunk(chunk.coord, offset, 0)
+				: offset_chunk(chunk.coord, 0, offset);
+
+			const TileChunk* neighbour = tilefield.find_chunk(neighbour_coord);
+			if (!neighbour)
+				continue;
+
+			const int32_t edge_self      = (offset < 0) ? 0 : s - 1;
+			const int32_t edge_neighbour = (offset < 0) ? s - 1 : 0;
+
+			auto self_local = [&](int32_t border) {
+				return along_z ? get_local_index(edge_self, border) : get_local_index(border, edge_self);
+			};
+
+			auto neighbour_local = [&](int32_t border) {
+				return along_z ? get_local_index(edge_neighbour, border) : get_local_index(border, edge_neighbour);
+			};
+
+			auto emit = [&](int32_t border) {
+				const uint32_t local_self      = self_local(border);
+				const uint32_t local_neighbour = neighbour_local(border);
+
+				const uint32_t cost_self      = chunk.costs[local_self];
+				const uint32_t cost_neighbour = tile_cost(neighbour->tiles[local_neighbour]);
+
+				add_link(
+					local_self,
+					tile_of(neighbour_coord, local_neighbour),
+					(cost_self + cost_neighbour) * cfg::tile_path_weight_straight
+				);
+			};
+
+			int32_t run_beg = -1;
+
+			for (int32_t border = 0; border <= s; ++border) {
+
+				const bool open = border < s
+					&& chunk.costs[self_local(border)] != 0
+					&& tile_cost(neighbour->tiles[neighbour_local(border)]) != 0;
+
+				if (open && run_beg < 0)
+					run_beg = border;
+
+				if (open || run_beg < 0)
+					continue;
+
+				const int32_t run_length = border - run_beg;
+
+				if (run_length < cfg::tile_path_entrance_split) {
+					emit(run_beg + run_length / 2);
+				}
+				else {
+					emit(run_beg);
+					emit(border - 1);
+				}
+
+				run_beg = -1;
+			}
+		}
+
+		// NOTE: transitions, both ends become nodes, only the near end carries the link
+
+		for (const TilePathTransition& transition : m_transitions) {
+
+			const bool from_here = same_chunk(get_chunk_coord(transition.from), chunk.coord);
+			const bool to_here   = same_chunk(get_chunk_coord(transition.to),   chunk.coord);
+
+			if (from_here && chunk.costs[get_local_index(transition.from)] != 0)
+				add_link(get_local_index(transition.from), transition.to, transition.cost);
+
+			if (to_here && chunk.costs[get_local_index(transition.to)] != 0)
+				(void) add_node(get_local_index(transition.to));
+		}
+
+		// NOTE: links grouped by node, a node appears once however many borders it sits on
+
+		const uint32_t node_count = static_cast<uint32_t>(chunk.nodes.size());
+
+		for (uint32_t node_idx = 0; node_idx < node_count; ++node_idx) {
+
+			PathNode& node = chunk.nodes[node_idx];
+
+			node.link_beg = static_cast<uint32_t>(chunk.links.size());
+
+			for (uint32_t link_idx = 0; link_idx < scratch.node_links.size(); ++link_idx) {
+				if (scratch.node_link_owner[link_idx] == node_idx)
+					chunk.links.emplace_back(scratch.node_links[link_idx]);
+			}
+
+			node.link_count = static_cast<uint32_t>(chunk.links.size()) - node.link_beg;
+		}
+
+		std::fill_n(chunk.node_mask, k_mask_words, uint64_t {0});
+
+		for (const PathNode& node : chunk.nodes)
+			chunk.node_mask[node.local_index >> 6] |= uint64_t {1} << (node.local_index & 63U);
+
+		// NOTE: intra chunk edges with their tile paths, one dijkstra per node
+
+		for (uint32_t node_idx = 0; node_idx < node_count; ++node_idx) {
+
+			PathNode& node = chunk.nodes[node_idx];
+
+			node.edge_beg = static_cast<uint32_t>(chunk.edges.size());
+
+			search_local(chunk.costs.data(), node.local_index, scratch.search, scratch.heap, chunk.node_mask, node_count);
+
+			for (uint32_t target_idx = 0; target_idx < node_count; ++target_idx) {
+
+				const uint32_t target_local = chunk.nodes[target_idx].local_index;
+
+				if (target_idx == node_idx || scratch.search.cost[target_local] == k_infinite_cost)
+					continue;
+
+				scratch.path.clear();
+
+				for (uint32_t step = target_local; step != node.local_index; step = scratch.search.parent[step])
+					scratch.path.emplace_back(static_cast<uint16_t>(step));
+
+				const uint32_t path_beg = static_cast<uint32_t>(chunk.paths.size());
+
+				for (uint32_t step_idx = static_cast<uint32_t>(scratch.path.size()); step_idx > 0; --step_idx)
+					chunk.paths.emplace_back(scratch.path[step_idx - 1]);
+
+				chunk.edges.emplace_back(PathEdge {
+					.target     = target_idx,
+					.cost       = scratch.search.cost[target_local],
+					.path_beg   = path_beg,
+					.path_count = static_cast<uint32_t>(scratch.path.size())
+				});
+			}
+
+			node.edge_count = static_cast<uint32_t>(chunk.edges.size()) - node.edge_beg;
+		}
+	}
+
+
+	static void search_paths(void* slice_raw)
+	{
+		auto* slice = static_cast<SearchJobSlice*>(slice_raw);
+
+		const TilePathfinder& pathfinder = *slice->pathfinder;
+
+		SearchScratch& scratch = *slice->scratch;
+		scratch.tiles.clear();
+
+		for (uint32_t request_idx = slice->begin; request_idx < slice->end; ++request_idx)
+			slice->results[request_idx] = pathfinder.search_path(slice->requests[request_idx], scratch);
+	}
+
+
+	// NOTE: local dijkstra from start and from goal stand in for inserting both into the graph,
+	//       a* over the abstract nodes closes the gap. costs are symmetric so the goal search
+	//       also prices the way from a goal chunk node to the goal
+
+	TilePathResult search_path(const TilePathRequest& request, SearchScratch& scratch) const
+	{
+		TilePathResult result {};
+
+		const uint32_t start_slot = m_directory.find(get_chunk_coord_hash(get_chunk_coord(request.start)));
+		const uint32_t goal_slot  = m_directory.find(get_chunk_coord_hash(get_chunk_coord(request.goal)));
+
+		if (start_slot == ChunkDirectory::k_empty_slot || goal_slot == ChunkDirectory::k_empty_slot) {
+			result.status = TilePathStatus::blocked;
+			return result;
+		}
+
+		const PathChunk& start_chunk = m_chunks[start_slot];
+		const PathChunk& goal_chunk  = m_chunks[goal_slot];
+
+		const uint32_t start_local = get_local_index(request.start);
+		const uint32_t goal_local  = get_local_index(request.goal);
+
+		if (start_chunk.costs[start_local] == 0 || goal_chunk.costs[goal_local] == 0) {
+			result.status = TilePathStatus::blocked;
+			return result;
+		}
+
+		// NOTE: both searches stop once every node of their chunk, and the goal on a shared chunk, settled
+
+		std::copy_n(start_chunk.node_mask, k_mask_words, scratch.target_mask);
+
+		if (start_slot == goal_slot)
+			scratch.target_mask[goal_local >> 6] |= uint64_t {1} << (goal_local & 63U);
+
+		uint32_t start_targets = 0;
+		for (const uint64_t mask_word : scratch.target_mask)
+			start_targets += static_cast<uint32_t>(std::popcount(mask_word));
+
+		search_local(start_chunk.costs.data(), start_local, scratch.start_search, scratch.heap, scratch.target_mask, start_targets);
+		search_local(goal_chunk.costs.data(),  goal_local,  scratch.goal_search,  scratch.heap, goal_chunk.node_mask,
+			static_cast<uint32_t>(goal_chunk.nodes.size()));
+
+		uint32_t best_cost = k_infinite_cost;
+		uint32_t best_node = k_invalid_node;
+
+		if (start_slot == goal_slot)
+			best_cost = scratch.start_search.cost[goal_local];
+
+		// NOTE: generation stamps spare clearing the per node arrays for every request
+
+		const uint32_t node_limit = m_node_total;
+
+		if (scratch.node_stamp.size() < node_limit) {
+			scratch.node_cost.resize(node_limit);
+			scratch.node_parent.resize(node_limit);
+			scratch.node_via_link.resize(node_limit);
+			scratch.node_stamp.resize(node_limit, 0U);
+		}
+
+		if (++scratch.stamp == 0) {
+			std::fill_n(scratch.node_stamp.data(), scratch.node_stamp.size(), 0U);
+			scratch.stamp = 1;
+		}
+
+		auto node_cost = [&](uint32_t node) {
+			return scratch.node_stamp[node] == scratch.stamp ? scratch.node_cost[node] : k_infinite_cost;
+		};
+
+		auto relax = [&](uint32_t node, uint32_t cost, uint32_t parent, bool via_link) {
+			if (cost >= node_cost(node))
+				return;
+
+			scratch.node_stamp[node]    = scratch.stamp;
+			scratch.node_cost[node]     = cost;
+			scratch.node_parent[node]   = parent;
+			scratch.node_via_link[node] = via_link ? 1U : 0U;
+
+			scratch.heap.emplace_back(heap_key(cost + heuristic(m_node_tiles[node], request.goal), node));
+			std::push_heap(scratch.heap.begin(), scratch.heap.end(), std::greater<> {});
+		};
+
+		scratch.heap.clear();
+
+		for (uint32_t node_idx = 0; node_idx < start_chunk.nodes.size(); ++node_idx) {
+			const uint32_t cost = scratch.start_search.cost[start_chunk.nodes[node_idx].local_index];
+			if (cost != k_infinite_cost)
+				relax(start_chunk.node_base + node_idx, cost, k_invalid_node, false);
+		}
+
+		while (!scratch.heap.empty()) {
+
+			std::pop_heap(scratch.heap.begin(), scratch.heap.end(), std::greater<> {});
+			const uint32_t entry_cost  = static_cast<uint32_t>(scratch.heap.back() >> 32);
+			const uint32_t entry_index = static_cast<uint32_t>(scratch.heap.back());
+			scratch.heap.pop_back();
+
+			if (entry_cost >= best_cost)
+				break;
+
+			const uint32_t node = entry_index;
+			const uint32_t cost = node_cost(node);
+
+			if (entry_cost != cost + heuristic(m_node_tiles[node], request.goal))
+				continue;
+
+			const uint32_t   slot  = m_node_chunks[node];
+			const PathChunk& chunk = m_chunks[slot];
+			const PathNode&  info  = chunk.nodes[node - chunk.node_base];
+
+			if (slot == goal_slot) {
+				const uint32_t goal_cost = scratch.goal_search.cost[info.local_index];
+				if (goal_cost != k_infinite_cost && cost + goal_cost < best_cost) {
+					best_cost = cost + goal_cost;
+					best_node = node;
+				}
+			}
+
+			for (uint32_t edge_idx = info.edge_beg; edge_idx < info.edge_beg + info.edge_count; ++edge_idx) {
+				const PathEdge& edge = chunk.edges[edge_idx];
+				relax(chunk.node_base + edge.target, cost + edge.cost, node, false);
+			}
+
+			for (uint32_t link_idx = info.link_beg; link_idx < info.link_beg + info.link_count; ++link_idx) {
+				const PathLink& link = chunk.links[link_idx];
+				if (link.target_node != k_invalid_node)
+					relax(link.target_node, cost + link.cost, node, true);
+			}
+		}
+
+		if (best_cost == k_infinite_cost) {
+			result.status = TilePathStatus::unreachable;
+			return result;
+		}
+
+		result.status   = TilePathStatus::found;
+		result.cost     = best_cost;
+		result.tile_beg = static_cast<uint32_t>(scratch.tiles.size());
+
+		if (best_node == k_invalid_node) {
+			append_from_start(start_chunk, goal_local, scratch);
+		}
+		else {
+			scratch.chain.clear();
+
+			for (uint32_t node = best_node; node != k_invalid_node; node = scratch.node_parent[node])
+				scratch.chain.emplace_back(node);
+
+			std::reverse(scratch.chain.begin(), scratch.chain.end());
+
+			append_from_start(start_chunk, start_chunk.nodes[scratch.chain[0] - start_chunk.node_base].local_index, scratch);
+
+			for (uint32_t chain_idx = 1; chain_idx < scratch.chain.size(); ++chain_idx) {
+
+				const uint32_t node_from = scratch.chain[chain_idx - 1];
+				const uint32_t node_to   = scratch.chain[chain_idx];
+
+				if (scratch.node_via_link[node_to]) {
+					scratch.tiles.emplace_back(m_node_tiles[node_to]);
+					continue;
+				}
+
+				const PathChunk& chunk = m_chunks[m_node_chunks[node_from]];
+				const PathNode&  info  = chunk.nodes[node_from - chunk.node_base];
+
+				for (uint32_t edge_idx = info.edge_beg; edge_idx < info.edge_beg + info.edge_count; ++edge_idx) {
+
+					const PathEdge& edge = chunk.edges[edge_idx];
+
+					if (chunk.node_base + edge.target != node_to)
+						continue;
+
+					for (uint32_t step_idx = 0; step_idx < edge.path_count; ++step_idx)
+						scratch.tiles.emplace_back(tile_of(chunk.coord, chunk.paths[edge.path_beg + step_idx]));
+
+					break;
+				}
+			}
+
+			// NOTE: the goal search parents already point towards the goal
+
+			const PathNode& last = goal_chunk.nodes[best_node - goal_chunk.node_base];
+
+			for (uint32_t step = last.local_index; step != goal_local;) {
+				step = scratch.goal_search.parent[step];
+				scratch.tiles.emplace_back(tile_of(goal_chunk.coord, step));
+			}
+		}
+
+		result.tile_count = static_cast<uint32_t>(scratch.tiles.size()) - result.tile_beg;
+
+		return result;
+	}
+
+
+	// NOTE: start tile through target_local, walked back along the start search parents
+
+	static void append_from_start(const PathChunk& start_chunk, uint32_t target_local, SearchScratch& scratch)
+	{
+		const uint32_t tile_beg = static_cast<uint32_t>(scratch.tiles.size());
+
+		uint32_t step = target_local;
+
+		while (true) {
+			scratch.tiles.emplace_back(tile_of(start_chunk.coord, step));
+
+			const uint32_t parent = scratch.start_search.parent[step];
+			if (parent == step)
+				break;
+
+			step = parent;
+		}
+
+		std::reverse(scratch.tiles.begin() + tile_beg, scratch.tiles.end());
+	}
+
+private:
+
+	mtp::vault<PathChunk, mtp::default_set> m_chunks;
+	ChunkDirectory                          m_directory;
+
+	mtp::vault<TilePathTransition, mtp::default_set> m_transitions;
+
+	mtp::vault<uint32_t,  mtp::default_set> m_node_chunks;
+	mtp::vault<TileCoord, mtp::default_set> m_node_tiles;
+	uint32_t                                m_node_total {0};
+
+	mtp::vault<uint32_t, mtp::default_set> m_in_offsets;
+	mtp::vault<uint32_t, mtp::default_set> m_in_cursor;
+	mtp::vault<InLink,   mtp::default_set> m_in_links;
+
+	uint64_t m_version {0};
+
+	mtp::vault<uint32_t,      mtp::default_set> m_build_tasks;
+	mtp::vault<BuildJobSlice, mtp::default_set> m_build_slices;
+	mtp::vault<BuildScratch,  mtp::default_set> m_build_scratch;
+
+	mtp::vault<SearchJobSlice, mtp::default_set> m_search_slices;
+	mtp::vault<SearchScratch,  mtp::default_set> m_search_scratch;
+
+	TileChangeCursor m_change_cursor {};
+
+	TilePathCostFn m_cost_fn   {nullptr};
+	const void*    m_rule_data {nullptr};
+
+	uint32_t m_heuristic_scale {k_heuristic_unit};
+};
+
+
+} // hpr::scn
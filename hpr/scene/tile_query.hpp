@@ -1,10 +1,12 @@
 #pragma once
 
+#include <bit>
+#include <array>
+
 #include "math.hpp"
 
 #include "stratum.hpp"
 #include "tile_data.hpp"
-#include "tile_field.hpp"
 #include "storey_data.hpp"
 #include "tile_draw_data.hpp"
 
@@ -30,6 +32,31 @@ namespace hpr::scn {
 }
 
 
+// NOTE: resolves the storey through the stratum instead of treating one voxel as one storey,
+//       storey_index is -1 when the height falls outside the stack
+
+[[nodiscard]] inline TileCoord world_to_tile(
+	const vec3&           pos_world,
+	const TileGridParams& grid,
+	const Stratum&        stratum,
+	int32_t               storey_stack
+)
+{
+	const vec3 local = pos_world - grid.origin_world;
+
+	const float size_inv = 1.0f / grid.tile_size;
+
+	const int32_t x = static_cast<int32_t>(floorf(local.x * size_inv));
+	const int32_t z = static_cast<int32_t>(floorf(local.z * size_inv));
+
+	const int32_t voxel_y = static_cast<int32_t>(floorf(local.y * size_inv));
+
+	const Storey* storey = stratum.find_storey_at_voxel_y(storey_stack, voxel_y);
+
+	return TileCoord {x, z, storey ? storey->index_y : -1, storey_stack};
+}
+
+
 [[nodiscard]] inline vec3 tile_to_world_center(const TileCoord& coord, const TileGridParams& grid)
 {
 	const float x = grid.origin_world.x + (static_cast<float>(coord.x)            + 0.5f) * grid.tile_size;
@@ -42,8 +69,10 @@ namespace hpr::scn {
 
 [[nodiscard]] inline TileChunkCoord get_chunk_coord(TileCoord coord)
 {
-	const int32_t chunk_x = math::floor_div(coord.x, cfg::chunk_size);
-	const int32_t chunk_z = math::floor_div(coord.z, cfg::chunk_size);
+	// NOTE: arithmetic shift floors negative coords as well
+
+	const int32_t chunk_x = coord.x >> cfg::chunk_shift;
+	const int32_t chunk_z = coord.z >> cfg::chunk_shift;
 
 	return TileChunkCoord {
 		.chunk_x      = chunk_x,
@@ -54,6 +83,47 @@ namespace hpr::scn {
 }
 
 
+[[nodiscard]] inline uint32_t get_local_index(int32_t local_x, int32_t local_z)
+{
+	HPR_ASSERT_MSG(local_x >= 0 && local_x < cfg::chunk_size, "[tile] local_x out of range");
+	HPR_ASSERT_MSG(local_z >= 0 && local_z < cfg::chunk_size, "[tile] local_z out of range");
+
+	return static_cast<uint32_t>(local_x) + (static_cast<uint32_t>(local_z) << cfg::chunk_shift);
+}
+
+
+[[nodiscard]] inline uint32_t get_local_index(TileCoord coord)
+{
+	return get_local_index(coord.x & cfg::chunk_mask, coord.z & cfg::chunk_mask);
+}
+
+
+[[nodiscard]] inline bool same_chunk(TileChunkCoord lhs, TileChunkCoord rhs)
+{
+	return lhs.chunk_x      == rhs.chunk_x
+		&& lhs.chunk_z      == rhs.chunk_z
+		&& lhs.storey_index == rhs.storey_index
+		&& lhs.storey_stack == rhs.storey_stack;
+}
+
+
+[[nodiscard]] inline bool region_empty(const TileRegion& region)
+{
+	return region.x_end      <= region.x_beg
+		|| region.z_end      <= region.z_beg
+		|| region.storey_end <= region.storey_beg;
+}
+
+
+[[nodiscard]] inline bool regions_overlap(const TileRegion& lhs, const TileRegion& rhs)
+{
+	return lhs.storey_stack == rhs.storey_stack
+		&& lhs.x_beg      < rhs.x_end      && rhs.x_beg      < lhs.x_end
+		&& lhs.z_beg      < rhs.z_end      && rhs.z_beg      < lhs.z_end
+		&& lhs.storey_beg < rhs.storey_end && rhs.storey_beg < lhs.storey_end;
+}
+
+
 [[nodiscard]] inline uint64_t get_chunk_coord_hash(TileChunkCoord coord)
 {
 	static constexpr uint64_t fnv1a_offset_basis = 14695981039346656037ULL;
@@ -78,11 +148,10 @@ namespace hpr::scn {
 inline void mark_dirty_chunk(
 	const Stratum&             stratum,
 	const TileGridParams&      grid_params,
-	const TileCoord            tile_coord,
+	const TileChunkCoord       chunk_coord,
 	rdr::TileChunkDrawableSet& chunk_drawable_set
 )
 {
-	const TileChunkCoord chunk_coord = get_chunk_coord(tile_coord);
 	const uint64_t coord_hash = get_chunk_coord_hash(chunk_coord);
 
 	const Storey* storey = stratum.find_storey(chunk_coord.storey_stack, chunk_coord.storey_index);
@@ -116,20 +185,26 @@ inline void mark_dirty_chunk(
 		glm::translate(mat4(1.0f), vec3(min_x, min_y, min_z)) *
 		glm::scale(mat4(1.0f), vec3(size_x, 1.0f, size_z));
 
-	// TODO: replace o(n) per chunk edit with an index map
+	const uint32_t drawable_idx = chunk_drawable_set.index.find(coord_hash);
 
-	for (auto& chunk_drawable : chunk_drawable_set.drawables) {
-		if (chunk_drawable.coord_hash == coord_hash) {
+	if (drawable_idx != ChunkDirectory::k_empty_slot) {
 
-			chunk_drawable.coord         = chunk_coord;
-			chunk_drawable.tile_style    = chunk_drawable_set.tile_style;
-			chunk_drawable.mtx_M         = mtx_M;
-			chunk_drawable.bounds_center = bounds_center;
-			chunk_drawable.bounds_half   = bounds_half;
-			chunk_drawable.dirty         = true;
+		auto& chunk_drawable = chunk_drawable_set.drawables[drawable_idx];
 
-			return;
+		chunk_drawable.coord         = chunk_coord;
+		chunk_drawable.tile_style    = chunk_drawable_set.tile_style;
+		chunk_drawable.mtx_M         = mtx_M;
+		chunk_drawable.bounds_center = bounds_center;
+		chunk_drawable.bounds_half   = bounds_half;
+
+		chunk_drawable_set.cull_tree.update(drawable_idx, bounds_center, bounds_half);
+
+		if (!chunk_drawable.dirty) {
+			chunk_drawable.dirty = true;
+			chunk_drawable_set.dirty_queue.emplace_back(drawable_idx);
 		}
+
+		return;
 	}
 
 	const rdr::TileChunkDrawable chunk_drawable {
@@ -144,7 +219,78 @@ inline void mark_dirty_chunk(
 		.dirty         = true
 	};
 
+	const uint32_t new_idx = static_cast<uint32_t>(chunk_drawable_set.drawables.size());
+
 	chunk_drawable_set.drawables.emplace_back(chunk_drawable);
+	chunk_drawable_set.cull_tree.insert(new_idx, chunk_coord, bounds_center, bounds_half);
+	chunk_drawable_set.index.insert(coord_hash, new_idx);
+	chunk_drawable_set.dirty_queue.emplace_back(new_idx);
+}
+
+
+inline void mark_dirty_chunk(
+	const Stratum&             stratum,
+	const TileGridParams&      grid_params,
+	const TileCoord            tile_coord,
+	rdr::TileChunkDrawableSet& chunk_drawable_set
+)
+{
+	mark_dirty_chunk(stratum, grid_params, get_chunk_coord(tile_coord), chunk_drawable_set);
+}
+
+
+// NOTE: for chunks that left the field, e.g. as the TileRegionStream on_evict callback. the
+//       drawable leaves the cull tree and keeps its slot and tilemap, mark_dirty_chunk() on
+//       reload puts it back. a queued upload is dropped by the layer once it finds no chunk
+
+inline void release_tile_chunk(TileChunkCoord chunk_coord, rdr::TileChunkDrawableSet& chunk_drawable_set)
+{
+	const uint32_t drawable_idx = chunk_drawable_set.index.find(get_chunk_coord_hash(chunk_coord));
+
+	if (drawable_idx == ChunkDirectory::k_empty_slot)
+		return;
+
+	chunk_drawable_set.cull_tree.remove(drawable_idx);
+}
+
+
+// NOTE: covers the non empty tiles of a chunk with greedy rectangles, one bit mask per row.
+//       on_rect(x_beg, z_beg, x_end, z_end) gets half open local tile ranges
+
+template <typename RectFn>
+void for_each_filled_rect(const TileChunk& chunk, RectFn&& on_rect)
+{
+	static_assert(cfg::chunk_size == 32, "[tile] filled rects keep one row per 32 bit mask");
+
+	std::array<uint32_t, cfg::chunk_size> rows {};
+
+	for (int32_t z = 0; z < cfg::chunk_size; ++z) {
+		for (int32_t x = 0; x < cfg::chunk_size; ++x) {
+			if (chunk.tiles[get_local_index(x, z)] != 0)
+				rows[static_cast<size_t>(z)] |= 1U << x;
+		}
+	}
+
+	for (int32_t z = 0; z < cfg::chunk_size; ++z) {
+		while (rows[static_cast<size_t>(z)] != 0) {
+
+			const uint32_t row = rows[static_cast<size_t>(z)];
+
+			const int32_t x_beg = std::countr_zero(row);
+			const int32_t run   = std::countr_one(row >> x_beg);
+
+			const uint32_t span = (run == 32 ? ~0U : ((1U << run) - 1U)) << x_beg;
+
+			int32_t z_end = z + 1;
+			while (z_end < cfg::chunk_size && (rows[static_cast<size_t>(z_end)] & span) == span)
+				++z_end;
+
+			for (int32_t span_z = z; span_z < z_end; ++span_z)
+				rows[static_cast<size_t>(span_z)] &= ~span;
+
+			on_rect(x_beg, z, x_beg + run, z_end);
+		}
+	}
 }
 
 
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+#include "job_latch.hpp"
+#include "scheduler.hpp"
+
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "chunk_directory.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr int32_t  tile_sim_padded_size = chunk_size + 2;
+	inline constexpr uint32_t tile_sim_padded_area = static_cast<uint32_t>(tile_sim_padded_size * tile_sim_padded_size);
+
+	inline constexpr float    tile_sim_tick_interval       = 1.0f / 20.0f;
+	inline constexpr uint32_t tile_sim_max_ticks_per_frame = 4U;
+	inline constexpr uint32_t tile_sim_job_grain           = 4U;
+
+} // hpr::scn::cfg
+
+
+// NOTE: kernel input is the front chunk with a one tile halo from its 8 neighbours, missing
+//       neighbours read 0. local (x, z) sits at padded[(z + 1) * tile_sim_padded_size + x + 1]
+
+struct TileSimChunkInput
+{
+	TileChunkCoord  coord;
+	const TileType* padded;
+	uint64_t        tick;
+};
+
+
+// NOTE: writes all chunk_area tiles of the next state, runs on scheduler workers. sleeping
+//       chunks assume the result depends on the padded input only, tick is informational
+
+using TileSimKernelFn = void (*)(const TileSimChunkInput& input, TileType* out_tiles, const void* rule_data);
+
+
+// NOTE: fixed rate double buffered tile step. the back field only holds chunks that have been
+//       stepped, a changed chunk swaps its tile storage with its back twin after all jobs joined,
+//       so jobs never see a half written tick. chunks that did not change go to sleep, changed
+//       chunks wake themselves and their neighbours for the next tick
+
+class TileSimulation
+{
+public:
+
+	void clear()
+	{
+		m_back.clear();
+
+		m_active.clear();
+		m_active_index.clear();
+		m_changed.clear();
+
+		m_accumulator = 0.0f;
+		m_tick        = 0;
+	}
+
+
+	void set_kernel(TileSimKernelFn kernel_fn, const void* rule_data)
+	{
+		m_kernel_fn = kernel_fn;
+		m_rule_data = rule_data;
+	}
+
+
+	void activate(TileChunkCoord chunk_coord)
+	{
+		const uint64_t key = get_chunk_coord_hash(chunk_coord);
+
+		if (m_active_index.find(key) != ChunkDirectory::k_empty_slot)
+			return;
+
+		m_active_index.insert(key, static_cast<uint32_t>(m_active.size()));
+		m_active.emplace_back(chunk_coord);
+	}
+
+
+	void activate(TileCoord coord)
+	{
+		activate(get_chunk_coord(coord));
+	}
+
+
+	[[nodiscard]] uint32_t active_count() const
+	{
+		return static_cast<uint32_t>(m_active.size());
+	}
+
+
+	[[nodiscard]] uint64_t tick() const
+	{
+		return m_tick;
+	}
+
+
+	// NOTE: chunks whose tiles changed during the last tick
+
+	[[nodiscard]] const mtp::vault<TileChunkCoord, mtp::default_set>& changed_chunks() const
+	{
+		return m_changed;
+	}
+
+
+	template <typename MarkDirtyFn>
+	uint32_t advance(float delta_time, job::Scheduler& job_scheduler, TileField& front, MarkDirtyFn&& mark_dirty)
+	{
+		m_accumulator += delta_time;
+
+		uint32_t tick_count = 0;
+
+		while (m_accumulator >= cfg::tile_sim_tick_interval && tick_count < cfg::tile_sim_max_ticks_per_frame) {
+			step(job_scheduler, front, mark_dirty);
+			m_accumulator -= cfg::tile_sim_tick_interval;
+			++tick_count;
+		}
+
+		// NOTE: drop the backlog after a long frame instead of spiralling
+
+		m_accumulator = std::min(m_accumulator, cfg::tile_sim_tick_interval);
+
+		return tick_count;
+	}
+
+
+	template <typename MarkDirtyFn>
+	void step(job::Scheduler& job_scheduler, TileField& front, MarkDirtyFn&& mark_dirty)
+	{
+		m_changed.clear();
+
+		if (!m_kernel_fn || m_active.empty())
+			return;
+
+		++m_tick;
+
+		m_tasks.clear();
+
+		for (const TileChunkCoord& chunk_coord : m_active) {
+			if (front.find_chunk(chunk_coord)) {
+				(void) m_back.ensure_chunk(chunk_coord, 0);
+				m_tasks.emplace_back(StepTask {.coord = chunk_coord});
+			}
+		}
+
+		// NOTE: back chunk pointers only after every ensure_chunk, the vault may have moved
+
+		for (StepTask& task : m_tasks)
+			task.back_tiles = m_back.find_chunk(task.coord)->tiles.data();
+
+		const uint32_t task_count = static_cast<uint32_t>(m_tasks.size());
+		const uint32_t job_count  = (task_count + cfg::tile_sim_job_grain - 1) / cfg::tile_sim_job_grain;
+
+		m_slices.resize(job_count);
+		m_padded.resize(job_count * cfg::tile_sim_padded_area);
+
+		for (uint32_t job_idx = 0; job_idx < job_count; ++job_idx) {
+
+			StepJobSlice& slice = m_slices[job_idx];
+
+			slice.tasks     = m_tasks.data();
+			slice.front     = &front;
+			slice.padded    = m_padded.data() + job_idx * cfg::tile_sim_padded_area;
+			slice.kernel_fn = m_kernel_fn;
+			slice.rule_data = m_rule_data;
+			slice.tick      = m_tick;
+		}
+
+		job::JobLatch job_latch;
+
+		job_scheduler.dispatch_range(
+			job_latch,
+			&step_chunks,
+			task_count,
+			cfg::tile_sim_job_grain,
+			m_slices.data()
+		);
+
+		job_latch.wait();
+
+		m_active.clear();
+		m_active_index.clear();
+
+		for (const StepTask& task : m_tasks) {
+
+			if (!task.changed)
+				continue;
+
+			TileChunk* front_chunk = front.find_chunk(task.coord);
+			TileChunk* back_chunk  = m_back.find_chunk(task.coord);
+
+			std::swap(front_chunk->tiles, back_chunk->tiles);
+
+			m_changed.emplace_back(task.coord);
+			mark_dirty(task.coord);
+
+			for (int32_t offset_z = -1; offset_z <= 1; ++offset_z) {
+				for (int32_t offset_x = -1; offset_x <= 1; ++offset_x) {
+
+					const TileChunkCoord neighbour_coord {
+						.chunk_x      = task.coord.chunk_x + offset_x,
+						.chunk_z      = task.coord.chunk_z + offset_z,
+						.storey_index = task.coord.storey_index,
+						.storey_stack = task.coord.storey_stack
+					};
+
+					if (front.find_chunk(neighbour_coord))
+						activate(neighbour_coord);
+				}
+			}
+		}
+	}
+
+private:
+
+	struct StepTask
+	{
+		TileChunkCoord coord      {};
+		TileType*      back_tiles {nullptr};
+		bool           changed    {false};
+	};
+
+	struct StepJobSlice
+	{
+		uint32_t begin;
+		uint32_t end;
+
+		StepTask*        tasks;
+		const TileField* front;
+		TileType*        padded;
+
+		TileSimKernelFn kernel_fn;
+		const void*     rule_data;
+		uint64_t        tick;
+	};
+
+
+	static void gather_padded(const TileField& front, TileChunkCoord chunk_coord, TileType* padded)
+	{
+		static constexpr int32_t s = cfg::chunk_size;
+		static constexpr int32_t p = cfg::tile_sim_padded_size;
+
+		for (int32_t offset_z = -1; offset_z <= 1; ++offset_z) {
+
+			const int32_t local_z_beg = (offset_z < 0) ? s - 1 : 0;
+			const int32_t local_z_end = (offset_z > 0) ? 1 : s;
+
+			for (int32_t offset_x = -1; offset_x <= 1; ++offset_x) {
+
+				const int32_t local_x_beg = (offset_x < 0) ? s - 1 : 0;
+				const int32_t local_x_end = (offset_x > 0) ? 1 : s;
+				const int32_t row_count   = local_x_end - local_x_beg;
+
+				const TileChunk* chunk = front.find_chunk(TileChunkCoord {
+					.chunk_x      = chunk_coord.chunk_x + offset_x,
+					.chunk_z      = chunk_coord.chunk_z + offset_z,
+					.storey_index = chunk_coord.storey_index,
+					.storey_stack = chunk_coord.storey_stack
+				});
+
+				for (int32_t local_z = local_z_beg; local_z < local_z_end; ++local_z) {
+
+					const int32_t padded_x = offset_x * s + local_x_beg + 1;
+					const int32_t padded_z = offset_z * s + local_z + 1;
+
+					TileType* row_out = padded + padded_z * p + padded_x;
+
+					if (chunk)
+						std::copy_n(chunk->tiles.data() + get_local_index(local_x_beg, local_z), row_count, row_out);
+					else
+						std::fill_n(row_out, row_count, TileType {0});
+				}
+			}
+		}
+	}
+
+
+	static void step_chunks(void* slice_raw)
+	{
+		auto* slice = static_cast<StepJobSlice*>(slice_raw);
+
+		for (uint32_t task_idx = slice->begin; task_idx < slice->end; ++task_idx) {
+
+			StepTask& task = slice->tasks[task_idx];
+
+			gather_padded(*slice->front, task.coord, slice->padded);
+
+			const TileSimChunkInput input {
+				.coord  = task.coord,
+				.padded = slice->padded,
+				.tick   = slice->tick
+			};
+
+			slice->kernel_fn(input, task.back_tiles, slice->rule_data);
+
+			const TileChunk* front_chunk = slice->front->find_chunk(task.coord);
+
+			task.changed = std::memcmp(
+				front_chunk->tiles.data(),
+				task.back_tiles,
+				static_cast<size_t>(cfg::chunk_area) * sizeof(TileType)
+			) != 0;
+		}
+	}
+
+private:
+
+	TileField m_back;
+
+	mtp::vault<TileChunkCoord, mtp::default_set> m_active;
+	ChunkDirectory                               m_active_index;
+
+	mtp::vault<TileChunkCoord, mtp::default_set> m_changed;
+
+	mtp::vault<StepTask,     mtp::default_set> m_tasks;
+	mtp::vault<StepJobSlice, mtp::default_set> m_slices;
+	mtp::vault<TileType,     mtp::default_set> m_padded;
+
+	TileSimKernelFn m_kernel_fn {nullptr};
+	const void*     m_rule_data {nullptr};
+
+	float    m_accumulator {0.0f};
+	uint64_t m_tick        {0};
+};
+
+
+// NOTE: a medium tile with a source tile on one of its four sides turns into source, one tile
+//       per tick. everything else is copied through
+
+struct TileSpreadRule
+{
+	TileType source;
+	TileType medium;
+};
+
+
+inline void tile_spread_kernel(const TileSimChunkInput& input, TileType* out_tiles, const void* rule_data)
+{
+	static constexpr int32_t p = cfg::tile_sim_padded_size;
+
+	const auto* rule = static_cast<const TileSpreadRule*>(rule_data);
+
+	for (int32_t local_z = 0; local_z < cfg::chunk_size; ++local_z) {
+
+		const TileType* row = input.padded + (local_z + 1) * p + 1;
+
+		for (int32_t local_x = 0; local_x < cfg::chunk_size; ++local_x) {
+
+			const TileType* center = row + local_x;
+
+			const bool spreads =
+				*center == rule->medium &&
+				(center[-1] == rule->source || center[1] == rule->source ||
+				 center[-p] == rule->source || center[p] == rule->source);
+
+			out_tiles[get_local_index(local_x, local_z)] = spreads ? rule->source : *center;
+		}
+	}
+}
+
+
+} // hpr::scn
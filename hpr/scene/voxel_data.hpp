@@ -6,11 +6,13 @@
 
 #include "mtp_memory.hpp"
 
+#include "voxel_palette.hpp"
+
 
 namespace hpr::scn {
 
 
-using VoxelType = uint16_t;
+using VoxelType = VoxelPalette::Value;
 
 
 struct VoxelCoord
@@ -41,9 +43,7 @@ struct VoxelChunk
 	VoxelChunkCoord coord;
 	uint64_t        key;
 
-	// NOTE: ? storage: dense/sparse cube / rle / palette
-
-	mtp::vault<VoxelType, mtp::default_set> voxels;
+	VoxelPalette voxels;
 };
 
 
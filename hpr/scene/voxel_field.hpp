@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
 
 #include "panic.hpp"
 #include "mtp_memory.hpp"
@@ -8,6 +9,7 @@
 #include "math.hpp"
 
 #include "voxel_data.hpp"
+#include "voxel_palette.hpp"
 
 
 namespace hpr::scn {
@@ -19,11 +21,24 @@ public:
 
 	static constexpr int32_t k_chunk_size = 32;
 
+	static constexpr uint32_t k_chunk_volume =
+		static_cast<uint32_t>(k_chunk_size) *
+		static_cast<uint32_t>(k_chunk_size) *
+		static_cast<uint32_t>(k_chunk_size);
+
 	struct VoxelChunk
 	{
 		VoxelChunkCoord coord {};
 		uint64_t        key   {};
-		mtp::vault<VoxelType, mtp::default_set> voxels;
+		VoxelPalette    voxels;
+	};
+
+	// NOTE: grows with every chunk created and resets when the field empties, eviction leaves it conservative
+
+	struct ChunkExtent
+	{
+		VoxelChunkCoord min {};
+		VoxelChunkCoord max {};
 	};
 
 	using IndexMap = decltype(mtp::make_unordered_map<uint64_t, uint32_t, mtp::default_set>());
@@ -34,6 +49,8 @@ public:
 	{
 		m_chunks.clear();
 		m_index.clear();
+
+		m_chunk_extent = {};
 	}
 
 	[[nodiscard]] bool empty() const
@@ -41,6 +58,11 @@ public:
 		return m_chunks.empty();
 	}
 
+	[[nodiscard]] const ChunkExtent& chunk_extent() const
+	{
+		return m_chunk_extent;
+	}
+
 	[[nodiscard]] static int32_t floor_div(int32_t value, int32_t divisor)
 	{
 		HPR_ASSERT_MSG(divisor > 0, "[voxelfield] divisor <= 0");
@@ -88,42 +110,107 @@ public:
 			return 0;
 
 		const uint32_t idx = local_index(coord, chunk_coord);
-		return chunk->voxels[idx];
+		return chunk->voxels.get(idx);
 	}
 
 	void set(VoxelCoord coord, VoxelType voxel_type)
 	{
 		const VoxelChunkCoord chunk_coord = chunk_of(coord);
+
+		// NOTE: missing chunks already read as 0
+
+		if (voxel_type == 0 && !find_chunk(key_of(chunk_coord)))
+			return;
+
 		VoxelChunk& chunk = ensure_chunk(chunk_coord, 0);
 
 		const uint32_t idx = local_index(coord, chunk_coord);
-		chunk.voxels[idx] = voxel_type;
+		chunk.voxels.set(idx, voxel_type);
 	}
 
-	[[nodiscard]] VoxelType* get_ptr(VoxelCoord coord)
+	[[nodiscard]] const VoxelChunk* find_chunk(VoxelChunkCoord chunk_coord) const
 	{
-		const VoxelChunkCoord chunk_coord = chunk_of(coord);
-		const uint64_t key = key_of(chunk_coord);
+		return find_chunk(key_of(chunk_coord));
+	}
 
-		VoxelChunk* chunk = find_chunk(key);
-		if (!chunk)
-			return nullptr;
+	[[nodiscard]] static uint32_t chunk_local_index(uint32_t local_x, uint32_t local_y, uint32_t local_z)
+	{
+		const uint32_t s = static_cast<uint32_t>(k_chunk_size);
+		return local_x + local_z * s + local_y * s * s;
+	}
 
-		const uint32_t idx = local_index(coord, chunk_coord);
-		return &chunk->voxels[idx];
+	// NOTE: direct encoded chunks only narrow back to a palette here
+
+	void compact()
+	{
+		for (VoxelChunk& chunk : m_chunks)
+			chunk.voxels.compact();
 	}
 
-	[[nodiscard]] const VoxelType* get_ptr(VoxelCoord coord) const
+	[[nodiscard]] size_t memory_bytes() const
+	{
+		size_t bytes = m_chunks.size() * sizeof(VoxelChunk);
+
+		for (const VoxelChunk& chunk : m_chunks)
+			bytes += chunk.voxels.memory_bytes();
+
+		return bytes;
+	}
+
+	VoxelChunk& ensure_chunk(VoxelChunkCoord chunk_coord, VoxelType fill_value)
 	{
-		const VoxelChunkCoord chunk_coord = chunk_of(coord);
 		const uint64_t key = key_of(chunk_coord);
 
-		const VoxelChunk* chunk = find_chunk(key);
-		if (!chunk)
-			return nullptr;
+		if (VoxelChunk* existing = find_chunk(key))
+			return *existing;
 
-		const uint32_t idx = local_index(coord, chunk_coord);
-		return &chunk->voxels[idx];
+		VoxelChunk chunk {};
+		chunk.coord = chunk_coord;
+		chunk.key   = key;
+
+		chunk.voxels.reset(k_chunk_volume, fill_value);
+
+		if (m_chunks.empty()) {
+			m_chunk_extent.min = chunk_coord;
+			m_chunk_extent.max = chunk_coord;
+		}
+		else {
+			m_chunk_extent.min.chunk_x = std::min(m_chunk_extent.min.chunk_x, chunk_coord.chunk_x);
+			m_chunk_extent.min.chunk_y = std::min(m_chunk_extent.min.chunk_y, chunk_coord.chunk_y);
+			m_chunk_extent.min.chunk_z = std::min(m_chunk_extent.min.chunk_z, chunk_coord.chunk_z);
+			m_chunk_extent.max.chunk_x = std::max(m_chunk_extent.max.chunk_x, chunk_coord.chunk_x);
+			m_chunk_extent.max.chunk_y = std::max(m_chunk_extent.max.chunk_y, chunk_coord.chunk_y);
+			m_chunk_extent.max.chunk_z = std::max(m_chunk_extent.max.chunk_z, chunk_coord.chunk_z);
+		}
+
+		const uint32_t new_index = static_cast<uint32_t>(m_chunks.size());
+		m_chunks.emplace_back(std::move(chunk));
+		m_index[key] = new_index;
+
+		return m_chunks.back();
+	}
+
+	// NOTE: swap-removes the chunk, the last chunk takes over its slot so chunk pointers are not stable
+
+	bool evict_chunk(VoxelChunkCoord chunk_coord)
+	{
+		auto it = m_index.find(key_of(chunk_coord));
+		if (it == m_index.end())
+			return false;
+
+		const uint32_t idx = it->second;
+		m_index.erase(it);
+
+		const uint32_t last_idx = static_cast<uint32_t>(m_chunks.size() - 1);
+
+		if (idx != last_idx) {
+			m_chunks[idx] = std::move(m_chunks[last_idx]);
+			m_index[m_chunks[idx].key] = idx;
+		}
+
+		m_chunks.pop_back();
+
+		return true;
 	}
 
 private:
@@ -142,12 +229,11 @@ private:
 		HPR_ASSERT_MSG(local_y >= 0 && local_y < k_chunk_size, "[voxelfield] local_y out of range");
 		HPR_ASSERT_MSG(local_z >= 0 && local_z < k_chunk_size, "[voxelfield] local_z out of range");
 
-		const uint32_t x = static_cast<uint32_t>(local_x);
-		const uint32_t y = static_cast<uint32_t>(local_y);
-		const uint32_t z = static_cast<uint32_t>(local_z);
-
-		const uint32_t s = static_cast<uint32_t>(k_chunk_size);
-		return x + z * s + y * s * s;
+		return chunk_local_index(
+			static_cast<uint32_t>(local_x),
+			static_cast<uint32_t>(local_y),
+			static_cast<uint32_t>(local_z)
+		);
 	}
 
 	[[nodiscard]] VoxelChunk* find_chunk(uint64_t key)
@@ -172,41 +258,14 @@ private:
 		return &m_chunks[idx];
 	}
 
-	VoxelChunk& ensure_chunk(VoxelChunkCoord chunk_coord, VoxelType fill_value)
-	{
-		const uint64_t key = key_of(chunk_coord);
-
-		if (VoxelChunk* existing = find_chunk(key))
-			return *existing;
-
-		VoxelChunk chunk {};
-		chunk.coord = chunk_coord;
-		chunk.key   = key;
-
-		const uint32_t count =
-			static_cast<uint32_t>(k_chunk_size) *
-			static_cast<uint32_t>(k_chunk_size) *
-			static_cast<uint32_t>(k_chunk_size);
-
-		chunk.voxels.reserve(count);
-
-		for (uint32_t i = 0; i < count; ++i)
-			chunk.voxels.emplace_back(fill_value);
-
-		const uint32_t new_index = static_cast<uint32_t>(m_chunks.size());
-		m_chunks.emplace_back(std::move(chunk));
-		m_index[key] = new_index;
-
-		return m_chunks.back();
-	}
-
 private:
 
 	mtp::vault<VoxelChunk, mtp::default_set> m_chunks;
 
 	IndexMap m_index {mtp::make_unordered_map<uint64_t, uint32_t, mtp::default_set>()};
+
+	ChunkExtent m_chunk_extent {};
 };
 
 
 } // hpr::scn
-
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+
+#include "mtp_memory.hpp"
+
+#include "math.hpp"
+#include "voxel_data.hpp"
+#include "voxel_field.hpp"
+#include "render_data.hpp"
+
+
+namespace hpr::scn {
+
+
+namespace cfg {
+
+	inline constexpr int32_t  voxel_mesh_padded_size   = VoxelField::k_chunk_size + 2;
+	inline constexpr uint32_t voxel_mesh_padded_volume =
+		static_cast<uint32_t>(voxel_mesh_padded_size * voxel_mesh_padded_size * voxel_mesh_padded_size);
+
+} // hpr::scn::cfg
+
+
+// NOTE: per job scratch, reused across frames so meshing does not allocate once warm
+
+struct VoxelMeshBuffer
+{
+	mtp::vault<rdr::SceneVertex, mtp::default_set> vertices;
+	mtp::vault<uint32_t,         mtp::default_set> indices;
+
+	mtp::vault<VoxelType, mtp::default_set> dense;
+	mtp::vault<VoxelType, mtp::default_set> padded;
+	mtp::vault<int32_t,   mtp::default_set> face_mask;
+
+	void clear()
+	{
+		vertices.clear();
+		indices.clear();
+	}
+};
+
+
+namespace detail {
+
+	[[nodiscard]] inline uint32_t padded_index(int32_t x, int32_t y, int32_t z)
+	{
+		static constexpr uint32_t p = static_cast<uint32_t>(cfg::voxel_mesh_padded_size);
+
+		return static_cast<uint32_t>(x + 1)
+			+ static_cast<uint32_t>(z + 1) * p
+			+ static_cast<uint32_t>(y + 1) * p * p;
+	}
+
+
+	// NOTE: copies the face layer of a neighbour chunk into the padding, axis/side pick the face
+
+	inline void fill_padding_face(
+		const VoxelField&      voxelfield,
+		const VoxelChunkCoord& chunk_coord,
+		int32_t                axis,
+		int32_t                side,
+		VoxelType*             padded
+	)
+	{
+		static constexpr int32_t s = VoxelField::k_chunk_size;
+
+		VoxelChunkCoord neighbour_coord = chunk_coord;
+
+		if (axis == 0) neighbour_coord.chunk_x += side;
+		if (axis == 1) neighbour_coord.chunk_y += side;
+		if (axis == 2) neighbour_coord.chunk_z += side;
+
+		const VoxelField::VoxelChunk* neighbour = voxelfield.find_chunk(neighbour_coord);
+
+		const int32_t pad_layer    = (side > 0) ? s : -1;
+		const int32_t source_layer = (side > 0) ? 0 : s - 1;
+
+		const int32_t axis_u = (axis + 1) % 3;
+		const int32_t axis_v = (axis + 2) % 3;
+
+		for (int32_t j = 0; j < s; ++j) {
+			for (int32_t i = 0; i < s; ++i) {
+
+				int32_t pad[3];
+				pad[axis]   = pad_layer;
+				pad[axis_u] = i;
+				pad[axis_v] = j;
+
+				VoxelType voxel = 0;
+
+				if (neighbour) {
+					int32_t source[3];
+					source[axis]   = source_layer;
+					source[axis_u] = i;
+					source[axis_v] = j;
+
+					voxel = neighbour->voxels.get(VoxelField::chunk_local_index(
+						static_cast<uint32_t>(source[0]),
+						static_cast<uint32_t>(source[1]),
+						static_cast<uint32_t>(source[2])
+					));
+				}
+
+				padded[padded_index(pad[0], pad[1], pad[2])] = voxel;
+			}
+		}
+	}
+
+
+	inline void emit_quad(
+		VoxelMeshBuffer& out,
+		int32_t          axis,
+		bool             positive,
+		const int32_t    origin[3],
+		int32_t          extent_u,
+		int32_t          extent_v,
+		VoxelType        voxel,
+		float            voxel_size
+	)
+	{
+		const int32_t axis_u = (axis + 1) % 3;
+		const int32_t axis_v = (axis + 2) % 3;
+
+		vec3 corner {
+			static_cast<float>(origin[0]),
+			static_cast<float>(origin[1]),
+			static_cast<float>(origin[2])
+		};
+		corner *= voxel_size;
+
+		vec3 du {0.0f};
+		vec3 dv {0.0f};
+		du[axis_u] = static_cast<float>(extent_u) * voxel_size;
+		dv[axis_v] = static_cast<float>(extent_v) * voxel_size;
+
+		vec3 normal {0.0f};
+		normal[axis] = positive ? 1.0f : -1.0f;
+
+		vec4 tangent {0.0f, 0.0f, 0.0f, 1.0f};
+		tangent[axis_u] = 1.0f;
+
+		const float uv_u = static_cast<float>(extent_u);
+		const float uv_v = static_cast<float>(extent_v);
+
+		const vec3 positions[4] { corner, corner + du, corner + du + dv, corner + dv };
+		const vec2 uvs[4]       { {0.0f, 0.0f}, {uv_u, 0.0f}, {uv_u, uv_v}, {0.0f, uv_v} };
+
+		const uint32_t base = static_cast<uint32_t>(out.vertices.size());
+
+		for (uint32_t corner_idx = 0; corner_idx < 4; ++corner_idx) {
+			out.vertices.emplace_back(rdr::SceneVertex {
+				.tan  = tangent,
+				.pos  = positions[corner_idx],
+				.nrm  = normal,
+				.uv0  = uvs[corner_idx],
+				.uv1  = vec2 {0.0f},
+				.rgba = 0xFFFFFFFFU,
+				.ext  = voxel
+			});
+		}
+
+		// NOTE: (u, v, axis) is right handed, ccw seen from +axis
+
+		if (positive) {
+			out.indices.emplace_back(base + 0); out.indices.emplace_back(base + 1); out.indices.emplace_back(base + 2);
+			out.indices.emplace_back(base + 0); out.indices.emplace_back(base + 2); out.indices.emplace_back(base + 3);
+		}
+		else {
+			out.indices.emplace_back(base + 0); out.indices.emplace_back(base + 2); out.indices.emplace_back(base + 1);
+			out.indices.emplace_back(base + 0); out.indices.emplace_back(base + 3); out.indices.emplace_back(base + 2);
+		}
+	}
+
+} // hpr::scn::detail
+
+
+// NOTE: greedy meshing, any non-zero voxel is opaque, faces between equal types merge;
+//       positions are chunk local in world units, the drawable carries the chunk origin
+
+inline void build_voxel_chunk_mesh(
+	const VoxelField&     voxelfield,
+	const VoxelChunkCoord chunk_coord,
+	const float           voxel_size,
+	VoxelMeshBuffer&      out
+)
+{
+	static constexpr int32_t s = VoxelField::k_chunk_size;
+
+	out.clear();
+
+	const VoxelField::VoxelChunk* chunk = voxelfield.find_chunk(chunk_coord);
+
+	if (!chunk || (chunk->voxels.uniform() && chunk->voxels.get(0) == 0))
+		return;
+
+	out.dense.resize(VoxelField::k_chunk_volume);
+	out.padded.resize(cfg::voxel_mesh_padded_volume);
+	out.face_mask.resize(static_cast<uint32_t>(s * s));
+
+	chunk->voxels.decode(out.dense.data());
+
+	VoxelType* padded = out.padded.data();
+
+	for (int32_t y = 0; y < s; ++y) {
+		for (int32_t z = 0; z < s; ++z) {
+			const uint32_t row = VoxelField::chunk_local_index(0, static_cast<uint32_t>(y), static_cast<uint32_t>(z));
+			std::copy_n(out.dense.data() + row, s, padded + detail::padded_index(0, y, z));
+		}
+	}
+
+	for (int32_t axis = 0; axis < 3; ++axis) {
+		detail::fill_padding_face(voxelfield, chunk_coord, axis, -1, padded);
+		detail::fill_padding_face(voxelfield, chunk_coord, axis,  1, padded);
+	}
+
+	static constexpr int32_t p = cfg::voxel_mesh_padded_size;
+	static constexpr int32_t padded_stride[3] {1, p * p, p};
+
+	int32_t* face_mask = out.face_mask.data();
+
+	for (int32_t axis = 0; axis < 3; ++axis) {
+
+		const int32_t axis_u = (axis + 1) % 3;
+		const int32_t axis_v = (axis + 2) % 3;
+
+		const int32_t stride_axis = padded_stride[axis];
+		const int32_t stride_u    = padded_stride[axis_u];
+		const int32_t stride_v    = padded_stride[axis_v];
+
+		// NOTE: boundary layer n sits between voxels n - 1 and n, positive mask = +axis face
+
+		for (int32_t layer = 0; layer <= s; ++layer) {
+
+			const VoxelType* layer_front = padded + detail::padded_index(0, 0, 0) + layer * stride_axis;
+
+			const bool back_inside  = layer > 0;
+			const bool front_inside = layer < s;
+
+			// NOTE: chunk_size is 32 so one bit per column tracks the unmerged faces of a row
+
+			static_assert(VoxelField::k_chunk_size == 32, "[voxelmesher] row bits assume 32 wide chunks");
+
+			uint32_t row_bits[s];
+			uint32_t layer_bits = 0;
+
+			for (int32_t j = 0; j < s; ++j) {
+
+				const VoxelType* front_row = layer_front + j * stride_v;
+				int32_t*         mask_row  = face_mask + j * s;
+
+				uint32_t bits = 0;
+
+				for (int32_t i = 0; i < s; ++i) {
+
+					const VoxelType front = front_row[i * stride_u];
+					const VoxelType back  = front_row[i * stride_u - stride_axis];
+
+					const bool back_face  = back_inside  && back  != 0 && front == 0;
+					const bool front_face = front_inside && front != 0 && back  == 0;
+
+					mask_row[i] = back_face ? static_cast<int32_t>(back) : (front_face ? -static_cast<int32_t>(front) : 0);
+
+					bits |= static_cast<uint32_t>(back_face || front_face) << i;
+				}
+
+				row_bits[j] = bits;
+				layer_bits |= bits;
+			}
+
+			if (layer_bits == 0)
+				continue;
+
+			for (int32_t j = 0; j < s; ++j) {
+				while (row_bits[j] != 0) {
+
+					const int32_t i = std::countr_zero(row_bits[j]);
+					const int32_t mask = face_mask[i + j * s];
+
+					int32_t extent_u = 1;
+					while (i + extent_u < s
+						&& (row_bits[j] >> (i + extent_u) & 1U)
+						&& face_mask[i + extent_u + j * s] == mask) {
+						++extent_u;
+					}
+
+					const uint32_t span_bits = (extent_u == 32) ? 0xFFFFFFFFU : (((1U << extent_u) - 1U) << i);
+
+					int32_t extent_v = 1;
+					for (; j + extent_v < s; ++extent_v) {
+
+						if ((row_bits[j + extent_v] & span_bits) != span_bits)
+							break;
+
+						const int32_t* row = face_mask + (j + extent_v) * s;
+
+						bool row_matches = true;
+						for (int32_t k = 0; k < extent_u; ++k) {
+							if (row[i + k] != mask) {
+								row_matches = false;
+								break;
+							}
+						}
+
+						if (!row_matches)
+							break;
+					}
+
+					int32_t origin[3];
+					origin[axis]   = layer;
+					origin[axis_u] = i;
+					origin[axis_v] = j;
+
+					const bool positive = mask > 0;
+					const VoxelType voxel = static_cast<VoxelType>(positive ? mask : -mask);
+
+					detail::emit_quad(out, axis, positive, origin, extent_u, extent_v, voxel, voxel_size);
+
+					for (int32_t row_v = 0; row_v < extent_v; ++row_v)
+						row_bits[j + row_v] &= ~span_bits;
+				}
+			}
+		}
+	}
+}
+
+
+} // hpr::scn
@@ -0,0 +1,492 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "mtp_memory.hpp"
+
+
+namespace hpr::scn {
+
+
+// NOTE: palette indices bit-packed at 0/1/2/4/8 bits per voxel, widths divide 64 so no index
+//       straddles a word; above 256 live values the chunk stores raw 16 bit values instead
+//       and only narrows again through compact()
+
+class VoxelPalette
+{
+public:
+
+	using Value = uint16_t;
+
+	static constexpr uint32_t k_direct_bits      = 16U;
+	static constexpr uint32_t k_max_palette_bits = 8U;
+
+public:
+
+	void reset(uint32_t count, Value fill_value)
+	{
+		m_count = count;
+		m_bits  = 0;
+
+		m_words.clear();
+		m_palette.clear();
+		m_refs.clear();
+
+		m_palette.emplace_back(fill_value);
+		m_refs.emplace_back(count);
+
+		m_live = 1;
+	}
+
+
+	[[nodiscard]] uint32_t count() const
+	{
+		return m_count;
+	}
+
+
+	[[nodiscard]] uint32_t bits() const
+	{
+		return m_bits;
+	}
+
+
+	[[nodiscard]] bool uniform() const
+	{
+		return m_bits == 0;
+	}
+
+
+	[[nodiscard]] uint32_t palette_size() const
+	{
+		return m_bits == k_direct_bits ? 0U : m_live;
+	}
+
+
+	[[nodiscard]] size_t memory_bytes() const
+	{
+		return m_words.size()   * sizeof(uint64_t)
+			 + m_palette.size() * sizeof(Value)
+			 + m_refs.size()    * sizeof(uint32_t);
+	}
+
+
+	[[nodiscard]] Value get(uint32_t index) const
+	{
+		HPR_ASSERT_MSG(index < m_count, "[voxelpalette] index out of range");
+
+		if (m_bits == 0)
+			return m_palette[0];
+
+		const uint32_t packed = read_packed(index);
+
+		return m_bits == k_direct_bits ? static_cast<Value>(packed) : m_palette[packed];
+	}
+
+
+	void set(uint32_t index, Value value)
+	{
+		HPR_ASSERT_MSG(index < m_count, "[voxelpalette] index out of range");
+
+		if (m_bits == k_direct_bits) {
+			write_packed(index, value);
+			return;
+		}
+
+		const uint32_t old_entry = (m_bits == 0) ? 0U : read_packed(index);
+		if (m_palette[old_entry] == value)
+			return;
+
+		uint32_t entry = find_entry(value);
+
+		if (entry == k_no_entry) {
+			entry = claim_entry(value);
+
+			if (m_bits == k_direct_bits) {
+				write_packed(index, value);
+				return;
+			}
+		}
+
+		write_packed(index, entry);
+		++m_refs[entry];
+
+		release_entry(old_entry);
+	}
+
+
+	void decode(Value* out) const
+	{
+		if (m_bits == 0) {
+			std::fill_n(out, m_count, m_palette[0]);
+			return;
+		}
+
+		if (m_bits == k_direct_bits) {
+			for (uint32_t index = 0; index < m_count; ++index)
+				out[index] = static_cast<Value>(read_packed(index));
+			return;
+		}
+
+		const uint32_t per_word = 64U / m_bits;
+		const uint64_t mask     = (uint64_t {1} << m_bits) - 1U;
+
+		uint32_t index = 0;
+
+		for (const uint64_t word : m_words) {
+
+			uint64_t bits = word;
+			const uint32_t end = std::min(index + per_word, m_count);
+
+			for (; index < end; ++index) {
+				out[index] = m_palette[static_cast<uint32_t>(bits & mask)];
+				bits >>= m_bits;
+			}
+		}
+	}
+
+
+	// NOTE: rebuilds the narrowest encoding from the voxel contents, the only way out of direct mode
+
+	void compact()
+	{
+		if (m_bits != k_direct_bits)
+			return;
+
+		mtp::vault<uint32_t, mtp::default_set> value_refs;
+		value_refs.resize(uint32_t {1} << k_direct_bits, 0U);
+
+		uint32_t live = 0;
+
+		for (uint32_t index = 0; index < m_count; ++index) {
+			if (value_refs[read_packed(index)]++ == 0)
+				++live;
+		}
+
+		if (live > (1U << k_max_palette_bits))
+			return;
+
+		mtp::vault<Value, mtp::default_set> remap;
+		remap.resize(uint32_t {1} << k_direct_bits, Value {0});
+
+		m_palette.clear();
+		m_refs.clear();
+
+		for (uint32_t value = 0; value < value_refs.size(); ++value) {
+			if (value_refs[value] == 0)
+				continue;
+
+			remap[value] = static_cast<Value>(m_palette.size());
+
+			m_palette.emplace_back(static_cast<Value>(value));
+			m_refs.emplace_back(value_refs[value]);
+		}
+
+		m_live = live;
+
+		if (live == 1) {
+			collapse_uniform(0);
+			return;
+		}
+
+		repack(bits_for(live), remap.data());
+	}
+
+
+	// NOTE: flat image for region files - bits, entry count, palette entries, packed words;
+	//       ref counts are rebuilt on read so they never hit the disk
+
+	[[nodiscard]] size_t encoded_bytes() const
+	{
+		return k_encoded_header_bytes
+			 + m_palette.size() * sizeof(Value)
+			 + m_words.size()   * sizeof(uint64_t);
+	}
+
+
+	void write_bytes(uint8_t* out) const
+	{
+		const uint32_t entry_count = static_cast<uint32_t>(m_palette.size());
+
+		std::memcpy(out,                    &m_bits,      sizeof(uint32_t));
+		std::memcpy(out + sizeof(uint32_t), &entry_count, sizeof(uint32_t));
+		out += k_encoded_header_bytes;
+
+		if (entry_count != 0)
+			std::memcpy(out, m_palette.data(), entry_count * sizeof(Value));
+		out += entry_count * sizeof(Value);
+
+		if (!m_words.empty())
+			std::memcpy(out, m_words.data(), m_words.size() * sizeof(uint64_t));
+	}
+
+
+	[[nodiscard]] bool read_bytes(const uint8_t* data, size_t size, uint32_t count)
+	{
+		reset(count, 0);
+
+		if (size < k_encoded_header_bytes)
+			return false;
+
+		uint32_t bits        = 0;
+		uint32_t entry_count = 0;
+
+		std::memcpy(&bits,        data,                    sizeof(uint32_t));
+		std::memcpy(&entry_count, data + sizeof(uint32_t), sizeof(uint32_t));
+
+		const bool valid_bits = bits == 0 || bits == k_direct_bits || (bits <= k_max_palette_bits && (bits & (bits - 1)) == 0);
+		if (!valid_bits)
+			return false;
+
+		const uint32_t max_entries = (bits == 0) ? 1U : (bits == k_direct_bits ? 0U : (1U << bits));
+		if ((bits == k_direct_bits) ? entry_count != 0 : (entry_count == 0 || entry_count > max_entries))
+			return false;
+
+		const size_t word_count = (bits == 0) ? 0U : (static_cast<size_t>(count) * bits + 63U) / 64U;
+
+		if (size != k_encoded_header_bytes + entry_count * sizeof(Value) + word_count * sizeof(uint64_t))
+			return false;
+
+		data += k_encoded_header_bytes;
+
+		if (bits == 0) {
+			Value fill_value = 0;
+			std::memcpy(&fill_value, data, sizeof(Value));
+			reset(count, fill_value);
+			return true;
+		}
+
+		m_palette.resize(entry_count, Value {0});
+		m_refs.resize(entry_count, 0U);
+		m_words.resize(static_cast<uint32_t>(word_count), uint64_t {0});
+
+		if (entry_count != 0)
+			std::memcpy(m_palette.data(), data, entry_count * sizeof(Value));
+		std::memcpy(m_words.data(), data + entry_count * sizeof(Value), word_count * sizeof(uint64_t));
+
+		m_bits = bits;
+		m_live = 0;
+
+		if (bits == k_direct_bits)
+			return true;
+
+		for (uint32_t index = 0; index < m_count; ++index) {
+
+			const uint32_t entry = read_packed(index);
+
+			if (entry >= entry_count) {
+				reset(count, 0);
+				return false;
+			}
+
+			if (m_refs[entry]++ == 0)
+				++m_live;
+		}
+
+		if (m_live == 1) {
+			for (uint32_t entry = 0; entry < entry_count; ++entry) {
+				if (m_refs[entry] != 0) {
+					collapse_uniform(entry);
+					break;
+				}
+			}
+		}
+
+		return true;
+	}
+
+private:
+
+	static constexpr size_t   k_encoded_header_bytes = sizeof(uint32_t) * 2;
+	static constexpr uint32_t k_no_entry             = 0xFFFFFFFFU;
+
+
+	[[nodiscard]] static uint32_t bits_for(uint32_t entry_count)
+	{
+		uint32_t bits = 1;
+		while ((1U << bits) < entry_count)
+			bits <<= 1;
+
+		return bits;
+	}
+
+
+	[[nodiscard]] uint32_t read_packed(uint32_t index) const
+	{
+		const uint32_t bit   = index * m_bits;
+		const uint64_t mask  = (uint64_t {1} << m_bits) - 1U;
+		const uint64_t word  = m_words[bit >> 6];
+
+		return static_cast<uint32_t>((word >> (bit & 63U)) & mask);
+	}
+
+
+	void write_packed(uint32_t index, uint32_t packed)
+	{
+		const uint32_t bit   = index * m_bits;
+		const uint32_t shift = bit & 63U;
+		const uint64_t mask  = (uint64_t {1} << m_bits) - 1U;
+
+		uint64_t& word = m_words[bit >> 6];
+		word = (word & ~(mask << shift)) | (static_cast<uint64_t>(packed) << shift);
+	}
+
+
+	[[nodiscard]] uint32_t find_entry(Value value) const
+	{
+		for (uint32_t entry = 0; entry < m_palette.size(); ++entry) {
+			if (m_palette[entry] == value && m_refs[entry] != 0)
+				return entry;
+		}
+
+		return k_no_entry;
+	}
+
+
+	// NOTE: reuses a released slot first, widens when the current width is full
+
+	uint32_t claim_entry(Value value)
+	{
+		for (uint32_t entry = 0; entry < m_palette.size(); ++entry) {
+			if (m_refs[entry] == 0) {
+				m_palette[entry] = value;
+				++m_live;
+				return entry;
+			}
+		}
+
+		const uint32_t capacity = (m_bits == 0) ? 1U : (1U << m_bits);
+
+		if (m_palette.size() >= capacity) {
+
+			const uint32_t wider_bits = (m_bits == 0) ? 1U : (m_bits << 1);
+
+			if (wider_bits > k_max_palette_bits) {
+				repack(k_direct_bits, m_palette.data());
+
+				m_palette.clear();
+				m_refs.clear();
+				m_live = 0;
+
+				return k_no_entry;
+			}
+
+			repack(wider_bits, nullptr);
+		}
+
+		m_palette.emplace_back(value);
+		m_refs.emplace_back(0U);
+		++m_live;
+
+		return static_cast<uint32_t>(m_palette.size() - 1);
+	}
+
+
+	void release_entry(uint32_t entry)
+	{
+		HPR_ASSERT_MSG(m_refs[entry] > 0, "[voxelpalette] palette ref underflow");
+
+		if (--m_refs[entry] != 0)
+			return;
+
+		--m_live;
+
+		if (m_live == 1) {
+			for (uint32_t live_entry = 0; live_entry < m_palette.size(); ++live_entry) {
+				if (m_refs[live_entry] != 0) {
+					collapse_uniform(live_entry);
+					return;
+				}
+			}
+		}
+
+		// NOTE: narrow only with room to spare so a value flipping at the boundary does not repack every set
+
+		if (bits_for(m_live * 2) >= m_bits)
+			return;
+
+		mtp::vault<Value, mtp::default_set> remap;
+		remap.resize(static_cast<uint32_t>(m_palette.size()), Value {0});
+
+		uint32_t dst = 0;
+
+		for (uint32_t src = 0; src < m_palette.size(); ++src) {
+			if (m_refs[src] == 0)
+				continue;
+
+			remap[src] = static_cast<Value>(dst);
+
+			m_palette[dst] = m_palette[src];
+			m_refs[dst]    = m_refs[src];
+			++dst;
+		}
+
+		m_palette.resize(dst);
+		m_refs.resize(dst);
+
+		repack(bits_for(m_live), remap.data());
+	}
+
+
+	void collapse_uniform(uint32_t entry)
+	{
+		const Value value = m_palette[entry];
+
+		// NOTE: swap out the words so the packed storage is released, not just emptied
+
+		mtp::vault<uint64_t, mtp::default_set> released_words;
+		std::swap(released_words, m_words);
+
+		m_palette.clear();
+		m_refs.clear();
+
+		m_palette.emplace_back(value);
+		m_refs.emplace_back(m_count);
+
+		m_bits = 0;
+		m_live = 1;
+	}
+
+
+	// NOTE: remap translates old packed values, null keeps them as is
+
+	void repack(uint32_t new_bits, const Value* remap)
+	{
+		mtp::vault<uint64_t, mtp::default_set> old_words;
+		std::swap(old_words, m_words);
+
+		const uint32_t old_bits = m_bits;
+		const uint64_t old_mask = (old_bits == 0) ? 0U : ((uint64_t {1} << old_bits) - 1U);
+
+		m_bits = new_bits;
+		m_words.resize((m_count * new_bits + 63U) / 64U, uint64_t {0});
+
+		for (uint32_t index = 0; index < m_count; ++index) {
+
+			uint32_t packed = 0;
+
+			if (old_bits != 0) {
+				const uint32_t bit = index * old_bits;
+				packed = static_cast<uint32_t>((old_words[bit >> 6] >> (bit & 63U)) & old_mask);
+			}
+
+			write_packed(index, remap ? remap[packed] : packed);
+		}
+	}
+
+private:
+
+	mtp::vault<uint64_t, mtp::default_set> m_words;
+	mtp::vault<Value,    mtp::default_set> m_palette;
+	mtp::vault<uint32_t, mtp::default_set> m_refs;
+
+	uint32_t m_count {0};
+	uint32_t m_bits  {0};
+	uint32_t m_live  {0};
+};
+
+
+} // hpr::scn
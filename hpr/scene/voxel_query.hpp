@@ -0,0 +1,185 @@
+#pragma once
+
+#include "math.hpp"
+
+#include "voxel_data.hpp"
+#include "voxel_field.hpp"
+#include "voxel_draw_data.hpp"
+
+
+namespace hpr::scn {
+
+
+inline void mark_dirty_voxel_chunk(
+	const VoxelGridParams&      grid_params,
+	const VoxelChunkCoord       chunk_coord,
+	rdr::VoxelChunkDrawableSet& chunk_drawable_set
+)
+{
+	const uint64_t key = VoxelField::key_of(chunk_coord);
+
+	const uint32_t drawable_idx = chunk_drawable_set.index.find(key);
+
+	if (drawable_idx != ChunkDirectory::k_empty_slot) {
+
+		auto& chunk_drawable = chunk_drawable_set.drawables[drawable_idx];
+
+		if (!chunk_drawable.dirty) {
+			chunk_drawable.dirty = true;
+			chunk_drawable_set.dirty_queue.emplace_back(drawable_idx);
+		}
+
+		return;
+	}
+
+	const float chunk_extent = static_cast<float>(VoxelField::k_chunk_size) * grid_params.voxel_size;
+
+	const vec3 chunk_min = grid_params.origin_world + vec3 {
+		static_cast<float>(chunk_coord.chunk_x) * chunk_extent,
+		static_cast<float>(chunk_coord.chunk_y) * chunk_extent,
+		static_cast<float>(chunk_coord.chunk_z) * chunk_extent
+	};
+
+	const vec3 bounds_half {chunk_extent * 0.5f};
+
+	const rdr::VoxelChunkDrawable chunk_drawable {
+		.mesh          = Handle<rdr::Mesh>::null(),
+		.coord         = chunk_coord,
+		.mtx_M         = glm::translate(mat4(1.0f), chunk_min),
+		.bounds_center = chunk_min + bounds_half,
+		.bounds_half   = bounds_half,
+		.key           = key,
+		.dirty         = true
+	};
+
+	const uint32_t new_idx = static_cast<uint32_t>(chunk_drawable_set.drawables.size());
+
+	chunk_drawable_set.drawables.emplace_back(chunk_drawable);
+	chunk_drawable_set.index.insert(key, new_idx);
+	chunk_drawable_set.dirty_queue.emplace_back(new_idx);
+}
+
+
+// NOTE: an edit on a chunk face also changes the culled faces of the chunk across it
+
+inline void mark_dirty_voxel(
+	const VoxelField&           voxelfield,
+	const VoxelGridParams&      grid_params,
+	const VoxelCoord            voxel_coord,
+	rdr::VoxelChunkDrawableSet& chunk_drawable_set
+)
+{
+	const VoxelChunkCoord chunk_coord = VoxelField::chunk_of(voxel_coord);
+
+	mark_dirty_voxel_chunk(grid_params, chunk_coord, chunk_drawable_set);
+
+	const int32_t local[3] {
+		voxel_coord.x - chunk_coord.chunk_x * VoxelField::k_chunk_size,
+		voxel_coord.y - chunk_coord.chunk_y * VoxelField::k_chunk_size,
+		voxel_coord.z - chunk_coord.chunk_z * VoxelField::k_chunk_size
+	};
+
+	for (int32_t axis = 0; axis < 3; ++axis) {
+
+		int32_t step = 0;
+
+		if (local[axis] == 0)
+			step = -1;
+		else if (local[axis] == VoxelField::k_chunk_size - 1)
+			step = 1;
+
+		if (step == 0)
+			continue;
+
+		VoxelChunkCoord neighbour_coord = chunk_coord;
+
+		if (axis == 0) neighbour_coord.chunk_x += step;
+		if (axis == 1) neighbour_coord.chunk_y += step;
+		if (axis == 2) neighbour_coord.chunk_z += step;
+
+		if (voxelfield.find_chunk(neighbour_coord))
+			mark_dirty_voxel_chunk(grid_params, neighbour_coord, chunk_drawable_set);
+	}
+}
+
+
+// NOTE: the voxel write path, skips the remesh when the voxel already holds voxel_type
+
+inline void set_voxel(
+	VoxelField&                 voxelfield,
+	const VoxelGridParams&      grid_params,
+	const VoxelCoord            voxel_coord,
+	const VoxelType             voxel_type,
+	rdr::VoxelChunkDrawableSet& chunk_drawable_set
+)
+{
+	if (voxelfield.get(voxel_coord) == voxel_type)
+		return;
+
+	voxelfield.set(voxel_coord, voxel_type);
+
+	mark_dirty_voxel(voxelfield, grid_params, voxel_coord, chunk_drawable_set);
+}
+
+
+inline void mark_dirty_voxel_face_neighbours(
+	const VoxelField&           voxelfield,
+	const VoxelGridParams&      grid_params,
+	const VoxelChunkCoord       chunk_coord,
+	rdr::VoxelChunkDrawableSet& chunk_drawable_set
+)
+{
+	static constexpr int32_t face_steps [6][3] {
+		{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+	};
+
+	for (const auto& step : face_steps) {
+
+		const VoxelChunkCoord neighbour_coord {
+			chunk_coord.chunk_x + step[0],
+			chunk_coord.chunk_y + step[1],
+			chunk_coord.chunk_z + step[2]
+		};
+
+		if (voxelfield.find_chunk(neighbour_coord))
+			mark_dirty_voxel_chunk(grid_params, neighbour_coord, chunk_drawable_set);
+	}
+}
+
+
+// NOTE: for chunks created or loaded whole, e.g. as the VoxelRegionStream on_load callback.
+//       the six face neighbours lose the faces they showed towards the new chunk
+
+inline void mark_voxel_chunk_loaded(
+	const VoxelField&           voxelfield,
+	const VoxelGridParams&      grid_params,
+	const VoxelChunkCoord       chunk_coord,
+	rdr::VoxelChunkDrawableSet& chunk_drawable_set
+)
+{
+	mark_dirty_voxel_chunk(grid_params, chunk_coord, chunk_drawable_set);
+	mark_dirty_voxel_face_neighbours(voxelfield, grid_params, chunk_coord, chunk_drawable_set);
+}
+
+
+// NOTE: for chunks that left the field, e.g. as the VoxelRegionStream on_evict callback. the
+//       drawable stops drawing at once and keeps its mesh for a reload, the face neighbours
+//       get back the faces they hid towards the chunk
+
+inline void mark_voxel_chunk_evicted(
+	const VoxelField&           voxelfield,
+	const VoxelGridParams&      grid_params,
+	const VoxelChunkCoord       chunk_coord,
+	rdr::VoxelChunkDrawableSet& chunk_drawable_set
+)
+{
+	const uint32_t drawable_idx = chunk_drawable_set.index.find(VoxelField::key_of(chunk_coord));
+
+	if (drawable_idx != ChunkDirectory::k_empty_slot)
+		chunk_drawable_set.drawables[drawable_idx].idx_count = 0;
+
+	mark_dirty_voxel_face_neighbours(voxelfield, grid_params, chunk_coord, chunk_drawable_set);
+}
+
+
+} // hpr::scn
@@ -0,0 +1,243 @@
+#include <random>
+#include <cstdint>
+
+#include "mtp_memory.hpp"
+
+#include "harness.hpp"
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "chunk_directory.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+// NOTE: tile access as TileField did it before the dense grid, every read hashes the chunk
+//       coord and goes through the node based map
+
+class MapTileField
+{
+public:
+
+	explicit MapTileField(scn::TileField& tilefield)
+		: m_chunks {&tilefield.chunks()}
+		, m_chunk_map {mtp::make_unordered_map<uint64_t, uint32_t, mtp::default_set>()}
+	{
+		m_chunk_map.reserve(m_chunks->size());
+
+		for (uint32_t slot = 0; slot < m_chunks->size(); ++slot)
+			m_chunk_map[(*m_chunks)[slot].key] = slot;
+	}
+
+	[[nodiscard]] scn::TileType get(scn::TileCoord coord) const
+	{
+		const auto found = m_chunk_map.find(scn::get_chunk_coord_hash(scn::get_chunk_coord(coord)));
+		if (found == m_chunk_map.end())
+			return 0;
+
+		return (*m_chunks)[found->second].tiles[scn::get_local_index(coord)];
+	}
+
+	void set(scn::TileCoord coord, scn::TileType tile_type)
+	{
+		const auto found = m_chunk_map.find(scn::get_chunk_coord_hash(scn::get_chunk_coord(coord)));
+		if (found == m_chunk_map.end())
+			return;
+
+		(*m_chunks)[found->second].tiles[scn::get_local_index(coord)] = tile_type;
+	}
+
+private:
+
+	mtp::vault<scn::TileChunk, mtp::default_set>* m_chunks;
+
+	decltype(mtp::make_unordered_map<uint64_t, uint32_t, mtp::default_set>()) m_chunk_map;
+};
+
+
+// NOTE: 3x3 neighbourhood sum over a square block of one storey, the access pattern of
+//       the simulation kernels and the flow field
+
+template <typename GetFn>
+uint64_t walk_neighbourhood(int32_t block_beg, int32_t block_side, int32_t storey_index, GetFn&& get)
+{
+	uint64_t sum = 0;
+
+	for (int32_t z = block_beg; z < block_beg + block_side; ++z) {
+		for (int32_t x = block_beg; x < block_beg + block_side; ++x) {
+			for (int32_t dz = -1; dz <= 1; ++dz) {
+				for (int32_t dx = -1; dx <= 1; ++dx)
+					sum += get(scn::TileCoord {x + dx, z + dz, storey_index, 0});
+			}
+		}
+	}
+
+	return sum;
+}
+
+
+} // namespace
+
+
+// NOTE: chunk directory against the node based map it replaced, same fnv chunk keys,
+//       random order hits and misses. tile reads go through the tile field dense grid
+
+int main()
+{
+	test::init();
+
+	static constexpr int32_t  chunk_side   = 64;
+	static constexpr int32_t  storey_count = 4;
+	static constexpr uint32_t lookup_count = 1U << 22;
+
+	mtp::vault<uint64_t, mtp::default_set> keys;
+	mtp::vault<uint64_t, mtp::default_set> miss_keys;
+
+	for (int32_t storey = 0; storey < storey_count; ++storey) {
+		for (int32_t chunk_z = 0; chunk_z < chunk_side; ++chunk_z) {
+			for (int32_t chunk_x = 0; chunk_x < chunk_side; ++chunk_x) {
+				keys.emplace_back(scn::get_chunk_coord_hash(scn::TileChunkCoord {chunk_x, chunk_z, storey, 0}));
+				miss_keys.emplace_back(scn::get_chunk_coord_hash(scn::TileChunkCoord {chunk_x, chunk_z, storey, 1}));
+			}
+		}
+	}
+
+	const uint32_t key_count = static_cast<uint32_t>(keys.size());
+
+	std::mt19937 rng {42};
+
+	mtp::vault<uint32_t, mtp::default_set> order;
+	order.resize(lookup_count);
+
+	for (uint32_t& key_idx : order)
+		key_idx = static_cast<uint32_t>(rng() % key_count);
+
+	auto index_map = mtp::make_unordered_map<uint64_t, uint32_t, mtp::default_set>();
+	scn::ChunkDirectory directory;
+
+	test::bench("insert unordered_map", key_count, [&]
+	{
+		index_map.clear();
+		index_map.reserve(key_count);
+		for (uint32_t key_idx = 0; key_idx < key_count; ++key_idx)
+			index_map[keys[key_idx]] = key_idx;
+	});
+
+	test::bench("insert chunk directory", key_count, [&]
+	{
+		directory.clear();
+		directory.reserve(key_count);
+		for (uint32_t key_idx = 0; key_idx < key_count; ++key_idx)
+			directory.insert(keys[key_idx], key_idx);
+	});
+
+	uint64_t slot_sum = 0;
+
+	test::bench("find hit unordered_map", lookup_count, [&]
+	{
+		for (const uint32_t key_idx : order)
+			slot_sum += index_map.find(keys[key_idx])->second;
+	});
+
+	test::bench("find hit chunk directory", lookup_count, [&]
+	{
+		for (const uint32_t key_idx : order)
+			slot_sum += directory.find(keys[key_idx]);
+	});
+
+	test::bench("find miss unordered_map", lookup_count, [&]
+	{
+		for (const uint32_t key_idx : order)
+			slot_sum += (index_map.find(miss_keys[key_idx]) == index_map.end()) ? 1U : 0U;
+	});
+
+	test::bench("find miss chunk directory", lookup_count, [&]
+	{
+		for (const uint32_t key_idx : order)
+			slot_sum += (directory.find(miss_keys[key_idx]) == scn::ChunkDirectory::k_empty_slot) ? 1U : 0U;
+	});
+
+	test::keep(slot_sum);
+
+	scn::TileField tilefield;
+	tilefield.resize(chunk_side * scn::cfg::chunk_size, chunk_side * scn::cfg::chunk_size, storey_count, 1);
+
+	const int32_t tile_side = chunk_side * scn::cfg::chunk_size;
+
+	mtp::vault<scn::TileCoord, mtp::default_set> tile_coords;
+	tile_coords.resize(lookup_count);
+
+	for (scn::TileCoord& coord : tile_coords) {
+		coord = scn::TileCoord {
+			static_cast<int32_t>(rng() % static_cast<uint32_t>(tile_side)),
+			static_cast<int32_t>(rng() % static_cast<uint32_t>(tile_side)),
+			static_cast<int32_t>(rng() % static_cast<uint32_t>(storey_count)),
+			0
+		};
+	}
+
+	uint64_t tile_sum = 0;
+
+	MapTileField map_tilefield {tilefield};
+
+	test::bench("tile field get unordered_map", lookup_count, [&]
+	{
+		for (const scn::TileCoord& coord : tile_coords)
+			tile_sum += map_tilefield.get(coord);
+	});
+
+	test::bench("tile field get dense grid", lookup_count, [&]
+	{
+		for (const scn::TileCoord& coord : tile_coords)
+			tile_sum += tilefield.get(coord);
+	});
+
+	test::bench("tile field set unordered_map", lookup_count, [&]
+	{
+		for (const scn::TileCoord& coord : tile_coords)
+			map_tilefield.set(coord, static_cast<scn::TileType>(coord.x & 7));
+	});
+
+	test::bench("tile field set dense grid", lookup_count, [&]
+	{
+		for (const scn::TileCoord& coord : tile_coords)
+			tilefield.set(coord, static_cast<scn::TileType>(coord.x & 7));
+	});
+
+	/* neighbourhood walk, straddling chunk edges on every row */
+
+	static constexpr int32_t block_beg  = 100;
+	static constexpr int32_t block_side = 256;
+	static constexpr int32_t walk_reads = block_side * block_side * 9;
+
+	test::bench("neighbourhood unordered_map", walk_reads, [&]
+	{
+		tile_sum += walk_neighbourhood(block_beg, block_side, 1, [&](scn::TileCoord coord) {
+			return map_tilefield.get(coord);
+		});
+	});
+
+	test::bench("neighbourhood dense grid", walk_reads, [&]
+	{
+		tile_sum += walk_neighbourhood(block_beg, block_side, 1, [&](scn::TileCoord coord) {
+			return tilefield.get(coord);
+		});
+	});
+
+	test::bench("neighbourhood tile cursor", walk_reads, [&]
+	{
+		scn::TileCursor cursor {tilefield};
+
+		tile_sum += walk_neighbourhood(block_beg, block_side, 1, [&](scn::TileCoord coord) {
+			return cursor.get(coord);
+		});
+	});
+
+	test::keep(tile_sum);
+
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include <array>
+#include <cmath>
+#include <random>
+#include <cstdio>
+#include <cstdint>
+
+#include "mtp_memory.hpp"
+
+#include "harness.hpp"
+#include "math.hpp"
+#include "frustum_cull.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+struct AosPlane
+{
+	vec3  normal;
+	vec3  abs_normal;
+	float offset;
+};
+
+
+struct AosBox
+{
+	vec3 center;
+	vec3 half;
+};
+
+
+} // namespace
+
+
+// NOTE: a million boxes against a skewed frustum, Mop/s reads as Mbox/s. the lane kernel
+//       against the scalar single box test and the plane by plane aos loop it replaced
+
+int main()
+{
+	test::init();
+
+	static constexpr uint32_t box_count = 1000000U;
+
+	const std::array<vec4, math::frustum_plane_count> raw_planes {
+		vec4 { 1.0f,  0.1f,  0.0f,  80.0f},
+		vec4 {-1.0f,  0.2f,  0.0f,  80.0f},
+		vec4 { 0.0f,  1.0f,  0.1f,  40.0f},
+		vec4 { 0.1f, -1.0f,  0.0f,  40.0f},
+		vec4 { 0.1f,  0.0f,  1.0f, 100.0f},
+		vec4 { 0.0f,  0.1f, -1.0f, 100.0f}
+	};
+
+	rdr::CullFrustum frustum;
+	frustum.set_planes(raw_planes);
+
+	std::array<AosPlane, math::frustum_plane_count> aos_planes;
+
+	for (size_t plane_idx = 0; plane_idx < aos_planes.size(); ++plane_idx) {
+
+		const vec4  raw_plane      = raw_planes[plane_idx];
+		const vec3  raw_normal     {raw_plane.x, raw_plane.y, raw_plane.z};
+		const float inv_normal_len = 1.0f / glm::length(raw_normal);
+		const vec3  unit_normal    = raw_normal * inv_normal_len;
+
+		aos_planes[plane_idx] = {unit_normal, glm::abs(unit_normal), raw_plane.w * inv_normal_len};
+	}
+
+	std::mt19937 rng {5};
+
+	auto uniform = [&rng](float lo, float hi) {
+		return std::uniform_real_distribution<float> {lo, hi}(rng);
+	};
+
+	rdr::CullBoundSet bounds;
+	bounds.reserve(box_count);
+
+	mtp::vault<AosBox, mtp::default_set> boxes;
+	boxes.reserve(box_count);
+
+	for (uint32_t box_idx = 0; box_idx < box_count; ++box_idx) {
+
+		const vec3 center {uniform(-300.0f, 300.0f), uniform(-100.0f, 100.0f), uniform(-300.0f, 300.0f)};
+		const vec3 half   {uniform(0.1f, 5.0f), uniform(0.1f, 5.0f), uniform(0.1f, 5.0f)};
+
+		(void) bounds.push(center, half);
+		boxes.emplace_back(AosBox {center, half});
+	}
+
+	mtp::vault<uint32_t, mtp::default_set> visible_indices;
+	visible_indices.resize(box_count);
+
+	uint32_t kernel_visible = 0;
+	uint32_t scalar_visible = 0;
+	uint32_t aos_visible    = 0;
+
+	test::bench("cull lane kernel", box_count, [&]
+	{
+		kernel_visible = rdr::cull_frustum(frustum, bounds, 0, box_count, visible_indices.data());
+	});
+
+	test::bench("cull scalar is_culled", box_count, [&]
+	{
+		scalar_visible = 0;
+		for (uint32_t box_idx = 0; box_idx < box_count; ++box_idx) {
+			if (!frustum.is_culled(boxes[box_idx].center, boxes[box_idx].half))
+				visible_indices[scalar_visible++] = box_idx;
+		}
+	});
+
+	test::bench("cull plane by plane aos", box_count, [&]
+	{
+		aos_visible = 0;
+		for (uint32_t box_idx = 0; box_idx < box_count; ++box_idx) {
+
+			const AosBox& box = boxes[box_idx];
+
+			bool is_culled = false;
+
+			for (const AosPlane& plane : aos_planes) {
+
+				const float aabb_proj_radius =
+					plane.abs_normal.x * box.half.x +
+					plane.abs_normal.y * box.half.y +
+					plane.abs_normal.z * box.half.z;
+
+				if (glm::dot(plane.normal, box.center) + plane.offset < -aabb_proj_radius) {
+					is_culled = true;
+					break;
+				}
+			}
+
+			if (!is_culled)
+				visible_indices[aos_visible++] = box_idx;
+		}
+	});
+
+	test::keep(visible_indices);
+
+	std::printf("visible %u of %u\n", kernel_visible, box_count);
+
+	if (kernel_visible != scalar_visible || kernel_visible != aos_visible) {
+		std::printf("visible count mismatch [kernel %u][scalar %u][aos %u]\n", kernel_visible, scalar_visible, aos_visible);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+#include <random>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "voxel_data.hpp"
+#include "voxel_field.hpp"
+#include "voxel_query.hpp"
+#include "voxel_mesher.hpp"
+#include "voxel_draw_data.hpp"
+
+
+using namespace hpr;
+
+
+// NOTE: remesh cost of one dirtied chunk. the wall chunk matches the scene layout,
+//       the noise chunk is the worst case for face merging
+
+int main()
+{
+	test::init();
+
+	static constexpr int32_t chunk_size = scn::VoxelField::k_chunk_size;
+
+	scn::VoxelField            voxelfield;
+	scn::VoxelGridParams       voxel_grid;
+	rdr::VoxelChunkDrawableSet chunk_drawable_set;
+	scn::VoxelMeshBuffer       mesh;
+
+	static constexpr scn::VoxelChunkCoord wall_chunk  {0, 0, 0};
+	static constexpr scn::VoxelChunkCoord noise_chunk {1, 0, 0};
+
+	for (int32_t y = 0; y < 12; ++y) {
+		for (int32_t i = 0; i < chunk_size; ++i) {
+			scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {i, y, 0}, 1, chunk_drawable_set);
+			scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {0, y, i}, 1, chunk_drawable_set);
+		}
+	}
+
+	std::mt19937 rng {42};
+
+	for (int32_t z = 0; z < chunk_size; ++z)
+		for (int32_t y = 0; y < chunk_size; ++y)
+			for (int32_t x = 0; x < chunk_size; ++x)
+				scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {chunk_size + x, y, z},
+					static_cast<scn::VoxelType>(rng() % 4U), chunk_drawable_set);
+
+	uint64_t index_sum = 0;
+
+	test::bench("remesh wall chunk", 1, [&]
+	{
+		scn::build_voxel_chunk_mesh(voxelfield, wall_chunk, voxel_grid.voxel_size, mesh);
+		index_sum += mesh.indices.size();
+	});
+
+	test::bench("remesh noise chunk", 1, [&]
+	{
+		scn::build_voxel_chunk_mesh(voxelfield, noise_chunk, voxel_grid.voxel_size, mesh);
+		index_sum += mesh.indices.size();
+	});
+
+	test::keep(index_sum);
+
+	return 0;
+}
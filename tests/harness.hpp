@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+
+#include "mtp_memory.hpp"
+
+
+namespace hpr::test {
+
+
+inline uint32_t failure_count = 0;
+
+
+inline void check(bool passed, const char* expr, const char* file, int line)
+{
+	if (passed)
+		return;
+
+	++failure_count;
+	std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+}
+
+
+inline void init()
+{
+	mtp::init_tls<mtp::default_set>();
+}
+
+
+[[nodiscard]] inline int finish(const char* name)
+{
+	if (failure_count == 0) {
+		std::printf("%s: ok\n", name);
+		return 0;
+	}
+
+	std::printf("%s: %u checks failed\n", name, failure_count);
+	return 1;
+}
+
+
+// NOTE: keeps a benchmark result alive without the compiler folding the work away
+
+template <typename T>
+inline void keep(const T& value)
+{
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+
+// NOTE: best of several rounds, prints and returns nanoseconds per operation
+
+template <typename RoundFn>
+double bench(const char* label, uint64_t op_count, RoundFn&& round_fn, uint32_t round_count = 5)
+{
+	double best_ns = 0.0;
+
+	for (uint32_t round = 0; round < round_count; ++round) {
+
+		const auto time_beg = std::chrono::steady_clock::now();
+		round_fn();
+		const auto time_end = std::chrono::steady_clock::now();
+
+		const double round_ns = std::chrono::duration<double, std::nano>(time_end - time_beg).count();
+
+		best_ns = (round == 0) ? round_ns : std::min(best_ns, round_ns);
+	}
+
+	const double op_ns = best_ns / static_cast<double>(std::max<uint64_t>(op_count, 1));
+
+	std::printf("%-40s %10.2f ns/op %12.2f Mop/s\n", label, op_ns, 1.0e3 / op_ns);
+
+	return op_ns;
+}
+
+
+} // hpr::test
+
+
+#define HPR_CHECK(expr) ::hpr::test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
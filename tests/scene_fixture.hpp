@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+
+#include "mtp_memory.hpp"
+
+#include "math.hpp"
+#include "entity.hpp"
+#include "ray_data.hpp"
+#include "scene.hpp"
+#include "scene_query.hpp"
+#include "scene_resolver.hpp"
+#include "render_data.hpp"
+#include "handle_store.hpp"
+#include "ecs_registry.hpp"
+#include "triangle_bvh.hpp"
+#include "components_scene.hpp"
+#include "components_render.hpp"
+
+
+namespace hpr::test {
+
+
+using SceneRegistry = ecs::Registry <
+	ecs::TransformComponent,
+	ecs::ModelComponent,
+	ecs::BoundComponent
+>;
+
+
+// NOTE: pickable entities over meshes of random triangles in the unit cube. each mesh has two
+//       submeshes over halves of one index buffer, like an imported primitive, and both
+//       geometry submeshes keep the whole buffer. bvhs are only built by build_bvhs(), without
+//       them raycast_submesh tests the world space triangles
+
+struct SceneFixture
+{
+	static constexpr uint32_t k_capacity = 256;
+
+
+	ecs::Entity add_model(std::mt19937& rng, uint32_t triangle_count)
+	{
+		std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+
+		const uint32_t vertex_count = triangle_count * 3;
+
+		mtp::vault<uint8_t, mtp::default_set> vertex_bytes;
+		mtp::vault<uint8_t, mtp::default_set> index_bytes;
+
+		vertex_bytes.resize(vertex_count * sizeof(rdr::SceneVertex));
+		index_bytes.resize(vertex_count * sizeof(uint32_t));
+
+		// NOTE: small triangles scattered around the cube, each near a random centre
+
+		for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+
+			const vec3 centre {unit(rng), unit(rng), unit(rng)};
+
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+
+				rdr::SceneVertex vertex {};
+				vertex.pos = centre + vec3 {unit(rng), unit(rng), unit(rng)} * 0.3f;
+
+				const uint32_t vertex_idx = triangle * 3 + corner;
+
+				std::memcpy(vertex_bytes.data() + vertex_idx * sizeof(rdr::SceneVertex), &vertex, sizeof(rdr::SceneVertex));
+				std::memcpy(index_bytes.data() + vertex_idx * sizeof(uint32_t), &vertex_idx, sizeof(uint32_t));
+			}
+		}
+
+		mtp::vault<uint8_t, mtp::default_set> index_copy;
+		index_copy.resize(index_bytes.size());
+		std::memcpy(index_copy.data(), index_bytes.data(), index_bytes.size());
+
+		const Handle<rdr::MeshGeometry> geometry_hnd = geometries.create(std::move(vertex_bytes), std::move(index_bytes));
+		geometries.get(geometry_hnd)->submeshes.emplace_back(std::move(index_copy));
+
+		const Handle<rdr::Mesh> mesh_hnd = meshes.create();
+		rdr::Mesh& mesh = *meshes.get(mesh_hnd);
+
+		const uint32_t split_idx = (triangle_count / 2) * 3;
+
+		mesh.geometry  = geometry_hnd;
+		mesh.vtx_count = vertex_count;
+		mesh.idx_count = vertex_count;
+		mesh.submeshes.emplace_back(rdr::Submesh {.first_idx = 0,         .idx_count = split_idx,                .idx_buffer = {}});
+		mesh.submeshes.emplace_back(rdr::Submesh {.first_idx = split_idx, .idx_count = vertex_count - split_idx, .idx_buffer = {}});
+
+		auto& scene_primitives = scene.scene_primitives();
+
+		const uint32_t submesh_first = static_cast<uint32_t>(scene_primitives.size());
+
+		scene_primitives.emplace_back(scn::ScenePrimitive {.mesh = mesh_hnd, .submesh_idx = 0, .material = {}});
+		scene_primitives.emplace_back(scn::ScenePrimitive {.mesh = mesh_hnd, .submesh_idx = 1, .material = {}});
+
+		const ecs::Entity entity = registry.create_entity();
+
+		registry.add<ecs::TransformComponent>(entity, ecs::TransformComponent {});
+		registry.add<ecs::ModelComponent>(entity, ecs::ModelComponent {.submesh_first = submesh_first, .submesh_count = 2});
+		registry.add<ecs::BoundComponent>(entity, ecs::BoundComponent {});
+
+		place(entity, vec3 {0.0f}, quat {1.0f, 0.0f, 0.0f, 0.0f}, vec3 {1.0f});
+
+		return entity;
+	}
+
+
+	// NOTE: sets the transform and the exact world bounds of the mesh, through patch so the
+	//       bound tree hears about it
+
+	void place(ecs::Entity entity, const vec3& position, const quat& rotation, const vec3& scale)
+	{
+		registry.patch<ecs::TransformComponent>(entity, [&](ecs::TransformComponent& transform)
+		{
+			transform.position = position;
+			transform.rotation = rotation;
+			transform.scale    = scale;
+		});
+
+		vec3 world_min {std::numeric_limits<float>::max()};
+		vec3 world_max {std::numeric_limits<float>::lowest()};
+
+		const ecs::ModelComponent& model = *registry.get<ecs::ModelComponent>(entity);
+
+		for (uint32_t submesh = 0; submesh < model.submesh_count; ++submesh) {
+			scn::for_each_triangle(registry, scene, resolver, entity, submesh, [&](const vec3& vtx_0, const vec3& vtx_1, const vec3& vtx_2)
+			{
+				world_min = glm::min(world_min, glm::min(vtx_0, glm::min(vtx_1, vtx_2)));
+				world_max = glm::max(world_max, glm::max(vtx_0, glm::max(vtx_1, vtx_2)));
+			});
+		}
+
+		registry.patch<ecs::BoundComponent>(entity, [&](ecs::BoundComponent& bound)
+		{
+			bound.world_center = (world_min + world_max) * 0.5f;
+			bound.world_half   = (world_max - world_min) * 0.5f;
+		});
+	}
+
+
+	void place_random(ecs::Entity entity, std::mt19937& rng, float extent)
+	{
+		std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+
+		quat rotation {unit(rng), unit(rng), unit(rng), unit(rng)};
+
+		const float length = std::sqrt(rotation.w * rotation.w + rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z);
+
+		rotation = quat {rotation.w / length, rotation.x / length, rotation.y / length, rotation.z / length};
+
+		const vec3 scale {1.0f + 0.5f * unit(rng), 1.0f + 0.5f * unit(rng), 1.0f + 0.5f * unit(rng)};
+
+		place(entity, vec3 {unit(rng), unit(rng) * 0.25f, unit(rng)} * extent, rotation, scale);
+	}
+
+
+	void build_bvhs()
+	{
+		for (const scn::ScenePrimitive& scene_primitive : scene.scene_primitives()) {
+
+			const rdr::Mesh*   mesh          = meshes.get(scene_primitive.mesh);
+			rdr::MeshGeometry* mesh_geometry = geometries.get(mesh->geometry);
+
+			rdr::SubmeshGeometry& submesh_geometry = mesh_geometry->submeshes[scene_primitive.submesh_idx];
+
+			if (!submesh_geometry.triangle_bvh.empty())
+				continue;
+
+			submesh_geometry.triangle_bvh.build(rdr::TriangleSource {
+				.position_bytes  = mesh_geometry->vertex_bytes.data() + offsetof(rdr::SceneVertex, pos),
+				.position_stride = static_cast<uint32_t>(sizeof(rdr::SceneVertex)),
+				.vertex_count    = static_cast<uint32_t>(mesh_geometry->vertex_bytes.size() / sizeof(rdr::SceneVertex)),
+				.indices         = reinterpret_cast<const uint32_t*>(submesh_geometry.index_bytes.data()),
+				.triangle_count  = static_cast<uint32_t>(submesh_geometry.index_bytes.size() / (3 * sizeof(uint32_t)))
+			});
+		}
+	}
+
+
+	// NOTE: every pickable entity and every world space triangle, what picking did before the
+	//       bound tree and the bvhs
+
+	[[nodiscard]] scn::RayHit raycast_linear(const scn::Ray& ray)
+	{
+		const vec3 ray_direction = glm::normalize(ray.direction);
+
+		scn::RayHit best_hit {};
+
+		scn::for_each_pickable_entity(registry, [&](ecs::Entity entity, const vec3&, const vec3&)
+		{
+			const uint32_t submesh_count = registry.get<ecs::ModelComponent>(entity)->submesh_count;
+
+			for (uint32_t submesh = 0; submesh < submesh_count; ++submesh) {
+				scn::for_each_triangle(registry, scene, resolver, entity, submesh, [&](const vec3& vtx_0, const vec3& vtx_1, const vec3& vtx_2)
+				{
+					float barycentric_U;
+					float barycentric_V;
+					float hit_distance;
+
+					if (scn::intersect_ray_triangle(ray.origin, ray_direction, vtx_0, vtx_1, vtx_2, hit_distance, barycentric_U, barycentric_V)
+						&& hit_distance < best_hit.closest_hit_distance) {
+						best_hit = scn::RayHit {.hit = true, .entity = entity, .submesh = submesh, .closest_hit_distance = hit_distance};
+					}
+				});
+			}
+		});
+
+		return best_hit;
+	}
+
+
+	res::HandleStore<rdr::Mesh>             meshes     {k_capacity};
+	res::HandleStore<rdr::MeshGeometry>     geometries {k_capacity};
+	res::HandleStore<rdr::MaterialInstance> materials  {1};
+
+	scn::SceneResolver resolver {meshes, geometries, materials};
+
+	SceneRegistry registry;
+	scn::Scene    scene;
+};
+
+
+// NOTE: same entity and submesh, distances agree up to the local space round trip
+
+[[nodiscard]] inline bool same_hit(const scn::RayHit& lhs, const scn::RayHit& rhs)
+{
+	if (lhs.hit != rhs.hit)
+		return false;
+
+	if (!lhs.hit)
+		return true;
+
+	return lhs.entity == rhs.entity && lhs.submesh == rhs.submesh
+		&& std::fabs(lhs.closest_hit_distance - rhs.closest_hit_distance) <= 1.0e-3f * (1.0f + lhs.closest_hit_distance);
+}
+
+
+} // hpr::test
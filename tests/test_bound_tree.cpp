@@ -0,0 +1,388 @@
+#include <cmath>
+#include <random>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "harness.hpp"
+#include "scene_fixture.hpp"
+
+#include "math.hpp"
+#include "entity.hpp"
+#include "ray_data.hpp"
+#include "bound_tree.hpp"
+#include "scene_query.hpp"
+#include "components_render.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+constexpr float world_extent = 100.0f;
+
+
+[[nodiscard]] vec3 random_point(std::mt19937& rng, float extent)
+{
+	std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+	return vec3 {unit(rng), unit(rng), unit(rng)} * extent;
+}
+
+
+[[nodiscard]] vec3 random_half(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> size {0.1f, 4.0f};
+	return vec3 {size(rng), size(rng), size(rng)};
+}
+
+
+void set_bound(test::SceneRegistry& registry, ecs::Entity entity, const vec3& center, const vec3& half)
+{
+	registry.patch<ecs::BoundComponent>(entity, [&](ecs::BoundComponent& bound)
+	{
+		bound.world_center = center;
+		bound.world_half   = half;
+	});
+}
+
+
+ecs::Entity add_box(test::SceneRegistry& registry, std::mt19937& rng)
+{
+	const ecs::Entity entity = registry.create_entity();
+
+	registry.add<ecs::ModelComponent>(entity, ecs::ModelComponent {.submesh_first = 0, .submesh_count = 0});
+	registry.add<ecs::BoundComponent>(entity, ecs::BoundComponent {
+		.local_center = vec3 {0.0f},
+		.local_half   = vec3 {0.0f},
+		.world_center = random_point(rng, world_extent),
+		.world_half   = random_half(rng)
+	});
+
+	return entity;
+}
+
+
+// NOTE: sorted entity lists, tree and brute force have to agree exactly
+
+using EntityList = mtp::vault<ecs::Entity, mtp::default_set>;
+
+
+template <typename Test>
+[[nodiscard]] EntityList brute_force(test::SceneRegistry& registry, Test&& test)
+{
+	EntityList entities;
+
+	scn::for_each_pickable_entity(registry, [&](ecs::Entity entity, const vec3& aabb_min, const vec3& aabb_max)
+	{
+		if (test(aabb_min, aabb_max))
+			entities.emplace_back(entity);
+	});
+
+	std::sort(entities.begin(), entities.end());
+
+	return entities;
+}
+
+
+[[nodiscard]] bool same_entities(EntityList& lhs, const EntityList& rhs)
+{
+	std::sort(lhs.begin(), lhs.end());
+	return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+
+[[nodiscard]] bool box_overlaps(const vec3& box_min, const vec3& box_max, const vec3& aabb_min, const vec3& aabb_max)
+{
+	return box_min.x <= aabb_max.x && box_min.y <= aabb_max.y && box_min.z <= aabb_max.z
+		&& aabb_min.x <= box_max.x && aabb_min.y <= box_max.y && aabb_min.z <= box_max.z;
+}
+
+
+[[nodiscard]] uint32_t query_mismatches(const scn::BoundTree& bound_tree, test::SceneRegistry& registry, std::mt19937& rng)
+{
+	uint32_t mismatch_count = 0;
+
+	for (uint32_t query_idx = 0; query_idx < 8; ++query_idx) {
+
+		/* boxes */
+
+		const vec3 box_center = random_point(rng, world_extent);
+		const vec3 box_half   = random_half(rng) * 5.0f;
+		const vec3 box_min    = box_center - box_half;
+		const vec3 box_max    = box_center + box_half;
+
+		EntityList box_hits;
+		bound_tree.query_box(box_min, box_max, [&](ecs::Entity entity) { box_hits.emplace_back(entity); });
+
+		mismatch_count += !same_entities(box_hits, brute_force(registry, [&](const vec3& aabb_min, const vec3& aabb_max)
+		{
+			return box_overlaps(box_min, box_max, aabb_min, aabb_max);
+		}));
+
+		/* spheres */
+
+		const vec3  sphere_center = random_point(rng, world_extent);
+		const float sphere_radius = 5.0f + static_cast<float>(rng() % 20U);
+
+		EntityList sphere_hits;
+		bound_tree.query_sphere(sphere_center, sphere_radius, [&](ecs::Entity entity) { sphere_hits.emplace_back(entity); });
+
+		mismatch_count += !same_entities(sphere_hits, brute_force(registry, [&](const vec3& aabb_min, const vec3& aabb_max)
+		{
+			const vec3 closest = glm::clamp(sphere_center, aabb_min, aabb_max);
+			return glm::dot(closest - sphere_center, closest - sphere_center) <= sphere_radius * sphere_radius;
+		}));
+
+		/* rays - every box along the ray without pruning, then the nearest entry with it */
+
+		const vec3 ray_origin    = random_point(rng, world_extent * 1.5f);
+		const vec3 ray_direction = glm::normalize(random_point(rng, 1.0f) + vec3 {1.0e-3f});
+
+		EntityList ray_hits;
+		bound_tree.raycast(ray_origin, ray_direction, std::numeric_limits<float>::infinity(), [&](ecs::Entity entity, float)
+		{
+			ray_hits.emplace_back(entity);
+			return std::numeric_limits<float>::infinity();
+		});
+
+		float nearest_entry = std::numeric_limits<float>::infinity();
+
+		const EntityList ray_reference = brute_force(registry, [&](const vec3& aabb_min, const vec3& aabb_max)
+		{
+			float entry = 0.0f;
+
+			if (!scn::intersect_ray_aabb(ray_origin, ray_direction, aabb_min, aabb_max, entry))
+				return false;
+
+			nearest_entry = std::min(nearest_entry, entry);
+			return true;
+		});
+
+		mismatch_count += !same_entities(ray_hits, ray_reference);
+
+		// NOTE: returning the entry prunes everything entered behind the nearest box so far
+
+		float pruned_entry = std::numeric_limits<float>::infinity();
+
+		bound_tree.raycast(ray_origin, ray_direction, std::numeric_limits<float>::infinity(), [&](ecs::Entity, float entry)
+		{
+			pruned_entry = std::min(pruned_entry, entry);
+			return pruned_entry;
+		});
+
+		if (std::isinf(nearest_entry))
+			mismatch_count += !std::isinf(pruned_entry);
+		else
+			mismatch_count += std::fabs(pruned_entry - nearest_entry) > 1.0e-3f * (1.0f + nearest_entry);
+	}
+
+	return mismatch_count;
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	/* inserts, removals and moves through the hooks, incremental and rebuilt */
+
+	{
+		static constexpr uint32_t box_count  = 600;
+		static constexpr uint32_t step_count = 300;
+
+		std::mt19937 rng {44};
+
+		test::SceneRegistry registry;
+		scn::BoundTree      bound_tree;
+
+		EntityList entities;
+
+		for (uint32_t box_idx = 0; box_idx < box_count / 2; ++box_idx)
+			entities.emplace_back(add_box(registry, rng));
+
+		// NOTE: half before attach are picked up by its scan, half after by the add hooks
+
+		bound_tree.attach(registry);
+
+		for (uint32_t box_idx = box_count / 2; box_idx < box_count; ++box_idx)
+			entities.emplace_back(add_box(registry, rng));
+
+		bound_tree.sync(registry);
+
+		HPR_CHECK(bound_tree.leaf_count() == box_count);
+
+		uint32_t mismatch_count = query_mismatches(bound_tree, registry, rng);
+		uint32_t count_mismatch = 0;
+		uint32_t max_height     = bound_tree.height();
+
+		for (uint32_t step = 0; step < step_count; ++step) {
+
+			// NOTE: a few changes per sync keep the tree on the incremental path, every 50th
+			//       step moves most boxes so the bulk rebuild runs too
+
+			const uint32_t change_count = (step % 50U == 49U) ? box_count : 1U + rng() % 8U;
+
+			for (uint32_t change = 0; change < change_count; ++change) {
+
+				const ecs::Entity entity = entities[rng() % entities.size()];
+				const uint32_t    roll   = rng() % 10U;
+
+				const auto* bound = registry.get<ecs::BoundComponent>(entity);
+
+				if (roll < 4U && bound) {
+
+					// NOTE: a small nudge stays inside the fat bounds, a jump leaves them
+
+					const vec3 offset = (roll < 2U) ? random_point(rng, 0.02f) : random_point(rng, 10.0f);
+					set_bound(registry, entity, bound->world_center + offset, bound->world_half);
+				}
+				else if (roll < 6U && bound) {
+					set_bound(registry, entity, random_point(rng, world_extent), random_half(rng));
+				}
+				else if (roll < 7U) {
+					registry.remove<ecs::BoundComponent>(entity);
+				}
+				else if (roll < 8U) {
+					registry.remove<ecs::ModelComponent>(entity);
+				}
+				else if (roll < 9U) {
+					if (!registry.has<ecs::ModelComponent>(entity))
+						registry.add<ecs::ModelComponent>(entity, ecs::ModelComponent {.submesh_first = 0, .submesh_count = 0});
+
+					if (!bound)
+						registry.add<ecs::BoundComponent>(entity, ecs::BoundComponent {
+							.local_center = vec3 {0.0f},
+							.local_half   = vec3 {0.0f},
+							.world_center = random_point(rng, world_extent),
+							.world_half   = random_half(rng)
+						});
+				}
+				else {
+					registry.destroy_entity(entity);
+					entities[static_cast<uint32_t>(std::find(entities.begin(), entities.end(), entity) - entities.begin())] = add_box(registry, rng);
+				}
+			}
+
+			bound_tree.sync(registry);
+
+			uint32_t live_count = 0;
+			scn::for_each_pickable_entity(registry, [&](ecs::Entity, const vec3&, const vec3&) { ++live_count; });
+
+			count_mismatch += bound_tree.leaf_count() != live_count;
+			max_height      = std::max(max_height, bound_tree.height());
+
+			if (step % 5U == 0U)
+				mismatch_count += query_mismatches(bound_tree, registry, rng);
+		}
+
+		HPR_CHECK(mismatch_count == 0);
+		HPR_CHECK(count_mismatch == 0);
+		HPR_CHECK(max_height <= scn::cfg::bound_tree_max_height);
+
+		// NOTE: rotations keep the incremental tree near its built cost
+
+		HPR_CHECK(bound_tree.sah_cost() > 0.0f);
+
+		/* frustum - a box of six inward planes selects what the box query does */
+
+		{
+			const vec3 box_min {-30.0f, -20.0f, -40.0f};
+			const vec3 box_max { 25.0f,  35.0f,  10.0f};
+
+			const vec4 planes [] {
+				vec4 { 1.0f,  0.0f,  0.0f, -box_min.x},
+				vec4 {-1.0f,  0.0f,  0.0f,  box_max.x},
+				vec4 { 0.0f,  1.0f,  0.0f, -box_min.y},
+				vec4 { 0.0f, -1.0f,  0.0f,  box_max.y},
+				vec4 { 0.0f,  0.0f,  1.0f, -box_min.z},
+				vec4 { 0.0f,  0.0f, -1.0f,  box_max.z}
+			};
+
+			EntityList frustum_hits;
+			bound_tree.query_frustum(planes, [&](ecs::Entity entity) { frustum_hits.emplace_back(entity); });
+
+			HPR_CHECK(same_entities(frustum_hits, brute_force(registry, [&](const vec3& aabb_min, const vec3& aabb_max)
+			{
+				return box_overlaps(box_min, box_max, aabb_min, aabb_max);
+			})));
+		}
+
+		/* detached, later changes are not heard */
+
+		bound_tree.detach(registry);
+
+		const uint32_t leaf_count = bound_tree.leaf_count();
+
+		(void) add_box(registry, rng);
+		bound_tree.sync(registry);
+
+		HPR_CHECK(bound_tree.leaf_count() == leaf_count);
+	}
+
+	/* raycast_scene picks what the linear scan over every triangle picked */
+
+	{
+		std::mt19937 rng {440};
+
+		test::SceneFixture fixture;
+
+		mtp::vault<ecs::Entity, mtp::default_set> models;
+
+		for (uint32_t model_idx = 0; model_idx < 40; ++model_idx)
+			models.emplace_back(fixture.add_model(rng, 64));
+
+		fixture.scene.bound_tree().attach(fixture.registry);
+
+		for (const ecs::Entity entity : models)
+			fixture.place_random(entity, rng, 8.0f);
+
+		fixture.scene.bound_tree().sync(fixture.registry);
+
+		uint32_t hit_count      = 0;
+		uint32_t mismatch_count = 0;
+
+		const auto cast_rays = [&]()
+		{
+			for (uint32_t ray_idx = 0; ray_idx < 400; ++ray_idx) {
+
+				// NOTE: rays from around the scene towards points inside it
+
+				const vec3 origin = random_point(rng, 30.0f);
+				const vec3 target = random_point(rng, 6.0f);
+
+				scn::Ray ray {.origin = origin, .direction = target - origin};
+
+				const scn::RayHit tree_hit   = scn::raycast_scene(ray, fixture.registry, fixture.scene, fixture.resolver);
+				const scn::RayHit linear_hit = fixture.raycast_linear(ray);
+
+				mismatch_count += !test::same_hit(tree_hit, linear_hit);
+				hit_count      += linear_hit.hit;
+			}
+		};
+
+		cast_rays();
+
+		// NOTE: with bvhs the submeshes are tested in local space, moved models keep up through the hooks
+
+		fixture.build_bvhs();
+
+		for (uint32_t model_idx = 0; model_idx < 10; ++model_idx)
+			fixture.place_random(models[rng() % models.size()], rng, 8.0f);
+
+		fixture.scene.bound_tree().sync(fixture.registry);
+
+		cast_rays();
+
+		HPR_CHECK(mismatch_count == 0);
+		HPR_CHECK(hit_count > 150);
+
+		fixture.scene.bound_tree().detach(fixture.registry);
+	}
+
+	return test::finish("test_bound_tree");
+}
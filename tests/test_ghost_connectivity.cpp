@@ -0,0 +1,278 @@
+#include <random>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "ghost_infra.hpp"
+#include "ghost_connectivity.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+[[nodiscard]] uint32_t find_root(mtp::vault<uint32_t, mtp::default_set>& parents, uint32_t node)
+{
+	while (parents[node] != node) {
+		parents[node] = parents[parents[node]];
+		node = parents[node];
+	}
+
+	return node;
+}
+
+
+// NOTE: reference components over the conducting edges, union find from scratch
+
+[[nodiscard]] mtp::vault<uint32_t, mtp::default_set> reference_roots(const scn::GhostGraph& graph)
+{
+	const uint32_t node_count = static_cast<uint32_t>(graph.nodes.size());
+
+	mtp::vault<uint32_t, mtp::default_set> parents;
+	parents.resize(node_count);
+
+	for (uint32_t node = 0; node < node_count; ++node)
+		parents[node] = node;
+
+	for (const scn::GhostEdge& edge : graph.edges) {
+		if (!(edge.flags & scn::ghost_edge_broken))
+			parents[find_root(parents, edge.a)] = find_root(parents, edge.b);
+	}
+
+	for (uint32_t node = 0; node < node_count; ++node)
+		parents[node] = find_root(parents, node);
+
+	return parents;
+}
+
+
+// NOTE: labels are arbitrary ids, two labelings agree when they induce the same partition and
+//       the component sizes and count match it
+
+[[nodiscard]] bool same_partition(const scn::GhostConnectivity& connectivity, const scn::GhostGraph& graph)
+{
+	const uint32_t node_count = static_cast<uint32_t>(graph.nodes.size());
+
+	if (connectivity.node_count() != node_count)
+		return false;
+
+	const mtp::vault<uint32_t, mtp::default_set> roots = reference_roots(graph);
+
+	static constexpr uint32_t unset = 0xFFFFFFFFU;
+
+	mtp::vault<uint32_t, mtp::default_set> label_of_root;
+	mtp::vault<uint32_t, mtp::default_set> root_of_label;
+	mtp::vault<uint32_t, mtp::default_set> root_sizes;
+
+	label_of_root.resize(node_count, unset);
+	root_of_label.resize(connectivity.component_capacity(), unset);
+	root_sizes.resize(node_count, 0U);
+
+	uint32_t root_count = 0;
+
+	for (uint32_t node = 0; node < node_count; ++node) {
+
+		const uint32_t root  = roots[node];
+		const uint32_t label = connectivity.component_of(node);
+
+		if (label_of_root[root] == unset && root_of_label[label] == unset) {
+			label_of_root[root]  = label;
+			root_of_label[label] = root;
+			++root_count;
+		}
+
+		if (label_of_root[root] != label || root_of_label[label] != root)
+			return false;
+
+		++root_sizes[root];
+	}
+
+	for (uint32_t node = 0; node < node_count; ++node) {
+		if (roots[node] == node && connectivity.component_size(label_of_root[node]) != root_sizes[node])
+			return false;
+	}
+
+	return connectivity.component_count() == root_count;
+}
+
+
+void add_node(scn::GhostGraph& graph, int32_t x, int32_t z)
+{
+	graph.nodes.emplace_back(scn::GhostNode {
+		.tile    = scn::TileCoord {.x = x, .z = z, .storey_index = 0, .storey_stack = 0},
+		.port    = scn::GhostPort::center,
+		.channel = scn::GhostChannel::power
+	});
+}
+
+
+void add_edge(scn::GhostGraph& graph, uint32_t node_a, uint32_t node_b)
+{
+	graph.edges.emplace_back(scn::GhostEdge {.a = node_a, .b = node_b, .channel = scn::GhostChannel::power});
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	/* a line cut in the middle splits, repairing it merges again */
+
+	{
+		scn::GhostGraph        graph;
+		scn::GhostConnectivity connectivity;
+
+		for (int32_t x = 0; x < 6; ++x)
+			add_node(graph, x, 0);
+
+		for (uint32_t node = 0; node + 1 < 6; ++node)
+			add_edge(graph, node, node + 1);
+
+		connectivity.sync(graph);
+		connectivity.set_source(0, true);
+
+		HPR_CHECK(connectivity.component_count() == 1);
+		HPR_CHECK(connectivity.supplied(5));
+		HPR_CHECK(connectivity.find_node(scn::TileCoord {3, 0, 0, 0}) == 3);
+		HPR_CHECK(connectivity.tile_supplied(scn::TileCoord {4, 0, 0, 0}));
+		HPR_CHECK(connectivity.find_node(scn::TileCoord {9, 0, 0, 0}) == scn::GhostConnectivity::k_none);
+
+		const uint64_t version = connectivity.component_version(connectivity.component_of(5));
+
+		connectivity.set_edge_broken(graph, 2, true);
+
+		HPR_CHECK(connectivity.component_count() == 2);
+		HPR_CHECK(connectivity.connected(0, 2));
+		HPR_CHECK(!connectivity.connected(2, 3));
+		HPR_CHECK(connectivity.supplied(2));
+		HPR_CHECK(!connectivity.supplied(3));
+		HPR_CHECK(connectivity.component_size(connectivity.component_of(5)) == 3);
+		HPR_CHECK(connectivity.component_version(connectivity.component_of(5)) > version);
+		HPR_CHECK(same_partition(connectivity, graph));
+
+		connectivity.set_edge_broken(graph, 2, false);
+
+		HPR_CHECK(connectivity.component_count() == 1);
+		HPR_CHECK(connectivity.supplied(5));
+		HPR_CHECK(same_partition(connectivity, graph));
+
+		/* a cycle survives one cut */
+
+		add_edge(graph, 5, 0);
+		connectivity.sync(graph);
+
+		connectivity.set_edge_broken(graph, 2, true);
+
+		HPR_CHECK(connectivity.component_count() == 1);
+		HPR_CHECK(connectivity.supplied(3));
+
+		connectivity.set_edge_broken(graph, 4, true);
+
+		HPR_CHECK(connectivity.component_count() == 2);
+		HPR_CHECK(connectivity.connected(3, 4));
+		HPR_CHECK(connectivity.connected(5, 0));
+		HPR_CHECK(!connectivity.supplied(4));
+		HPR_CHECK(same_partition(connectivity, graph));
+	}
+
+	/* random appends and cuts match a from-scratch rebuild after every step */
+
+	{
+		static constexpr uint32_t node_target = 400;
+		static constexpr uint32_t step_count  = 3000;
+
+		std::mt19937 rng {38};
+
+		scn::GhostGraph        graph;
+		scn::GhostConnectivity connectivity;
+
+		for (uint32_t node = 0; node < 8; ++node)
+			add_node(graph, static_cast<int32_t>(node), 1);
+
+		connectivity.rebuild(graph);
+
+		uint32_t mismatch_count = 0;
+		uint32_t rebuild_count  = 0;
+
+		for (uint32_t step = 0; step < step_count; ++step) {
+
+			const uint32_t roll       = rng() % 10U;
+			const uint32_t node_count = static_cast<uint32_t>(graph.nodes.size());
+			const uint32_t edge_count = static_cast<uint32_t>(graph.edges.size());
+
+			if (roll < 2U && node_count < node_target) {
+
+				// NOTE: a handful of nodes at once, synced without edges
+
+				const uint32_t append_count = 1U + rng() % 4U;
+
+				for (uint32_t append_idx = 0; append_idx < append_count; ++append_idx)
+					add_node(graph, static_cast<int32_t>(graph.nodes.size()), 1);
+
+				connectivity.sync(graph);
+			}
+			else if (roll < 6U || edge_count == 0) {
+
+				// NOTE: mostly short edges so components stay mixed, some arrive already broken
+
+				const uint32_t node_a = rng() % node_count;
+				const uint32_t node_b = (rng() % 4U == 0U) ? rng() % node_count : (node_a + 1U + rng() % 3U) % node_count;
+
+				add_edge(graph, node_a, node_b);
+
+				if (rng() % 8U == 0U)
+					graph.edges.back().flags = scn::ghost_edge_broken;
+
+				connectivity.sync(graph);
+			}
+			else {
+				const uint32_t edge_idx = rng() % edge_count;
+				const bool     broken   = (graph.edges[edge_idx].flags & scn::ghost_edge_broken) != 0;
+
+				connectivity.set_edge_broken(graph, edge_idx, !broken);
+			}
+
+			mismatch_count += !same_partition(connectivity, graph);
+
+			if (step % 250U == 0U) {
+				scn::GhostConnectivity rebuilt;
+				rebuilt.rebuild(graph);
+
+				mismatch_count += !same_partition(rebuilt, graph);
+				++rebuild_count;
+			}
+		}
+
+		HPR_CHECK(mismatch_count == 0);
+		HPR_CHECK(rebuild_count == step_count / 250U);
+
+		// NOTE: the overlay was folded along the way, links still cover every conducting edge once
+
+		uint32_t link_count = 0;
+
+		for (uint32_t node = 0; node < graph.nodes.size(); ++node)
+			connectivity.for_each_link(graph, node, [&](uint32_t) { ++link_count; });
+
+		uint32_t conducting_count = 0;
+
+		for (const scn::GhostEdge& edge : graph.edges)
+			conducting_count += !(edge.flags & scn::ghost_edge_broken);
+
+		HPR_CHECK(graph.edges.size() > 2 * scn::cfg::ghost_overlay_fold_min);
+		HPR_CHECK(link_count == conducting_count * 2);
+
+		/* a rebuild keeps sources by node */
+
+		connectivity.set_source(7, true);
+		connectivity.rebuild(graph);
+
+		HPR_CHECK(same_partition(connectivity, graph));
+		HPR_CHECK(connectivity.supplied(7));
+	}
+
+	return test::finish("test_ghost_connectivity");
+}
@@ -0,0 +1,207 @@
+#include <cmath>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "scheduler.hpp"
+#include "ghost_flow.hpp"
+#include "ghost_infra.hpp"
+#include "ghost_connectivity.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+// NOTE: two lines, nodes [0, 4) joined by edges 0..2 and nodes [4, 7) by edges 3..4
+
+[[nodiscard]] scn::GhostGraph make_network(scn::GhostChannel channel)
+{
+	scn::GhostGraph graph;
+
+	for (int32_t x = 0; x < 7; ++x) {
+		graph.nodes.emplace_back(scn::GhostNode {
+			.tile    = scn::TileCoord {.x = x, .z = 0, .storey_index = 0, .storey_stack = 0},
+			.port    = scn::GhostPort::center,
+			.channel = channel
+		});
+	}
+
+	for (const uint32_t node : {0U, 1U, 2U, 4U, 5U})
+		graph.edges.emplace_back(scn::GhostEdge {.a = node, .b = node + 1, .channel = channel});
+
+	return graph;
+}
+
+
+[[nodiscard]] bool near(float lhs, float rhs, float tolerance = 1.0e-3f)
+{
+	return std::fabs(lhs - rhs) <= tolerance;
+}
+
+
+// NOTE: pressure is warm started, a few ticks may be needed before every component settles
+
+uint32_t solve_settled(scn::GhostFlow& flow, job::Scheduler& job_scheduler, const scn::GhostGraph& graph, const scn::GhostConnectivity& connectivity)
+{
+	uint32_t tick_count = 0;
+
+	do {
+		flow.solve(job_scheduler, graph, connectivity);
+		++tick_count;
+	} while (flow.solved_count() != 0 && tick_count < 64);
+
+	return tick_count;
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	/* balance - supply is shared out per component */
+
+	{
+		scn::GhostGraph        graph = make_network(scn::GhostChannel::power);
+		scn::GhostConnectivity connectivity;
+		scn::GhostFlow         flow {scn::GhostFlowModel::balance};
+
+		connectivity.sync(graph);
+
+		flow.set_supply(0, 10.0f);
+		flow.set_demand(1, 2.0f);
+		flow.set_demand(3, 2.0f);
+
+		flow.set_supply(4, 3.0f);
+		flow.set_demand(5, 4.0f);
+		flow.set_demand(6, 4.0f);
+
+		flow.solve(job_scheduler, graph, connectivity);
+
+		HPR_CHECK(flow.solved_count() == 2);
+		HPR_CHECK(near(flow.potential()[3], 1.0f));
+		HPR_CHECK(near(flow.delivered()[1], 2.0f));
+		HPR_CHECK(near(flow.potential()[6], 3.0f / 8.0f));
+		HPR_CHECK(near(flow.delivered()[5], 1.5f));
+
+		/* nothing moved, nothing is solved again */
+
+		flow.solve(job_scheduler, graph, connectivity);
+
+		HPR_CHECK(flow.solved_count() == 0);
+
+		/* a demand change re-solves its own component only */
+
+		flow.set_demand(6, 2.0f);
+		flow.solve(job_scheduler, graph, connectivity);
+
+		HPR_CHECK(flow.solved_count() == 1);
+		HPR_CHECK(near(flow.potential()[5], 0.5f));
+
+		/* cutting the powered line leaves the far end dark */
+
+		connectivity.set_edge_broken(graph, 2, true);
+		flow.solve(job_scheduler, graph, connectivity);
+
+		HPR_CHECK(flow.solved_count() == 2);
+		HPR_CHECK(near(flow.potential()[1], 1.0f));
+		HPR_CHECK(near(flow.delivered()[3], 0.0f));
+
+		/* a new edge joins the two networks through sync */
+
+		graph.edges.emplace_back(scn::GhostEdge {.a = 2, .b = 4, .channel = scn::GhostChannel::power});
+		connectivity.sync(graph);
+
+		flow.solve(job_scheduler, graph, connectivity);
+
+		// NOTE: supply 13 over demand 2 + 4 + 2 on nodes 0..2 and 4..6
+
+		HPR_CHECK(connectivity.connected(0, 6));
+		HPR_CHECK(near(flow.potential()[6], 1.0f));
+		HPR_CHECK(near(flow.potential()[3], 0.0f));
+	}
+
+	/* reach - hops from the nearest supplying node */
+
+	{
+		scn::GhostGraph        graph = make_network(scn::GhostChannel::data);
+		scn::GhostConnectivity connectivity;
+		scn::GhostFlow         flow {scn::GhostFlowModel::reach};
+
+		connectivity.sync(graph);
+
+		flow.set_supply(1, 1.0f);
+
+		flow.solve(job_scheduler, graph, connectivity);
+
+		HPR_CHECK(flow.latency()[1] == 0);
+		HPR_CHECK(flow.latency()[0] == 1);
+		HPR_CHECK(flow.latency()[3] == 2);
+		HPR_CHECK(flow.latency()[5] == scn::GhostFlow::k_unreached);
+		HPR_CHECK(near(flow.potential()[5], 0.0f));
+	}
+
+	/* pressure - heads relax along each line, an unsupplied component drains to zero */
+
+	{
+		scn::GhostGraph        graph = make_network(scn::GhostChannel::pipe);
+		scn::GhostConnectivity connectivity;
+		scn::GhostFlow         flow {scn::GhostFlowModel::pressure};
+
+		connectivity.sync(graph);
+
+		flow.set_supply(0, 1.0f);
+		flow.set_supply(4, 1.0f);
+
+		(void) solve_settled(flow, job_scheduler, graph, connectivity);
+
+		// NOTE: no demand anywhere, every node reaches its source head
+
+		HPR_CHECK(flow.solved_count() == 0);
+
+		for (uint32_t node = 0; node < 7; ++node)
+			HPR_CHECK(near(flow.potential()[node], 1.0f));
+
+		/* demand at the end of a line pulls the head down towards it */
+
+		flow.set_demand(3, 1.0f);
+
+		const uint32_t tick_count = solve_settled(flow, job_scheduler, graph, connectivity);
+
+		HPR_CHECK(tick_count > 1);
+		HPR_CHECK(flow.solved_count() == 0);
+
+		// NOTE: at rest p[n] = sum(p[links]) / (links + demand), on 0-1-2-3 with head 1 and demand 1
+		//       at 3 that is p1 = 3/4, p2 = 1/2, p3 = 1/4
+
+		HPR_CHECK(near(flow.potential()[1], 0.75f));
+		HPR_CHECK(near(flow.potential()[2], 0.5f));
+		HPR_CHECK(near(flow.potential()[3], 0.25f));
+		HPR_CHECK(near(flow.delivered()[3], 0.25f));
+
+		HPR_CHECK(near(flow.potential()[6], 1.0f));
+
+		/* losing its source drains the second line */
+
+		flow.set_supply(4, 0.0f);
+		flow.set_demand(6, 0.5f);
+
+		(void) solve_settled(flow, job_scheduler, graph, connectivity);
+
+		HPR_CHECK(flow.solved_count() == 0);
+		HPR_CHECK(near(flow.potential()[4], 0.0f));
+		HPR_CHECK(near(flow.potential()[6], 0.0f));
+		HPR_CHECK(near(flow.potential()[3], 0.25f));
+	}
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_ghost_flow");
+}
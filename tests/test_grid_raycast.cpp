@@ -0,0 +1,124 @@
+#include <limits>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "math.hpp"
+#include "ray_data.hpp"
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+#include "voxel_data.hpp"
+#include "voxel_field.hpp"
+#include "grid_raycast.hpp"
+
+
+using namespace hpr;
+
+
+int main()
+{
+	test::init();
+
+	static constexpr float inf = std::numeric_limits<float>::infinity();
+
+	/* voxels */
+
+	scn::VoxelField      voxelfield;
+	scn::VoxelGridParams voxel_grid;
+
+	{
+		const scn::VoxelRayHit ray_hit = scn::raycast_voxels(
+			voxelfield, voxel_grid, scn::Ray {vec3 {0.0f, 0.0f, 0.0f}, vec3 {1.0f, 0.0f, 0.0f}}, inf);
+
+		HPR_CHECK(!ray_hit.hit);
+	}
+
+	voxelfield.set(scn::VoxelCoord {10, 4, 4}, 1);
+	voxelfield.set(scn::VoxelCoord {40, 4, 4}, 2);
+
+	{
+		const scn::VoxelRayHit ray_hit = scn::raycast_voxels(
+			voxelfield, voxel_grid, scn::Ray {vec3 {0.25f, 2.25f, 2.25f}, vec3 {1.0f, 0.0f, 0.0f}}, inf);
+
+		HPR_CHECK(ray_hit.hit);
+		HPR_CHECK(ray_hit.coord.x == 10 && ray_hit.coord.y == 4 && ray_hit.coord.z == 4);
+		HPR_CHECK(ray_hit.face == scn::GridFace::neg_x);
+		HPR_CHECK(ray_hit.voxel == 1);
+	}
+
+	{
+		/* misses pointing away, passing beside and starting far outside all terminate */
+
+		const scn::Ray miss_rays[] {
+			{vec3 {0.25f, 2.25f, 2.25f},  vec3 {-1.0f, 0.0f, 0.0f}},
+			{vec3 {0.25f, 9.25f, 2.25f},  vec3 {1.0f, 0.0f, 0.0f}},
+			{vec3 {0.25f, 2.25f, 2.25f},  vec3 {1.0f, 0.3f, 0.7f}},
+			{vec3 {-900.0f, 500.0f, 2.25f}, vec3 {1.0f, 0.0f, 0.0f}},
+			{vec3 {0.25f, 2.25f, 2.25f},  vec3 {0.0f, -1.0f, 0.0f}}
+		};
+
+		for (const scn::Ray& ray : miss_rays) {
+			const scn::VoxelRayHit ray_hit = scn::raycast_voxels(voxelfield, voxel_grid, ray, inf);
+			HPR_CHECK(!ray_hit.hit);
+		}
+	}
+
+	{
+		/* a ray entering the extent from far outside still reaches the far voxel */
+
+		const scn::VoxelRayHit ray_hit = scn::raycast_voxels(
+			voxelfield, voxel_grid, scn::Ray {vec3 {-500.0f, 2.25f, 2.25f}, vec3 {1.0f, 0.0f, 0.0f}}, inf);
+
+		HPR_CHECK(ray_hit.hit);
+		HPR_CHECK(ray_hit.coord.x == 10);
+	}
+
+	{
+		const scn::VoxelRayHit ray_hit = scn::raycast_voxels(
+			voxelfield, voxel_grid, scn::Ray {vec3 {30.0f, 2.25f, 2.25f}, vec3 {-1.0f, 0.0f, 0.0f}}, inf);
+
+		HPR_CHECK(ray_hit.hit);
+		HPR_CHECK(ray_hit.coord.x == 40);
+		HPR_CHECK(ray_hit.face == scn::GridFace::pos_x);
+	}
+
+	/* tiles */
+
+	scn::TileField      tilefield;
+	scn::TileGridParams tile_grid;
+
+	{
+		const scn::TileRayHit ray_hit = scn::raycast_tiles(
+			tilefield, tile_grid, scn::Ray {vec3 {0.0f, 0.0f, 0.0f}, vec3 {0.0f, 0.0f, 1.0f}}, 0, 0, inf);
+
+		HPR_CHECK(!ray_hit.hit);
+	}
+
+	tilefield.resize(64, 64, 1);
+	tilefield.set(scn::TileCoord {20, 6, 0, 0}, 3);
+
+	{
+		const scn::TileRayHit ray_hit = scn::raycast_tiles(
+			tilefield, tile_grid, scn::Ray {vec3 {0.25f, 0.0f, 3.25f}, vec3 {1.0f, 0.0f, 0.0f}}, 0, 0, inf);
+
+		HPR_CHECK(ray_hit.hit);
+		HPR_CHECK(ray_hit.coord.x == 20 && ray_hit.coord.z == 6);
+		HPR_CHECK(ray_hit.face == scn::GridFace::neg_x);
+		HPR_CHECK(ray_hit.tile == 3);
+	}
+
+	{
+		const scn::Ray miss_rays[] {
+			{vec3 {0.25f, 0.0f, 3.25f},   vec3 {-1.0f, 0.0f, 0.0f}},
+			{vec3 {0.25f, 0.0f, 3.25f},   vec3 {1.0f, 0.0f, 1.0f}},
+			{vec3 {-400.0f, 0.0f, 900.0f}, vec3 {1.0f, 0.0f, 0.0f}},
+			{vec3 {0.25f, 0.0f, 3.25f},   vec3 {0.0f, 1.0f, 0.0f}}
+		};
+
+		for (const scn::Ray& ray : miss_rays) {
+			const scn::TileRayHit ray_hit = scn::raycast_tiles(tilefield, tile_grid, ray, 0, 0, inf);
+			HPR_CHECK(!ray_hit.hit);
+		}
+	}
+
+	return test::finish("test_grid_raycast");
+}
@@ -0,0 +1,220 @@
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "harness.hpp"
+#include "math.hpp"
+#include "scheduler.hpp"
+#include "occlusion_cull.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+constexpr float fov_y  = 1.0471976f;
+constexpr float aspect = static_cast<float>(rdr::cfg::occlusion_width) / static_cast<float>(rdr::cfg::occlusion_height);
+
+
+// NOTE: camera at the origin looking down -z, the view is identity and view depth d is world z = -d
+
+[[nodiscard]] mat4 camera_VP()
+{
+	return glm::perspective(fov_y, aspect, 0.1f, 200.0f);
+}
+
+
+[[nodiscard]] float world_x(float screen_x, float depth)
+{
+	const float half_width = static_cast<float>(rdr::cfg::occlusion_width) * 0.5f;
+	return (screen_x / half_width - 1.0f) * depth * std::tan(fov_y * 0.5f) * aspect;
+}
+
+
+[[nodiscard]] float world_y(float screen_y, float depth)
+{
+	const float half_height = static_cast<float>(rdr::cfg::occlusion_height) * 0.5f;
+	return (screen_y / half_height - 1.0f) * depth * std::tan(fov_y * 0.5f);
+}
+
+
+struct Box
+{
+	vec3 center;
+	vec3 half;
+};
+
+
+// NOTE: largest box between the two view depths whose screen rect stays within the given
+//       one on both faces, the face nearer to the screen centre bounds each side
+
+[[nodiscard]] Box box_on_screen(float screen_x0, float screen_y0, float screen_x1, float screen_y1, float depth_near, float depth_far)
+{
+	const vec3 lo {
+		std::max(world_x(screen_x0, depth_near), world_x(screen_x0, depth_far)),
+		std::max(world_y(screen_y0, depth_near), world_y(screen_y0, depth_far)),
+		-depth_far
+	};
+
+	const vec3 hi {
+		std::min(world_x(screen_x1, depth_near), world_x(screen_x1, depth_far)),
+		std::min(world_y(screen_y1, depth_near), world_y(screen_y1, depth_far)),
+		-depth_near
+	};
+
+	return Box {.center = (lo + hi) * 0.5f, .half = (hi - lo) * 0.5f};
+}
+
+
+// NOTE: camera facing quad at a view depth over a screen rect, may reach past the screen
+
+void add_screen_quad(rdr::OcclusionBuffer& occlusion, float screen_x0, float screen_y0, float screen_x1, float screen_y1, float depth)
+{
+	const float x0 = world_x(screen_x0, depth);
+	const float y0 = world_y(screen_y0, depth);
+	const float x1 = world_x(screen_x1, depth);
+	const float y1 = world_y(screen_y1, depth);
+
+	occlusion.add_quad(vec3 {x0, y0, -depth}, vec3 {x1, y0, -depth}, vec3 {x1, y1, -depth}, vec3 {x0, y1, -depth});
+}
+
+
+[[nodiscard]] bool occluded(const rdr::OcclusionBuffer& occlusion, const Box& box)
+{
+	return occlusion.is_occluded(box.center, box.half);
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	const mat4 mtx_VP = camera_VP();
+
+	static constexpr float screen_w = static_cast<float>(rdr::cfg::occlusion_width);
+	static constexpr float screen_h = static_cast<float>(rdr::cfg::occlusion_height);
+
+	rdr::OcclusionBuffer occlusion;
+
+	/* nothing rasterized hides nothing */
+
+	{
+		occlusion.begin(mtx_VP);
+		occlusion.rasterize(job_scheduler);
+
+		HPR_CHECK(occlusion.polygon_count() == 0);
+		HPR_CHECK(!occluded(occlusion, box_on_screen(100.0f, 50.0f, 200.0f, 150.0f, 20.0f, 21.0f)));
+	}
+
+	/* a quad over the whole screen hides what is behind it only */
+
+	{
+		occlusion.begin(mtx_VP);
+		add_screen_quad(occlusion, -screen_w, -screen_h, 2.0f * screen_w, 2.0f * screen_h, 10.0f);
+		occlusion.rasterize(job_scheduler);
+
+		HPR_CHECK(occlusion.polygon_count() == 1);
+
+		HPR_CHECK(occluded(occlusion, box_on_screen(100.0f, 50.0f, 200.0f, 150.0f, 20.0f, 21.0f)));
+		HPR_CHECK(occluded(occlusion, box_on_screen(0.0f, 0.0f, screen_w - 1.0f, screen_h - 1.0f, 10.5f, 30.0f)));
+		HPR_CHECK(occluded(occlusion, box_on_screen(1.0f, 1.0f, 3.0f, 3.0f, 50.0f, 51.0f)));
+
+		// NOTE: in front of the quad, or reaching through it
+
+		HPR_CHECK(!occluded(occlusion, box_on_screen(100.0f, 50.0f, 200.0f, 150.0f, 5.0f, 6.0f)));
+		HPR_CHECK(!occluded(occlusion, box_on_screen(100.0f, 50.0f, 200.0f, 150.0f, 9.0f, 20.0f)));
+
+		// NOTE: corners behind the camera or on the near plane, whatever the rest of the box does
+
+		HPR_CHECK(!occluded(occlusion, Box {.center = vec3 {0.0f, 0.0f, -15.0f}, .half = vec3 {1.0f, 1.0f, 16.0f}}));
+		HPR_CHECK(!occluded(occlusion, Box {.center = vec3 {0.0f, 0.0f, 10.0f}, .half = vec3 {1.0f, 1.0f, 1.0f}}));
+		HPR_CHECK(!occluded(occlusion, Box {.center = vec3 {0.0f, 0.0f, -30.0f}, .half = vec3 {1.0f, 1.0f, 30.0f}}));
+	}
+
+	/* a quad over the left half hides only what stays behind fully covered pixels */
+
+	{
+		// NOTE: the edge runs through the middle of pixel column 160, that column is covered
+		//       in part and must not count
+
+		static constexpr float edge_x = 160.5f;
+
+		occlusion.begin(mtx_VP);
+		add_screen_quad(occlusion, -screen_w, -screen_h, edge_x, 2.0f * screen_h, 10.0f);
+		occlusion.rasterize(job_scheduler);
+
+		HPR_CHECK(occluded(occlusion, box_on_screen(40.0f, 30.0f, 159.75f, 160.0f, 20.0f, 20.5f)));
+		HPR_CHECK(occluded(occlusion, box_on_screen(150.0f, 80.0f, 159.9f, 90.0f, 20.0f, 20.5f)));
+
+		HPR_CHECK(!occluded(occlusion, box_on_screen(40.0f, 30.0f, 160.25f, 160.0f, 20.0f, 20.5f)));
+		HPR_CHECK(!occluded(occlusion, box_on_screen(160.1f, 80.0f, 160.4f, 90.0f, 20.0f, 20.5f)));
+		HPR_CHECK(!occluded(occlusion, box_on_screen(150.0f, 80.0f, 170.0f, 90.0f, 20.0f, 20.5f)));
+
+		// NOTE: beside the quad
+
+		HPR_CHECK(!occluded(occlusion, box_on_screen(200.0f, 30.0f, 300.0f, 160.0f, 20.0f, 20.5f)));
+		HPR_CHECK(!occluded(occlusion, box_on_screen(161.0f, 80.0f, 163.0f, 82.0f, 40.0f, 41.0f)));
+	}
+
+	/* partly covered pixels along a slanted edge never hide anything */
+
+	{
+		// NOTE: the screen cut along its diagonal, the fourth corner sits on the diagonal too.
+		//       probes straddling the diagonal cover pixels the quad covers in part only
+
+		occlusion.begin(mtx_VP);
+
+		const float depth = 10.0f;
+
+		const vec3 corner_a {world_x(-screen_w, depth), world_y(-screen_h, depth), -depth};
+		const vec3 corner_b {world_x(2.0f * screen_w, depth), world_y(-screen_h, depth), -depth};
+		const vec3 corner_c {world_x(2.0f * screen_w, depth), world_y(2.0f * screen_h, depth), -depth};
+		const vec3 corner_d {world_x(0.5f * screen_w, depth), world_y(0.5f * screen_h, depth), -depth};
+
+		occlusion.add_quad(corner_a, corner_b, corner_c, corner_d);
+		occlusion.rasterize(job_scheduler);
+
+		uint32_t hidden_count = 0;
+		uint32_t behind_count = 0;
+
+		for (uint32_t probe = 0; probe < 120; ++probe) {
+
+			// NOTE: the diagonal passes through (x, x * h / w) with the quad below it
+
+			const float screen_x = 20.0f + static_cast<float>(probe) * 2.3f;
+			const float screen_y = screen_x * screen_h / screen_w;
+
+			hidden_count += occluded(occlusion, box_on_screen(screen_x - 0.3f, screen_y - 0.3f, screen_x + 0.3f, screen_y + 0.3f, 20.0f, 20.5f));
+			behind_count += occluded(occlusion, box_on_screen(screen_x + 2.0f, screen_y - 6.0f, screen_x + 3.0f, screen_y - 5.0f, 20.0f, 20.5f));
+		}
+
+		HPR_CHECK(hidden_count == 0);
+		HPR_CHECK(behind_count == 120);
+	}
+
+	/* boxes occlude through their faces */
+
+	{
+		occlusion.begin(mtx_VP);
+		occlusion.add_box(vec3 {0.0f, 0.0f, -12.0f}, vec3 {4.0f, 4.0f, 2.0f});
+		occlusion.rasterize(job_scheduler);
+
+		HPR_CHECK(occlusion.polygon_count() == 6);
+
+		HPR_CHECK(occluded(occlusion, Box {.center = vec3 {0.0f, 0.0f, -30.0f}, .half = vec3 {1.0f, 1.0f, 1.0f}}));
+		HPR_CHECK(!occluded(occlusion, Box {.center = vec3 {0.0f, 0.0f, -30.0f}, .half = vec3 {16.0f, 1.0f, 1.0f}}));
+		HPR_CHECK(!occluded(occlusion, Box {.center = vec3 {0.0f, 0.0f, -8.0f}, .half = vec3 {1.0f, 1.0f, 1.0f}}));
+	}
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_occlusion_cull");
+}
@@ -0,0 +1,298 @@
+#include <span>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "harness.hpp"
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+#include "region_file.hpp"
+#include "region_stream.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+[[nodiscard]] mtp::vault<uint8_t, mtp::default_set> make_payload(size_t bytes, uint8_t seed)
+{
+	mtp::vault<uint8_t, mtp::default_set> payload;
+	payload.resize(static_cast<uint32_t>(bytes));
+
+	for (size_t byte_idx = 0; byte_idx < bytes; ++byte_idx)
+		payload[byte_idx] = static_cast<uint8_t>(seed + byte_idx * 7U);
+
+	return payload;
+}
+
+
+[[nodiscard]] std::span<const uint8_t> as_span(const mtp::vault<uint8_t, mtp::default_set>& payload)
+{
+	return {payload.data(), payload.size()};
+}
+
+
+[[nodiscard]] bool same_bytes(std::span<const uint8_t> lhs, const mtp::vault<uint8_t, mtp::default_set>& rhs)
+{
+	return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+
+[[nodiscard]] size_t sector_beg_of(std::span<const uint8_t> payload, const uint8_t* base)
+{
+	return static_cast<size_t>(payload.data() - base) / scn::cfg::region_sector_bytes;
+}
+
+
+[[nodiscard]] scn::TileChunkCoord tile_chunk(int32_t chunk_x, int32_t chunk_z)
+{
+	return scn::TileChunkCoord {.chunk_x = chunk_x, .chunk_z = chunk_z, .storey_index = 0, .storey_stack = 0};
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	char dir_template[] = "/tmp/hpr_region_XXXXXX";
+	const char* dir_path = ::mkdtemp(dir_template);
+
+	HPR_CHECK(dir_path != nullptr);
+	if (!dir_path)
+		return test::finish("test_region_file");
+
+	const std::string file_path = std::string {dir_path} + "/tile_0_0_0_0.hrg";
+
+	static constexpr scn::RegionCoord region_coord {{0, 0, 0, 0}};
+	static constexpr uint32_t         sector       = scn::cfg::region_sector_bytes;
+	static constexpr uint32_t         header_bytes = scn::RegionFile::k_header_sectors * sector;
+
+	const auto small  = make_payload(100, 1);
+	const auto medium = make_payload(sector + 10, 2);
+	const auto large  = make_payload(sector * 3, 3);
+
+	/* write and read round trip, across a reopen */
+
+	{
+		scn::RegionFile region;
+
+		HPR_CHECK(region.open(file_path.c_str(), scn::RegionKind::tile, region_coord));
+		HPR_CHECK(region.is_open());
+		HPR_CHECK(region.mapped_bytes() == header_bytes);
+		HPR_CHECK(region.read(0).empty());
+
+		HPR_CHECK(region.write(0, as_span(small)));
+		HPR_CHECK(region.write(5, as_span(medium)));
+
+		HPR_CHECK(same_bytes(region.read(0), small));
+		HPR_CHECK(same_bytes(region.read(5), medium));
+		HPR_CHECK(region.mapped_bytes() == header_bytes + 3 * sector);
+	}
+
+	{
+		scn::RegionFile region;
+
+		HPR_CHECK(region.open(file_path.c_str(), scn::RegionKind::tile, region_coord));
+		HPR_CHECK(same_bytes(region.read(0), small));
+		HPR_CHECK(same_bytes(region.read(5), medium));
+		HPR_CHECK(region.coord().axis[0] == 0);
+
+		/* a kind mismatch is refused */
+
+		scn::RegionFile voxel_region;
+		HPR_CHECK(!voxel_region.open(file_path.c_str(), scn::RegionKind::voxel, region_coord));
+		HPR_CHECK(!voxel_region.is_open());
+	}
+
+	/* growing a slot moves its payload to a gap that fits, the freed run is reused */
+
+	{
+		scn::RegionFile region;
+
+		HPR_CHECK(region.open(file_path.c_str(), scn::RegionKind::tile, region_coord));
+
+		const uint8_t* base = region.read(0).data() - header_bytes;
+
+		HPR_CHECK(sector_beg_of(region.read(0), base) == scn::RegionFile::k_header_sectors);
+
+		// NOTE: slot 0 sits in front of slot 5, three sectors do not fit there
+
+		HPR_CHECK(region.write(0, as_span(large)));
+
+		base = region.read(5).data() - (scn::RegionFile::k_header_sectors + 1) * sector;
+
+		HPR_CHECK(same_bytes(region.read(0), large));
+		HPR_CHECK(same_bytes(region.read(5), medium));
+		HPR_CHECK(sector_beg_of(region.read(0), base) == scn::RegionFile::k_header_sectors + 3);
+		HPR_CHECK(region.mapped_bytes() == header_bytes + 6 * sector);
+
+		HPR_CHECK(region.write(9, as_span(small)));
+
+		HPR_CHECK(sector_beg_of(region.read(9), base) == scn::RegionFile::k_header_sectors);
+		HPR_CHECK(region.mapped_bytes() == header_bytes + 6 * sector);
+
+		/* an empty payload frees the slot */
+
+		HPR_CHECK(region.write(9, {}));
+		HPR_CHECK(region.read(9).empty());
+		HPR_CHECK(same_bytes(region.read(0), large));
+	}
+
+	/* a truncated file keeps the slots that still fit and drops the rest */
+
+	{
+		HPR_CHECK(::truncate(file_path.c_str(), static_cast<off_t>(header_bytes + 3 * sector)) == 0);
+
+		scn::RegionFile region;
+
+		HPR_CHECK(region.open(file_path.c_str(), scn::RegionKind::tile, region_coord));
+		HPR_CHECK(same_bytes(region.read(5), medium));
+		HPR_CHECK(region.read(0).empty());
+
+		HPR_CHECK(region.write(0, as_span(small)));
+		HPR_CHECK(same_bytes(region.read(0), small));
+		HPR_CHECK(same_bytes(region.read(5), medium));
+	}
+
+	/* a file cut off mid sector, or inside the header, or with a bad magic, is refused */
+
+	{
+		HPR_CHECK(::truncate(file_path.c_str(), static_cast<off_t>(header_bytes + sector + 10)) == 0);
+
+		scn::RegionFile region;
+		HPR_CHECK(!region.open(file_path.c_str(), scn::RegionKind::tile, region_coord));
+
+		HPR_CHECK(::truncate(file_path.c_str(), 100) == 0);
+		HPR_CHECK(!region.open(file_path.c_str(), scn::RegionKind::tile, region_coord));
+
+		HPR_CHECK(::truncate(file_path.c_str(), static_cast<off_t>(header_bytes)) == 0);
+
+		const int file_handle = ::open(file_path.c_str(), O_WRONLY);
+		const uint32_t bad_magic = 0xDEADBEEFU;
+		HPR_CHECK(::pwrite(file_handle, &bad_magic, sizeof(bad_magic), 0) == sizeof(bad_magic));
+		::close(file_handle);
+
+		HPR_CHECK(!region.open(file_path.c_str(), scn::RegionKind::tile, region_coord));
+		HPR_CHECK(!region.is_open());
+	}
+
+	/* stream - resident lru evicts the coldest chunks and writes them back */
+
+	{
+		const std::string stream_path = std::string {dir_path} + "/stream";
+
+		scn::TileField         tilefield;
+		scn::TileRegionStream  stream;
+
+		stream.open(stream_path.c_str(), 4);
+
+		mtp::vault<scn::TileChunkCoord, mtp::default_set> wanted;
+		mtp::vault<scn::TileChunkCoord, mtp::default_set> evicted;
+		uint32_t loaded_count = 0;
+
+		const auto on_load  = [&](scn::TileChunkCoord) { ++loaded_count; };
+		const auto on_evict = [&](scn::TileChunkCoord chunk_coord) { evicted.emplace_back(chunk_coord); };
+
+		for (int32_t chunk_x = 0; chunk_x < 6; ++chunk_x) {
+
+			scn::TileChunk& chunk = tilefield.ensure_chunk(tile_chunk(chunk_x, 0), 0);
+			chunk.tiles[0] = static_cast<scn::TileType>(10 + chunk_x);
+
+			wanted.clear();
+			wanted.emplace_back(tile_chunk(chunk_x, 0));
+
+			stream.update(tilefield, std::span<const scn::TileChunkCoord> {wanted.data(), wanted.size()}, on_load, on_evict);
+		}
+
+		HPR_CHECK(stream.resident_count() == 4);
+		HPR_CHECK(evicted.size() == 2 && evicted[0].chunk_x == 0 && evicted[1].chunk_x == 1);
+		HPR_CHECK(tilefield.find_chunk(tile_chunk(0, 0)) == nullptr);
+		HPR_CHECK(tilefield.find_chunk(tile_chunk(5, 0)) != nullptr);
+
+		/* a chunk requested again comes back from disk, the coldest resident one leaves */
+
+		wanted.clear();
+		wanted.emplace_back(tile_chunk(0, 0));
+
+		stream.update(tilefield, std::span<const scn::TileChunkCoord> {wanted.data(), wanted.size()}, on_load, on_evict);
+
+		HPR_CHECK(loaded_count == 1);
+		HPR_CHECK(tilefield.get(scn::TileCoord {0, 0, 0, 0}) == 10);
+		HPR_CHECK(evicted.size() == 3 && evicted[2].chunk_x == 2);
+
+		/* a request over ground never written loads nothing */
+
+		wanted.clear();
+		wanted.emplace_back(tile_chunk(900, 900));
+
+		stream.update(tilefield, std::span<const scn::TileChunkCoord> {wanted.data(), wanted.size()}, on_load, on_evict);
+
+		HPR_CHECK(loaded_count == 1);
+		HPR_CHECK(tilefield.find_chunk(tile_chunk(900, 900)) == nullptr);
+
+		stream.close(tilefield);
+	}
+
+	/* stream - open region files stay within region_open_budget */
+
+	{
+		const std::string stream_path = std::string {dir_path} + "/budget";
+
+		static constexpr int32_t region_count = static_cast<int32_t>(scn::cfg::region_open_budget) + 8;
+		static constexpr int32_t region_side  = 1 << scn::cfg::tile_region_shift;
+
+		scn::TileField        tilefield;
+		scn::TileRegionStream stream;
+
+		stream.open(stream_path.c_str(), 1);
+
+		mtp::vault<scn::TileChunkCoord, mtp::default_set> wanted;
+
+		const auto on_load  = [](scn::TileChunkCoord) {};
+		const auto on_evict = [](scn::TileChunkCoord) {};
+
+		for (int32_t region_x = 0; region_x < region_count; ++region_x) {
+
+			scn::TileChunk& chunk = tilefield.ensure_chunk(tile_chunk(region_x * region_side, 0), 0);
+			chunk.tiles[1] = static_cast<scn::TileType>(region_x + 1);
+
+			wanted.clear();
+			wanted.emplace_back(chunk.coord);
+
+			stream.update(tilefield, std::span<const scn::TileChunkCoord> {wanted.data(), wanted.size()}, on_load, on_evict);
+
+			HPR_CHECK(stream.open_region_count() <= scn::cfg::region_open_budget);
+		}
+
+		HPR_CHECK(stream.open_region_count() == scn::cfg::region_open_budget);
+
+		/* the first regions were closed, their chunks still read back */
+
+		for (int32_t region_x = 0; region_x < 4; ++region_x) {
+
+			wanted.clear();
+			wanted.emplace_back(tile_chunk(region_x * region_side, 0));
+
+			stream.update(tilefield, std::span<const scn::TileChunkCoord> {wanted.data(), wanted.size()}, on_load, on_evict);
+
+			HPR_CHECK(tilefield.get(scn::TileCoord {region_x * region_side * scn::cfg::chunk_size + 1, 0, 0, 0}) == region_x + 1);
+			HPR_CHECK(stream.open_region_count() <= scn::cfg::region_open_budget);
+		}
+
+		stream.close(tilefield);
+	}
+
+	std::filesystem::remove_all(dir_path);
+
+	return test::finish("test_region_file");
+}
@@ -0,0 +1,276 @@
+#include <span>
+#include <array>
+#include <cmath>
+#include <random>
+#include <limits>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "scheduler.hpp"
+#include "scene_fixture.hpp"
+
+#include "math.hpp"
+#include "entity.hpp"
+#include "ray_data.hpp"
+#include "scene_query.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+constexpr uint32_t model_count = 40;
+
+
+[[nodiscard]] vec3 random_point(std::mt19937& rng, float extent)
+{
+	std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+	return vec3 {unit(rng), unit(rng), unit(rng)} * extent;
+}
+
+
+// NOTE: rays from around the scene towards points inside it, every fifth one pointing away
+//       so packets mix lanes that hit with lanes the bound tree drops early
+
+[[nodiscard]] mtp::vault<scn::Ray, mtp::default_set> random_rays(std::mt19937& rng, uint32_t ray_count)
+{
+	mtp::vault<scn::Ray, mtp::default_set> rays;
+
+	for (uint32_t ray_idx = 0; ray_idx < ray_count; ++ray_idx) {
+
+		const vec3 origin = random_point(rng, 20.0f);
+		const vec3 target = random_point(rng, 4.0f);
+
+		rays.emplace_back(scn::Ray {.origin = origin, .direction = (ray_idx % 5U == 4U) ? origin - target : target - origin});
+	}
+
+	return rays;
+}
+
+
+struct RayTally
+{
+	uint32_t hit_count      {0};
+	uint32_t mismatch_count {0};
+};
+
+
+// NOTE: the batch, and packets of the rays in their given order, against raycast_scene ray by ray
+
+RayTally compare_batch(job::Scheduler& job_scheduler, test::SceneFixture& fixture, std::span<const scn::Ray> rays)
+{
+	const uint32_t ray_count = static_cast<uint32_t>(rays.size());
+
+	mtp::vault<scn::RayHit, mtp::default_set> batch_hits;
+	mtp::vault<scn::RayHit, mtp::default_set> packet_hits;
+	batch_hits.resize(ray_count);
+	packet_hits.resize(ray_count);
+
+	scn::raycast_scene_batch(
+		job_scheduler,
+		rays,
+		std::span<scn::RayHit> {batch_hits.data(), batch_hits.size()},
+		fixture.registry,
+		fixture.scene,
+		fixture.resolver
+	);
+
+	mtp::vault<uint32_t, mtp::default_set> ray_order;
+
+	for (uint32_t ray_idx = 0; ray_idx < ray_count; ++ray_idx)
+		ray_order.emplace_back(ray_idx);
+
+	scn::SceneRayJobSlice<test::SceneRegistry> slice {
+		.begin     = 0,
+		.end       = (ray_count + scn::cfg::scene_ray_packet_size - 1) / scn::cfg::scene_ray_packet_size,
+		.rays      = rays.data(),
+		.ray_order = ray_order.data(),
+		.ray_count = ray_count,
+		.ray_hits  = packet_hits.data(),
+		.registry  = &fixture.registry,
+		.scene     = &fixture.scene,
+		.resolver  = &fixture.resolver
+	};
+
+	scn::raycast_scene_packets<test::SceneRegistry>(&slice);
+
+	RayTally tally {};
+
+	for (uint32_t ray_idx = 0; ray_idx < ray_count; ++ray_idx) {
+
+		scn::Ray ray = rays[ray_idx];
+
+		const scn::RayHit single_hit = scn::raycast_scene(ray, fixture.registry, fixture.scene, fixture.resolver);
+
+		tally.mismatch_count += !test::same_hit(batch_hits[ray_idx], single_hit);
+		tally.mismatch_count += !test::same_hit(packet_hits[ray_idx], single_hit);
+		tally.hit_count      += single_hit.hit;
+	}
+
+	return tally;
+}
+
+
+// NOTE: lanes outside the mask keep what they held, the others get raycast_submesh's answer
+
+uint32_t compare_submesh_packet(test::SceneFixture& fixture, std::mt19937& rng, ecs::Entity entity, uint32_t ray_mask)
+{
+	std::array<vec3,  scn::cfg::scene_ray_packet_size> ray_origins;
+	std::array<vec3,  scn::cfg::scene_ray_packet_size> ray_directions;
+	std::array<float, scn::cfg::scene_ray_packet_size> max_distances;
+	std::array<float, scn::cfg::scene_ray_packet_size> closest_distances;
+
+	const vec3 entity_center = fixture.registry.get<ecs::BoundComponent>(entity)->world_center;
+
+	for (uint32_t ray = 0; ray < scn::cfg::scene_ray_packet_size; ++ray) {
+
+		ray_origins[ray]       = entity_center + random_point(rng, 6.0f);
+		ray_directions[ray]    = glm::normalize(entity_center + random_point(rng, 0.5f) - ray_origins[ray]);
+		max_distances[ray]     = (ray % 3U == 2U) ? 4.0f : std::numeric_limits<float>::infinity();
+		closest_distances[ray] = -1.0f;
+	}
+
+	uint32_t mismatch_count = 0;
+
+	for (uint32_t submesh = 0; submesh < 2; ++submesh) {
+
+		scn::raycast_submesh_packet(
+			fixture.registry,
+			fixture.scene,
+			fixture.resolver,
+			entity,
+			submesh,
+			std::span<const vec3> {ray_origins},
+			std::span<const vec3> {ray_directions},
+			std::span<const float> {max_distances},
+			ray_mask,
+			std::span<float> {closest_distances}
+		);
+
+		for (uint32_t ray = 0; ray < scn::cfg::scene_ray_packet_size; ++ray) {
+
+			if (!(ray_mask & (1U << ray))) {
+				mismatch_count += closest_distances[ray] != -1.0f;
+				continue;
+			}
+
+			const float expected = scn::raycast_submesh(
+				fixture.registry,
+				fixture.scene,
+				fixture.resolver,
+				entity,
+				submesh,
+				ray_origins[ray],
+				ray_directions[ray],
+				max_distances[ray]
+			);
+
+			if (std::isinf(expected) || std::isinf(closest_distances[ray]))
+				mismatch_count += std::isinf(expected) != std::isinf(closest_distances[ray]);
+			else
+				mismatch_count += std::fabs(expected - closest_distances[ray]) > 1.0e-3f * (1.0f + expected);
+		}
+	}
+
+	return mismatch_count;
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	std::mt19937 rng {460};
+
+	test::SceneFixture fixture;
+
+	mtp::vault<ecs::Entity, mtp::default_set> models;
+
+	for (uint32_t model_idx = 0; model_idx < model_count; ++model_idx)
+		models.emplace_back(fixture.add_model(rng, 64));
+
+	fixture.scene.bound_tree().attach(fixture.registry);
+
+	for (const ecs::Entity entity : models)
+		fixture.place_random(entity, rng, 8.0f);
+
+	fixture.scene.bound_tree().sync(fixture.registry);
+
+	/* an empty batch writes nothing */
+
+	{
+		scn::RayHit untouched {.hit = true, .entity = models[0], .submesh = 1, .closest_hit_distance = 2.0f};
+
+		scn::raycast_scene_batch(
+			job_scheduler,
+			std::span<const scn::Ray> {},
+			std::span<scn::RayHit> {&untouched, 1},
+			fixture.registry,
+			fixture.scene,
+			fixture.resolver
+		);
+
+		HPR_CHECK(untouched.hit && untouched.submesh == 1);
+	}
+
+	/* batches and packets agree with raycast_scene, before and after the bvhs */
+
+	{
+		RayTally total {};
+
+		uint32_t lane_mismatch_count = 0;
+
+		const auto cast_batches = [&]()
+		{
+			// NOTE: a lone ray, one short packet, a short last packet, and enough packets for
+			//       several jobs
+
+			for (const uint32_t ray_count : {1U, 5U, 13U, 403U}) {
+
+				const mtp::vault<scn::Ray, mtp::default_set> rays = random_rays(rng, ray_count);
+				const RayTally tally = compare_batch(job_scheduler, fixture, std::span<const scn::Ray> {rays.data(), rays.size()});
+
+				total.hit_count      += tally.hit_count;
+				total.mismatch_count += tally.mismatch_count;
+			}
+
+			// NOTE: submesh packets only touch the masked lanes
+
+			for (uint32_t round = 0; round < 40; ++round) {
+
+				const uint32_t ray_mask = static_cast<uint32_t>(rng()) & ((1U << scn::cfg::scene_ray_packet_size) - 1U);
+
+				lane_mismatch_count += compare_submesh_packet(fixture, rng, models[rng() % models.size()], ray_mask);
+			}
+		};
+
+		cast_batches();
+
+		fixture.build_bvhs();
+
+		for (uint32_t model_idx = 0; model_idx < 10; ++model_idx)
+			fixture.place_random(models[rng() % models.size()], rng, 8.0f);
+
+		fixture.scene.bound_tree().sync(fixture.registry);
+
+		cast_batches();
+
+		HPR_CHECK(total.mismatch_count == 0);
+		HPR_CHECK(total.hit_count > 120);
+		HPR_CHECK(lane_mismatch_count == 0);
+	}
+
+	fixture.scene.bound_tree().detach(fixture.registry);
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_scene_raycast");
+}
@@ -0,0 +1,373 @@
+#include <span>
+#include <array>
+#include <cmath>
+#include <random>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "harness.hpp"
+#include "scheduler.hpp"
+
+#include "math.hpp"
+#include "entity.hpp"
+#include "tile_data.hpp"
+#include "ecs_registry.hpp"
+#include "spatial_hash.hpp"
+#include "components_scene.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+using HashRegistry = ecs::Registry<ecs::TransformComponent>;
+
+
+constexpr float    tile_size   = 0.5f;
+constexpr float    cell_size   = tile_size * static_cast<float>(scn::cfg::spatial_hash_cell_tiles);
+constexpr uint32_t nearest_max = 12;
+
+
+struct Body
+{
+	ecs::Entity entity;
+	vec3        position;
+};
+
+
+void place(HashRegistry& registry, Body& body, const vec3& position)
+{
+	body.position = position;
+
+	ecs::TransformComponent& transform = *registry.get<ecs::TransformComponent>(body.entity);
+
+	transform.world    = mat4 {1.0f};
+	transform.world[3] = vec4 {position, 1.0f};
+}
+
+
+[[nodiscard]] Body add_body(HashRegistry& registry, const vec3& position)
+{
+	Body body {.entity = registry.create_entity(), .position = vec3 {0.0f}};
+
+	registry.add<ecs::TransformComponent>(body.entity, ecs::TransformComponent {});
+
+	place(registry, body, position);
+
+	return body;
+}
+
+
+[[nodiscard]] float distance_sq(const vec3& lhs, const vec3& rhs)
+{
+	return glm::dot(lhs - rhs, lhs - rhs);
+}
+
+
+// NOTE: the same mix as SpatialHash::bucket_index, to pick cells that share a bucket
+
+[[nodiscard]] uint32_t bucket_of(int32_t cell_x, int32_t cell_z, uint32_t bucket_mask)
+{
+	const uint32_t hash =
+		static_cast<uint32_t>(cell_x) * 73856093U ^
+		static_cast<uint32_t>(cell_z) * 19349663U;
+
+	return (hash ^ (hash >> 16)) & bucket_mask;
+}
+
+
+struct HashTally
+{
+	uint32_t query_count    {0};
+	uint32_t hit_count      {0};
+	uint32_t pair_count     {0};
+	uint32_t mismatch_count {0};
+};
+
+
+// NOTE: every query kind against a scan over every body, centers near bodies, between them
+//       and far outside the populated area
+
+void compare_queries(const scn::SpatialHash& hash, std::span<const Body> bodies, std::mt19937& rng, float extent, HashTally& tally)
+{
+	std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+
+	/* entries */
+
+	{
+		mtp::vault<ecs::Entity, mtp::default_set> hashed;
+		mtp::vault<ecs::Entity, mtp::default_set> expected;
+
+		for (const scn::SpatialHashEntry& entry : hash.entries())
+			hashed.emplace_back(entry.entity);
+
+		for (const Body& body : bodies)
+			expected.emplace_back(body.entity);
+
+		std::sort(hashed.begin(), hashed.end());
+		std::sort(expected.begin(), expected.end());
+
+		tally.mismatch_count += hashed != expected;
+	}
+
+	mtp::vault<ecs::Entity, mtp::default_set> hashed;
+	mtp::vault<ecs::Entity, mtp::default_set> expected;
+
+	for (uint32_t query_idx = 0; query_idx < 200; ++query_idx) {
+
+		vec3 center = vec3 {unit(rng), unit(rng) * 0.1f, unit(rng)} * extent;
+
+		if (query_idx % 4U == 0U && !bodies.empty())
+			center = bodies[rng() % bodies.size()].position;
+		if (query_idx % 37U == 5U)
+			center = vec3 {extent * 40.0f, 0.0f, -extent * 40.0f};
+
+		// NOTE: from inside one cell up to wider than the whole area, which scans flat
+
+		const float radius = (query_idx % 9U == 8U) ? extent * 4.0f : cell_size * (0.1f + 3.0f * (unit(rng) * 0.5f + 0.5f));
+
+		/* radius */
+
+		hashed.clear();
+		expected.clear();
+
+		hash.query_radius(center, radius, [&](ecs::Entity entity, const vec3& position, float entity_distance_sq)
+		{
+			hashed.emplace_back(entity);
+			tally.mismatch_count += entity_distance_sq != distance_sq(position, center);
+		});
+
+		for (const Body& body : bodies) {
+			if (distance_sq(body.position, center) <= radius * radius)
+				expected.emplace_back(body.entity);
+		}
+
+		std::sort(hashed.begin(), hashed.end());
+		std::sort(expected.begin(), expected.end());
+
+		tally.mismatch_count += hashed != expected;
+		tally.hit_count      += static_cast<uint32_t>(expected.size());
+
+		/* nearest */
+
+		const uint32_t    k              = 1U + static_cast<uint32_t>(rng() % nearest_max);
+		const ecs::Entity exclude_entity = (query_idx % 4U == 0U && !bodies.empty()) ? bodies[rng() % bodies.size()].entity : ecs::invalid_entity;
+		const float       max_radius     = (query_idx % 3U == 0U) ? std::numeric_limits<float>::infinity() : radius;
+
+		std::array<scn::SpatialHashNeighbor, nearest_max> nearest {};
+
+		const uint32_t found_count = hash.query_nearest(center, max_radius, std::span<scn::SpatialHashNeighbor> {nearest.data(), k}, exclude_entity);
+
+		mtp::vault<float, mtp::default_set> expected_distances;
+
+		for (const Body& body : bodies) {
+			const float body_distance_sq = distance_sq(body.position, center);
+			if (body.entity != exclude_entity && body_distance_sq <= max_radius * max_radius)
+				expected_distances.emplace_back(body_distance_sq);
+		}
+
+		std::sort(expected_distances.begin(), expected_distances.end());
+		expected_distances.resize(std::min<size_t>(expected_distances.size(), k));
+
+		tally.mismatch_count += found_count != expected_distances.size();
+
+		for (uint32_t found_idx = 0; found_idx < std::min<uint32_t>(found_count, static_cast<uint32_t>(expected_distances.size())); ++found_idx) {
+
+			const scn::SpatialHashNeighbor& neighbor = nearest[found_idx];
+
+			// NOTE: ties may pick either entity, the distances are what has to match. the hash
+			//       computes them in its own order, so only up to rounding
+
+			tally.mismatch_count += std::fabs(neighbor.distance_sq - expected_distances[found_idx]) > 1.0e-5f * (1.0f + expected_distances[found_idx]);
+			tally.mismatch_count += neighbor.entity == exclude_entity;
+
+			for (uint32_t other_idx = 0; other_idx < found_idx; ++other_idx)
+				tally.mismatch_count += nearest[other_idx].entity == neighbor.entity;
+		}
+
+		++tally.query_count;
+	}
+
+	/* pairs */
+
+	for (const float pair_radius : {cell_size * 0.3f, cell_size}) {
+
+		mtp::vault<uint64_t, mtp::default_set> hashed_pairs;
+		mtp::vault<uint64_t, mtp::default_set> expected_pairs;
+
+		const auto pair_key = [](ecs::Entity lhs, ecs::Entity rhs)
+		{
+			return static_cast<uint64_t>(std::min(lhs, rhs)) << 32 | std::max(lhs, rhs);
+		};
+
+		hash.for_each_pair(pair_radius, [&](ecs::Entity entity_a, ecs::Entity entity_b, float)
+		{
+			tally.mismatch_count += entity_a == entity_b;
+			hashed_pairs.emplace_back(pair_key(entity_a, entity_b));
+		});
+
+		for (uint32_t body_a = 0; body_a < bodies.size(); ++body_a) {
+			for (uint32_t body_b = body_a + 1; body_b < bodies.size(); ++body_b) {
+				if (distance_sq(bodies[body_a].position, bodies[body_b].position) <= pair_radius * pair_radius)
+					expected_pairs.emplace_back(pair_key(bodies[body_a].entity, bodies[body_b].entity));
+			}
+		}
+
+		// NOTE: sorted, not deduplicated, so a pair reported twice is a mismatch
+
+		std::sort(hashed_pairs.begin(), hashed_pairs.end());
+		std::sort(expected_pairs.begin(), expected_pairs.end());
+
+		tally.mismatch_count += hashed_pairs != expected_pairs;
+		tally.pair_count     += static_cast<uint32_t>(expected_pairs.size());
+	}
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	std::mt19937 rng {50};
+
+	std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+
+	const scn::TileGridParams grid {.origin_world = vec3 {-3.0f, 0.0f, 1.25f}, .tile_size = tile_size};
+
+	/* an empty hash answers nothing */
+
+	{
+		HashRegistry     registry;
+		scn::SpatialHash hash;
+
+		hash.rebuild(job_scheduler, registry, grid);
+
+		std::array<scn::SpatialHashNeighbor, 4> nearest {};
+
+		uint32_t hit_count = 0;
+
+		hash.query_radius(vec3 {0.0f}, 100.0f, [&](ecs::Entity, const vec3&, float) { ++hit_count; });
+		hash.for_each_pair(cell_size, [&](ecs::Entity, ecs::Entity, float) { ++hit_count; });
+
+		HPR_CHECK(hash.size() == 0);
+		HPR_CHECK(hit_count == 0);
+		HPR_CHECK(hash.query_nearest(vec3 {0.0f}, 100.0f, nearest) == 0);
+	}
+
+	/* queries match brute force over several rebuild jobs, across moves and removals */
+
+	{
+		HashRegistry     registry;
+		scn::SpatialHash hash;
+
+		mtp::vault<Body, mtp::default_set> bodies;
+
+		// NOTE: spread out plus a dense clump, around and below the grid origin
+
+		static constexpr float extent = 60.0f;
+
+		const uint32_t body_count = scn::cfg::spatial_hash_job_grain * 2U + 300U;
+
+		for (uint32_t body_idx = 0; body_idx < body_count; ++body_idx) {
+
+			const float body_extent = (body_idx % 4U == 0U) ? cell_size * 2.0f : extent;
+
+			bodies.emplace_back(add_body(registry, vec3 {unit(rng), unit(rng) * 0.1f, unit(rng)} * body_extent));
+		}
+
+		HashTally tally {};
+
+		hash.rebuild(job_scheduler, registry, grid);
+
+		HPR_CHECK(hash.size() == body_count);
+		HPR_CHECK(hash.cell_size() == cell_size);
+
+		compare_queries(hash, std::span<const Body> {bodies.data(), bodies.size()}, rng, extent, tally);
+
+		for (uint32_t step = 0; step < 3; ++step) {
+
+			for (Body& body : bodies)
+				place(registry, body, body.position + vec3 {unit(rng), 0.0f, unit(rng)} * cell_size);
+
+			for (uint32_t removed = 0; removed < 500; ++removed) {
+
+				const uint32_t body_idx = static_cast<uint32_t>(rng() % bodies.size());
+
+				registry.destroy_entity(bodies[body_idx].entity);
+
+				bodies[body_idx] = bodies.back();
+				bodies.pop_back();
+			}
+
+			hash.rebuild(job_scheduler, registry, grid);
+
+			HPR_CHECK(hash.size() == bodies.size());
+
+			compare_queries(hash, std::span<const Body> {bodies.data(), bodies.size()}, rng, extent, tally);
+		}
+
+		HPR_CHECK(tally.mismatch_count == 0);
+		HPR_CHECK(tally.query_count == 800);
+		HPR_CHECK(tally.hit_count > 5000);
+		HPR_CHECK(tally.pair_count > 1000);
+	}
+
+	/* cells sharing a bucket never leak into each other */
+
+	{
+		HashRegistry     registry;
+		scn::SpatialHash hash;
+
+		mtp::vault<Body, mtp::default_set> bodies;
+
+		// NOTE: fewer bodies than the minimum bucket count keeps the mask fixed, every cell
+		//       that lands in bucket 0 within reach gets a few bodies, so neighbouring and
+		//       far apart cells alike collide
+
+		static constexpr uint32_t bucket_mask = scn::cfg::spatial_hash_min_buckets - 1;
+		static constexpr int32_t  cell_reach  = 40;
+
+		for (int32_t cell_z = -cell_reach; cell_z < cell_reach && bodies.size() + 3 <= bucket_mask; ++cell_z) {
+			for (int32_t cell_x = -cell_reach; cell_x < cell_reach && bodies.size() + 3 <= bucket_mask; ++cell_x) {
+
+				if (bucket_of(cell_x, cell_z, bucket_mask) != 0)
+					continue;
+
+				for (uint32_t body_idx = 0; body_idx < 3; ++body_idx) {
+
+					const vec3 in_cell {
+						grid.origin_world.x + (static_cast<float>(cell_x) + 0.5f + 0.45f * unit(rng)) * cell_size,
+						unit(rng),
+						grid.origin_world.z + (static_cast<float>(cell_z) + 0.5f + 0.45f * unit(rng)) * cell_size
+					};
+
+					bodies.emplace_back(add_body(registry, in_cell));
+				}
+			}
+		}
+
+		HPR_CHECK(bodies.size() > 30);
+
+		hash.rebuild(job_scheduler, registry, grid);
+
+		HashTally tally {};
+
+		compare_queries(hash, std::span<const Body> {bodies.data(), bodies.size()}, rng, static_cast<float>(cell_reach) * cell_size, tally);
+
+		HPR_CHECK(tally.mismatch_count == 0);
+		HPR_CHECK(tally.hit_count > 0);
+	}
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_spatial_hash");
+}
@@ -0,0 +1,289 @@
+#include <map>
+#include <tuple>
+#include <random>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "scheduler.hpp"
+#include "tile_data.hpp"
+#include "tile_path.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "tile_change.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+using ChunkKey   = std::tuple<int32_t, int32_t, int32_t, int32_t>;
+using ChunkMasks = std::map<ChunkKey, scn::TileChunkMask>;
+
+
+[[nodiscard]] ChunkKey chunk_key(scn::TileChunkCoord coord)
+{
+	return ChunkKey {coord.chunk_x, coord.chunk_z, coord.storey_index, coord.storey_stack};
+}
+
+
+[[nodiscard]] bool same_mask(const scn::TileChunkMask& lhs, const scn::TileChunkMask& rhs)
+{
+	for (uint32_t word = 0; word < scn::TileChunkMask::k_words; ++word) {
+		if (lhs.bits[word] != rhs.bits[word])
+			return false;
+	}
+	return true;
+}
+
+
+// NOTE: every sealed tick kept whole, what pull() has to report is the merge of the ticks
+//       newer than the cursor that the log still holds
+
+struct ChangeReference
+{
+	mtp::vault<ChunkMasks, mtp::default_set> ticks;
+	ChunkMasks                               open;
+
+	void record(scn::TileChunkCoord coord, const scn::TileChunkMask& mask)
+	{
+		open[chunk_key(coord)].merge(mask);
+	}
+
+	void end_tick()
+	{
+		if (open.empty())
+			return;
+
+		ticks.emplace_back(std::move(open));
+		open.clear();
+	}
+
+	[[nodiscard]] uint64_t version() const
+	{
+		return ticks.size();
+	}
+
+	[[nodiscard]] uint64_t dropped_version() const
+	{
+		return version() > scn::cfg::tile_change_history ? version() - scn::cfg::tile_change_history : 0;
+	}
+
+	[[nodiscard]] ChunkMasks since(uint64_t cursor_version) const
+	{
+		ChunkMasks merged;
+
+		for (uint64_t version = std::max(cursor_version, dropped_version()); version < ticks.size(); ++version) {
+			for (const auto& [key, mask] : ticks[version])
+				merged[key].merge(mask);
+		}
+
+		return merged;
+	}
+};
+
+
+struct Consumer
+{
+	scn::TileChangeCursor cursor;
+	uint32_t              pull_percent;
+};
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	std::mt19937 rng {43};
+
+	/* pulls merge every sealed tick newer than the cursor, stale cursors are told */
+
+	{
+		scn::TileChangeLog change_log;
+		ChangeReference    reference;
+
+		// NOTE: one consumer pulls every tick, one now and then, one so rarely it falls out of
+		//       the history, one joins late
+
+		Consumer consumers [] {
+			Consumer {.cursor = change_log.subscribe(), .pull_percent = 100},
+			Consumer {.cursor = change_log.subscribe(), .pull_percent = 15},
+			Consumer {.cursor = change_log.subscribe(), .pull_percent = 1},
+			Consumer {.cursor = {},                     .pull_percent = 30}
+		};
+
+		uint32_t pull_count       = 0;
+		uint32_t merged_count     = 0;
+		uint32_t incomplete_count = 0;
+		uint32_t mismatch_count   = 0;
+
+		const auto pull = [&](Consumer& consumer)
+		{
+			const uint64_t   cursor_version = consumer.cursor.version;
+			const ChunkMasks expected       = reference.since(cursor_version);
+
+			ChunkMasks reported;
+
+			const bool complete = change_log.pull(consumer.cursor, [&](const scn::TileChange& change)
+			{
+				mismatch_count += change.key != scn::get_chunk_coord_hash(change.coord);
+				mismatch_count += !reported.emplace(chunk_key(change.coord), change.mask).second;
+			});
+
+			mismatch_count += complete != (cursor_version >= reference.dropped_version());
+			mismatch_count += consumer.cursor.version != reference.version();
+			mismatch_count += reported.size() != expected.size();
+
+			for (const auto& [key, mask] : expected) {
+				const auto found = reported.find(key);
+				mismatch_count += found == reported.end() || !same_mask(found->second, mask);
+			}
+
+			++pull_count;
+			merged_count     += reference.version() - cursor_version > 1 && !expected.empty();
+			incomplete_count += !complete;
+		};
+
+		std::uniform_int_distribution<int32_t> tile_axis {-80, 79};
+
+		for (uint32_t tick = 0; tick < 600; ++tick) {
+
+			if (tick == 200)
+				consumers[3].cursor = change_log.subscribe();
+
+			// NOTE: every seventh tick records nothing and must not move the version
+
+			const uint32_t record_count = (tick % 7U == 3U) ? 0U : 1U + rng() % 6U;
+
+			for (uint32_t record_idx = 0; record_idx < record_count; ++record_idx) {
+
+				const scn::TileCoord tile {
+					.x            = tile_axis(rng),
+					.z            = tile_axis(rng),
+					.storey_index = static_cast<int32_t>(rng() % 2U),
+					.storey_stack = 0
+				};
+
+				const scn::TileChunkCoord chunk_coord = scn::get_chunk_coord(tile);
+
+				scn::TileChunkMask mask {};
+
+				switch (rng() % 4U) {
+
+					case 0:
+						mask.fill();
+						change_log.record(chunk_coord);
+						break;
+
+					case 1:
+						for (uint32_t bit_idx = 0; bit_idx < 5; ++bit_idx)
+							mask.set(static_cast<uint32_t>(rng() % scn::cfg::chunk_area));
+						change_log.record(chunk_coord, mask);
+						break;
+
+					default:
+						mask.set(scn::get_local_index(tile));
+						change_log.record(tile);
+						break;
+				}
+
+				reference.record(chunk_coord, mask);
+			}
+
+			// NOTE: records still open are not reported
+
+			for (Consumer& consumer : consumers) {
+				if (rng() % 100U < consumer.pull_percent / 2U)
+					pull(consumer);
+			}
+
+			reference.end_tick();
+
+			HPR_CHECK(change_log.end_tick() == reference.version());
+
+			for (Consumer& consumer : consumers) {
+				if (rng() % 100U < consumer.pull_percent)
+					pull(consumer);
+			}
+		}
+
+		for (Consumer& consumer : consumers)
+			pull(consumer);
+
+		HPR_CHECK(change_log.version() == reference.version());
+		HPR_CHECK(mismatch_count == 0);
+		HPR_CHECK(pull_count > 600);
+		HPR_CHECK(merged_count > 50);
+		HPR_CHECK(incomplete_count > 0);
+
+		// NOTE: a fresh cursor starts empty, clear() forgets the history
+
+		scn::TileChangeCursor late_cursor = change_log.subscribe();
+
+		uint32_t late_change_count = 0;
+
+		HPR_CHECK(change_log.pull(late_cursor, [&](const scn::TileChange&) { ++late_change_count; }));
+		HPR_CHECK(late_change_count == 0);
+
+		change_log.clear();
+
+		scn::TileChangeCursor cleared_cursor {};
+
+		HPR_CHECK(change_log.version() == 0);
+		HPR_CHECK(change_log.pull(cleared_cursor, [&](const scn::TileChange&) { ++late_change_count; }));
+		HPR_CHECK(late_change_count == 0);
+	}
+
+	/* a pathfinder behind the history rebuilds every chunk */
+
+	{
+		job::Scheduler job_scheduler;
+		job_scheduler.init(4);
+
+		scn::TileField tilefield;
+		tilefield.resize(96, 96, 1, 1);
+
+		scn::TilePathfinder pathfinder;
+		scn::TileChangeLog  change_log;
+
+		const uint32_t chunk_count = pathfinder.update(job_scheduler, tilefield);
+
+		HPR_CHECK(chunk_count == pathfinder.chunk_count());
+		HPR_CHECK(chunk_count == 9);
+
+		// NOTE: an inner tile within the history dirties its own chunk only
+
+		change_log.record(scn::TileCoord {.x = 40, .z = 40, .storey_index = 0, .storey_stack = 0});
+		change_log.end_tick();
+
+		pathfinder.consume(change_log);
+
+		HPR_CHECK(pathfinder.update(job_scheduler, tilefield) == 1);
+
+		for (uint32_t tick = 0; tick <= scn::cfg::tile_change_history; ++tick) {
+			change_log.record(scn::TileCoord {.x = 40, .z = 40, .storey_index = 0, .storey_stack = 0});
+			change_log.end_tick();
+		}
+
+		pathfinder.consume(change_log);
+
+		HPR_CHECK(pathfinder.update(job_scheduler, tilefield) == chunk_count);
+
+		// NOTE: caught up again, the next pull is complete
+
+		change_log.record(scn::TileCoord {.x = 40, .z = 40, .storey_index = 0, .storey_stack = 0});
+		change_log.end_tick();
+
+		pathfinder.consume(change_log);
+
+		HPR_CHECK(pathfinder.update(job_scheduler, tilefield) == 1);
+
+		job_scheduler.shutdown();
+	}
+
+	return test::finish("test_tile_change");
+}
@@ -0,0 +1,266 @@
+#include <array>
+#include <cmath>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
+#include "harness.hpp"
+#include "math.hpp"
+#include "tile_data.hpp"
+#include "frustum_cull.hpp"
+#include "tile_chunk_cull.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+constexpr int32_t chunk_extent  = 24;
+constexpr float   chunk_world   = 32.0f;
+constexpr float   storey_height = 8.0f;
+
+
+struct Drawable
+{
+	scn::TileChunkCoord coord;
+	vec3                center;
+	vec3                half;
+	bool                alive;
+};
+
+
+// NOTE: the chunk's content never fills it, random bounds inside the chunk cell
+
+void random_bounds(std::mt19937& rng, Drawable& drawable)
+{
+	std::uniform_real_distribution<float> unit {0.0f, 1.0f};
+
+	const vec3 cell_min {
+		static_cast<float>(drawable.coord.chunk_x) * chunk_world,
+		static_cast<float>(drawable.coord.storey_index) * storey_height,
+		static_cast<float>(drawable.coord.chunk_z) * chunk_world
+	};
+
+	const vec3 cell_size {chunk_world, storey_height, chunk_world};
+
+	const vec3 lo = cell_min + cell_size * vec3 {unit(rng), unit(rng), unit(rng)} * 0.5f;
+	const vec3 hi = cell_min + cell_size * (vec3 {0.5f} + vec3 {unit(rng), unit(rng), unit(rng)} * 0.5f);
+
+	drawable.center = (lo + hi) * 0.5f;
+	drawable.half   = (hi - lo) * 0.5f;
+}
+
+
+// NOTE: a box around a random point with each face tilted a little, from a few chunks to
+//       the whole map so storeys and regions come out culled, cut and contained
+
+[[nodiscard]] rdr::CullFrustum random_frustum(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+
+	const float world_half = static_cast<float>(chunk_extent) * chunk_world;
+
+	const vec3  center = vec3 {unit(rng) * world_half, unit(rng) * storey_height * 2.0f, unit(rng) * world_half};
+	const float reach  = std::pow(2.0f, 5.0f + 7.0f * (unit(rng) * 0.5f + 0.5f));
+
+	const vec3 half {reach * (1.0f + 0.5f * unit(rng)), storey_height * (1.0f + 4.0f * (unit(rng) * 0.5f + 0.5f)), reach * (1.0f + 0.5f * unit(rng))};
+
+	std::array<vec4, math::frustum_plane_count> raw_planes;
+
+	for (uint32_t axis = 0; axis < 3; ++axis) {
+		for (uint32_t side = 0; side < 2; ++side) {
+
+			vec3 normal {unit(rng) * 0.15f, unit(rng) * 0.15f, unit(rng) * 0.15f};
+			normal[axis] = side ? -1.0f : 1.0f;
+
+			vec3 point = center;
+			point[axis] += side ? half[axis] : -half[axis];
+
+			raw_planes[axis * 2 + side] = vec4 {normal, -glm::dot(normal, point)};
+		}
+	}
+
+	rdr::CullFrustum frustum;
+	frustum.set_planes(raw_planes);
+
+	return frustum;
+}
+
+
+// NOTE: every live drawable in one flat set, cull_frustum over all of it, then the storeys
+
+[[nodiscard]] mtp::vault<uint32_t, mtp::default_set> gather_flat(
+	const mtp::vault<Drawable, mtp::default_set>& drawables,
+	const rdr::CullFrustum&                       frustum,
+	int32_t                                       storey_min,
+	int32_t                                       storey_max
+)
+{
+	rdr::CullBoundSet                      bounds;
+	mtp::vault<uint32_t, mtp::default_set> bound_drawables;
+
+	for (uint32_t drawable_idx = 0; drawable_idx < drawables.size(); ++drawable_idx) {
+		if (drawables[drawable_idx].alive) {
+			(void) bounds.push(drawables[drawable_idx].center, drawables[drawable_idx].half);
+			bound_drawables.emplace_back(drawable_idx);
+		}
+	}
+
+	mtp::vault<uint32_t, mtp::default_set> visible;
+	visible.resize(bounds.size());
+
+	visible.resize(rdr::cull_frustum(frustum, bounds, 0, bounds.size(), visible.data()));
+
+	mtp::vault<uint32_t, mtp::default_set> visible_drawables;
+
+	for (const uint32_t bound_idx : visible) {
+
+		const uint32_t drawable_idx = bound_drawables[bound_idx];
+		const int32_t  storey_index = drawables[drawable_idx].coord.storey_index;
+
+		if (storey_index >= storey_min && storey_index <= storey_max)
+			visible_drawables.emplace_back(drawable_idx);
+	}
+
+	return visible_drawables;
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	std::mt19937 rng {49};
+
+	std::uniform_int_distribution<int32_t> chunk_axis  {-chunk_extent, chunk_extent - 1};
+	std::uniform_int_distribution<int32_t> storey_axis {-1, 2};
+
+	rdr::TileChunkCullTree                 cull_tree;
+	mtp::vault<Drawable, mtp::default_set> drawables;
+
+	// NOTE: negative chunk and storey coords share the region key with positive ones only
+	//       through the 16 bit fields, a storey from a colliding key would break the filter
+
+	const auto add_drawable = [&]()
+	{
+		Drawable drawable {
+			.coord  = scn::TileChunkCoord {
+				.chunk_x      = chunk_axis(rng),
+				.chunk_z      = chunk_axis(rng),
+				.storey_index = storey_axis(rng),
+				.storey_stack = static_cast<int32_t>(rng() % 2U)
+			},
+			.center = vec3 {0.0f},
+			.half   = vec3 {0.0f},
+			.alive  = true
+		};
+
+		random_bounds(rng, drawable);
+
+		cull_tree.insert(static_cast<uint32_t>(drawables.size()), drawable.coord, drawable.center, drawable.half);
+		drawables.emplace_back(drawable);
+	};
+
+	uint32_t gather_count   = 0;
+	uint32_t visible_total  = 0;
+	uint32_t mismatch_count = 0;
+
+	const auto compare_gathers = [&]()
+	{
+		mtp::vault<uint32_t, mtp::default_set> visible_tree;
+
+		for (uint32_t round = 0; round < 40; ++round) {
+
+			const rdr::CullFrustum frustum = random_frustum(rng);
+
+			// NOTE: storey ranges inside, across and past the storeys that exist
+
+			const int32_t storey_min = static_cast<int32_t>(rng() % 6U) - 2;
+			const int32_t storey_max = storey_min + static_cast<int32_t>(rng() % 5U) - 1;
+
+			visible_tree.clear();
+			cull_tree.gather(frustum, storey_min, storey_max, visible_tree);
+
+			mtp::vault<uint32_t, mtp::default_set> visible_flat = gather_flat(drawables, frustum, storey_min, storey_max);
+
+			std::sort(visible_tree.begin(), visible_tree.end());
+			std::sort(visible_flat.begin(), visible_flat.end());
+
+			mismatch_count += visible_tree.size() != visible_flat.size()
+				|| !std::equal(visible_tree.begin(), visible_tree.end(), visible_flat.begin());
+
+			++gather_count;
+			visible_total += static_cast<uint32_t>(visible_flat.size());
+		}
+	};
+
+	/* a fresh tree gathers what the flat cull and the storey filter keep */
+
+	for (uint32_t drawable_idx = 0; drawable_idx < 3000; ++drawable_idx)
+		add_drawable();
+
+	HPR_CHECK(cull_tree.size() == drawables.size());
+
+	compare_gathers();
+
+	/* updates, removes and drawables put back keep it exact */
+
+	for (uint32_t step = 0; step < 10; ++step) {
+
+		for (uint32_t edit = 0; edit < 300; ++edit) {
+
+			const uint32_t drawable_idx = static_cast<uint32_t>(rng() % drawables.size());
+			Drawable&      drawable     = drawables[drawable_idx];
+
+			switch (rng() % 3U) {
+
+				case 0:
+					cull_tree.remove(drawable_idx);
+					drawable.alive = false;
+					break;
+
+				default:
+					random_bounds(rng, drawable);
+					cull_tree.update(drawable_idx, drawable.center, drawable.half);
+					drawable.alive = true;
+					break;
+			}
+		}
+
+		for (uint32_t drawable_idx = 0; drawable_idx < 50; ++drawable_idx)
+			add_drawable();
+
+		compare_gathers();
+	}
+
+	uint32_t contains_mismatch_count = 0;
+
+	for (uint32_t drawable_idx = 0; drawable_idx < drawables.size(); ++drawable_idx)
+		contains_mismatch_count += cull_tree.contains(drawable_idx) != drawables[drawable_idx].alive;
+
+	HPR_CHECK(contains_mismatch_count == 0);
+	HPR_CHECK(!cull_tree.contains(static_cast<uint32_t>(drawables.size())));
+
+	HPR_CHECK(mismatch_count == 0);
+	HPR_CHECK(gather_count == 440);
+	HPR_CHECK(visible_total > gather_count * 50);
+
+	/* a cleared tree gathers nothing */
+
+	{
+		cull_tree.clear();
+
+		mtp::vault<uint32_t, mtp::default_set> visible_tree;
+		cull_tree.gather(random_frustum(rng), -10, 10, visible_tree);
+
+		HPR_CHECK(cull_tree.size() == 0);
+		HPR_CHECK(visible_tree.empty());
+	}
+
+	return test::finish("test_tile_chunk_cull");
+}
@@ -0,0 +1,233 @@
+#include <span>
+#include <random>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "scheduler.hpp"
+#include "tile_data.hpp"
+#include "tile_flow.hpp"
+#include "tile_path.hpp"
+#include "tile_field.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+constexpr int32_t width  = 96;
+constexpr int32_t height = 96;
+
+
+[[nodiscard]] scn::TileCoord tile_at(int32_t x, int32_t z)
+{
+	return scn::TileCoord {.x = x, .z = z, .storey_index = 0, .storey_stack = 0};
+}
+
+
+[[nodiscard]] scn::TileCoord random_tile(std::mt19937& rng)
+{
+	return tile_at(static_cast<int32_t>(rng() % width), static_cast<int32_t>(rng() % height));
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	/* simd directions match the scalar reference, ties and unreached tiles included */
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	{
+		std::mt19937 rng {41};
+
+		mtp::vault<int32_t, mtp::default_set> padded;
+		padded.resize(scn::cfg::tile_flow_padded_area);
+
+		mtp::vault<uint8_t, mtp::default_set> simd_direction;
+		mtp::vault<uint8_t, mtp::default_set> scalar_direction;
+		simd_direction.resize(scn::cfg::chunk_area);
+		scalar_direction.resize(scn::cfg::chunk_area);
+
+		uint32_t mismatch_count = 0;
+
+		for (uint32_t round = 0; round < 200; ++round) {
+
+			// NOTE: a narrow value range makes ties common, the ring stays unreached like in generate
+
+			const uint32_t value_range     = 4U + round % 60U;
+			const uint32_t unreached_share = round % 5U;
+
+			for (int32_t z = 0; z < scn::cfg::tile_flow_padded_size; ++z) {
+				for (int32_t x = 0; x < scn::cfg::tile_flow_padded_size; ++x) {
+
+					const bool ring      = x == 0 || z == 0 || x == scn::cfg::tile_flow_padded_size - 1 || z == scn::cfg::tile_flow_padded_size - 1;
+					const bool unreached = ring || rng() % 10U < unreached_share;
+
+					padded[static_cast<uint32_t>(z * scn::cfg::tile_flow_padded_size + x)] =
+						unreached ? scn::TileFlowField::k_unreached : static_cast<int32_t>(rng() % value_range);
+				}
+			}
+
+			scn::detail::flow_directions_simd(padded.data(), simd_direction.data());
+			scn::detail::flow_directions_scalar(padded.data(), scalar_direction.data());
+
+			for (uint32_t local_index = 0; local_index < static_cast<uint32_t>(scn::cfg::chunk_area); ++local_index)
+				mismatch_count += simd_direction[local_index] != scalar_direction[local_index];
+		}
+
+		HPR_CHECK(mismatch_count == 0);
+	}
+#endif
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	scn::TileField tilefield;
+	tilefield.resize(width, height, 1, 1);
+
+	std::mt19937 rng {4100};
+
+	for (uint32_t scatter_idx = 0; scatter_idx < static_cast<uint32_t>(width * height) / 5U; ++scatter_idx)
+		tilefield.set(random_tile(rng), 0);
+
+	// NOTE: a closed pocket the goal can never be reached from
+
+	for (int32_t offset = -2; offset <= 2; ++offset) {
+		tilefield.set(tile_at(70 + offset, 68), 0);
+		tilefield.set(tile_at(70 + offset, 72), 0);
+		tilefield.set(tile_at(68, 70 + offset), 0);
+		tilefield.set(tile_at(72, 70 + offset), 0);
+	}
+
+	tilefield.set(tile_at(70, 70), 1);
+
+	const scn::TileCoord goal = tile_at(20, 30);
+	tilefield.set(goal, 1);
+
+	scn::TilePathfinder pathfinder;
+	(void) pathfinder.update(job_scheduler, tilefield);
+
+	scn::TileFlowField flow_field;
+	flow_field.reset(pathfinder, goal);
+
+	HPR_CHECK(flow_field.version() == pathfinder.version());
+
+	/* chunks integrate lazily, once each */
+
+	{
+		const scn::TileCoord first_batch [] {tile_at(1, 1), tile_at(2, 2), tile_at(40, 1)};
+
+		HPR_CHECK(flow_field.generate(job_scheduler, pathfinder, first_batch) == 2);
+		HPR_CHECK(flow_field.generate(job_scheduler, pathfinder, first_batch) == 0);
+		HPR_CHECK(flow_field.direction(tile_at(90, 90)) == scn::tile_flow_unreached);
+		HPR_CHECK(flow_field.integration(tile_at(90, 90)) == scn::TileFlowField::k_unreached);
+
+		mtp::vault<scn::TileCoord, mtp::default_set> every_chunk;
+
+		for (int32_t z = 0; z < height; z += scn::cfg::chunk_size)
+			for (int32_t x = 0; x < width; x += scn::cfg::chunk_size)
+				every_chunk.emplace_back(tile_at(x, z));
+
+		HPR_CHECK(flow_field.generate(job_scheduler, pathfinder, std::span<const scn::TileCoord> {every_chunk.data(), every_chunk.size()}) == 7);
+		HPR_CHECK(flow_field.chunk_count() == 9);
+		HPR_CHECK(flow_field.direction(goal) == scn::tile_flow_goal);
+		HPR_CHECK(flow_field.integration(goal) == 0);
+	}
+
+	/* the integrated cost of a tile is the cost find_paths reports from it */
+
+	{
+		mtp::vault<scn::TilePathRequest, mtp::default_set> requests;
+
+		for (uint32_t request_idx = 0; request_idx < 300; ++request_idx)
+			requests.emplace_back(scn::TilePathRequest {.start = random_tile(rng), .goal = goal});
+
+		requests.emplace_back(scn::TilePathRequest {.start = tile_at(70, 70), .goal = goal});
+
+		scn::TilePathBatch batch;
+		pathfinder.find_paths(job_scheduler, tilefield, std::span<const scn::TilePathRequest> {requests.data(), requests.size()}, batch);
+
+		HPR_CHECK(batch.results.back().status == scn::TilePathStatus::unreachable);
+
+		uint32_t found_count    = 0;
+		uint32_t mismatch_count = 0;
+
+		for (uint32_t request_idx = 0; request_idx < requests.size(); ++request_idx) {
+
+			const scn::TilePathResult& result      = batch.results[request_idx];
+			const int32_t              integration = flow_field.integration(requests[request_idx].start);
+
+			if (result.status == scn::TilePathStatus::found) {
+				mismatch_count += integration != static_cast<int32_t>(result.cost);
+				++found_count;
+			}
+			else {
+				mismatch_count += integration != scn::TileFlowField::k_unreached;
+			}
+		}
+
+		HPR_CHECK(mismatch_count == 0);
+		HPR_CHECK(found_count > 150);
+	}
+
+	/* following the directions walks downhill to the goal */
+
+	{
+		uint32_t walk_count     = 0;
+		uint32_t mismatch_count = 0;
+
+		for (uint32_t walk_idx = 0; walk_idx < 100; ++walk_idx) {
+
+			scn::TileCoord tile = random_tile(rng);
+
+			if (flow_field.integration(tile) == scn::TileFlowField::k_unreached)
+				continue;
+
+			++walk_count;
+
+			for (uint32_t step = 0; step < static_cast<uint32_t>(width * height); ++step) {
+
+				const uint8_t code = flow_field.direction(tile);
+
+				if (code == scn::tile_flow_goal)
+					break;
+
+				if (code >= 8) {
+					++mismatch_count;
+					break;
+				}
+
+				const scn::TileCoord next = tile_at(tile.x + scn::detail::flow_step_x[code], tile.z + scn::detail::flow_step_z[code]);
+
+				mismatch_count += tilefield.get(next) == 0;
+				mismatch_count += flow_field.integration(next) >= flow_field.integration(tile);
+
+				tile = next;
+			}
+
+			mismatch_count += !(tile.x == goal.x && tile.z == goal.z);
+		}
+
+		HPR_CHECK(walk_count > 50);
+		HPR_CHECK(mismatch_count == 0);
+
+		/* sample is still on the goal and where the field has no way */
+
+		const scn::TileCoord agent_tiles [] {goal, tile_at(70, 70)};
+		vec2                 directions  [2] {};
+
+		flow_field.sample(agent_tiles, directions);
+
+		HPR_CHECK(directions[0].x == 0.0f && directions[0].y == 0.0f);
+		HPR_CHECK(directions[1].x == 0.0f && directions[1].y == 0.0f);
+	}
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_tile_flow");
+}
@@ -0,0 +1,243 @@
+#include <cstdint>
+#include <algorithm>
+
+#include "harness.hpp"
+#include "tile_data.hpp"
+#include "tile_edit.hpp"
+#include "tile_field.hpp"
+#include "tile_query.hpp"
+#include "tile_change.hpp"
+#include "tile_journal.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+struct DirtyRecord
+{
+	scn::TileChunkCoord coord;
+	scn::TileChunkMask  mask;
+};
+
+
+struct DirtyRecorder
+{
+	mtp::vault<DirtyRecord, mtp::default_set> records;
+
+	void operator()(scn::TileChunkCoord chunk_coord, const scn::TileChunkMask& mask)
+	{
+		records.emplace_back(DirtyRecord {chunk_coord, mask});
+	}
+
+	[[nodiscard]] uint32_t tile_count() const
+	{
+		uint32_t total = 0;
+		for (const DirtyRecord& record : records)
+			total += record.mask.count();
+		return total;
+	}
+};
+
+
+[[nodiscard]] scn::TileCoord tile_at(int32_t x, int32_t z)
+{
+	return scn::TileCoord {.x = x, .z = z, .storey_index = 0, .storey_stack = 0};
+}
+
+
+[[nodiscard]] mtp::vault<scn::TileType, mtp::default_set> snapshot(const scn::TileField& tilefield)
+{
+	mtp::vault<scn::TileType, mtp::default_set> tiles;
+
+	for (const scn::TileChunk& chunk : tilefield.chunks())
+		tiles.insert(tiles.end(), chunk.tiles.begin(), chunk.tiles.end());
+
+	return tiles;
+}
+
+
+[[nodiscard]] bool same_tiles(const scn::TileField& tilefield, const mtp::vault<scn::TileType, mtp::default_set>& expected)
+{
+	const mtp::vault<scn::TileType, mtp::default_set> tiles = snapshot(tilefield);
+
+	return tiles.size() == expected.size() && std::equal(tiles.begin(), tiles.end(), expected.begin());
+}
+
+
+void paint_row(scn::TileEditBatch& batch, const scn::TileField& tilefield, int32_t x_beg, int32_t x_end, int32_t z, scn::TileType after)
+{
+	for (int32_t x = x_beg; x < x_end; ++x)
+		batch.push(tile_at(x, z), tilefield.get(tile_at(x, z)), after);
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	scn::TileField tilefield;
+	tilefield.resize(64, 64, 1, 0);
+
+	const auto ground = snapshot(tilefield);
+
+	/* apply, undo and redo round-trip exact tile contents */
+
+	scn::TileEditJournal journal;
+	scn::TileEditBatch   batch;
+
+	paint_row(batch, tilefield, 20, 45, 3, 5);
+	batch.push(tile_at(10, 40), 0, 7);
+	batch.push(tile_at(10, 40), 7, 8);
+
+	{
+		DirtyRecorder recorder;
+
+		HPR_CHECK(journal.apply(batch, tilefield, recorder) == 26);
+		HPR_CHECK(recorder.records.size() == 3);
+		HPR_CHECK(recorder.tile_count() == 26);
+		HPR_CHECK(journal.entry_count() == 1);
+		HPR_CHECK(journal.can_undo() && !journal.can_redo());
+	}
+
+	HPR_CHECK(tilefield.get(tile_at(10, 40)) == 8);
+	HPR_CHECK(tilefield.get(tile_at(44, 3)) == 5);
+	HPR_CHECK(tilefield.get(tile_at(45, 3)) == 0);
+
+	const auto painted = snapshot(tilefield);
+
+	{
+		DirtyRecorder recorder;
+
+		HPR_CHECK(journal.undo(tilefield, recorder));
+		HPR_CHECK(same_tiles(tilefield, ground));
+		HPR_CHECK(recorder.tile_count() == 26);
+
+		for (const DirtyRecord& record : recorder.records) {
+			if (record.coord.chunk_x == 0 && record.coord.chunk_z == 0) {
+				HPR_CHECK(record.mask.test(scn::get_local_index(20, 3)));
+				HPR_CHECK(record.mask.test(scn::get_local_index(31, 3)));
+				HPR_CHECK(!record.mask.test(scn::get_local_index(19, 3)));
+			}
+		}
+	}
+
+	{
+		DirtyRecorder recorder;
+
+		HPR_CHECK(journal.redo(tilefield, recorder));
+		HPR_CHECK(same_tiles(tilefield, painted));
+		HPR_CHECK(recorder.tile_count() == 26);
+		HPR_CHECK(!journal.redo(tilefield, recorder));
+	}
+
+	/* runs break at chunk boundaries, full rows of one chunk merge into one run */
+
+	{
+		scn::TileEditJournal run_journal;
+		scn::TileEditBatch   run_batch;
+
+		paint_row(run_batch, tilefield, 0, 64, 10, 2);
+
+		(void) run_journal.apply(run_batch, tilefield, DirtyRecorder {});
+
+		const size_t row_bytes = sizeof(scn::TileJournalEntry) + 2 * sizeof(scn::TileJournalChunk) + 2 * sizeof(scn::TileJournalRun);
+
+		HPR_CHECK(run_journal.memory_bytes() == row_bytes);
+
+		run_journal.clear();
+		run_batch.clear();
+
+		paint_row(run_batch, tilefield, 0, 32, 20, 3);
+		paint_row(run_batch, tilefield, 0, 32, 21, 3);
+		paint_row(run_batch, tilefield, 31, 33, 22, 3);
+
+		(void) run_journal.apply(run_batch, tilefield, DirtyRecorder {});
+
+		const size_t block_bytes = sizeof(scn::TileJournalEntry) + 2 * sizeof(scn::TileJournalChunk) + 3 * sizeof(scn::TileJournalRun);
+
+		HPR_CHECK(run_journal.memory_bytes() == block_bytes);
+
+		HPR_CHECK(run_journal.undo(tilefield, DirtyRecorder {}));
+		HPR_CHECK(tilefield.get(tile_at(31, 22)) == 0);
+		HPR_CHECK(tilefield.get(tile_at(32, 22)) == 0);
+		HPR_CHECK(tilefield.get(tile_at(0, 21)) == 0);
+
+		HPR_CHECK(run_journal.undo(tilefield, DirtyRecorder {}) == false);
+		HPR_CHECK(tilefield.get(tile_at(0, 10)) == 2);
+
+		tilefield.resize(64, 64, 1, 0);
+		HPR_CHECK(same_tiles(tilefield, ground));
+	}
+
+	/* a new edit after undo truncates redo */
+
+	{
+		scn::TileEditJournal branch_journal;
+		scn::TileEditBatch   branch_batch;
+
+		branch_batch.push(tile_at(1, 1), 0, 1);
+		(void) branch_journal.apply(branch_batch, tilefield, DirtyRecorder {});
+
+		branch_batch.clear();
+		branch_batch.push(tile_at(2, 2), 0, 2);
+		(void) branch_journal.apply(branch_batch, tilefield, DirtyRecorder {});
+
+		HPR_CHECK(branch_journal.undo(tilefield, DirtyRecorder {}));
+		HPR_CHECK(branch_journal.can_redo());
+		HPR_CHECK(tilefield.get(tile_at(2, 2)) == 0);
+
+		branch_batch.clear();
+		branch_batch.push(tile_at(3, 3), 0, 3);
+		(void) branch_journal.apply(branch_batch, tilefield, DirtyRecorder {});
+
+		HPR_CHECK(!branch_journal.can_redo());
+		HPR_CHECK(branch_journal.entry_count() == 2);
+		HPR_CHECK(!branch_journal.redo(tilefield, DirtyRecorder {}));
+
+		HPR_CHECK(branch_journal.undo(tilefield, DirtyRecorder {}));
+		HPR_CHECK(branch_journal.undo(tilefield, DirtyRecorder {}));
+		HPR_CHECK(!branch_journal.can_undo());
+		HPR_CHECK(same_tiles(tilefield, ground));
+	}
+
+	/* a mismatched before is skipped, on apply and on replay */
+
+	{
+		scn::TileEditJournal skip_journal;
+		scn::TileEditBatch   skip_batch;
+
+		skip_batch.push(tile_at(4, 4), 9, 1);
+
+		DirtyRecorder recorder;
+
+		HPR_CHECK(skip_journal.apply(skip_batch, tilefield, recorder) == 0);
+		HPR_CHECK(recorder.records.empty());
+		HPR_CHECK(skip_journal.entry_count() == 0);
+		HPR_CHECK(tilefield.get(tile_at(4, 4)) == 0);
+
+		skip_batch.push(tile_at(5, 4), 0, 1);
+		skip_batch.push(tile_at(6, 4), 0, 1);
+
+		HPR_CHECK(skip_journal.apply(skip_batch, tilefield, recorder) == 2);
+		HPR_CHECK(tilefield.get(tile_at(4, 4)) == 0);
+
+		// NOTE: a later write outside the journal wins over undo
+
+		tilefield.set(tile_at(6, 4), 4);
+
+		recorder.records.clear();
+
+		HPR_CHECK(skip_journal.undo(tilefield, recorder));
+		HPR_CHECK(tilefield.get(tile_at(5, 4)) == 0);
+		HPR_CHECK(tilefield.get(tile_at(6, 4)) == 4);
+		HPR_CHECK(recorder.tile_count() == 1);
+	}
+
+	return test::finish("test_tile_journal");
+}
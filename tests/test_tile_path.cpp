@@ -0,0 +1,443 @@
+#include <span>
+#include <random>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+
+#include "harness.hpp"
+#include "scheduler.hpp"
+#include "tile_data.hpp"
+#include "tile_edit.hpp"
+#include "tile_path.hpp"
+#include "tile_field.hpp"
+#include "tile_change.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+constexpr int32_t width  = 128;
+constexpr int32_t height = 96;
+
+constexpr uint32_t k_no_path = 0xFFFFFFFFU;
+
+constexpr scn::TileType ground = 1;
+constexpr scn::TileType mud    = 2;
+
+
+// NOTE: 0 blocks, mud costs three times as much as ground
+
+[[nodiscard]] uint8_t tile_cost(scn::TileType tile, const void*)
+{
+	return (tile == 0) ? uint8_t {0} : (tile == mud) ? uint8_t {3} : uint8_t {1};
+}
+
+
+[[nodiscard]] scn::TileCoord tile_at(int32_t x, int32_t z, int32_t storey_index = 0)
+{
+	return scn::TileCoord {.x = x, .z = z, .storey_index = storey_index, .storey_stack = 0};
+}
+
+
+[[nodiscard]] bool same_tile(scn::TileCoord lhs, scn::TileCoord rhs)
+{
+	return lhs.x == rhs.x && lhs.z == rhs.z && lhs.storey_index == rhs.storey_index && lhs.storey_stack == rhs.storey_stack;
+}
+
+
+[[nodiscard]] uint32_t cost_at(const scn::TileField& tilefield, int32_t x, int32_t z, int32_t storey_index)
+{
+	if (x < 0 || z < 0 || x >= width || z >= height)
+		return 0;
+
+	return tile_cost(tilefield.get(tile_at(x, z, storey_index)), nullptr);
+}
+
+
+// NOTE: the step the pathfinder allows between two tiles of one storey, k_no_path when there is
+//       none. 8 connected, diagonals stay inside one chunk and never cut a blocked corner
+
+[[nodiscard]] uint32_t step_cost(const scn::TileField& tilefield, scn::TileCoord from, scn::TileCoord to)
+{
+	const int32_t delta_x = to.x - from.x;
+	const int32_t delta_z = to.z - from.z;
+
+	if (from.storey_index != to.storey_index || std::abs(delta_x) > 1 || std::abs(delta_z) > 1 || (delta_x == 0 && delta_z == 0))
+		return k_no_path;
+
+	const uint32_t cost_from = cost_at(tilefield, from.x, from.z, from.storey_index);
+	const uint32_t cost_to   = cost_at(tilefield, to.x, to.z, to.storey_index);
+
+	if (cost_from == 0 || cost_to == 0)
+		return k_no_path;
+
+	const bool diagonal = delta_x != 0 && delta_z != 0;
+
+	if (diagonal) {
+		if ((from.x >> scn::cfg::chunk_shift) != (to.x >> scn::cfg::chunk_shift) ||
+			(from.z >> scn::cfg::chunk_shift) != (to.z >> scn::cfg::chunk_shift))
+			return k_no_path;
+
+		if (cost_at(tilefield, to.x, from.z, from.storey_index) == 0 || cost_at(tilefield, from.x, to.z, from.storey_index) == 0)
+			return k_no_path;
+	}
+
+	const uint32_t weight = diagonal ? scn::cfg::tile_path_weight_diagonal : scn::cfg::tile_path_weight_straight;
+
+	return (cost_from + cost_to) * weight;
+}
+
+
+// NOTE: plain tile a* on one storey with the octile bound, the optimum the pathfinder approaches
+
+[[nodiscard]] uint32_t plain_astar(const scn::TileField& tilefield, scn::TileCoord start, scn::TileCoord goal)
+{
+	if (cost_at(tilefield, start.x, start.z, start.storey_index) == 0 || cost_at(tilefield, goal.x, goal.z, goal.storey_index) == 0)
+		return k_no_path;
+
+	const auto bound = [&](int32_t x, int32_t z) -> uint32_t {
+		const uint32_t delta_x = static_cast<uint32_t>(std::abs(x - goal.x));
+		const uint32_t delta_z = static_cast<uint32_t>(std::abs(z - goal.z));
+		return 10U * std::max(delta_x, delta_z) + 4U * std::min(delta_x, delta_z);
+	};
+
+	mtp::vault<uint32_t, mtp::default_set> costs;
+	costs.resize(static_cast<uint32_t>(width * height), k_no_path);
+
+	mtp::vault<uint64_t, mtp::default_set> heap;
+
+	const auto push = [&](int32_t x, int32_t z, uint32_t cost) {
+		costs[static_cast<uint32_t>(z * width + x)] = cost;
+		heap.emplace_back((static_cast<uint64_t>(cost + bound(x, z)) << 32) | static_cast<uint32_t>(z * width + x));
+		std::push_heap(heap.begin(), heap.end(), std::greater<> {});
+	};
+
+	push(start.x, start.z, 0);
+
+	while (!heap.empty()) {
+
+		std::pop_heap(heap.begin(), heap.end(), std::greater<> {});
+		const uint32_t index = static_cast<uint32_t>(heap.back());
+		const uint32_t key   = static_cast<uint32_t>(heap.back() >> 32);
+		heap.pop_back();
+
+		const int32_t x = static_cast<int32_t>(index) % width;
+		const int32_t z = static_cast<int32_t>(index) / width;
+
+		if (key != costs[index] + bound(x, z))
+			continue;
+
+		if (x == goal.x && z == goal.z)
+			return costs[index];
+
+		for (int32_t offset_z = -1; offset_z <= 1; ++offset_z) {
+			for (int32_t offset_x = -1; offset_x <= 1; ++offset_x) {
+
+				const scn::TileCoord next = tile_at(x + offset_x, z + offset_z, start.storey_index);
+				const uint32_t       step = step_cost(tilefield, tile_at(x, z, start.storey_index), next);
+
+				if (step == k_no_path)
+					continue;
+
+				if (costs[index] + step < costs[static_cast<uint32_t>(next.z * width + next.x)])
+					push(next.x, next.z, costs[index] + step);
+			}
+		}
+	}
+
+	return k_no_path;
+}
+
+
+// NOTE: a returned path runs from start to goal over allowed steps and transitions, and its
+//       steps add up to the reported cost
+
+[[nodiscard]] bool valid_path(
+	const scn::TileField&       tilefield,
+	const scn::TilePathfinder&  pathfinder,
+	const scn::TilePathBatch&   batch,
+	uint32_t                    request_idx,
+	const scn::TilePathRequest& request
+)
+{
+	const scn::TilePathResult& result = batch.results[request_idx];
+
+	if (result.status != scn::TilePathStatus::found || result.tile_count == 0)
+		return false;
+
+	const scn::TileCoord* tiles = batch.tiles.data() + result.tile_beg;
+
+	if (!same_tile(tiles[0], request.start) || !same_tile(tiles[result.tile_count - 1], request.goal))
+		return false;
+
+	uint32_t total = 0;
+
+	for (uint32_t tile_idx = 1; tile_idx < result.tile_count; ++tile_idx) {
+
+		uint32_t step = step_cost(tilefield, tiles[tile_idx - 1], tiles[tile_idx]);
+
+		for (const scn::TilePathTransition& transition : pathfinder.transitions()) {
+			if (same_tile(transition.from, tiles[tile_idx - 1]) && same_tile(transition.to, tiles[tile_idx]))
+				step = std::min(step, transition.cost);
+		}
+
+		if (step == k_no_path)
+			return false;
+
+		total += step;
+	}
+
+	return total == result.cost;
+}
+
+
+// NOTE: writes outside the change log tell the pathfinder themselves
+
+void set_tile(scn::TileField& tilefield, scn::TilePathfinder& pathfinder, scn::TileCoord coord, scn::TileType tile)
+{
+	tilefield.set(coord, tile);
+	pathfinder.invalidate(coord);
+}
+
+
+void find_one(
+	scn::TilePathfinder&  pathfinder,
+	job::Scheduler&       job_scheduler,
+	const scn::TileField& tilefield,
+	scn::TilePathRequest  request,
+	scn::TilePathBatch&   batch
+)
+{
+	pathfinder.find_paths(job_scheduler, tilefield, std::span<const scn::TilePathRequest> {&request, 1}, batch);
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	scn::TileField tilefield;
+	tilefield.resize(width, height, 2, ground);
+
+	scn::TilePathfinder pathfinder;
+	pathfinder.set_cost(&tile_cost, nullptr);
+
+	scn::TilePathBatch batch;
+
+	/* a path inside one chunk is the exact optimum */
+
+	{
+		// NOTE: a wall across most of chunk (0, 0) with mud in the gap
+
+		for (int32_t z = 2; z < 30; ++z)
+			set_tile(tilefield, pathfinder, tile_at(16, z), 0);
+
+		set_tile(tilefield, pathfinder, tile_at(16, 2), mud);
+
+		const scn::TilePathRequest request {.start = tile_at(4, 20), .goal = tile_at(28, 20)};
+
+		find_one(pathfinder, job_scheduler, tilefield, request, batch);
+
+		HPR_CHECK(pathfinder.chunk_count() == 4 * 3 * 2);
+		HPR_CHECK(valid_path(tilefield, pathfinder, batch, 0, request));
+		HPR_CHECK(batch.results[0].cost == plain_astar(tilefield, request.start, request.goal));
+
+		const scn::TilePathRequest open_request {.start = tile_at(40, 3), .goal = tile_at(60, 17)};
+
+		find_one(pathfinder, job_scheduler, tilefield, open_request, batch);
+
+		HPR_CHECK(batch.results[0].cost == 20U * 10U + 14U * 4U);
+		HPR_CHECK(batch.results[0].tile_count == 21);
+	}
+
+	/* paths across chunks stay valid and close to plain a* */
+
+	{
+		std::mt19937 rng {40};
+
+		for (uint32_t scatter_idx = 0; scatter_idx < static_cast<uint32_t>(width * height) / 5U; ++scatter_idx) {
+			const scn::TileCoord coord = tile_at(static_cast<int32_t>(rng() % width), static_cast<int32_t>(rng() % height));
+			set_tile(tilefield, pathfinder, coord, (rng() % 3U == 0U) ? mud : scn::TileType {0});
+		}
+
+		mtp::vault<scn::TilePathRequest, mtp::default_set> requests;
+
+		for (uint32_t request_idx = 0; request_idx < 200; ++request_idx) {
+			requests.emplace_back(scn::TilePathRequest {
+				.start = tile_at(static_cast<int32_t>(rng() % width), static_cast<int32_t>(rng() % height)),
+				.goal  = tile_at(static_cast<int32_t>(rng() % width), static_cast<int32_t>(rng() % height))
+			});
+		}
+
+		pathfinder.find_paths(job_scheduler, tilefield, std::span<const scn::TilePathRequest> {requests.data(), requests.size()}, batch);
+
+		HPR_CHECK(batch.results.size() == requests.size());
+
+		uint32_t found_count    = 0;
+		uint32_t mismatch_count = 0;
+		uint64_t found_cost     = 0;
+		uint64_t optimum_cost   = 0;
+
+		for (uint32_t request_idx = 0; request_idx < requests.size(); ++request_idx) {
+
+			const scn::TilePathRequest& request = requests[request_idx];
+			const scn::TilePathResult&  result  = batch.results[request_idx];
+
+			const bool     blocked = tilefield.get(request.start) == 0 || tilefield.get(request.goal) == 0;
+			const uint32_t optimum = plain_astar(tilefield, request.start, request.goal);
+
+			if (blocked) {
+				mismatch_count += result.status != scn::TilePathStatus::blocked;
+				continue;
+			}
+
+			if (optimum == k_no_path) {
+				mismatch_count += result.status != scn::TilePathStatus::unreachable;
+				continue;
+			}
+
+			mismatch_count += !valid_path(tilefield, pathfinder, batch, request_idx, request);
+			mismatch_count += result.cost < optimum;
+
+			found_cost   += result.cost;
+			optimum_cost += optimum;
+			++found_count;
+		}
+
+		HPR_CHECK(mismatch_count == 0);
+		HPR_CHECK(found_count > 100);
+
+		// NOTE: hpa* is near optimal, not exact. entrances sit at the ends of border runs, so a
+		//       single path may detour noticeably while the batch stays close on average
+
+		HPR_CHECK(found_cost * 100U <= optimum_cost * 110U);
+
+		// NOTE: a resize rewrites every chunk, the pathfinder starts over
+
+		tilefield.resize(width, height, 2, ground);
+		pathfinder.clear();
+	}
+
+	/* storey transitions - the only way up is a stair, removing it cuts the storeys apart */
+
+	{
+		// NOTE: a ledge on storey 1, surrounded by void
+
+		for (int32_t z = 0; z < height; ++z)
+			for (int32_t x = 0; x < width; ++x)
+				set_tile(tilefield, pathfinder, tile_at(x, z, 1), (x >= 70 && x < 80 && z >= 60 && z < 70) ? ground : scn::TileType {0});
+
+		pathfinder.add_transition(tile_at(10, 10, 0), tile_at(72, 62, 1), 120);
+		pathfinder.add_transition(tile_at(72, 62, 1), tile_at(10, 10, 0), 120);
+
+		const scn::TilePathRequest request {.start = tile_at(3, 40, 0), .goal = tile_at(78, 68, 1)};
+
+		find_one(pathfinder, job_scheduler, tilefield, request, batch);
+
+		const uint32_t optimum =
+			plain_astar(tilefield, request.start, tile_at(10, 10, 0)) + 120U +
+			plain_astar(tilefield, tile_at(72, 62, 1), request.goal);
+
+		HPR_CHECK(valid_path(tilefield, pathfinder, batch, 0, request));
+		HPR_CHECK(batch.results[0].cost >= optimum);
+		HPR_CHECK(batch.results[0].cost * 100U <= optimum * 125U);
+
+		// NOTE: the way back down takes the reverse stair
+
+		find_one(pathfinder, job_scheduler, tilefield, scn::TilePathRequest {.start = request.goal, .goal = request.start}, batch);
+
+		HPR_CHECK(batch.results[0].status == scn::TilePathStatus::found);
+
+		pathfinder.remove_transitions(tile_at(10, 10, 0));
+
+		HPR_CHECK(pathfinder.transitions().empty());
+
+		find_one(pathfinder, job_scheduler, tilefield, request, batch);
+
+		HPR_CHECK(batch.results[0].status == scn::TilePathStatus::unreachable);
+	}
+
+	/* an enclosed goal is unreachable, a blocked one or one off the field is blocked */
+
+	{
+		for (int32_t offset = -2; offset <= 2; ++offset) {
+			set_tile(tilefield, pathfinder, tile_at(50 + offset, 48), 0);
+			set_tile(tilefield, pathfinder, tile_at(50 + offset, 52), 0);
+			set_tile(tilefield, pathfinder, tile_at(48, 50 + offset), 0);
+			set_tile(tilefield, pathfinder, tile_at(52, 50 + offset), 0);
+		}
+
+		find_one(pathfinder, job_scheduler, tilefield, scn::TilePathRequest {.start = tile_at(5, 5), .goal = tile_at(50, 50)}, batch);
+
+		HPR_CHECK(batch.results[0].status == scn::TilePathStatus::unreachable);
+		HPR_CHECK(plain_astar(tilefield, tile_at(5, 5), tile_at(50, 50)) == k_no_path);
+
+		find_one(pathfinder, job_scheduler, tilefield, scn::TilePathRequest {.start = tile_at(5, 5), .goal = tile_at(48, 50)}, batch);
+
+		HPR_CHECK(batch.results[0].status == scn::TilePathStatus::blocked);
+
+		find_one(pathfinder, job_scheduler, tilefield, scn::TilePathRequest {.start = tile_at(5, 5), .goal = tile_at(500, 5)}, batch);
+
+		HPR_CHECK(batch.results[0].status == scn::TilePathStatus::blocked);
+	}
+
+	/* an edit logged through the change log invalidates its chunks, the re-plan routes around it */
+
+	{
+		scn::TileChangeLog change_log;
+
+		const scn::TilePathRequest request {.start = tile_at(100, 10), .goal = tile_at(100, 80)};
+
+		find_one(pathfinder, job_scheduler, tilefield, request, batch);
+
+		const uint32_t open_cost    = batch.results[0].cost;
+		const uint32_t open_optimum = plain_astar(tilefield, request.start, request.goal);
+
+		HPR_CHECK(open_cost >= open_optimum && open_cost * 100U <= open_optimum * 125U);
+
+		// NOTE: a wall across chunks (2, 1) and (3, 1), its first tile sits on the border with
+		//       chunk (1, 1) which is invalidated too
+
+		scn::TileEditBatch edit_batch;
+
+		for (int32_t x = 64; x < width; ++x)
+			edit_batch.push(tile_at(x, 45), ground, 0);
+
+		(void) edit_batch.apply(tilefield, [&](scn::TileCoord coord) {
+			change_log.record(coord);
+		});
+
+		change_log.end_tick();
+
+		// NOTE: nothing was rebuilt before the log was consumed
+
+		HPR_CHECK(pathfinder.update(job_scheduler, tilefield) == 0);
+
+		pathfinder.consume(change_log);
+
+		HPR_CHECK(pathfinder.update(job_scheduler, tilefield) == 3);
+
+		find_one(pathfinder, job_scheduler, tilefield, request, batch);
+
+		const uint32_t optimum = plain_astar(tilefield, request.start, request.goal);
+
+		HPR_CHECK(valid_path(tilefield, pathfinder, batch, 0, request));
+		HPR_CHECK(batch.results[0].cost > open_cost);
+		HPR_CHECK(batch.results[0].cost >= optimum);
+		HPR_CHECK(batch.results[0].cost * 100U <= optimum * 125U);
+	}
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_tile_path");
+}
@@ -0,0 +1,259 @@
+#include <random>
+#include <cstdint>
+
+#include "harness.hpp"
+#include "scheduler.hpp"
+#include "tile_sim.hpp"
+#include "tile_data.hpp"
+#include "tile_field.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+constexpr scn::TileSpreadRule spread_rule {.source = 3, .medium = 2};
+
+
+struct DirtyCounter
+{
+	uint32_t count {0};
+
+	void operator()(scn::TileChunkCoord)
+	{
+		++count;
+	}
+};
+
+
+[[nodiscard]] scn::TileCoord tile_at(int32_t x, int32_t z)
+{
+	return scn::TileCoord {.x = x, .z = z, .storey_index = 0, .storey_stack = 0};
+}
+
+
+[[nodiscard]] scn::TileChunkCoord chunk_at(int32_t chunk_x, int32_t chunk_z)
+{
+	return scn::TileChunkCoord {.chunk_x = chunk_x, .chunk_z = chunk_z, .storey_index = 0, .storey_stack = 0};
+}
+
+
+void activate_all(scn::TileSimulation& tile_sim, int32_t chunk_width, int32_t chunk_height)
+{
+	for (int32_t chunk_z = 0; chunk_z < chunk_height; ++chunk_z)
+		for (int32_t chunk_x = 0; chunk_x < chunk_width; ++chunk_x)
+			tile_sim.activate(chunk_at(chunk_x, chunk_z));
+}
+
+
+// NOTE: whole grid reference step, outside tiles read 0 like missing chunks
+
+void spread_reference(
+	const mtp::vault<scn::TileType, mtp::default_set>& front,
+	mtp::vault<scn::TileType, mtp::default_set>&       back,
+	int32_t                                            width,
+	int32_t                                            height
+)
+{
+	const auto at = [&](int32_t x, int32_t z) -> scn::TileType {
+		if (x < 0 || z < 0 || x >= width || z >= height)
+			return 0;
+		return front[static_cast<uint32_t>(z * width + x)];
+	};
+
+	back.resize(front.size());
+
+	for (int32_t z = 0; z < height; ++z) {
+		for (int32_t x = 0; x < width; ++x) {
+
+			const scn::TileType tile = at(x, z);
+
+			const bool spreads =
+				tile == spread_rule.medium &&
+				(at(x - 1, z) == spread_rule.source || at(x + 1, z) == spread_rule.source ||
+				 at(x, z - 1) == spread_rule.source || at(x, z + 1) == spread_rule.source);
+
+			back[static_cast<uint32_t>(z * width + x)] = spreads ? spread_rule.source : tile;
+		}
+	}
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	/* neighbours read the previous tick across a chunk border, never the tick in flight */
+
+	{
+		scn::TileField tilefield;
+		tilefield.resize(64, 32, 1, spread_rule.medium);
+		tilefield.set(tile_at(30, 5), spread_rule.source);
+
+		scn::TileSimulation tile_sim;
+		tile_sim.set_kernel(&scn::tile_spread_kernel, &spread_rule);
+
+		activate_all(tile_sim, 2, 1);
+
+		DirtyCounter dirty;
+
+		tile_sim.step(job_scheduler, tilefield, dirty);
+
+		HPR_CHECK(tile_sim.tick() == 1);
+		HPR_CHECK(tilefield.get(tile_at(31, 5)) == spread_rule.source);
+		HPR_CHECK(tilefield.get(tile_at(29, 5)) == spread_rule.source);
+		HPR_CHECK(tilefield.get(tile_at(32, 5)) == spread_rule.medium);
+		HPR_CHECK(tilefield.get(tile_at(30, 7)) == spread_rule.medium);
+
+		// NOTE: only the left chunk changed, it wakes itself and its neighbour
+
+		HPR_CHECK(dirty.count == 1);
+		HPR_CHECK(tile_sim.changed_chunks().size() == 1);
+		HPR_CHECK(tile_sim.changed_chunks()[0].chunk_x == 0);
+		HPR_CHECK(tile_sim.active_count() == 2);
+
+		tile_sim.step(job_scheduler, tilefield, dirty);
+
+		HPR_CHECK(tilefield.get(tile_at(32, 5)) == spread_rule.source);
+		HPR_CHECK(tilefield.get(tile_at(33, 5)) == spread_rule.medium);
+		HPR_CHECK(tilefield.get(tile_at(30, 7)) == spread_rule.source);
+		HPR_CHECK(dirty.count == 3);
+	}
+
+	/* a chunk that did not change sleeps, an inactive chunk is not stepped */
+
+	{
+		scn::TileField tilefield;
+		tilefield.resize(96, 32, 1, spread_rule.medium);
+		tilefield.set(tile_at(5, 5), spread_rule.source);
+		tilefield.set(tile_at(70, 5), spread_rule.source);
+
+		scn::TileSimulation tile_sim;
+
+		DirtyCounter dirty;
+
+		// NOTE: nothing runs without a kernel
+
+		tile_sim.activate(chunk_at(0, 0));
+		tile_sim.step(job_scheduler, tilefield, dirty);
+
+		HPR_CHECK(tile_sim.tick() == 0);
+		HPR_CHECK(tilefield.get(tile_at(6, 5)) == spread_rule.medium);
+
+		tile_sim.set_kernel(&scn::tile_spread_kernel, &spread_rule);
+		tile_sim.step(job_scheduler, tilefield, dirty);
+
+		HPR_CHECK(tilefield.get(tile_at(6, 5)) == spread_rule.source);
+		HPR_CHECK(tilefield.get(tile_at(71, 5)) == spread_rule.medium);
+
+		uint32_t step_count = 1;
+
+		while (tile_sim.active_count() != 0 && step_count < 200) {
+			tile_sim.step(job_scheduler, tilefield, dirty);
+			++step_count;
+		}
+
+		// NOTE: the flood reaches the far chunk through the middle one and then runs dry
+
+		HPR_CHECK(tile_sim.active_count() == 0);
+		HPR_CHECK(tile_sim.changed_chunks().empty());
+
+		for (int32_t z = 0; z < 32; ++z)
+			for (int32_t x = 0; x < 96; ++x)
+				HPR_CHECK(tilefield.get(tile_at(x, z)) == spread_rule.source);
+
+		const uint64_t tick_at_rest = tile_sim.tick();
+
+		tile_sim.step(job_scheduler, tilefield, dirty);
+
+		HPR_CHECK(tile_sim.tick() == tick_at_rest);
+	}
+
+	/* many chunks across several jobs match a whole grid reference step by step */
+
+	{
+		static constexpr int32_t chunk_width  = 5;
+		static constexpr int32_t chunk_height = 4;
+		static constexpr int32_t width        = chunk_width * scn::cfg::chunk_size;
+		static constexpr int32_t height       = chunk_height * scn::cfg::chunk_size;
+
+		static_assert(chunk_width * chunk_height > 2 * scn::cfg::tile_sim_job_grain);
+
+		scn::TileField tilefield;
+		tilefield.resize(width, height, 1, 0);
+
+		mtp::vault<scn::TileType, mtp::default_set> reference;
+		mtp::vault<scn::TileType, mtp::default_set> reference_back;
+		reference.resize(static_cast<uint32_t>(width * height));
+
+		std::mt19937 rng {37};
+
+		for (int32_t z = 0; z < height; ++z) {
+			for (int32_t x = 0; x < width; ++x) {
+
+				const uint32_t roll = rng() % 100U;
+
+				const scn::TileType tile =
+					(roll < 2U)  ? spread_rule.source :
+					(roll < 80U) ? spread_rule.medium : scn::TileType {0};
+
+				tilefield.set(tile_at(x, z), tile);
+				reference[static_cast<uint32_t>(z * width + x)] = tile;
+			}
+		}
+
+		scn::TileSimulation tile_sim;
+		tile_sim.set_kernel(&scn::tile_spread_kernel, &spread_rule);
+
+		activate_all(tile_sim, chunk_width, chunk_height);
+
+		DirtyCounter dirty;
+
+		for (uint32_t step_idx = 0; step_idx < 24; ++step_idx) {
+
+			tile_sim.step(job_scheduler, tilefield, dirty);
+
+			spread_reference(reference, reference_back, width, height);
+			reference.swap(reference_back);
+
+			uint32_t mismatch_count = 0;
+
+			for (int32_t z = 0; z < height; ++z)
+				for (int32_t x = 0; x < width; ++x)
+					mismatch_count += tilefield.get(tile_at(x, z)) != reference[static_cast<uint32_t>(z * width + x)];
+
+			HPR_CHECK(mismatch_count == 0);
+		}
+	}
+
+	/* advance runs whole ticks only and caps a long frame */
+
+	{
+		scn::TileField tilefield;
+		tilefield.resize(32, 32, 1, spread_rule.medium);
+		tilefield.set(tile_at(0, 0), spread_rule.source);
+
+		scn::TileSimulation tile_sim;
+		tile_sim.set_kernel(&scn::tile_spread_kernel, &spread_rule);
+		tile_sim.activate(tile_at(0, 0));
+
+		DirtyCounter dirty;
+
+		HPR_CHECK(tile_sim.advance(scn::cfg::tile_sim_tick_interval * 0.5f, job_scheduler, tilefield, dirty) == 0);
+		HPR_CHECK(tile_sim.advance(scn::cfg::tile_sim_tick_interval * 0.75f, job_scheduler, tilefield, dirty) == 1);
+		HPR_CHECK(tile_sim.advance(1.0f, job_scheduler, tilefield, dirty) == scn::cfg::tile_sim_max_ticks_per_frame);
+		HPR_CHECK(tile_sim.tick() == 1 + scn::cfg::tile_sim_max_ticks_per_frame);
+	}
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_tile_sim");
+}
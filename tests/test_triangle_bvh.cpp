@@ -0,0 +1,370 @@
+#include <cmath>
+#include <random>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "harness.hpp"
+#include "job_latch.hpp"
+#include "scheduler.hpp"
+
+#include "math.hpp"
+#include "render_data.hpp"
+#include "scene_query.hpp"
+#include "triangle_bvh.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+struct Mesh
+{
+	mtp::vault<rdr::SceneVertex, mtp::default_set> vertices;
+	mtp::vault<uint32_t,         mtp::default_set> indices;
+
+	[[nodiscard]] rdr::TriangleSource source() const
+	{
+		return rdr::TriangleSource {
+			.position_bytes  = reinterpret_cast<const uint8_t*>(vertices.data()) + offsetof(rdr::SceneVertex, pos),
+			.position_stride = static_cast<uint32_t>(sizeof(rdr::SceneVertex)),
+			.vertex_count    = static_cast<uint32_t>(vertices.size()),
+			.indices         = indices.data(),
+			.triangle_count  = static_cast<uint32_t>(indices.size() / 3)
+		};
+	}
+};
+
+
+// NOTE: shared vertices on a noisy grid folded into a hull, plus loose triangles, a few
+//       degenerate ones and a few pointing past the vertex count that the build leaves out
+
+[[nodiscard]] Mesh make_mesh(std::mt19937& rng, uint32_t grid_size, uint32_t loose_count)
+{
+	std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+
+	Mesh mesh;
+
+	for (uint32_t z = 0; z <= grid_size; ++z) {
+		for (uint32_t x = 0; x <= grid_size; ++x) {
+
+			const float u = static_cast<float>(x) / static_cast<float>(grid_size) * 6.2831853f;
+			const float v = static_cast<float>(z) / static_cast<float>(grid_size) * 3.1415927f;
+
+			rdr::SceneVertex vertex {};
+			vertex.pos = vec3 {std::cos(u) * std::sin(v), std::cos(v), std::sin(u) * std::sin(v)} * (4.0f + 0.2f * unit(rng));
+
+			mesh.vertices.emplace_back(vertex);
+		}
+	}
+
+	const uint32_t row = grid_size + 1;
+
+	for (uint32_t z = 0; z < grid_size; ++z) {
+		for (uint32_t x = 0; x < grid_size; ++x) {
+
+			const uint32_t corner = z * row + x;
+
+			for (const uint32_t index : {corner, corner + 1, corner + row, corner + 1, corner + row + 1, corner + row})
+				mesh.indices.emplace_back(index);
+		}
+	}
+
+	for (uint32_t loose = 0; loose < loose_count; ++loose) {
+
+		const vec3 centre = vec3 {unit(rng), unit(rng), unit(rng)} * 3.0f;
+
+		for (uint32_t corner = 0; corner < 3; ++corner) {
+
+			rdr::SceneVertex vertex {};
+			vertex.pos = centre + vec3 {unit(rng), unit(rng), unit(rng)} * 0.4f;
+
+			mesh.indices.emplace_back(static_cast<uint32_t>(mesh.vertices.size()));
+			mesh.vertices.emplace_back(vertex);
+		}
+	}
+
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+
+	for (uint32_t degenerate = 0; degenerate < 4; ++degenerate) {
+		for (uint32_t corner = 0; corner < 3; ++corner)
+			mesh.indices.emplace_back(degenerate);
+	}
+
+	for (uint32_t invalid = 0; invalid < 3; ++invalid) {
+		mesh.indices.emplace_back(0);
+		mesh.indices.emplace_back(1);
+		mesh.indices.emplace_back(vertex_count + invalid);
+	}
+
+	return mesh;
+}
+
+
+[[nodiscard]] uint32_t valid_triangle_count(const Mesh& mesh)
+{
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+
+	uint32_t valid_count = 0;
+
+	for (uint32_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle) {
+		valid_count += mesh.indices[triangle * 3 + 0] < vertex_count
+			&& mesh.indices[triangle * 3 + 1] < vertex_count
+			&& mesh.indices[triangle * 3 + 2] < vertex_count;
+	}
+
+	return valid_count;
+}
+
+
+[[nodiscard]] bool intersect(const Mesh& mesh, uint32_t triangle, const vec3& origin, const vec3& direction, float& distance)
+{
+	const rdr::TriangleSource source = mesh.source();
+
+	float barycentric_U;
+	float barycentric_V;
+
+	return scn::intersect_ray_triangle(
+		origin,
+		direction,
+		source.position(triangle, 0),
+		source.position(triangle, 1),
+		source.position(triangle, 2),
+		distance,
+		barycentric_U,
+		barycentric_V
+	);
+}
+
+
+struct Hit
+{
+	uint32_t triangle {std::numeric_limits<uint32_t>::max()};
+	float    distance {std::numeric_limits<float>::infinity()};
+};
+
+
+[[nodiscard]] Hit raycast_brute(const Mesh& mesh, const vec3& origin, const vec3& direction)
+{
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+
+	Hit best {};
+
+	for (uint32_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle) {
+
+		if (mesh.indices[triangle * 3 + 2] >= vertex_count)
+			continue;
+
+		float distance = 0.0f;
+
+		if (intersect(mesh, triangle, origin, direction, distance) && distance < best.distance)
+			best = Hit {.triangle = triangle, .distance = distance};
+	}
+
+	return best;
+}
+
+
+[[nodiscard]] Hit raycast_bvh(const rdr::TriangleBvh& bvh, const Mesh& mesh, const vec3& origin, const vec3& direction)
+{
+	Hit best {};
+
+	bvh.raycast(origin, direction, std::numeric_limits<float>::infinity(), [&](uint32_t triangle) -> float
+	{
+		float distance = 0.0f;
+
+		if (intersect(mesh, triangle, origin, direction, distance) && distance < best.distance)
+			best = Hit {.triangle = triangle, .distance = distance};
+
+		return best.distance;
+	});
+
+	return best;
+}
+
+
+struct SubtreeJobSlice
+{
+	uint32_t begin;
+	uint32_t end;
+
+	rdr::TriangleBvh* bvh;
+};
+
+
+void build_subtrees(void* slice_raw)
+{
+	auto* slice = static_cast<SubtreeJobSlice*>(slice_raw);
+
+	for (uint32_t subtree_idx = slice->begin; subtree_idx < slice->end; ++subtree_idx)
+		slice->bvh->build_subtree(subtree_idx);
+}
+
+
+// NOTE: the way build_triangle_bvhs runs it, subtrees on the workers and spliced after
+
+uint32_t build_parallel(job::Scheduler& job_scheduler, rdr::TriangleBvh& bvh, const Mesh& mesh, uint32_t subtree_size)
+{
+	const uint32_t subtree_count = bvh.begin_build(mesh.source(), subtree_size);
+
+	mtp::vault<SubtreeJobSlice, mtp::default_set> job_slices;
+	job_slices.resize(subtree_count);
+
+	for (SubtreeJobSlice& slice : job_slices)
+		slice.bvh = &bvh;
+
+	job::JobLatch job_latch;
+
+	job_scheduler.dispatch_range(job_latch, &build_subtrees, subtree_count, 1, job_slices.data());
+
+	job_latch.wait();
+
+	bvh.finish_build();
+
+	return subtree_count;
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	job::Scheduler job_scheduler;
+	job_scheduler.init(4);
+
+	std::mt19937 rng {45};
+
+	std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+
+	/* empty and tiny meshes */
+
+	{
+		Mesh empty_mesh;
+
+		rdr::TriangleBvh bvh;
+		bvh.build(empty_mesh.source());
+
+		HPR_CHECK(bvh.empty());
+		HPR_CHECK(raycast_bvh(bvh, empty_mesh, vec3 {0.0f}, vec3 {1.0f, 0.0f, 0.0f}).distance == std::numeric_limits<float>::infinity());
+
+		Mesh single_mesh;
+		single_mesh.vertices.resize(3);
+		single_mesh.vertices[0].pos = vec3 {-1.0f, -1.0f, 2.0f};
+		single_mesh.vertices[1].pos = vec3 { 1.0f, -1.0f, 2.0f};
+		single_mesh.vertices[2].pos = vec3 { 0.0f,  1.0f, 2.0f};
+		for (const uint32_t index : {0U, 1U, 2U})
+			single_mesh.indices.emplace_back(index);
+
+		bvh.build(single_mesh.source());
+
+		HPR_CHECK(bvh.node_count() == 1);
+		HPR_CHECK(raycast_bvh(bvh, single_mesh, vec3 {0.0f}, vec3 {0.0f, 0.0f, 1.0f}).triangle == 0);
+		HPR_CHECK(raycast_bvh(bvh, single_mesh, vec3 {0.0f}, vec3 {0.0f, 0.0f, -1.0f}).triangle == std::numeric_limits<uint32_t>::max());
+	}
+
+	/* nearest hit equals the brute force one, serial and with spliced subtrees */
+
+	for (const uint32_t grid_size : {6U, 40U, 90U}) {
+
+		const Mesh mesh = make_mesh(rng, grid_size, grid_size * 8);
+
+		rdr::TriangleBvh serial_bvh;
+		serial_bvh.build(mesh.source());
+
+		rdr::TriangleBvh parallel_bvh;
+		const uint32_t subtree_count = build_parallel(job_scheduler, parallel_bvh, mesh, 64);
+
+		HPR_CHECK(serial_bvh.triangle_count() == valid_triangle_count(mesh));
+		HPR_CHECK(parallel_bvh.triangle_count() == valid_triangle_count(mesh));
+
+		// NOTE: deferring ranges does not change how they are split, only where the nodes land
+
+		HPR_CHECK(parallel_bvh.node_count() == serial_bvh.node_count());
+		HPR_CHECK(grid_size < 40 || subtree_count > 8);
+
+		uint32_t hit_count      = 0;
+		uint32_t mismatch_count = 0;
+		uint32_t missed_count   = 0;
+
+		for (uint32_t ray_idx = 0; ray_idx < 500; ++ray_idx) {
+
+			// NOTE: from outside and from inside the hull, axis aligned now and then
+
+			const vec3 origin = vec3 {unit(rng), unit(rng), unit(rng)} * ((ray_idx % 2U) ? 8.0f : 2.0f);
+
+			vec3 direction = glm::normalize(vec3 {unit(rng), unit(rng), unit(rng)} * 6.0f - origin + vec3 {1.0e-3f});
+
+			if (ray_idx % 7U == 0U)
+				direction = vec3 {0.0f, (ray_idx % 2U) ? -1.0f : 1.0f, 0.0f};
+
+			const Hit brute_hit    = raycast_brute(mesh, origin, direction);
+			const Hit serial_hit   = raycast_bvh(serial_bvh, mesh, origin, direction);
+			const Hit parallel_hit = raycast_bvh(parallel_bvh, mesh, origin, direction);
+
+			mismatch_count += serial_hit.triangle != brute_hit.triangle || serial_hit.distance != brute_hit.distance;
+			mismatch_count += parallel_hit.triangle != brute_hit.triangle || parallel_hit.distance != brute_hit.distance;
+
+			hit_count += brute_hit.triangle != std::numeric_limits<uint32_t>::max();
+
+			// NOTE: without pruning every triangle the ray crosses is visited
+
+			mtp::vault<uint8_t, mtp::default_set> visited;
+			visited.resize(mesh.indices.size() / 3, 0);
+
+			parallel_bvh.raycast(origin, direction, std::numeric_limits<float>::infinity(), [&](uint32_t triangle) -> float
+			{
+				visited[triangle] = 1;
+				return std::numeric_limits<float>::infinity();
+			});
+
+			for (uint32_t triangle = 0; triangle < visited.size(); ++triangle) {
+
+				float distance = 0.0f;
+
+				if (mesh.indices[triangle * 3 + 2] < mesh.vertices.size() && !visited[triangle])
+					missed_count += intersect(mesh, triangle, origin, direction, distance);
+			}
+		}
+
+		HPR_CHECK(mismatch_count == 0);
+		HPR_CHECK(missed_count == 0);
+		HPR_CHECK(hit_count > 300);
+	}
+
+	/* a rebuild of the same bvh starts from scratch */
+
+	{
+		const Mesh large_mesh = make_mesh(rng, 50, 200);
+		const Mesh small_mesh = make_mesh(rng, 8, 10);
+
+		rdr::TriangleBvh bvh;
+		(void) build_parallel(job_scheduler, bvh, large_mesh, 128);
+		(void) build_parallel(job_scheduler, bvh, small_mesh, 16);
+
+		HPR_CHECK(bvh.triangle_count() == valid_triangle_count(small_mesh));
+
+		uint32_t mismatch_count = 0;
+
+		for (uint32_t ray_idx = 0; ray_idx < 200; ++ray_idx) {
+
+			const vec3 origin    = vec3 {unit(rng), unit(rng), unit(rng)} * 8.0f;
+			const vec3 direction = glm::normalize(vec3 {unit(rng), unit(rng), unit(rng)} - origin * 0.125f);
+
+			const Hit brute_hit = raycast_brute(small_mesh, origin, direction);
+			const Hit bvh_hit   = raycast_bvh(bvh, small_mesh, origin, direction);
+
+			mismatch_count += bvh_hit.triangle != brute_hit.triangle || bvh_hit.distance != brute_hit.distance;
+		}
+
+		HPR_CHECK(mismatch_count == 0);
+	}
+
+	job_scheduler.shutdown();
+
+	return test::finish("test_triangle_bvh");
+}
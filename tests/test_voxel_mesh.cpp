@@ -0,0 +1,147 @@
+#include <cstdint>
+
+#include "harness.hpp"
+#include "voxel_data.hpp"
+#include "voxel_field.hpp"
+#include "voxel_query.hpp"
+#include "voxel_mesher.hpp"
+#include "voxel_draw_data.hpp"
+
+
+using namespace hpr;
+
+
+namespace {
+
+
+void consume_dirty(rdr::VoxelChunkDrawableSet& chunk_drawable_set)
+{
+	for (const uint32_t drawable_idx : chunk_drawable_set.dirty_queue)
+		chunk_drawable_set.drawables[drawable_idx].dirty = false;
+
+	chunk_drawable_set.dirty_queue.clear();
+}
+
+
+[[nodiscard]] bool is_queued(const rdr::VoxelChunkDrawableSet& chunk_drawable_set, scn::VoxelChunkCoord chunk_coord)
+{
+	const uint32_t drawable_idx = chunk_drawable_set.index.find(scn::VoxelField::key_of(chunk_coord));
+
+	if (drawable_idx == scn::ChunkDirectory::k_empty_slot)
+		return false;
+
+	for (const uint32_t queued_idx : chunk_drawable_set.dirty_queue) {
+		if (queued_idx == drawable_idx)
+			return chunk_drawable_set.drawables[drawable_idx].dirty;
+	}
+
+	return false;
+}
+
+
+[[nodiscard]] uint32_t quad_count(const scn::VoxelMeshBuffer& mesh)
+{
+	return static_cast<uint32_t>(mesh.indices.size()) / 6U;
+}
+
+
+} // namespace
+
+
+int main()
+{
+	test::init();
+
+	scn::VoxelField            voxelfield;
+	scn::VoxelGridParams       voxel_grid;
+	rdr::VoxelChunkDrawableSet chunk_drawable_set;
+	scn::VoxelMeshBuffer       mesh;
+
+	static constexpr scn::VoxelChunkCoord origin_chunk {0, 0, 0};
+	static constexpr scn::VoxelChunkCoord east_chunk   {1, 0, 0};
+	static constexpr scn::VoxelChunkCoord upper_chunk  {0, 1, 0};
+
+	/* an edit queues its chunk, the dirtied chunk meshes to one quad per face */
+
+	scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {5, 5, 5}, 1, chunk_drawable_set);
+
+	HPR_CHECK(chunk_drawable_set.drawables.size() == 1);
+	HPR_CHECK(is_queued(chunk_drawable_set, origin_chunk));
+
+	scn::build_voxel_chunk_mesh(voxelfield, origin_chunk, voxel_grid.voxel_size, mesh);
+
+	HPR_CHECK(quad_count(mesh) == 6);
+	HPR_CHECK(mesh.vertices.size() == 24);
+
+	/* equal faces merge, a 2x2x2 block is still six quads */
+
+	consume_dirty(chunk_drawable_set);
+
+	for (int32_t y = 5; y < 7; ++y)
+		for (int32_t z = 5; z < 7; ++z)
+			for (int32_t x = 5; x < 7; ++x)
+				scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {x, y, z}, 1, chunk_drawable_set);
+
+	HPR_CHECK(chunk_drawable_set.dirty_queue.size() == 1);
+	HPR_CHECK(is_queued(chunk_drawable_set, origin_chunk));
+
+	scn::build_voxel_chunk_mesh(voxelfield, origin_chunk, voxel_grid.voxel_size, mesh);
+
+	HPR_CHECK(quad_count(mesh) == 6);
+
+	/* rewriting the same value queues nothing */
+
+	consume_dirty(chunk_drawable_set);
+
+	scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {5, 5, 5}, 1, chunk_drawable_set);
+
+	HPR_CHECK(chunk_drawable_set.dirty_queue.empty());
+
+	/* an edit on a chunk face requeues the chunk across it and culls the shared face */
+
+	scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {31, 20, 20}, 2, chunk_drawable_set);
+
+	consume_dirty(chunk_drawable_set);
+
+	scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {32, 20, 20}, 2, chunk_drawable_set);
+
+	HPR_CHECK(is_queued(chunk_drawable_set, east_chunk));
+	HPR_CHECK(is_queued(chunk_drawable_set, origin_chunk));
+
+	scn::build_voxel_chunk_mesh(voxelfield, origin_chunk, voxel_grid.voxel_size, mesh);
+
+	HPR_CHECK(quad_count(mesh) == 6 + 5);
+
+	scn::build_voxel_chunk_mesh(voxelfield, east_chunk, voxel_grid.voxel_size, mesh);
+
+	HPR_CHECK(quad_count(mesh) == 5);
+
+	/* a chunk created whole queues itself and its resident face neighbours */
+
+	consume_dirty(chunk_drawable_set);
+
+	(void) voxelfield.ensure_chunk(upper_chunk, 3);
+	scn::mark_voxel_chunk_loaded(voxelfield, voxel_grid, upper_chunk, chunk_drawable_set);
+
+	HPR_CHECK(is_queued(chunk_drawable_set, upper_chunk));
+	HPR_CHECK(is_queued(chunk_drawable_set, origin_chunk));
+	HPR_CHECK(!is_queued(chunk_drawable_set, east_chunk));
+
+	scn::build_voxel_chunk_mesh(voxelfield, upper_chunk, voxel_grid.voxel_size, mesh);
+
+	HPR_CHECK(quad_count(mesh) == 6);
+
+	/* clearing the last voxel leaves an empty mesh */
+
+	consume_dirty(chunk_drawable_set);
+
+	scn::set_voxel(voxelfield, voxel_grid, scn::VoxelCoord {32, 20, 20}, 0, chunk_drawable_set);
+
+	HPR_CHECK(is_queued(chunk_drawable_set, east_chunk));
+
+	scn::build_voxel_chunk_mesh(voxelfield, east_chunk, voxel_grid.voxel_size, mesh);
+
+	HPR_CHECK(mesh.indices.empty());
+
+	return test::finish("test_voxel_mesh");
+}